@@ -0,0 +1,7 @@
+ orig_build_dir = build/
+ orig_cur_dir = /root/repo
+ orig_deps_dir = build/debug/deps/
+ orig_header_dir = src/
+ orig_mode_dir = build/debug/
+ orig_objs_dir = build/debug/objs/
+ orig_src_dir = src/
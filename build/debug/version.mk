@@ -0,0 +1 @@
+version_str = debug-git-44a423b-dirty
@@ -0,0 +1,7 @@
+ orig_build_dir = build/
+ orig_cur_dir = /root/repo
+ orig_deps_dir = build/release/deps/
+ orig_header_dir = src/
+ orig_mode_dir = build/release/
+ orig_objs_dir = build/release/objs/
+ orig_src_dir = src/
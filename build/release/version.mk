@@ -0,0 +1 @@
+version_str = release-git-44a423b-dirty
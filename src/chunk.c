@@ -9,13 +9,15 @@ void initChunk(Chunk* chunk) {
   chunk->count = 0;
   chunk->capacity = 0;
   chunk->code = NULL;
+  chunk->lineCount = 0;
+  chunk->lineCapacity = 0;
   chunk->lines = NULL;
   initValueArray(&chunk->constants);
 }
 
 void freeChunk(GC* gc, Chunk* chunk) {
   FREE_ARRAY(gc, uint8_t, chunk->code, chunk->capacity);
-  FREE_ARRAY(gc, int, chunk->lines, chunk->capacity);
+  FREE_ARRAY(gc, LineStart, chunk->lines, chunk->lineCapacity);
   freeValueArray(gc, &chunk->constants);
   initChunk(chunk);
 }
@@ -26,12 +28,10 @@ void writeChunk(GC* gc, Chunk* chunk, uint8_t byte, int line) {
     chunk->capacity = GROW_CAPACITY(oldCapacity);
     chunk->code = GROW_ARRAY(
         gc, uint8_t, chunk->code, oldCapacity, chunk->capacity);
-    chunk->lines =
-        GROW_ARRAY(gc, int, chunk->lines, oldCapacity, chunk->capacity);
   }
 
   chunk->code[chunk->count] = byte;
-  chunk->lines[chunk->count] = line;
+  addLine(gc, chunk, chunk->count, line);
   chunk->count++;
 }
 
@@ -42,6 +42,40 @@ int addConstant(GC* gc, Chunk* chunk, Value value) {
   return chunk->constants.count - 1;
 }
 
-int findConstant(Chunk* chunk, Value value) {
-  return findInValueArray(&chunk->constants, value);
+void addLine(GC* gc, Chunk* chunk, int offset, int line) {
+  // Drop the lines of code that was rewound to write over it.
+  while (chunk->lineCount > 0 &&
+      chunk->lines[chunk->lineCount - 1].offset >= offset) {
+    chunk->lineCount--;
+  }
+  if (chunk->lineCount > 0 &&
+      chunk->lines[chunk->lineCount - 1].line == line) {
+    return;
+  }
+
+  if (chunk->lineCapacity < chunk->lineCount + 1) {
+    int oldCapacity = chunk->lineCapacity;
+    chunk->lineCapacity = GROW_CAPACITY(oldCapacity);
+    chunk->lines = GROW_ARRAY(
+        gc, LineStart, chunk->lines, oldCapacity, chunk->lineCapacity);
+  }
+
+  LineStart* lineStart = &chunk->lines[chunk->lineCount++];
+  lineStart->offset = offset;
+  lineStart->line = line;
+}
+
+int getLine(Chunk* chunk, int offset) {
+  // Find the last line that starts at or before offset.
+  int low = 0;
+  int high = chunk->lineCount - 1;
+  while (low < high) {
+    int mid = low + (high - low + 1) / 2;
+    if (chunk->lines[mid].offset <= offset) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+  return chunk->lines[low].line;
 }
@@ -13,30 +13,62 @@ typedef enum {
   OP_TRUE,
   OP_FALSE,
   OP_POP,
+  OP_DUP,
   OP_GET_LOCAL,
   OP_SET_LOCAL,
+  OP_SET_LOCAL_POP,
+  OP_INC_LOCAL,
   OP_GET_GLOBAL,
   OP_GET_GLOBAL_I,
   OP_DEFINE_GLOBAL,
+  OP_DEFINE_GLOBAL_I,
   OP_SET_GLOBAL,
   OP_SET_GLOBAL_I,
+  OP_SET_GLOBAL_I_POP,
   OP_GET_UPVALUE,
   OP_SET_UPVALUE,
   OP_GET_PROPERTY,
+  OP_HOIST_PROPERTY,
+  OP_GET_HOISTED,
   OP_SET_PROPERTY,
+  OP_GET_PROPERTY_KEEP,
+  OP_ADD_PROPERTY,
+  OP_SUBTRACT_PROPERTY,
+  OP_MULTIPLY_PROPERTY,
+  OP_DIVIDE_PROPERTY,
+  OP_MODULO_PROPERTY,
   OP_GET_INDEX,
   OP_SET_INDEX,
+  OP_GET_INDEX_KEEP,
+  OP_ADD_INDEX,
+  OP_SUBTRACT_INDEX,
+  OP_MULTIPLY_INDEX,
+  OP_DIVIDE_INDEX,
+  OP_MODULO_INDEX,
   OP_GET_SUPER,
   OP_EQUAL,
+  OP_NOT_EQUAL,
   OP_GREATER,
+  OP_GREATER_NN,
+  OP_NOT_GREATER,
   OP_LESS,
+  OP_LESS_NN,
+  OP_NOT_LESS,
   OP_LESS_C,
+  OP_LESS_C_NN,
+  OP_NOT_LESS_C,
   OP_ADD,
+  OP_ADD_NN,
   OP_ADD_C,
+  OP_ADD_C_NN,
   OP_SUBTRACT,
+  OP_SUBTRACT_NN,
   OP_SUBTRACT_C,
+  OP_SUBTRACT_C_NN,
   OP_MULTIPLY,
+  OP_MULTIPLY_NN,
   OP_DIVIDE,
+  OP_DIVIDE_NN,
   OP_MODULO,
   OP_NOT,
   OP_NEGATE,
@@ -44,16 +76,30 @@ typedef enum {
   OP_JUMP,
   OP_JUMP_IF_FALSE,
   OP_PJMP_IF_FALSE,
+  OP_JUMP_IF_LESS_LC,
+  OP_JUMP_IF_NOT_LESS_LC,
+  OP_JUMP_IF_GREATER_LC,
+  OP_JUMP_IF_NOT_GREATER_LC,
+  OP_JUMP_IF_EQUAL_LC,
+  OP_JUMP_IF_NOT_EQUAL_LC,
+  OP_JUMP_IF_LESS_LL,
+  OP_JUMP_IF_NOT_LESS_LL,
+  OP_JUMP_IF_EQUAL_LL,
+  OP_JUMP_IF_NOT_EQUAL_LL,
   OP_LOOP,
   OP_CALL,
   OP_INVOKE,
   OP_SUPER_INVOKE,
   OP_CLOSURE,
   OP_CLOSE_UPVALUE,
-  OP_LIST_INIT,
+  OP_LIST_BUILD,
   OP_LIST_DATA,
-  OP_MAP_INIT,
+  OP_LIST_TEMPLATE,
+  OP_MAP_BUILD,
   OP_MAP_DATA,
+  OP_MAP_TEMPLATE,
+  OP_ITER_INIT,
+  OP_ITER_NEXT,
   OP_RETURN,
   OP_CLASS,
   OP_INHERIT,
@@ -61,11 +107,19 @@ typedef enum {
   MAX_OPCODES
 } OpCode;
 
+// The code from offset up to the next LineStart came from line.
+typedef struct {
+  int offset;
+  int line;
+} LineStart;
+
 typedef struct {
   int count;
   int capacity;
   uint8_t* code;
-  int* lines;
+  int lineCount;
+  int lineCapacity;
+  LineStart* lines;
   ValueArray constants;
 } Chunk;
 
@@ -73,6 +127,7 @@ void initChunk(Chunk* chunk);
 void freeChunk(GC* gc, Chunk* chunk);
 void writeChunk(GC* gc, Chunk* chunk, uint8_t byte, int line);
 int addConstant(GC* gc, Chunk* chunk, Value value);
-int findConstant(Chunk* chunk, Value value);
+void addLine(GC* gc, Chunk* chunk, int offset, int line);
+int getLine(Chunk* chunk, int offset);
 
 #endif
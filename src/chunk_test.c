@@ -57,13 +57,28 @@ UTEST_F(Chunk, Lines) {
   writeChunk(&ufx->gc, &ufx->chunk, OP_RETURN, 3);
   writeChunk(&ufx->gc, &ufx->chunk, OP_RETURN, 4);
   ASSERT_EQ(7, ufx->chunk.count);
-  EXPECT_EQ(1, ufx->chunk.lines[0]);
-  EXPECT_EQ(2, ufx->chunk.lines[1]);
-  EXPECT_EQ(2, ufx->chunk.lines[2]);
-  EXPECT_EQ(3, ufx->chunk.lines[3]);
-  EXPECT_EQ(3, ufx->chunk.lines[4]);
-  EXPECT_EQ(3, ufx->chunk.lines[5]);
-  EXPECT_EQ(4, ufx->chunk.lines[6]);
+  EXPECT_EQ(4, ufx->chunk.lineCount);
+  EXPECT_EQ(1, getLine(&ufx->chunk, 0));
+  EXPECT_EQ(2, getLine(&ufx->chunk, 1));
+  EXPECT_EQ(2, getLine(&ufx->chunk, 2));
+  EXPECT_EQ(3, getLine(&ufx->chunk, 3));
+  EXPECT_EQ(3, getLine(&ufx->chunk, 4));
+  EXPECT_EQ(3, getLine(&ufx->chunk, 5));
+  EXPECT_EQ(4, getLine(&ufx->chunk, 6));
+}
+
+UTEST_F(Chunk, LinesRewound) {
+  writeChunk(&ufx->gc, &ufx->chunk, OP_NIL, 1);
+  writeChunk(&ufx->gc, &ufx->chunk, OP_NIL, 2);
+  writeChunk(&ufx->gc, &ufx->chunk, OP_NIL, 3);
+  ufx->chunk.count = 1;
+  writeChunk(&ufx->gc, &ufx->chunk, OP_RETURN, 1);
+  writeChunk(&ufx->gc, &ufx->chunk, OP_RETURN, 4);
+  ASSERT_EQ(3, ufx->chunk.count);
+  EXPECT_EQ(2, ufx->chunk.lineCount);
+  EXPECT_EQ(1, getLine(&ufx->chunk, 0));
+  EXPECT_EQ(1, getLine(&ufx->chunk, 1));
+  EXPECT_EQ(4, getLine(&ufx->chunk, 2));
 }
 
 UTEST_F(Chunk, OpConstant) {
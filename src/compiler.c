@@ -1,13 +1,18 @@
 #include "compiler.h"
 
+#include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "common.h"
 #include "debug.h"
+#include "dict.h"
 #include "gc.h"
 #include "memory.h"
+#include "number.h"
+#include "optimizer.h"
 #include "scanner.h"
 
 bool debugPrintCode = false;
@@ -16,6 +21,7 @@ typedef struct {
   Token name;
   int depth;
   bool isCaptured;
+  bool isNumber; // Holds a number here, unless captured.
 } Local;
 
 typedef struct {
@@ -39,6 +45,14 @@ typedef struct Compiler {
   int localCount;
   Upvalue upvalues[UINT8_COUNT];
   int scopeDepth;
+  // Where the last expression known to give a number ends in the code.
+  int numberEnd;
+  struct LoopStart* loop; // The innermost loop being compiled.
+
+  // Maps constants to their indices in the chunk's constant pool. It
+  // isn't updated when the pool is rewound, so makeConstant() checks
+  // each index it finds.
+  Dict constants;
 } Compiler;
 
 typedef struct ClassCompiler {
@@ -46,6 +60,83 @@ typedef struct ClassCompiler {
   bool hasSuperclass;
 } ClassCompiler;
 
+// A position in a chunk's code and constants to go back to if the code
+// after it is replaced.
+typedef struct {
+  int code;
+  int constants;
+} ChunkMark;
+
+// Which of the first count locals of a function hold numbers at some
+// point in its code.
+typedef struct {
+  bool isNumber[UINT8_COUNT];
+  int count;
+} LocalTypes;
+
+typedef enum {
+  ACCESS_GET,    // Gets property name of the variable in slot.
+  ACCESS_ASSIGN, // Assigns the variable in slot.
+  ACCESS_SET,    // Sets property name of any instance.
+} AccessType;
+
+// Something the code of a loop does that decides which property reads
+// can be hoisted out of it.
+typedef struct {
+  AccessType type;
+  bool isLocal;
+  int slot;
+  Token name;
+} LoopAccess;
+
+// A property read hoisted out of a loop, cached in a hidden local.
+typedef struct {
+  LoopAccess read;
+  int local;
+} Hoist;
+
+// Most different accesses a loop keeps track of, and reads it hoists.
+#define LOOP_ACCESSES 32
+#define LOOP_HOISTS 8
+
+// Where a loop starts, to compile it again from if its code turns out
+// to make fewer locals numbers than it was compiled assuming, or to
+// have property reads worth hoisting.
+typedef struct LoopStart {
+  struct LoopStart* enclosing;
+  Scanner scanner;
+  Token current;
+  Token previous;
+  ChunkMark mark;
+  int localCount;
+  LocalTypes types;
+  bool narrowed;
+
+  LoopAccess accesses[LOOP_ACCESSES];
+  int accessCount;
+  bool writesAny; // Calls code, or may set any field.
+  Hoist hoists[LOOP_HOISTS];
+  int hoistCount;
+  bool planned; // The hoists have been chosen.
+} LoopStart;
+
+// Natives without side effects, so calls to them with a constant
+// argument can be computed while compiling.
+typedef enum {
+  PURE_CEIL,
+  PURE_CHR,
+  PURE_FLOOR,
+  PURE_ROUND,
+  PURE_NATIVE_COUNT,
+} PureNative;
+
+static const char* pureNativeNames[PURE_NATIVE_COUNT] = {
+  [PURE_CEIL] = "ceil",
+  [PURE_CHR] = "chr",
+  [PURE_FLOOR] = "floor",
+  [PURE_ROUND] = "round",
+};
+
 typedef struct {
   FILE* fout;
   FILE* ferr;
@@ -55,11 +146,18 @@ typedef struct {
   void (*prevFixWeak)(void*);
   void* prevFixWeakArg;
   Table* strings;
+  Table* globals;
+  ValueArray* globalSlots;
+  const char* source;
   Scanner scanner;
   Compiler* currentCompiler;
   ClassCompiler* currentClass;
   Token current;
   Token previous;
+  ChunkMark leftMark; // Start of the left operand of an infix rule.
+  int loopRetries; // See retryLoop().
+  int reboundNatives; // See scanReboundNatives().
+  int pureNativeSlots[PURE_NATIVE_COUNT]; // See resolvePureNatives().
   bool hadError;
   bool panicMode;
 } Parser;
@@ -200,10 +298,36 @@ static void emitReturn(Parser* parser) {
   emitByte(parser, OP_RETURN);
 }
 
+// Like valuesEqual(), but tells -0 and 0 apart, since they print
+// differently.
+static bool sameConstant(Value a, Value b) {
+  return valuesEqual(a, b) &&
+      (!IS_NUMBER(a) || signbit(AS_NUMBER(a)) == signbit(AS_NUMBER(b)));
+}
+
 static uint16_t makeConstant(Parser* parser, Value value) {
-  int constant = findConstant(currentChunk(parser), value);
+  Chunk* chunk = currentChunk(parser);
+  Dict* constants = &parser->currentCompiler->constants;
+  // -0 and 0 are the same key, so -0 goes under nil, which is never
+  // a constant.
+  Value key = value;
+  if (IS_NUMBER(value) && AS_NUMBER(value) == 0.0 &&
+      signbit(AS_NUMBER(value))) {
+    key = NIL_VAL;
+  }
+
+  int constant = -1;
+  Value index;
+  if (dictGet(constants, key, &index)) {
+    constant = (int)AS_NUMBER(index);
+    if (constant >= chunk->constants.count ||
+        !sameConstant(value, chunk->constants.values[constant])) {
+      constant = -1;
+    }
+  }
   if (constant == -1) {
-    constant = addConstant(parser->gc, currentChunk(parser), value);
+    constant = addConstant(parser->gc, chunk, value);
+    dictSet(parser->gc, constants, key, NUMBER_VAL(constant));
   }
   // GCOV_EXCL_START
   if (constant > UINT16_MAX) {
@@ -215,8 +339,76 @@ static uint16_t makeConstant(Parser* parser, Value value) {
   return (uint16_t)constant;
 }
 
+// Note that the code emitted so far ends with a number.
+static void markNumber(Parser* parser) {
+  parser->currentCompiler->numberEnd = currentChunk(parser)->count;
+}
+
+// True if the expression just compiled is known to give a number.
+static bool numberResult(Parser* parser) {
+  return parser->currentCompiler->numberEnd ==
+      currentChunk(parser)->count;
+}
+
 static void emitConstant(Parser* parser, Value value) {
   emitOpShort(parser, OP_CONSTANT, makeConstant(parser, value));
+  if (IS_NUMBER(value)) {
+    markNumber(parser);
+  }
+}
+
+static void emitValue(Parser* parser, Value value) {
+  if (IS_NIL(value)) {
+    emitByte(parser, OP_NIL);
+  } else if (IS_BOOL(value)) {
+    emitByte(parser, AS_BOOL(value) ? OP_TRUE : OP_FALSE);
+  } else {
+    emitConstant(parser, value);
+  }
+}
+
+static ChunkMark markChunk(Parser* parser) {
+  ChunkMark mark = { currentChunk(parser)->count,
+    currentChunk(parser)->constants.count };
+  return mark;
+}
+
+// Drop the code emitted since mark, along with the constants added for
+// it, which nothing before it can refer to.
+static void rewindChunk(Parser* parser, ChunkMark mark) {
+  currentChunk(parser)->count = mark.code;
+  currentChunk(parser)->constants.count = mark.constants;
+  parser->currentCompiler->numberEnd = -1;
+}
+
+// If the code from start to end just loads a constant, store it in
+// value and return true.
+static bool constantLoad(
+    Parser* parser, int start, int end, Value* value) {
+  Chunk* chunk = currentChunk(parser);
+  int length = end - start;
+  if (length == 1 && chunk->code[start] == OP_NIL) {
+    *value = NIL_VAL;
+  } else if (length == 1 && chunk->code[start] == OP_TRUE) {
+    *value = BOOL_VAL(true);
+  } else if (length == 1 && chunk->code[start] == OP_FALSE) {
+    *value = BOOL_VAL(false);
+  } else if (length == 3 && chunk->code[start] == OP_CONSTANT) {
+    uint16_t constant = (uint16_t)(chunk->code[start + 1] << 8);
+    constant |= chunk->code[start + 2];
+    *value = chunk->constants.values[constant];
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Replace the code since mark with code that loads value.
+static void emitFolded(Parser* parser, ChunkMark mark, Value value) {
+  pushTemp(parser->gc, value);
+  rewindChunk(parser, mark);
+  emitValue(parser, value);
+  popTemp(parser->gc);
 }
 
 static void patchJump(Parser* parser, int offset) {
@@ -240,6 +432,9 @@ static void initCompiler(Parser* parser, Compiler* compiler,
   compiler->type = type;
   compiler->localCount = 0;
   compiler->scopeDepth = 0;
+  compiler->numberEnd = -1;
+  compiler->loop = NULL;
+  initDict(&compiler->constants);
   compiler->function = newFunction(parser->gc);
   parser->currentCompiler = compiler;
   if (type != TYPE_SCRIPT) {
@@ -251,6 +446,7 @@ static void initCompiler(Parser* parser, Compiler* compiler,
                       ->locals[parser->currentCompiler->localCount++];
   local->depth = 0;
   local->isCaptured = false;
+  local->isNumber = false;
   if (type != TYPE_FUNCTION) {
     local->name.start = "this";
     local->name.length = 4;
@@ -260,17 +456,73 @@ static void initCompiler(Parser* parser, Compiler* compiler,
   }
 }
 
+// If all function does is return a constant, or for a method, a field
+// of this, let calls to it do that without running its code. Anything
+// after its first return is never reached.
+static void findInline(ObjFunction* function) {
+  Chunk* chunk = &function->chunk;
+  uint8_t* code = chunk->code;
+  Value* constants = chunk->constants.values;
+  InlineKind kind = INLINE_CONSTANT;
+  Value value;
+  if (chunk->count >= 2 && code[0] == OP_NIL && code[1] == OP_RETURN) {
+    value = NIL_VAL;
+  } else if (chunk->count >= 2 && code[0] == OP_TRUE &&
+      code[1] == OP_RETURN) {
+    value = BOOL_VAL(true);
+  } else if (chunk->count >= 2 && code[0] == OP_FALSE &&
+      code[1] == OP_RETURN) {
+    value = BOOL_VAL(false);
+  } else if (chunk->count >= 4 && code[0] == OP_CONSTANT &&
+      code[3] == OP_RETURN) {
+    value = constants[(code[1] << 8) | code[2]];
+  } else if (chunk->count >= 6 && function->arity == 0 &&
+      code[0] == OP_GET_LOCAL && code[1] == 0 &&
+      code[2] == OP_GET_PROPERTY && code[5] == OP_RETURN) {
+    kind = INLINE_GETTER;
+    value = constants[(code[3] << 8) | code[4]];
+  } else {
+    return;
+  }
+  function->inlineKind = kind;
+  function->inlineValue = value;
+}
+
+// Optimize and print the code of function and the functions it makes.
+static void finishFunction(Parser* parser, ObjFunction* function) {
+  Chunk* chunk = &function->chunk;
+  for (int i = 0; i < chunk->constants.count; ++i) {
+    if (IS_FUNCTION(chunk->constants.values[i])) {
+      finishFunction(parser, AS_FUNCTION(chunk->constants.values[i]));
+    }
+  }
+
+  const char* name =
+      function->name != NULL ? function->name->chars : "<script>";
+  optimizeChunk(parser->ferr, parser->gc, chunk, name);
+  // The script has to run in a frame of its own.
+  if (function->name != NULL) {
+    findInline(function);
+  }
+
+  // GCOV_EXCL_START
+  if (debugPrintCode) {
+    disassembleChunk(parser->ferr, chunk, name);
+  }
+  // GCOV_EXCL_STOP
+}
+
 static ObjFunction* endCompiler(Parser* parser) {
   emitReturn(parser);
   ObjFunction* function = parser->currentCompiler->function;
 
-  // GCOV_EXCL_START
-  if (debugPrintCode && !parser->hadError) {
-    disassembleChunk(parser->ferr, currentChunk(parser),
-        function->name != NULL ? function->name->chars : "<script>");
+  // A loop may be compiled more than once, dropping the functions made
+  // the first time, so wait for the whole script to finish any.
+  if (parser->currentCompiler->enclosing == NULL && !parser->hadError) {
+    finishFunction(parser, function);
   }
-  // GCOV_EXCL_STOP
 
+  freeDict(parser->gc, &parser->currentCompiler->constants);
   parser->currentCompiler = parser->currentCompiler->enclosing;
   return function;
 }
@@ -297,8 +549,7 @@ static void endScope(Parser* parser) {
   }
 }
 
-static bool parsePrecedence(
-    Parser* parser, Precedence precedence, bool stopForSoleConst);
+static void parsePrecedence(Parser* parser, Precedence precedence);
 static ParseRule* getRule(TokenType type);
 static void expression(Parser* parser);
 static void declaration(Parser* parser);
@@ -312,6 +563,50 @@ static uint16_t identifierConstant(Parser* parser, Token* name) {
           parser->gc, parser->strings, name->start, name->length)));
 }
 
+// Return the PureNative whose name is chars, or -1 if there isn't one.
+static int pureNativeIndex(const char* chars, int length) {
+  for (int i = 0; i < PURE_NATIVE_COUNT; ++i) {
+    if ((size_t)length == strlen(pureNativeNames[i]) &&
+        memcmp(chars, pureNativeNames[i], (size_t)length) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Return the slot of the global variable named name, adding one if
+// there isn't one yet.
+static uint16_t globalSlot(Parser* parser, Token* name) {
+  ObjString* string = copyString(
+      parser->gc, parser->strings, name->start, name->length);
+  Value slot;
+  if (tableGet(parser->globals, string, &slot)) {
+    return (uint16_t)AS_NUMBER(slot);
+  }
+
+  int newSlot = parser->globalSlots->count;
+  // GCOV_EXCL_START
+  if (newSlot > UINT16_MAX) {
+    error(parser, "Too many global variables.");
+    return 0;
+  }
+  // GCOV_EXCL_STOP
+
+  pushTemp(parser->gc, OBJ_VAL(string));
+  writeValueArray(parser->gc, parser->globalSlots, EMPTY_VAL);
+  tableSet(parser->gc, parser->globals, string,
+      NUMBER_VAL((double)newSlot));
+  popTemp(parser->gc);
+
+  // resolvePureNatives() only finds natives defined before compiling,
+  // so record the slot of any the source reaches first.
+  int native = pureNativeIndex(name->start, name->length);
+  if (native >= 0 && !(parser->reboundNatives & (1 << native))) {
+    parser->pureNativeSlots[native] = newSlot;
+  }
+  return (uint16_t)newSlot;
+}
+
 static bool identifiersEqual(Token* a, Token* b) {
   if (a->length != b->length) {
     return false;
@@ -391,6 +686,43 @@ static void addLocal(Parser* parser, Token name) {
   local->name = name;
   local->depth = -1;
   local->isCaptured = false;
+  local->isNumber = false;
+}
+
+// A closure could store anything in a captured local at any time.
+static bool localIsNumber(Local* local) {
+  return local->isNumber && !local->isCaptured;
+}
+
+static void saveTypes(Parser* parser, LocalTypes* types) {
+  Compiler* compiler = parser->currentCompiler;
+  for (int i = 0; i < compiler->localCount; ++i) {
+    types->isNumber[i] = localIsNumber(&compiler->locals[i]);
+  }
+  types->count = compiler->localCount;
+}
+
+// Locals declared since types were saved are left alone.
+static int savedLocals(Parser* parser, const LocalTypes* types) {
+  int count = parser->currentCompiler->localCount;
+  return types->count < count ? types->count : count;
+}
+
+static void restoreTypes(Parser* parser, const LocalTypes* types) {
+  Compiler* compiler = parser->currentCompiler;
+  for (int i = 0; i < savedLocals(parser, types); ++i) {
+    compiler->locals[i].isNumber = types->isNumber[i];
+  }
+}
+
+// Where another path with the given types joins the current one, keep
+// only the locals that are numbers on both.
+static void mergeTypes(Parser* parser, const LocalTypes* types) {
+  Compiler* compiler = parser->currentCompiler;
+  for (int i = 0; i < savedLocals(parser, types); ++i) {
+    compiler->locals[i].isNumber =
+        localIsNumber(&compiler->locals[i]) && types->isNumber[i];
+  }
 }
 
 static void declareVariable(Parser* parser) {
@@ -423,7 +755,7 @@ static uint16_t parseVariable(
     return 0;
   }
 
-  return identifierConstant(parser, &parser->previous);
+  return globalSlot(parser, &parser->previous);
 }
 
 static void markInitialized(Parser* parser) {
@@ -441,7 +773,125 @@ static void defineVariable(Parser* parser, uint16_t global) {
     return;
   }
 
-  emitOpShort(parser, OP_DEFINE_GLOBAL, global);
+  emitOpShort(parser, OP_DEFINE_GLOBAL_I, global);
+}
+
+static bool sameVariable(LoopAccess* a, LoopAccess* b) {
+  return a->isLocal == b->isLocal && a->slot == b->slot;
+}
+
+static bool sameAccess(LoopAccess* a, LoopAccess* b) {
+  if (a->type != b->type) {
+    return false;
+  }
+  switch (a->type) {
+    case ACCESS_GET:
+      return sameVariable(a, b) && identifiersEqual(&a->name, &b->name);
+    case ACCESS_ASSIGN: return sameVariable(a, b);
+    case ACCESS_SET: return identifiersEqual(&a->name, &b->name);
+  }
+  return false; // GCOV_EXCL_LINE: Unreachable.
+}
+
+// Note access in the loops being compiled, except in those it can't
+// matter to: locals declared in a loop are new each time around it.
+static void recordAccess(Parser* parser, LoopAccess access) {
+  for (LoopStart* loop = parser->currentCompiler->loop; loop != NULL;
+       loop = loop->enclosing) {
+    if (access.type != ACCESS_SET && access.isLocal &&
+        access.slot >= loop->localCount) {
+      continue;
+    }
+    bool seen = false;
+    for (int i = 0; i < loop->accessCount && !seen; ++i) {
+      seen = sameAccess(&loop->accesses[i], &access);
+    }
+    if (seen) {
+      continue;
+    } else if (loop->accessCount == LOOP_ACCESSES) {
+      loop->writesAny = true;
+    } else {
+      loop->accesses[loop->accessCount++] = access;
+    }
+  }
+}
+
+// Note that the loops being compiled may change any field, such as by
+// calling code that could do anything.
+static void recordWritesAny(Parser* parser) {
+  for (LoopStart* loop = parser->currentCompiler->loop; loop != NULL;
+       loop = loop->enclosing) {
+    loop->writesAny = true;
+  }
+}
+
+// Return the hidden local a loop being compiled caches read in, or -1
+// if none does.
+static int hoistedLocal(Parser* parser, LoopAccess* read) {
+  for (LoopStart* loop = parser->currentCompiler->loop; loop != NULL;
+       loop = loop->enclosing) {
+    for (int i = 0; i < loop->hoistCount; ++i) {
+      if (sameAccess(&loop->hoists[i].read, read)) {
+        return loop->hoists[i].local;
+      }
+    }
+  }
+  return -1;
+}
+
+// If the code from start to the end of the chunk just loads a local or
+// global variable, store which in access and return true.
+static bool variableLoad(
+    Parser* parser, int start, LoopAccess* access) {
+  Chunk* chunk = currentChunk(parser);
+  int length = chunk->count - start;
+  if (length == 2 && chunk->code[start] == OP_GET_LOCAL) {
+    access->isLocal = true;
+    access->slot = chunk->code[start + 1];
+  } else if (length == 3 && chunk->code[start] == OP_GET_GLOBAL_I) {
+    access->isLocal = false;
+    access->slot =
+        (chunk->code[start + 1] << 8) | chunk->code[start + 2];
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Emit a read of property name, with the given constant, of the value
+// loaded by the code from receiverStart. If a loop hoists the read, it
+// comes from the hidden local the loop caches it in once it's filled.
+static void getProperty(
+    Parser* parser, int receiverStart, Token name, uint16_t constant) {
+  LoopAccess read = { ACCESS_GET, false, 0, name };
+  if (parser->currentCompiler->loop == NULL ||
+      !variableLoad(parser, receiverStart, &read)) {
+    emitOpShort(parser, OP_GET_PROPERTY, constant);
+    return;
+  }
+  int local = hoistedLocal(parser, &read);
+  if (local == -1) {
+    recordAccess(parser, read);
+    emitOpShort(parser, OP_GET_PROPERTY, constant);
+    return;
+  }
+
+  // The constant for the name comes after the receiver's code, so only
+  // the code is rewound.
+  Chunk* chunk = currentChunk(parser);
+  uint8_t receiver[3];
+  int length = chunk->count - receiverStart;
+  memcpy(receiver, &chunk->code[receiverStart], (size_t)length);
+  chunk->count = receiverStart;
+  emitBytes(parser, OP_GET_HOISTED, (uint8_t)local);
+  emitBytes(parser, 0xff, 0xff);
+  int jump = chunk->count - 2;
+  for (int i = 0; i < length; ++i) {
+    emitByte(parser, receiver[i]);
+  }
+  emitOpShort(parser, OP_HOIST_PROPERTY, constant);
+  emitByte(parser, (uint8_t)local);
+  patchJump(parser, jump);
 }
 
 static uint8_t argumentList(Parser* parser) {
@@ -465,103 +915,346 @@ static uint8_t argumentList(Parser* parser) {
 static void and_(Parser* parser, bool canAssign) {
   (void)canAssign;
 
+  ChunkMark leftMark = parser->leftMark;
+  Value left;
+  if (constantLoad(
+          parser, leftMark.code, currentChunk(parser)->count, &left)) {
+    // Keep only the operand that decides the result.
+    ChunkMark rightMark = markChunk(parser);
+    if (!isFalsey(left)) {
+      rewindChunk(parser, leftMark);
+    }
+    LocalTypes types;
+    saveTypes(parser, &types);
+    parsePrecedence(parser, PREC_AND);
+    if (isFalsey(left)) {
+      rewindChunk(parser, rightMark);
+      restoreTypes(parser, &types);
+    }
+    return;
+  }
+
   int endJump = emitJump(parser, OP_JUMP_IF_FALSE);
+  LocalTypes types;
+  saveTypes(parser, &types);
 
   emitByte(parser, OP_POP);
-  parsePrecedence(parser, PREC_AND, false);
+  parsePrecedence(parser, PREC_AND);
 
+  mergeTypes(parser, &types);
   patchJump(parser, endJump);
-}
+  // The result may be the left operand.
+  parser->currentCompiler->numberEnd = -1;
+}
+
+// Compute a op b as the VM would into result, or return false if that
+// would be a runtime error, which is left for run time to report.
+static bool foldBinary(Parser* parser, TokenType operatorType, Value a,
+    Value b, Value* result) {
+  if (operatorType == TOKEN_EQUAL_EQUAL) {
+    *result = BOOL_VAL(valuesEqual(a, b));
+    return true;
+  } else if (operatorType == TOKEN_BANG_EQUAL) {
+    *result = BOOL_VAL(!valuesEqual(a, b));
+    return true;
+  } else if (operatorType == TOKEN_PLUS && IS_STRING(a) &&
+      IS_STRING(b)) {
+    ObjString* aStr = AS_STRING(a);
+    ObjString* bStr = AS_STRING(b);
+    *result = OBJ_VAL(concatStrings(parser->gc, parser->strings,
+        aStr->chars, aStr->length, aStr->hash, bStr->chars,
+        bStr->length));
+    return true;
+  } else if (!IS_NUMBER(a) || !IS_NUMBER(b)) {
+    return false;
+  }
 
-static void binary(Parser* parser, bool canAssign) {
-  (void)canAssign;
+  double x = AS_NUMBER(a);
+  double y = AS_NUMBER(b);
+  switch (operatorType) {
+    // Like the VM, >= and <= are the negations of < and >.
+    case TOKEN_GREATER: *result = BOOL_VAL(x > y); break;
+    case TOKEN_GREATER_EQUAL: *result = BOOL_VAL(!(x < y)); break;
+    case TOKEN_LESS: *result = BOOL_VAL(x < y); break;
+    case TOKEN_LESS_EQUAL: *result = BOOL_VAL(!(x > y)); break;
+    case TOKEN_PLUS: *result = NUMBER_VAL(x + y); break;
+    case TOKEN_MINUS: *result = NUMBER_VAL(x - y); break;
+    case TOKEN_STAR: *result = NUMBER_VAL(x * y); break;
+    case TOKEN_SLASH: *result = NUMBER_VAL(x / y); break;
+    case TOKEN_PERCENT: *result = NUMBER_VAL(fmod(x, y)); break;
+    default: return false; // GCOV_EXCL_LINE: Unreachable.
+  }
+  return true;
+}
 
-  TokenType operatorType = parser->previous.type;
-  ParseRule* rule = getRule(operatorType);
-  if (!parsePrecedence(
-          parser, (Precedence)(rule->precedence + 1), true)) {
-    TokenType prevType = parser->previous.type;
-    ParseFn prefixRule = NULL;
-    if (prevType == TOKEN_NUMBER) {
-      double value = strtod(parser->previous.start, NULL);
-      switch (operatorType) {
-        case TOKEN_GREATER_EQUAL:
-          emitOpShort(parser, OP_LESS_C,
-              makeConstant(parser, NUMBER_VAL(value)));
-          emitByte(parser, OP_NOT);
-          break;
-        case TOKEN_LESS:
-          emitOpShort(parser, OP_LESS_C,
-              makeConstant(parser, NUMBER_VAL(value)));
-          break;
-        case TOKEN_PLUS:
-          emitOpShort(parser, OP_ADD_C,
-              makeConstant(parser, NUMBER_VAL(value)));
-          break;
-        case TOKEN_MINUS:
-          emitOpShort(parser, OP_SUBTRACT_C,
-              makeConstant(parser, NUMBER_VAL(value)));
-          break;
-        default: prefixRule = getRule(prevType)->prefix;
-      }
-    } else if (prevType == TOKEN_STRING) {
-      if (operatorType == TOKEN_PLUS) {
-        ObjString* str = copyString(parser->gc, parser->strings,
-            parser->previous.start + 1, parser->previous.length - 2);
-        pushTemp(parser->gc, OBJ_VAL(str));
-        emitOpShort(
-            parser, OP_ADD_C, makeConstant(parser, OBJ_VAL(str)));
-        popTemp(parser->gc);
-      } else {
-        prefixRule = getRule(prevType)->prefix;
-      }
-    } else {
-      prefixRule = getRule(prevType)->prefix;
+// Emit the operator instruction for operands compiled from leftMark
+// and rightMark to the end of the chunk, folding them if they're both
+// constants.
+static void emitBinary(Parser* parser, TokenType operatorType,
+    ChunkMark leftMark, bool leftNumber, ChunkMark rightMark) {
+  bool rightNumber = numberResult(parser);
+  // Operands known to be numbers can skip the type checks.
+  bool numbers = leftNumber && rightNumber;
+
+  Value right;
+  if (constantLoad(parser, rightMark.code, currentChunk(parser)->count,
+          &right)) {
+    Value left;
+    Value result;
+    if (constantLoad(parser, leftMark.code, rightMark.code, &left) &&
+        foldBinary(parser, operatorType, left, right, &result)) {
+      emitFolded(parser, leftMark, result);
+      return;
     }
 
-    if (prefixRule != NULL) {
-      prefixRule(parser, false);
-    } else {
+    // Take a constant right operand from the instruction itself.
+    OpCode op;
+    switch (operatorType) {
+      case TOKEN_GREATER_EQUAL: op = OP_LESS_C; break;
+      case TOKEN_LESS: op = numbers ? OP_LESS_C_NN : OP_LESS_C; break;
+      case TOKEN_PLUS: op = numbers ? OP_ADD_C_NN : OP_ADD_C; break;
+      case TOKEN_MINUS:
+        op = numbers ? OP_SUBTRACT_C_NN : OP_SUBTRACT_C;
+        break;
+      default: op = OP_RETURN;
+    }
+    if (op != OP_RETURN &&
+        (IS_NUMBER(right) || (op == OP_ADD_C && IS_STRING(right)))) {
+      pushTemp(parser->gc, right);
+      rewindChunk(parser, rightMark);
+      emitOpShort(parser, op, makeConstant(parser, right));
+      popTemp(parser->gc);
+      if (operatorType == TOKEN_GREATER_EQUAL) {
+        emitByte(parser, OP_NOT);
+      } else if (operatorType != TOKEN_LESS && IS_NUMBER(right)) {
+        markNumber(parser);
+      }
       return;
     }
   }
 
+  // >= and <= keep the checked ops, which fuse with OP_NOT.
   switch (operatorType) {
     case TOKEN_BANG_EQUAL: emitBytes(parser, OP_EQUAL, OP_NOT); break;
     case TOKEN_EQUAL_EQUAL: emitByte(parser, OP_EQUAL); break;
-    case TOKEN_GREATER: emitByte(parser, OP_GREATER); break;
+    case TOKEN_GREATER:
+      emitByte(parser, numbers ? OP_GREATER_NN : OP_GREATER);
+      break;
     case TOKEN_GREATER_EQUAL: emitBytes(parser, OP_LESS, OP_NOT); break;
-    case TOKEN_LESS: emitByte(parser, OP_LESS); break;
+    case TOKEN_LESS:
+      emitByte(parser, numbers ? OP_LESS_NN : OP_LESS);
+      break;
     case TOKEN_LESS_EQUAL: emitBytes(parser, OP_GREATER, OP_NOT); break;
-    case TOKEN_PLUS: emitByte(parser, OP_ADD); break;
-    case TOKEN_MINUS: emitByte(parser, OP_SUBTRACT); break;
-    case TOKEN_STAR: emitByte(parser, OP_MULTIPLY); break;
-    case TOKEN_SLASH: emitByte(parser, OP_DIVIDE); break;
-    case TOKEN_PERCENT: emitByte(parser, OP_MODULO); break;
+    case TOKEN_PLUS:
+      emitByte(parser, numbers ? OP_ADD_NN : OP_ADD);
+      // Adding a number to anything but a number is an error.
+      if (leftNumber || rightNumber) {
+        markNumber(parser);
+      }
+      break;
+    case TOKEN_MINUS:
+      emitByte(parser, numbers ? OP_SUBTRACT_NN : OP_SUBTRACT);
+      markNumber(parser);
+      break;
+    case TOKEN_STAR:
+      emitByte(parser, numbers ? OP_MULTIPLY_NN : OP_MULTIPLY);
+      markNumber(parser);
+      break;
+    case TOKEN_SLASH:
+      emitByte(parser, numbers ? OP_DIVIDE_NN : OP_DIVIDE);
+      markNumber(parser);
+      break;
+    case TOKEN_PERCENT:
+      emitByte(parser, OP_MODULO);
+      markNumber(parser);
+      break;
     default: return; // GCOV_EXCL_LINE: Unreachable.
   }
 }
 
+static void binary(Parser* parser, bool canAssign) {
+  (void)canAssign;
+
+  ChunkMark leftMark = parser->leftMark;
+  bool leftNumber = numberResult(parser);
+  TokenType operatorType = parser->previous.type;
+  ParseRule* rule = getRule(operatorType);
+  ChunkMark rightMark = markChunk(parser);
+  parsePrecedence(parser, (Precedence)(rule->precedence + 1));
+  emitBinary(parser, operatorType, leftMark, leftNumber, rightMark);
+}
+
+// If the next token is a compound assignment operator like +=, consume
+// it and return the type of the operator it applies, else TOKEN_EOF.
+static TokenType matchCompound(Parser* parser) {
+  TokenType operatorType;
+  switch (parser->current.type) {
+    case TOKEN_MINUS_EQUAL: operatorType = TOKEN_MINUS; break;
+    case TOKEN_PERCENT_EQUAL: operatorType = TOKEN_PERCENT; break;
+    case TOKEN_PLUS_EQUAL: operatorType = TOKEN_PLUS; break;
+    case TOKEN_SLASH_EQUAL: operatorType = TOKEN_SLASH; break;
+    case TOKEN_STAR_EQUAL: operatorType = TOKEN_STAR; break;
+    default: return TOKEN_EOF;
+  }
+  advance(parser);
+  return operatorType;
+}
+
+// Return the op that applies operatorType to the element (if index is
+// true) or field read by OP_GET_INDEX_KEEP or OP_GET_PROPERTY_KEEP, and
+// stores the result back.
+static OpCode compoundOp(TokenType operatorType, bool index) {
+  switch (operatorType) {
+    case TOKEN_MINUS:
+      return index ? OP_SUBTRACT_INDEX : OP_SUBTRACT_PROPERTY;
+    case TOKEN_PERCENT:
+      return index ? OP_MODULO_INDEX : OP_MODULO_PROPERTY;
+    case TOKEN_PLUS: return index ? OP_ADD_INDEX : OP_ADD_PROPERTY;
+    case TOKEN_SLASH:
+      return index ? OP_DIVIDE_INDEX : OP_DIVIDE_PROPERTY;
+    default: return index ? OP_MULTIPLY_INDEX : OP_MULTIPLY_PROPERTY;
+  }
+}
+
+// Return a bit set of the pure natives whose names the source defines
+// or assigns anywhere, since calling those names may not reach the
+// natives.
+static int scanReboundNatives(const char* source) {
+  bool mentioned = false;
+  for (int i = 0; i < PURE_NATIVE_COUNT; ++i) {
+    mentioned |= strstr(source, pureNativeNames[i]) != NULL;
+  }
+  if (!mentioned) {
+    return 0;
+  }
+
+  int rebound = 0;
+  Scanner scanner;
+  initScanner(&scanner, source);
+  TokenType prevType = TOKEN_EOF;
+  Token token = scanToken(&scanner);
+  while (token.type != TOKEN_EOF) {
+    Token next = scanToken(&scanner);
+    if (token.type == TOKEN_IDENTIFIER &&
+        (prevType == TOKEN_VAR || prevType == TOKEN_FUN ||
+            prevType == TOKEN_CLASS || next.type == TOKEN_EQUAL)) {
+      int native = pureNativeIndex(token.start, token.length);
+      if (native >= 0) {
+        rebound |= 1 << native;
+      }
+    }
+    prevType = token.type;
+    token = next;
+  }
+  return rebound;
+}
+
+// Store the global slot of each pure native that the source doesn't
+// rebind, or -1 if it does, so foldCall() can compare slot numbers.
+static void resolvePureNatives(Parser* parser) {
+  for (int i = 0; i < PURE_NATIVE_COUNT; ++i) {
+    parser->pureNativeSlots[i] = -1;
+    if (parser->reboundNatives & (1 << i)) {
+      continue;
+    }
+    const char* chars = pureNativeNames[i];
+    ObjString* name = copyString(
+        parser->gc, parser->strings, chars, (int)strlen(chars));
+    Value slot;
+    if (tableGet(parser->globals, name, &slot)) {
+      parser->pureNativeSlots[i] = (int)AS_NUMBER(slot);
+    }
+  }
+}
+
+// If the code from calleeStart to argStart loads a pure native and the
+// code after that loads a constant argument it accepts, store the
+// result of the call in result and return true.
+static bool foldCall(
+    Parser* parser, int calleeStart, int argStart, Value* result) {
+  Chunk* chunk = currentChunk(parser);
+  Value arg;
+  if (argStart - calleeStart != 3 ||
+      chunk->code[calleeStart] != OP_GET_GLOBAL_I ||
+      !constantLoad(parser, argStart, chunk->count, &arg) ||
+      !IS_NUMBER(arg)) {
+    return false;
+  }
+
+  uint16_t slot = (uint16_t)(chunk->code[calleeStart + 1] << 8);
+  slot |= chunk->code[calleeStart + 2];
+  int native = 0;
+  while (native < PURE_NATIVE_COUNT &&
+      parser->pureNativeSlots[native] != slot) {
+    native++;
+  }
+  if (native == PURE_NATIVE_COUNT) {
+    return false;
+  }
+
+  double num = AS_NUMBER(arg);
+  switch ((PureNative)native) {
+    case PURE_CEIL: *result = NUMBER_VAL(ceil(num)); break;
+    case PURE_CHR: {
+      if (num < (double)CHAR_MIN || num > (double)CHAR_MAX ||
+          (double)(char)num != num) {
+        return false;
+      }
+      char c = (char)num;
+      *result =
+          OBJ_VAL(copyString(parser->gc, parser->strings, &c, 1));
+      break;
+    }
+    case PURE_FLOOR: *result = NUMBER_VAL(floor(num)); break;
+    case PURE_ROUND: *result = NUMBER_VAL(round(num)); break;
+    default: return false; // GCOV_EXCL_LINE: Unreachable.
+  }
+  return true;
+}
+
 static void call(Parser* parser, bool canAssign) {
   (void)canAssign;
 
+  ChunkMark calleeMark = parser->leftMark;
+  int argStart = currentChunk(parser)->count;
   uint8_t argCount = argumentList(parser);
+  Value result;
+  if (argCount == 1 &&
+      foldCall(parser, calleeMark.code, argStart, &result)) {
+    emitFolded(parser, calleeMark, result);
+    return;
+  }
   emitBytes(parser, OP_CALL, argCount);
+  recordWritesAny(parser);
 }
 
 static void dot(Parser* parser, bool canAssign) {
+  int receiverStart = parser->leftMark.code;
   consume(parser, TOKEN_IDENTIFIER, "Expect property name after '.'.");
-  uint16_t name = identifierConstant(parser, &parser->previous);
-
-  if (canAssign && match(parser, TOKEN_EQUAL)) {
+  Token nameToken = parser->previous;
+  uint16_t name = identifierConstant(parser, &nameToken);
+
+  TokenType compound = canAssign ? matchCompound(parser) : TOKEN_EOF;
+  if (canAssign &&
+      (compound != TOKEN_EOF || match(parser, TOKEN_EQUAL))) {
+    if (compound != TOKEN_EOF) {
+      // Read the field before the right-hand side can change it.
+      emitOpShort(parser, OP_GET_PROPERTY_KEEP, name);
+    }
     expression(parser);
-    emitOpShort(parser, OP_SET_PROPERTY, name);
+    emitOpShort(parser,
+        compound != TOKEN_EOF ? compoundOp(compound, false)
+                              : OP_SET_PROPERTY,
+        name);
+    LoopAccess set = { ACCESS_SET, false, 0, nameToken };
+    recordAccess(parser, set);
   } else if (match(parser, TOKEN_LEFT_PAREN)) {
     uint8_t argCount = argumentList(parser);
     emitOpShort(parser, OP_INVOKE, name);
     emitByte(parser, argCount);
+    recordWritesAny(parser);
   } else {
-    emitOpShort(parser, OP_GET_PROPERTY, name);
+    getProperty(parser, receiverStart, nameToken, name);
   }
 }
 
@@ -571,18 +1264,72 @@ static void lambda(Parser* parser, bool canAssign) {
   function(parser, TYPE_FUNCTION, "()", 2);
 }
 
+// Most values OP_LIST_BUILD and friends take off the stack at once.
+#define LITERAL_BATCH 255
+
+// If the code from start to the end of the chunk just loads a constant,
+// append the constant to values and return true.
+static bool loadsConstant(
+    Parser* parser, int start, ValueArray* values) {
+  Value value;
+  if (!constantLoad(
+          parser, start, currentChunk(parser)->count, &value)) {
+    return false;
+  }
+  writeValueArray(parser->gc, values, value);
+  return true;
+}
+
+// Emit the op that collects the last count list elements or map pairs
+// from the stack, into a new container if built is false, else into
+// the one below them.
+static void emitBatch(Parser* parser, OpCode buildOp, OpCode dataOp,
+    int count, bool* built) {
+  emitBytes(parser, *built ? dataOp : buildOp, (uint8_t)count);
+  *built = true;
+}
+
 static void list(Parser* parser, bool canAssign) {
   (void)canAssign;
 
-  emitByte(parser, OP_LIST_INIT);
+  // Constant elements are gathered in case they all are, so the list
+  // can be copied from a template instead of built element by element.
+  ChunkMark start = markChunk(parser);
+  ValueArray constants;
+  initValueArray(&constants);
+  bool allConstant = true;
+  bool built = false;
+  int batch = 0;
   do {
     if (check(parser, TOKEN_RIGHT_SQUARE)) {
       break;
     }
+    int elementStart = currentChunk(parser)->count;
     expression(parser);
-    emitByte(parser, OP_LIST_DATA);
+    allConstant =
+        allConstant && loadsConstant(parser, elementStart, &constants);
+    if (++batch == LITERAL_BATCH) {
+      emitBatch(parser, OP_LIST_BUILD, OP_LIST_DATA, batch, &built);
+      batch = 0;
+    }
   } while (match(parser, TOKEN_COMMA));
   consume(parser, TOKEN_RIGHT_SQUARE, "Expect ']' after list.");
+
+  if (allConstant && constants.count > 0) {
+    ObjList* template = newList(parser->gc);
+    pushTemp(parser->gc, OBJ_VAL(template));
+    reserveValueArray(parser->gc, &template->elements, constants.count);
+    memcpy(template->elements.values, constants.values,
+        sizeof(Value) * (size_t)constants.count);
+    template->elements.count = constants.count;
+    rewindChunk(parser, start);
+    uint16_t constant = makeConstant(parser, OBJ_VAL(template));
+    emitOpShort(parser, OP_LIST_TEMPLATE, constant);
+    popTemp(parser->gc);
+  } else if (batch > 0 || !built) {
+    emitBatch(parser, OP_LIST_BUILD, OP_LIST_DATA, batch, &built);
+  }
+  freeValueArray(parser->gc, &constants);
 }
 
 static void literal(Parser* parser, bool canAssign) {
@@ -607,9 +1354,18 @@ static void index_(Parser* parser, bool canAssign) {
   expression(parser);
   consume(parser, TOKEN_RIGHT_SQUARE, "Expect ']' after expression.");
 
-  if (canAssign && match(parser, TOKEN_EQUAL)) {
+  TokenType compound = canAssign ? matchCompound(parser) : TOKEN_EOF;
+  if (canAssign &&
+      (compound != TOKEN_EOF || match(parser, TOKEN_EQUAL))) {
+    if (compound != TOKEN_EOF) {
+      emitByte(parser, OP_GET_INDEX_KEEP);
+    }
     expression(parser);
-    emitByte(parser, OP_SET_INDEX);
+    emitByte(parser, compound != TOKEN_EOF ? compoundOp(compound, true)
+                                           : OP_SET_INDEX);
+    // It sets a field if the key is a string and the object an
+    // instance.
+    recordWritesAny(parser);
   } else {
     emitByte(parser, OP_GET_INDEX);
   }
@@ -618,11 +1374,18 @@ static void index_(Parser* parser, bool canAssign) {
 static void map(Parser* parser, bool canAssign) {
   (void)canAssign;
 
-  emitByte(parser, OP_MAP_INIT);
+  // Like list(), with constants holding alternating keys and values.
+  ChunkMark start = markChunk(parser);
+  ValueArray constants;
+  initValueArray(&constants);
+  bool allConstant = true;
+  bool built = false;
+  int batch = 0;
   do {
     if (check(parser, TOKEN_RIGHT_BRACE)) {
       break;
     }
+    int keyStart = currentChunk(parser)->count;
     if (match(parser, TOKEN_LEFT_SQUARE)) {
       expression(parser);
       consume(
@@ -632,31 +1395,80 @@ static void map(Parser* parser, bool canAssign) {
       uint16_t constant = identifierConstant(parser, &parser->previous);
       emitOpShort(parser, OP_CONSTANT, constant);
     }
+    allConstant =
+        allConstant && loadsConstant(parser, keyStart, &constants);
     consume(parser, TOKEN_COLON, "Expect ':' after map key.");
+    int valueStart = currentChunk(parser)->count;
     expression(parser);
-    emitByte(parser, OP_MAP_DATA);
+    allConstant =
+        allConstant && loadsConstant(parser, valueStart, &constants);
+    if (++batch == LITERAL_BATCH) {
+      emitBatch(parser, OP_MAP_BUILD, OP_MAP_DATA, batch, &built);
+      batch = 0;
+    }
   } while (match(parser, TOKEN_COMMA));
   consume(parser, TOKEN_RIGHT_BRACE, "Expect '}' after map.");
+
+  if (allConstant && constants.count > 0) {
+    ObjMap* template = newMap(parser->gc);
+    pushTemp(parser->gc, OBJ_VAL(template));
+    dictReserve(parser->gc, &template->dict, constants.count / 2);
+    for (int i = 0; i < constants.count; i += 2) {
+      dictSet(parser->gc, &template->dict, constants.values[i],
+          constants.values[i + 1]);
+    }
+    rewindChunk(parser, start);
+    uint16_t constant = makeConstant(parser, OBJ_VAL(template));
+    emitOpShort(parser, OP_MAP_TEMPLATE, constant);
+    popTemp(parser->gc);
+  } else if (batch > 0 || !built) {
+    emitBatch(parser, OP_MAP_BUILD, OP_MAP_DATA, batch, &built);
+  }
+  freeValueArray(parser->gc, &constants);
 }
 
 static void number(Parser* parser, bool canAssign) {
   (void)canAssign;
 
-  double value = strtod(parser->previous.start, NULL);
+  double value = parseNumber(parser->previous.start, NULL);
   emitConstant(parser, NUMBER_VAL(value));
 }
 
 static void or_(Parser* parser, bool canAssign) {
   (void)canAssign;
 
+  ChunkMark leftMark = parser->leftMark;
+  Value left;
+  if (constantLoad(
+          parser, leftMark.code, currentChunk(parser)->count, &left)) {
+    // Keep only the operand that decides the result.
+    ChunkMark rightMark = markChunk(parser);
+    if (isFalsey(left)) {
+      rewindChunk(parser, leftMark);
+    }
+    LocalTypes types;
+    saveTypes(parser, &types);
+    parsePrecedence(parser, PREC_OR);
+    if (!isFalsey(left)) {
+      rewindChunk(parser, rightMark);
+      restoreTypes(parser, &types);
+    }
+    return;
+  }
+
   int elseJump = emitJump(parser, OP_JUMP_IF_FALSE);
   int endJump = emitJump(parser, OP_JUMP);
+  LocalTypes types;
+  saveTypes(parser, &types);
 
   patchJump(parser, elseJump);
   emitByte(parser, OP_POP);
 
-  parsePrecedence(parser, PREC_OR, false);
+  parsePrecedence(parser, PREC_OR);
+  mergeTypes(parser, &types);
   patchJump(parser, endJump);
+  // The result may be the left operand.
+  parser->currentCompiler->numberEnd = -1;
 }
 
 static void string(Parser* parser, bool canAssign) {
@@ -669,6 +1481,35 @@ static void string(Parser* parser, bool canAssign) {
   popTemp(parser->gc);
 }
 
+// If the code from start to the end of the chunk adds a constant to
+// the number in local slot, or subtracts one from it, rewrite it to
+// change the local in place and then load it.
+static bool emitIncrement(Parser* parser, ChunkMark mark, int slot) {
+  Chunk* chunk = currentChunk(parser);
+  int start = mark.code;
+  if (chunk->count - start != 5 || chunk->code[start] != OP_GET_LOCAL ||
+      chunk->code[start + 1] != slot ||
+      (chunk->code[start + 2] != OP_ADD_C_NN &&
+          chunk->code[start + 2] != OP_SUBTRACT_C_NN)) {
+    return false;
+  }
+
+  uint16_t constant = (uint16_t)(chunk->code[start + 3] << 8);
+  constant |= chunk->code[start + 4];
+  double step = AS_NUMBER(chunk->constants.values[constant]);
+  if (chunk->code[start + 2] == OP_SUBTRACT_C_NN) {
+    // a - b is a + -b exactly.
+    step = -step;
+  }
+  rewindChunk(parser, mark);
+  constant = makeConstant(parser, NUMBER_VAL(step));
+  emitBytes(parser, OP_INC_LOCAL, (uint8_t)slot);
+  emitBytes(
+      parser, (uint8_t)(constant >> 8), (uint8_t)(constant & 0xff));
+  emitBytes(parser, OP_GET_LOCAL, (uint8_t)slot);
+  return true;
+}
+
 static void namedVariable(Parser* parser, Token name, bool canAssign) {
   uint8_t getOp, setOp;
   int arg = resolveLocal(parser, parser->currentCompiler, &name);
@@ -680,24 +1521,57 @@ static void namedVariable(Parser* parser, Token name, bool canAssign) {
     getOp = OP_GET_UPVALUE;
     setOp = OP_SET_UPVALUE;
   } else {
-    arg = identifierConstant(parser, &name);
-    getOp = OP_GET_GLOBAL;
-    setOp = OP_SET_GLOBAL;
-  }
-
-  if (canAssign && match(parser, TOKEN_EQUAL)) {
-    expression(parser);
-    if (setOp == OP_SET_GLOBAL) {
-      emitOpShort(parser, setOp, (uint16_t)arg);
-    } else {
-      emitBytes(parser, setOp, (uint8_t)arg);
-    }
-  } else {
-    if (getOp == OP_GET_GLOBAL) {
+    arg = globalSlot(parser, &name);
+    getOp = OP_GET_GLOBAL_I;
+    setOp = OP_SET_GLOBAL_I;
+  }
+
+  Local* local = getOp == OP_GET_LOCAL
+      ? &parser->currentCompiler->locals[arg]
+      : NULL;
+  ChunkMark valueMark = markChunk(parser);
+  TokenType compound = canAssign ? matchCompound(parser) : TOKEN_EOF;
+  if (compound == TOKEN_EOF &&
+      !(canAssign && match(parser, TOKEN_EQUAL))) {
+    if (getOp == OP_GET_GLOBAL_I) {
       emitOpShort(parser, getOp, (uint16_t)arg);
     } else {
       emitBytes(parser, getOp, (uint8_t)arg);
     }
+    if (local != NULL && localIsNumber(local)) {
+      markNumber(parser);
+    }
+    return;
+  }
+
+  if (compound != TOKEN_EOF) {
+    // Upvalues and global slots are as quick to reach twice as the
+    // operands of a fused op would be, so only locals get one.
+    namedVariable(parser, name, false);
+    bool leftNumber = numberResult(parser);
+    ChunkMark rightMark = markChunk(parser);
+    expression(parser);
+    emitBinary(parser, compound, valueMark, leftNumber, rightMark);
+  } else {
+    expression(parser);
+  }
+  bool isNumber = numberResult(parser);
+  if (local != NULL) {
+    local->isNumber = isNumber;
+  }
+  if (local != NULL && emitIncrement(parser, valueMark, arg)) {
+    // The new value is already loaded.
+  } else if (setOp == OP_SET_GLOBAL_I) {
+    emitOpShort(parser, setOp, (uint16_t)arg);
+  } else {
+    emitBytes(parser, setOp, (uint8_t)arg);
+  }
+  if (setOp != OP_SET_UPVALUE) {
+    LoopAccess assign = { ACCESS_ASSIGN, local != NULL, arg, name };
+    recordAccess(parser, assign);
+  }
+  if (isNumber) {
+    markNumber(parser);
   }
 }
 
@@ -731,6 +1605,7 @@ static void super_(Parser* parser, bool canAssign) {
     namedVariable(parser, syntheticToken("super"), false);
     emitOpShort(parser, OP_SUPER_INVOKE, name);
     emitByte(parser, argCount);
+    recordWritesAny(parser);
   } else {
     namedVariable(parser, syntheticToken("super"), false);
     emitOpShort(parser, OP_GET_SUPER, name);
@@ -754,12 +1629,30 @@ static void unary(Parser* parser, bool canAssign) {
   TokenType operatorType = parser->previous.type;
 
   // Compile the operand.
-  parsePrecedence(parser, PREC_UNARY, false);
+  ChunkMark operandMark = markChunk(parser);
+  parsePrecedence(parser, PREC_UNARY);
+
+  // Fold a constant operand unless it would be a runtime error.
+  Value operand;
+  if (constantLoad(parser, operandMark.code,
+          currentChunk(parser)->count, &operand)) {
+    if (operatorType == TOKEN_BANG) {
+      emitFolded(parser, operandMark, BOOL_VAL(isFalsey(operand)));
+      return;
+    } else if (IS_NUMBER(operand)) {
+      emitFolded(
+          parser, operandMark, NUMBER_VAL(-AS_NUMBER(operand)));
+      return;
+    }
+  }
 
   // Emit the operator instruction.
   switch (operatorType) {
     case TOKEN_BANG: emitByte(parser, OP_NOT); break;
-    case TOKEN_MINUS: emitByte(parser, OP_NEGATE); break;
+    case TOKEN_MINUS:
+      emitByte(parser, OP_NEGATE);
+      markNumber(parser);
+      break;
     default: return; // GCOV_EXCL_LINE: Unreachable.
   }
 }
@@ -789,6 +1682,11 @@ ParseRule rules[] = {
   [TOKEN_GREATER_EQUAL] = { NULL,     binary, PREC_COMPARISON },
   [TOKEN_LESS]          = { NULL,     binary, PREC_COMPARISON },
   [TOKEN_LESS_EQUAL]    = { NULL,     binary, PREC_COMPARISON },
+  [TOKEN_MINUS_EQUAL]   = { NULL,     NULL,   PREC_NONE },
+  [TOKEN_PERCENT_EQUAL] = { NULL,     NULL,   PREC_NONE },
+  [TOKEN_PLUS_EQUAL]    = { NULL,     NULL,   PREC_NONE },
+  [TOKEN_SLASH_EQUAL]   = { NULL,     NULL,   PREC_NONE },
+  [TOKEN_STAR_EQUAL]    = { NULL,     NULL,   PREC_NONE },
   [TOKEN_IDENTIFIER]    = { variable, NULL,   PREC_NONE },
   [TOKEN_STRING]        = { string,   NULL,   PREC_NONE },
   [TOKEN_NUMBER]        = { number,   NULL,   PREC_NONE },
@@ -813,35 +1711,29 @@ ParseRule rules[] = {
 };
 // clang-format on
 
-static bool parsePrecedence(
-    Parser* parser, Precedence precedence, bool stopForSoleConst) {
+static void parsePrecedence(Parser* parser, Precedence precedence) {
+  ChunkMark start = markChunk(parser);
   advance(parser);
   ParseFn prefixRule = getRule(parser->previous.type)->prefix;
   if (prefixRule == NULL) {
     error(parser, "Expect expression.");
-    return false;
+    return;
   }
 
-  bool soleConst = false;
   bool canAssign = precedence <= PREC_ASSIGNMENT;
-  if (!stopForSoleConst ||
-      precedence <= getRule(parser->current.type)->precedence) {
-    prefixRule(parser, canAssign);
-  } else {
-    soleConst = true;
-  }
+  prefixRule(parser, canAssign);
 
   while (precedence <= getRule(parser->current.type)->precedence) {
     advance(parser);
     ParseFn infixRule = getRule(parser->previous.type)->infix;
+    parser->leftMark = start;
     infixRule(parser, canAssign);
   }
 
-  if (canAssign && match(parser, TOKEN_EQUAL)) {
+  if (canAssign && (match(parser, TOKEN_EQUAL) ||
+                       matchCompound(parser) != TOKEN_EOF)) {
     error(parser, "Invalid assignment target.");
   }
-
-  return !soleConst;
 }
 
 static ParseRule* getRule(TokenType type) {
@@ -849,7 +1741,7 @@ static ParseRule* getRule(TokenType type) {
 }
 
 static void expression(Parser* parser) {
-  parsePrecedence(parser, PREC_ASSIGNMENT, false);
+  parsePrecedence(parser, PREC_ASSIGNMENT);
 }
 
 static void block(Parser* parser) {
@@ -915,13 +1807,12 @@ static void method(Parser* parser) {
 }
 
 static void classDeclaration(Parser* parser) {
-  consume(parser, TOKEN_IDENTIFIER, "Expect class name.");
+  uint16_t global = parseVariable(parser, "Expect class name.");
   Token className = parser->previous;
   uint16_t nameConstant = identifierConstant(parser, &parser->previous);
-  declareVariable(parser);
 
   emitOpShort(parser, OP_CLASS, nameConstant);
-  defineVariable(parser, nameConstant);
+  defineVariable(parser, global);
 
   ClassCompiler classCompiler;
   classCompiler.hasSuperclass = false;
@@ -969,85 +1860,414 @@ static void funDeclaration(Parser* parser) {
   defineVariable(parser, global);
 }
 
-static void varDeclaration(Parser* parser) {
-  uint16_t global = parseVariable(parser, "Expect variable name.");
-
+static void varInitializer(Parser* parser, uint16_t global) {
+  bool isNumber = false;
   if (match(parser, TOKEN_EQUAL)) {
     expression(parser);
+    isNumber = numberResult(parser);
   } else {
     emitByte(parser, OP_NIL);
   }
   consume(parser, TOKEN_SEMICOLON,
       "Expect ';' after variable declaration.");
 
+  Compiler* compiler = parser->currentCompiler;
+  if (compiler->scopeDepth > 0) {
+    compiler->locals[compiler->localCount - 1].isNumber = isNumber;
+  }
   defineVariable(parser, global);
 }
 
+static void varDeclaration(Parser* parser) {
+  uint16_t global = parseVariable(parser, "Expect variable name.");
+  varInitializer(parser, global);
+}
+
 static void expressionStatement(Parser* parser) {
   expression(parser);
   consume(parser, TOKEN_SEMICOLON, "Expect ';' after expression.");
   emitByte(parser, OP_POP);
 }
 
+// Loops are compiled assuming the locals that are numbers where they
+// start stay numbers through every pass. When that turns out wrong,
+// they're compiled again with fewer numbers, up to this many times for
+// all the loops in a script, after which loops assume no numbers. The
+// same budget covers compiling loops again to hoist property reads.
+#define LOOP_RETRIES 64
+
+static void startLoop(Parser* parser, LoopStart* loop) {
+  Compiler* compiler = parser->currentCompiler;
+  loop->enclosing = compiler->loop;
+  compiler->loop = loop;
+  loop->scanner = parser->scanner;
+  loop->current = parser->current;
+  loop->previous = parser->previous;
+  loop->mark = markChunk(parser);
+  loop->localCount = compiler->localCount;
+  if (parser->loopRetries >= LOOP_RETRIES) {
+    for (int i = 0; i < compiler->localCount; ++i) {
+      compiler->locals[i].isNumber = false;
+    }
+  }
+  saveTypes(parser, &loop->types);
+  loop->narrowed = false;
+  loop->accessCount = 0;
+  loop->writesAny = false;
+  loop->hoistCount = 0;
+  loop->planned = false;
+}
+
+static void endLoop(Parser* parser, LoopStart* loop) {
+  parser->currentCompiler->loop = loop->enclosing;
+}
+
+// Push a nil for each read the loop hoists, into a hidden local that
+// the first read in the loop fills in. Call it where each pass starts.
+static void emitHoists(Parser* parser, LoopStart* loop) {
+  for (int i = 0; i < loop->hoistCount; ++i) {
+    emitByte(parser, OP_NIL);
+    addLocal(parser, syntheticToken(""));
+    markInitialized(parser);
+    loop->hoists[i].local = parser->currentCompiler->localCount - 1;
+  }
+}
+
+// Where code jumps back to the start of the loop, drop the numbers it
+// assumed there that the locals aren't now.
+static void narrowLoop(Parser* parser, LoopStart* loop) {
+  Compiler* compiler = parser->currentCompiler;
+  for (int i = 0; i < loop->types.count; ++i) {
+    if (loop->types.isNumber[i] &&
+        !localIsNumber(&compiler->locals[i])) {
+      loop->types.isNumber[i] = false;
+      loop->narrowed = true;
+    }
+  }
+}
+
+// Hoist the property reads of variables that nothing in the loop may
+// change, which means the loop can't call any code, since nothing shows
+// what that code does. Return true if there are any.
+static bool planHoists(Parser* parser, LoopStart* loop) {
+  loop->planned = true;
+  if (loop->writesAny || parser->loopRetries >= LOOP_RETRIES) {
+    return false;
+  }
+  for (int i = 0; i < loop->accessCount; ++i) {
+    LoopAccess* read = &loop->accesses[i];
+    if (read->type != ACCESS_GET || loop->hoistCount == LOOP_HOISTS) {
+      continue;
+    }
+    bool changes = false;
+    for (int j = 0; j < loop->accessCount && !changes; ++j) {
+      LoopAccess* access = &loop->accesses[j];
+      changes = (access->type == ACCESS_ASSIGN &&
+                    sameVariable(access, read)) ||
+          (access->type == ACCESS_SET &&
+              identifiersEqual(&access->name, &read->name));
+    }
+    if (!changes) {
+      loop->hoists[loop->hoistCount++].read = *read;
+    }
+  }
+  return loop->hoistCount > 0;
+}
+
+// If the loop was compiled assuming too many numbers, or has reads to
+// hoist that the first pass found, go back to its start and return
+// true.
+static bool retryLoop(Parser* parser, LoopStart* loop) {
+  bool hoisting = !loop->planned && planHoists(parser, loop);
+  if ((!loop->narrowed && !hoisting) || parser->hadError) {
+    return false;
+  }
+  parser->scanner = loop->scanner;
+  parser->current = loop->current;
+  parser->previous = loop->previous;
+  rewindChunk(parser, loop->mark);
+  parser->currentCompiler->localCount = loop->localCount;
+  restoreTypes(parser, &loop->types);
+  loop->narrowed = false;
+  loop->accessCount = 0;
+  loop->writesAny = false;
+  parser->loopRetries++;
+  return true;
+}
+
+static bool checkIn(Parser* parser) {
+  return check(parser, TOKEN_IDENTIFIER) &&
+      parser->current.length == 2 &&
+      memcmp(parser->current.start, "in", 2) == 0;
+}
+
+// Compile the rest of a for-in loop after the name of its first
+// variable. Hidden locals for the iterable and a cursor into it come
+// before the loop variables, so the iterable can't see them; the
+// caller's endScope() releases them all.
+static void forInStatement(Parser* parser) {
+  Token names[2];
+  int varCount = 1;
+  names[0] = parser->previous;
+  if (match(parser, TOKEN_COMMA)) {
+    consume(parser, TOKEN_IDENTIFIER, "Expect variable name.");
+    names[varCount++] = parser->previous;
+    if (identifiersEqual(&names[0], &names[1])) {
+      error(parser, "Already a variable with this name in this scope.");
+    }
+  }
+
+  if (!checkIn(parser)) {
+    errorAtCurrent(parser, "Expect 'in' after loop variables.");
+    return;
+  }
+  advance(parser);
+  expression(parser);
+  consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after for clauses.");
+
+  addLocal(parser, syntheticToken(""));
+  markInitialized(parser);
+  emitByte(parser, OP_ITER_INIT);
+  addLocal(parser, syntheticToken(""));
+  markInitialized(parser);
+
+  int firstVar = parser->currentCompiler->localCount;
+  for (int i = 0; i < varCount; ++i) {
+    addLocal(parser, names[i]);
+    markInitialized(parser);
+    emitByte(parser, OP_NIL);
+  }
+
+  LoopStart loop;
+  startLoop(parser, &loop);
+  do {
+    emitHoists(parser, &loop);
+    for (int i = 0; i < varCount; ++i) {
+      LoopAccess assign = { ACCESS_ASSIGN, true, firstVar + i,
+          names[i] };
+      recordAccess(parser, assign);
+    }
+    int loopStart = currentChunk(parser)->count;
+    emitBytes(parser, OP_ITER_NEXT, (uint8_t)firstVar);
+    emitByte(parser, (uint8_t)varCount);
+    emitBytes(parser, 0xff, 0xff);
+    int exitJump = currentChunk(parser)->count - 2;
+
+    statement(parser);
+    emitLoop(parser, loopStart);
+    patchJump(parser, exitJump);
+    narrowLoop(parser, &loop);
+  } while (retryLoop(parser, &loop));
+  endLoop(parser, &loop);
+  restoreTypes(parser, &loop.types);
+}
+
+// Emit a jump taken if the condition compiled from mark to the end of
+// the chunk is false, and return the offset of its distance for
+// patchJump(). A condition comparing a local with a constant or another
+// local is replaced by an op that compares them in place.
+static int emitConditionJump(Parser* parser, ChunkMark mark) {
+  Chunk* chunk = currentChunk(parser);
+  uint8_t* code = &chunk->code[mark.code];
+  int length = chunk->count - mark.code;
+  bool negated = length > 0 && code[length - 1] == OP_NOT;
+  length -= negated;
+  if (length < 4 || code[0] != OP_GET_LOCAL) {
+    return emitJump(parser, OP_PJMP_IF_FALSE);
+  }
+
+  uint8_t a = code[1];
+  uint8_t op = code[length - 1];
+  uint16_t constant = 0;
+  int b = -1;
+  if (length == 5 &&
+      (code[2] == OP_LESS_C || code[2] == OP_LESS_C_NN)) {
+    op = OP_LESS;
+    constant = (uint16_t)((code[3] << 8) | code[4]);
+  } else if (length == 6 && code[2] == OP_CONSTANT) {
+    constant = (uint16_t)((code[3] << 8) | code[4]);
+  } else if (length == 4 && (code[2] == OP_NIL || code[2] == OP_TRUE ||
+                                code[2] == OP_FALSE)) {
+    Value value = code[2] == OP_NIL ? NIL_VAL
+                                    : BOOL_VAL(code[2] == OP_TRUE);
+    constant = makeConstant(parser, value);
+  } else if (length == 5 && code[2] == OP_GET_LOCAL) {
+    b = code[3];
+  } else {
+    return emitJump(parser, OP_PJMP_IF_FALSE);
+  }
+
+  // Jump if the comparison gives what makes the condition false.
+  bool jumpIf = negated;
+  OpCode jumpOp;
+  switch (op) {
+    case OP_LESS:
+    case OP_LESS_NN:
+      jumpOp = b == -1
+          ? (jumpIf ? OP_JUMP_IF_LESS_LC : OP_JUMP_IF_NOT_LESS_LC)
+          : (jumpIf ? OP_JUMP_IF_LESS_LL : OP_JUMP_IF_NOT_LESS_LL);
+      break;
+    case OP_GREATER:
+    case OP_GREATER_NN:
+      if (b != -1) {
+        // a > b is b < a.
+        uint8_t swap = a;
+        a = (uint8_t)b;
+        b = swap;
+        jumpOp = jumpIf ? OP_JUMP_IF_LESS_LL : OP_JUMP_IF_NOT_LESS_LL;
+      } else {
+        jumpOp =
+            jumpIf ? OP_JUMP_IF_GREATER_LC : OP_JUMP_IF_NOT_GREATER_LC;
+      }
+      break;
+    case OP_EQUAL:
+      jumpOp = b == -1
+          ? (jumpIf ? OP_JUMP_IF_EQUAL_LC : OP_JUMP_IF_NOT_EQUAL_LC)
+          : (jumpIf ? OP_JUMP_IF_EQUAL_LL : OP_JUMP_IF_NOT_EQUAL_LL);
+      break;
+    default: return emitJump(parser, OP_PJMP_IF_FALSE);
+  }
+
+  // The constant stays in the pool, so only the code is rewound.
+  chunk->count = mark.code;
+  emitBytes(parser, jumpOp, a);
+  if (b == -1) {
+    emitBytes(
+        parser, (uint8_t)(constant >> 8), (uint8_t)(constant & 0xff));
+  } else {
+    emitByte(parser, (uint8_t)b);
+  }
+  emitBytes(parser, 0xff, 0xff);
+  return chunk->count - 2;
+}
+
 static void forStatement(Parser* parser) {
   beginScope(parser);
   consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'for'.");
   if (match(parser, TOKEN_SEMICOLON)) {
     // No initializer.
   } else if (match(parser, TOKEN_VAR)) {
-    varDeclaration(parser);
+    consume(parser, TOKEN_IDENTIFIER, "Expect variable name.");
+    if (check(parser, TOKEN_COMMA) || checkIn(parser)) {
+      forInStatement(parser);
+      endScope(parser);
+      return;
+    }
+    declareVariable(parser);
+    varInitializer(parser, 0);
   } else {
     expressionStatement(parser);
   }
 
-  int loopStart = currentChunk(parser)->count;
-  int exitJump = -1;
-  if (!match(parser, TOKEN_SEMICOLON)) {
-    expression(parser);
-    consume(
-        parser, TOKEN_SEMICOLON, "Expect ';' after loop condition.");
+  LoopStart loop;
+  startLoop(parser, &loop);
+  LocalTypes exitTypes;
+  do {
+    emitHoists(parser, &loop);
+    ChunkMark loopMark = markChunk(parser);
+    int loopStart = loopMark.code;
+    int exitJump = -1;
+    bool neverRuns = false;
+    if (!match(parser, TOKEN_SEMICOLON)) {
+      expression(parser);
+      consume(
+          parser, TOKEN_SEMICOLON, "Expect ';' after loop condition.");
 
-    // Jump out of the loop if the condition is false.
-    exitJump = emitJump(parser, OP_PJMP_IF_FALSE);
-  }
+      Value condition;
+      if (constantLoad(parser, loopStart, currentChunk(parser)->count,
+              &condition)) {
+        rewindChunk(parser, loopMark);
+        neverRuns = isFalsey(condition);
+      } else {
+        // Jump out of the loop if the condition is false.
+        exitJump = emitConditionJump(parser, loopMark);
+      }
+    }
+    saveTypes(parser, &exitTypes);
+
+    if (!match(parser, TOKEN_RIGHT_PAREN)) {
+      int bodyJump = emitJump(parser, OP_JUMP);
+      int incrementStart = currentChunk(parser)->count;
+      // The increment runs after the body, with no more numbers than
+      // the loop starts with.
+      restoreTypes(parser, &loop.types);
+      expression(parser);
+      emitByte(parser, OP_POP);
+      consume(
+          parser, TOKEN_RIGHT_PAREN, "Expect ')' after for clauses.");
+      narrowLoop(parser, &loop);
+      restoreTypes(parser, &exitTypes);
 
-  if (!match(parser, TOKEN_RIGHT_PAREN)) {
-    int bodyJump = emitJump(parser, OP_JUMP);
-    int incrementStart = currentChunk(parser)->count;
-    expression(parser);
-    emitByte(parser, OP_POP);
-    consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after for clauses.");
+      emitLoop(parser, loopStart);
+      loopStart = incrementStart;
+      patchJump(parser, bodyJump);
+    }
 
+    statement(parser);
     emitLoop(parser, loopStart);
-    loopStart = incrementStart;
-    patchJump(parser, bodyJump);
-  }
-
-  statement(parser);
-  emitLoop(parser, loopStart);
+    narrowLoop(parser, &loop);
 
-  if (exitJump != -1) {
-    patchJump(parser, exitJump);
-  }
+    if (neverRuns) {
+      rewindChunk(parser, loopMark);
+    } else if (exitJump != -1) {
+      patchJump(parser, exitJump);
+    }
+  } while (retryLoop(parser, &loop));
+  endLoop(parser, &loop);
+  restoreTypes(parser, &exitTypes);
 
   endScope(parser);
 }
 
 static void ifStatement(Parser* parser) {
   consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'if'.");
+  ChunkMark conditionMark = markChunk(parser);
   expression(parser);
   consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after condition.");
 
-  int thenJump = emitJump(parser, OP_PJMP_IF_FALSE);
+  // Compile but discard the branch a constant condition never takes.
+  Value condition;
+  if (constantLoad(parser, conditionMark.code,
+          currentChunk(parser)->count, &condition)) {
+    rewindChunk(parser, conditionMark);
+    bool taken = !isFalsey(condition);
+    LocalTypes types;
+    ChunkMark thenMark = markChunk(parser);
+    saveTypes(parser, &types);
+    statement(parser);
+    if (!taken) {
+      rewindChunk(parser, thenMark);
+      restoreTypes(parser, &types);
+    }
+    if (match(parser, TOKEN_ELSE)) {
+      ChunkMark elseMark = markChunk(parser);
+      saveTypes(parser, &types);
+      statement(parser);
+      if (taken) {
+        rewindChunk(parser, elseMark);
+        restoreTypes(parser, &types);
+      }
+    }
+    return;
+  }
+
+  int thenJump = emitConditionJump(parser, conditionMark);
+  LocalTypes elseTypes;
+  saveTypes(parser, &elseTypes);
   statement(parser);
 
   if (match(parser, TOKEN_ELSE)) {
     int elseJump = emitJump(parser, OP_JUMP);
     patchJump(parser, thenJump);
+    LocalTypes thenTypes;
+    saveTypes(parser, &thenTypes);
+    restoreTypes(parser, &elseTypes);
     statement(parser);
+    mergeTypes(parser, &thenTypes);
     patchJump(parser, elseJump);
   } else {
     patchJump(parser, thenJump);
+    mergeTypes(parser, &elseTypes);
   }
 }
 
@@ -1076,16 +2296,42 @@ static void returnStatement(Parser* parser) {
 }
 
 static void whileStatement(Parser* parser) {
-  int loopStart = currentChunk(parser)->count;
-  consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'while'.");
-  expression(parser);
-  consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after condition.");
-
-  int exitJump = emitJump(parser, OP_PJMP_IF_FALSE);
-  statement(parser);
-  emitLoop(parser, loopStart);
-
-  patchJump(parser, exitJump);
+  LoopStart loop;
+  startLoop(parser, &loop);
+  LocalTypes exitTypes;
+  do {
+    // The hidden locals of hoisted reads need a scope.
+    beginScope(parser);
+    emitHoists(parser, &loop);
+    ChunkMark loopMark = markChunk(parser);
+    int loopStart = loopMark.code;
+    consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'while'.");
+    expression(parser);
+    consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after condition.");
+    saveTypes(parser, &exitTypes);
+
+    // A constant condition needs no test, and if false, no loop at
+    // all.
+    Value condition;
+    if (constantLoad(parser, loopStart, currentChunk(parser)->count,
+            &condition)) {
+      rewindChunk(parser, loopMark);
+      statement(parser);
+      emitLoop(parser, loopStart);
+      if (isFalsey(condition)) {
+        rewindChunk(parser, loopMark);
+      }
+    } else {
+      int exitJump = emitConditionJump(parser, loopMark);
+      statement(parser);
+      emitLoop(parser, loopStart);
+      patchJump(parser, exitJump);
+    }
+    narrowLoop(parser, &loop);
+    endScope(parser);
+  } while (retryLoop(parser, &loop));
+  endLoop(parser, &loop);
+  restoreTypes(parser, &exitTypes);
 }
 
 static void synchronize(Parser* parser) {
@@ -1153,8 +2399,11 @@ static void compilerMarkRoots(struct GC* gc, void* arg) {
   Compiler* compiler = parser->currentCompiler;
   while (compiler != NULL) {
     markObject(gc, (Obj*)compiler->function);
+    // Rewound constants may only be left in here.
+    markDict(gc, &compiler->constants);
     compiler = compiler->enclosing;
   }
+  markTable(gc, parser->globals);
 
   if (parser->prevMarkRoots) {
     parser->prevMarkRoots(gc, parser->prevMarkRootsArg);
@@ -1195,14 +2444,22 @@ static void restoreGC(Parser* parser) {
 }
 
 ObjFunction* compile(FILE* fout, FILE* ferr, const char* source, GC* gc,
-    Table* strings) {
+    Table* strings, Table* globals, ValueArray* globalSlots,
+    int* reboundNatives) {
   Parser parser;
   parser.fout = fout;
   parser.ferr = ferr;
   setupGC(&parser, gc, strings);
   parser.strings = strings;
+  parser.globals = globals;
+  parser.globalSlots = globalSlots;
+  parser.source = source;
   parser.currentCompiler = NULL;
   parser.currentClass = NULL;
+  parser.loopRetries = 0;
+  *reboundNatives |= scanReboundNatives(source);
+  parser.reboundNatives = *reboundNatives;
+  resolvePureNatives(&parser);
   parser.hadError = false;
   parser.panicMode = false;
 
@@ -8,8 +8,15 @@
 #include "object.h"
 #include "table.h"
 
-ObjFunction* compile(
-    FILE* fout, FILE* ferr, const char* source, GC* gc, Table* strings);
+// globals maps the names of global variables to their slots in
+// globalSlots. Slots are added for new names, holding EMPTY_VAL until
+// the variable is defined.
+//
+// reboundNatives accumulates the natives that any source compiled with
+// it so far may rebind, so later sources don't fold calls to them.
+ObjFunction* compile(FILE* fout, FILE* ferr, const char* source, GC* gc,
+    Table* strings, Table* globals, ValueArray* globalSlots,
+    int* reboundNatives);
 
 extern bool debugPrintCode;
 
@@ -0,0 +1,52 @@
+#include "compiler.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ubench.h"
+
+#include "gc.h"
+
+UBENCH_EX(Compiler, ManyConstants) {
+#define LINES 100000
+#define CONSTANTS 50000
+
+  // Each line has a new constant or one seen earlier.
+  size_t size = LINES * sizeof("x = 12345;\n");
+  char* src = malloc(size);
+  assert(src);
+  size_t length = 0;
+  for (int i = 0; i < LINES; ++i) {
+    length += (size_t)snprintf(
+        src + length, size - length, "x = %d;\n", i % CONSTANTS);
+  }
+
+  GC gc;
+  Table strings;
+  Table globals;
+  ValueArray globalSlots;
+  ObjFunction* result = NULL;
+
+  initGC(&gc);
+  initTable(&strings, 0.75);
+  initTable(&globals, 0.75);
+  initValueArray(&globalSlots);
+  UBENCH_DO_BENCHMARK() {
+    int reboundNatives = 0;
+    result = compile(stdout, stderr, src, &gc, &strings, &globals,
+        &globalSlots, &reboundNatives);
+  }
+  assert(result);
+  assert(result->chunk.constants.count == CONSTANTS);
+  freeValueArray(&gc, &globalSlots);
+  freeTable(&gc, &globals);
+  freeTable(&gc, &strings);
+  freeGC(&gc);
+  free(src);
+
+#undef LINES
+#undef CONSTANTS
+}
+
+UBENCH_MAIN();
@@ -10,6 +10,7 @@
 #include "list.h"
 #include "membuf.h"
 #include "memory.h"
+#include "optimizer.h"
 
 #define ufx utest_fixture
 
@@ -47,6 +48,7 @@ typedef struct {
 
 struct DumpSrc {
   SourceToDump* cases;
+  int optimizeLevel;
 };
 
 UTEST_I_SETUP(DumpSrc) {
@@ -60,15 +62,21 @@ UTEST_I_TEARDOWN(DumpSrc) {
 
   GC gc;
   Table strings;
+  Table globals;
+  ValueArray globalSlots;
   MemBuf out, err;
 
   initGC(&gc);
   initTable(&strings, 0.75);
+  initTable(&globals, 0.75);
+  initValueArray(&globalSlots);
   initMemBuf(&out);
   initMemBuf(&err);
 
-  ObjFunction* result =
-      compile(out.fptr, err.fptr, expected->src, &gc, &strings);
+  optimizeLevel = ufx->optimizeLevel;
+  int reboundNatives = 0;
+  ObjFunction* result = compile(out.fptr, err.fptr, expected->src, &gc,
+      &strings, &globals, &globalSlots, &reboundNatives);
   EXPECT_EQ(expected->success, !!result);
 
   if (result) {
@@ -89,16 +97,28 @@ UTEST_I_TEARDOWN(DumpSrc) {
     }
   }
 
+  freeValueArray(&gc, &globalSlots);
+  freeTable(&gc, &globals);
   freeTable(&gc, &strings);
   freeGC(&gc);
   freeMemBuf(&out);
   freeMemBuf(&err);
 }
 
+// Most cases check the code the compiler emits, before optimization.
 #define DUMP_SRC(name, data, count) \
   UTEST_I(DumpSrc, name, count) { \
     static_assert(sizeof(data) / sizeof(data[0]) == count, #name); \
     utest_fixture->cases = data; \
+    utest_fixture->optimizeLevel = 0; \
+    ASSERT_TRUE(1); \
+  }
+
+#define DUMP_OPTIMIZED_SRC(name, data, count) \
+  UTEST_I(DumpSrc, name, count) { \
+    static_assert(sizeof(data) / sizeof(data[0]) == count, #name); \
+    utest_fixture->cases = data; \
+    utest_fixture->optimizeLevel = 1; \
     ASSERT_TRUE(1); \
   }
 
@@ -156,26 +176,26 @@ DUMP_SRC(Strings, strings, 2);
 SourceToDump varGet[] = {
   { true, "foo;",
       "== <script> ==\n"
-      "0000    1 OP_GET_GLOBAL       0 'foo'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
       "0003    | OP_POP\n"
       "0004    | OP_NIL\n"
       "0005    | OP_RETURN\n" },
   { true, "foo + foo;",
       "== <script> ==\n"
-      "0000    1 OP_GET_GLOBAL       0 'foo'\n"
-      "0003    | OP_GET_GLOBAL       0 'foo'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_GET_GLOBAL_I     0\n"
       "0006    | OP_ADD\n"
       "0007    | OP_POP\n"
       "0008    | OP_NIL\n"
       "0009    | OP_RETURN\n" },
   { true, "foo + bar + foo + bar;",
       "== <script> ==\n"
-      "0000    1 OP_GET_GLOBAL       0 'foo'\n"
-      "0003    | OP_GET_GLOBAL       1 'bar'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_GET_GLOBAL_I     1\n"
       "0006    | OP_ADD\n"
-      "0007    | OP_GET_GLOBAL       0 'foo'\n"
+      "0007    | OP_GET_GLOBAL_I     0\n"
       "0010    | OP_ADD\n"
-      "0011    | OP_GET_GLOBAL       1 'bar'\n"
+      "0011    | OP_GET_GLOBAL_I     1\n"
       "0014    | OP_ADD\n"
       "0015    | OP_POP\n"
       "0016    | OP_NIL\n"
@@ -188,8 +208,8 @@ SourceToDump varSet[] = {
   { false, "foo + bar = 0;", "Invalid assignment target." },
   { true, "foo = 0;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '0'\n"
-      "0003    | OP_SET_GLOBAL       0 'foo'\n"
+      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0003    | OP_SET_GLOBAL_I     0\n"
       "0006    | OP_POP\n"
       "0007    | OP_NIL\n"
       "0008    | OP_RETURN\n" },
@@ -197,37 +217,136 @@ SourceToDump varSet[] = {
 
 DUMP_SRC(VarSet, varSet, 2);
 
-SourceToDump unary[] = {
-  { true, "-1;",
+SourceToDump compoundAssign[] = {
+  { false, "foo + bar += 0;", "Invalid assignment target." },
+  { true, "foo += 1;",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_ADD_C            0 '1'\n"
+      "0006    | OP_SET_GLOBAL_I     0\n"
+      "0009    | OP_POP\n"
+      "0010    | OP_NIL\n"
+      "0011    | OP_RETURN\n" },
+  { true, "{var a=1;a-=2;}",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_INC_LOCAL        1    1 '-2'\n"
+      "0007    | OP_GET_LOCAL        1\n"
+      "0009    | OP_POP\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+  { true, "{var a;a+=1;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_GET_LOCAL        1\n"
+      "0003    | OP_ADD_C            0 '1'\n"
+      "0006    | OP_SET_LOCAL        1\n"
+      "0008    | OP_POP\n"
+      "0009    | OP_POP\n"
+      "0010    | OP_NIL\n"
+      "0011    | OP_RETURN\n" },
+  { true, "{var a=1;a*=a;}",
       "== <script> ==\n"
       "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_GET_LOCAL        1\n"
+      "0005    | OP_GET_LOCAL        1\n"
+      "0007    | OP_MULTIPLY_NN\n"
+      "0008    | OP_SET_LOCAL        1\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_POP\n"
+      "0012    | OP_NIL\n"
+      "0013    | OP_RETURN\n" },
+  { true, "{var a=1;a=a+2;}",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_INC_LOCAL        1    1 '2'\n"
+      "0007    | OP_GET_LOCAL        1\n"
+      "0009    | OP_POP\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+  { true, "{var a=1;a=2+a;}",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_CONSTANT         1 '2'\n"
+      "0006    | OP_GET_LOCAL        1\n"
+      "0008    | OP_ADD_NN\n"
+      "0009    | OP_SET_LOCAL        1\n"
+      "0011    | OP_POP\n"
+      "0012    | OP_POP\n"
+      "0013    | OP_NIL\n"
+      "0014    | OP_RETURN\n" },
+  { true, "{var a=1;fun f(){a+=\"x\";}}",
+      "== f ==\n"
+      "0000    1 OP_GET_UPVALUE      0\n"
+      "0002    | OP_ADD_C            0 'x'\n"
+      "0005    | OP_SET_UPVALUE      0\n"
+      "0007    | OP_POP\n"
+      "0008    | OP_NIL\n"
+      "0009    | OP_RETURN\n"
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_CLOSURE          1 <fn f>\n"
+      "0006      |                     local 1\n"
+      "0008    | OP_POP\n"
+      "0009    | OP_CLOSE_UPVALUE\n"
+      "0010    | OP_NIL\n"
+      "0011    | OP_RETURN\n" },
+  { true, "a.b%=2;",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_GET_PROPERTY_KEEP    0 'b'\n"
+      "0006    | OP_CONSTANT         1 '2'\n"
+      "0009    | OP_MODULO_PROPERTY    0 'b'\n"
+      "0012    | OP_POP\n"
+      "0013    | OP_NIL\n"
+      "0014    | OP_RETURN\n" },
+  { true, "a[0]/=b;",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 '0'\n"
+      "0006    | OP_GET_INDEX_KEEP\n"
+      "0007    | OP_GET_GLOBAL_I     1\n"
+      "0010    | OP_DIVIDE_INDEX\n"
+      "0011    | OP_POP\n"
+      "0012    | OP_NIL\n"
+      "0013    | OP_RETURN\n" },
+};
+
+DUMP_SRC(CompoundAssign, compoundAssign, 10);
+
+SourceToDump unary[] = {
+  { true, "-a;",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
       "0003    | OP_NEGATE\n"
       "0004    | OP_POP\n"
       "0005    | OP_NIL\n"
       "0006    | OP_RETURN\n" },
-  { true, "--1;",
+  { true, "--a;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
       "0003    | OP_NEGATE\n"
       "0004    | OP_NEGATE\n"
       "0005    | OP_POP\n"
       "0006    | OP_NIL\n"
       "0007    | OP_RETURN\n" },
-  { true, "!false;",
+  { true, "!a;",
       "== <script> ==\n"
-      "0000    1 OP_FALSE\n"
-      "0001    | OP_NOT\n"
-      "0002    | OP_POP\n"
-      "0003    | OP_NIL\n"
-      "0004    | OP_RETURN\n" },
-  { true, "!!false;",
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_NOT\n"
+      "0004    | OP_POP\n"
+      "0005    | OP_NIL\n"
+      "0006    | OP_RETURN\n" },
+  { true, "!!a;",
       "== <script> ==\n"
-      "0000    1 OP_FALSE\n"
-      "0001    | OP_NOT\n"
-      "0002    | OP_NOT\n"
-      "0003    | OP_POP\n"
-      "0004    | OP_NIL\n"
-      "0005    | OP_RETURN\n" },
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_NOT\n"
+      "0004    | OP_NOT\n"
+      "0005    | OP_POP\n"
+      "0006    | OP_NIL\n"
+      "0007    | OP_RETURN\n" },
 };
 
 DUMP_SRC(Unary, unary, 4);
@@ -242,253 +361,243 @@ SourceToDump grouping[] = {
       "0005    | OP_RETURN\n" },
   { true, "(-1);",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '1'\n"
-      "0003    | OP_NEGATE\n"
-      "0004    | OP_POP\n"
-      "0005    | OP_NIL\n"
-      "0006    | OP_RETURN\n" },
+      "0000    1 OP_CONSTANT         0 '-1'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
   { true, "-(1);",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '1'\n"
-      "0003    | OP_NEGATE\n"
-      "0004    | OP_POP\n"
-      "0005    | OP_NIL\n"
-      "0006    | OP_RETURN\n" },
+      "0000    1 OP_CONSTANT         0 '-1'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
   { true, "-(-1);",
       "== <script> ==\n"
       "0000    1 OP_CONSTANT         0 '1'\n"
-      "0003    | OP_NEGATE\n"
-      "0004    | OP_NEGATE\n"
-      "0005    | OP_POP\n"
-      "0006    | OP_NIL\n"
-      "0007    | OP_RETURN\n" },
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
 };
 
 DUMP_SRC(Grouping, grouping, 5);
 
 SourceToDump binaryNums[] = {
-  { true, "3 + 2;",
+  { true, "a + 2;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '3'\n"
-      "0003    | OP_ADD_C            1 '2'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_ADD_C            0 '2'\n"
       "0006    | OP_POP\n"
       "0007    | OP_NIL\n"
       "0008    | OP_RETURN\n" },
-  { true, "3 - 2;",
+  { true, "a - 2;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '3'\n"
-      "0003    | OP_SUBTRACT_C       1 '2'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_SUBTRACT_C       0 '2'\n"
       "0006    | OP_POP\n"
       "0007    | OP_NIL\n"
       "0008    | OP_RETURN\n" },
-  { true, "3 * 2;",
+  { true, "a * 2;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '3'\n"
-      "0003    | OP_CONSTANT         1 '2'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 '2'\n"
       "0006    | OP_MULTIPLY\n"
       "0007    | OP_POP\n"
       "0008    | OP_NIL\n"
       "0009    | OP_RETURN\n" },
-  { true, "3 / 2;",
+  { true, "a / 2;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '3'\n"
-      "0003    | OP_CONSTANT         1 '2'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 '2'\n"
       "0006    | OP_DIVIDE\n"
       "0007    | OP_POP\n"
       "0008    | OP_NIL\n"
       "0009    | OP_RETURN\n" },
-  { true, "3 % 2;",
+  { true, "a % 2;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '3'\n"
-      "0003    | OP_CONSTANT         1 '2'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 '2'\n"
       "0006    | OP_MODULO\n"
       "0007    | OP_POP\n"
       "0008    | OP_NIL\n"
       "0009    | OP_RETURN\n" },
-  { true, "4 + 3 % 2;",
+  { true, "a + b % 2;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '4'\n"
-      "0003    | OP_CONSTANT         1 '3'\n"
-      "0006    | OP_CONSTANT         2 '2'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_GET_GLOBAL_I     1\n"
+      "0006    | OP_CONSTANT         0 '2'\n"
       "0009    | OP_MODULO\n"
       "0010    | OP_ADD\n"
       "0011    | OP_POP\n"
       "0012    | OP_NIL\n"
       "0013    | OP_RETURN\n" },
-  { true, "4 + 3 - 2 + 1 - 0;",
+  { true, "a + 3 - 2 + 1 - 0;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '4'\n"
-      "0003    | OP_ADD_C            1 '3'\n"
-      "0006    | OP_SUBTRACT_C       2 '2'\n"
-      "0009    | OP_ADD_C            3 '1'\n"
-      "0012    | OP_SUBTRACT_C       4 '0'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_ADD_C            0 '3'\n"
+      "0006    | OP_SUBTRACT_C_NN    1 '2'\n"
+      "0009    | OP_ADD_C_NN         2 '1'\n"
+      "0012    | OP_SUBTRACT_C_NN    3 '0'\n"
       "0015    | OP_POP\n"
       "0016    | OP_NIL\n"
       "0017    | OP_RETURN\n" },
-  { true, "4 / 3 * 2 / 1 * 0;",
+  { true, "a / 3 * 2 / 1 * 0;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '4'\n"
-      "0003    | OP_CONSTANT         1 '3'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 '3'\n"
       "0006    | OP_DIVIDE\n"
-      "0007    | OP_CONSTANT         2 '2'\n"
-      "0010    | OP_MULTIPLY\n"
-      "0011    | OP_CONSTANT         3 '1'\n"
-      "0014    | OP_DIVIDE\n"
-      "0015    | OP_CONSTANT         4 '0'\n"
-      "0018    | OP_MULTIPLY\n"
+      "0007    | OP_CONSTANT         1 '2'\n"
+      "0010    | OP_MULTIPLY_NN\n"
+      "0011    | OP_CONSTANT         2 '1'\n"
+      "0014    | OP_DIVIDE_NN\n"
+      "0015    | OP_CONSTANT         3 '0'\n"
+      "0018    | OP_MULTIPLY_NN\n"
       "0019    | OP_POP\n"
       "0020    | OP_NIL\n"
       "0021    | OP_RETURN\n" },
-  { true, "3 * 2 + 1;",
+  { true, "a * 2 + 1;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '3'\n"
-      "0003    | OP_CONSTANT         1 '2'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 '2'\n"
       "0006    | OP_MULTIPLY\n"
-      "0007    | OP_ADD_C            2 '1'\n"
+      "0007    | OP_ADD_C_NN         1 '1'\n"
       "0010    | OP_POP\n"
       "0011    | OP_NIL\n"
       "0012    | OP_RETURN\n" },
-  { true, "3 + 2 * 1;",
+  { true, "a + b * 1;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '3'\n"
-      "0003    | OP_CONSTANT         1 '2'\n"
-      "0006    | OP_CONSTANT         2 '1'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_GET_GLOBAL_I     1\n"
+      "0006    | OP_CONSTANT         0 '1'\n"
       "0009    | OP_MULTIPLY\n"
       "0010    | OP_ADD\n"
       "0011    | OP_POP\n"
       "0012    | OP_NIL\n"
       "0013    | OP_RETURN\n" },
-  { true, "(-1 + 2) * 3 - -4;",
+  { true, "(-a + 2) * 3 - -4;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
       "0003    | OP_NEGATE\n"
-      "0004    | OP_ADD_C            1 '2'\n"
-      "0007    | OP_CONSTANT         2 '3'\n"
-      "0010    | OP_MULTIPLY\n"
-      "0011    | OP_CONSTANT         3 '4'\n"
-      "0014    | OP_NEGATE\n"
-      "0015    | OP_SUBTRACT\n"
-      "0016    | OP_POP\n"
-      "0017    | OP_NIL\n"
-      "0018    | OP_RETURN\n" },
+      "0004    | OP_ADD_C_NN         0 '2'\n"
+      "0007    | OP_CONSTANT         1 '3'\n"
+      "0010    | OP_MULTIPLY_NN\n"
+      "0011    | OP_SUBTRACT_C_NN    2 '-4'\n"
+      "0014    | OP_POP\n"
+      "0015    | OP_NIL\n"
+      "0016    | OP_RETURN\n" },
 };
 
 DUMP_SRC(BinaryNums, binaryNums, 11);
 
 SourceToDump binaryCompare[] = {
-  { true, "true != true;",
+  { true, "a != true;",
       "== <script> ==\n"
-      "0000    1 OP_TRUE\n"
-      "0001    | OP_TRUE\n"
-      "0002    | OP_EQUAL\n"
-      "0003    | OP_NOT\n"
-      "0004    | OP_POP\n"
-      "0005    | OP_NIL\n"
-      "0006    | OP_RETURN\n" },
-  { true, "true == true;",
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_TRUE\n"
+      "0004    | OP_EQUAL\n"
+      "0005    | OP_NOT\n"
+      "0006    | OP_POP\n"
+      "0007    | OP_NIL\n"
+      "0008    | OP_RETURN\n" },
+  { true, "a == true;",
       "== <script> ==\n"
-      "0000    1 OP_TRUE\n"
-      "0001    | OP_TRUE\n"
-      "0002    | OP_EQUAL\n"
-      "0003    | OP_POP\n"
-      "0004    | OP_NIL\n"
-      "0005    | OP_RETURN\n" },
-  { true, "0 > 1;",
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_TRUE\n"
+      "0004    | OP_EQUAL\n"
+      "0005    | OP_POP\n"
+      "0006    | OP_NIL\n"
+      "0007    | OP_RETURN\n" },
+  { true, "a > 1;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '0'\n"
-      "0003    | OP_CONSTANT         1 '1'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 '1'\n"
       "0006    | OP_GREATER\n"
       "0007    | OP_POP\n"
       "0008    | OP_NIL\n"
       "0009    | OP_RETURN\n" },
-  { true, "0 >= 1;",
+  { true, "a >= 1;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '0'\n"
-      "0003    | OP_LESS_C           1 '1'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_LESS_C           0 '1'\n"
       "0006    | OP_NOT\n"
       "0007    | OP_POP\n"
       "0008    | OP_NIL\n"
       "0009    | OP_RETURN\n" },
-  { true, "0 < 1;",
+  { true, "a < 1;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '0'\n"
-      "0003    | OP_LESS_C           1 '1'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_LESS_C           0 '1'\n"
       "0006    | OP_POP\n"
       "0007    | OP_NIL\n"
       "0008    | OP_RETURN\n" },
-  { true, "0 <= 1;",
+  { true, "a <= 1;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '0'\n"
-      "0003    | OP_CONSTANT         1 '1'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 '1'\n"
       "0006    | OP_GREATER\n"
       "0007    | OP_NOT\n"
       "0008    | OP_POP\n"
       "0009    | OP_NIL\n"
       "0010    | OP_RETURN\n" },
-  { true, "0 + 1 < 2 == true;",
+  { true, "a + 1 < 2 == true;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '0'\n"
-      "0003    | OP_ADD_C            1 '1'\n"
-      "0006    | OP_LESS_C           2 '2'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_ADD_C            0 '1'\n"
+      "0006    | OP_LESS_C_NN        1 '2'\n"
       "0009    | OP_TRUE\n"
       "0010    | OP_EQUAL\n"
       "0011    | OP_POP\n"
       "0012    | OP_NIL\n"
       "0013    | OP_RETURN\n" },
-  { true, "true == 0 < 1 + 2;",
+  { true, "true == a < 1 + 2;",
       "== <script> ==\n"
       "0000    1 OP_TRUE\n"
-      "0001    | OP_CONSTANT         0 '0'\n"
-      "0004    | OP_CONSTANT         1 '1'\n"
-      "0007    | OP_ADD_C            2 '2'\n"
-      "0010    | OP_LESS\n"
-      "0011    | OP_EQUAL\n"
-      "0012    | OP_POP\n"
-      "0013    | OP_NIL\n"
-      "0014    | OP_RETURN\n" },
-  { true, "0 >= 1 + 2;",
+      "0001    | OP_GET_GLOBAL_I     0\n"
+      "0004    | OP_LESS_C           0 '3'\n"
+      "0007    | OP_EQUAL\n"
+      "0008    | OP_POP\n"
+      "0009    | OP_NIL\n"
+      "0010    | OP_RETURN\n" },
+  { true, "a >= 1 + 2;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '0'\n"
-      "0003    | OP_CONSTANT         1 '1'\n"
-      "0006    | OP_ADD_C            2 '2'\n"
-      "0009    | OP_LESS\n"
-      "0010    | OP_NOT\n"
-      "0011    | OP_POP\n"
-      "0012    | OP_NIL\n"
-      "0013    | OP_RETURN\n" },
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_LESS_C           0 '3'\n"
+      "0006    | OP_NOT\n"
+      "0007    | OP_POP\n"
+      "0008    | OP_NIL\n"
+      "0009    | OP_RETURN\n" },
 };
 
 DUMP_SRC(BinaryCompare, binaryCompare, 9);
 
 SourceToDump addStrings[] = {
-  { true, "\"\" + \"\";",
+  { true, "a + \"\";",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 ''\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
       "0003    | OP_ADD_C            0 ''\n"
       "0006    | OP_POP\n"
       "0007    | OP_NIL\n"
       "0008    | OP_RETURN\n" },
-  { true, "\"foo\" + \"bar\";",
+  { true, "a + \"bar\";",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 'foo'\n"
-      "0003    | OP_ADD_C            1 'bar'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_ADD_C            0 'bar'\n"
       "0006    | OP_POP\n"
       "0007    | OP_NIL\n"
       "0008    | OP_RETURN\n" },
-  { true, "\"foo\" + \"bar\" + \"baz\";",
+  { true, "a + \"bar\" + \"baz\";",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 'foo'\n"
-      "0003    | OP_ADD_C            1 'bar'\n"
-      "0006    | OP_ADD_C            2 'baz'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_ADD_C            0 'bar'\n"
+      "0006    | OP_ADD_C            1 'baz'\n"
       "0009    | OP_POP\n"
       "0010    | OP_NIL\n"
       "0011    | OP_RETURN\n" },
-  { true, "\"foo\" + \"bar\" + \"foo\" + \"bar\";",
+  { true, "a + \"foo\" + \"bar\" + \"foo\";",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 'foo'\n"
-      "0003    | OP_ADD_C            1 'bar'\n"
-      "0006    | OP_ADD_C            0 'foo'\n"
-      "0009    | OP_ADD_C            1 'bar'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_ADD_C            0 'foo'\n"
+      "0006    | OP_ADD_C            1 'bar'\n"
+      "0009    | OP_ADD_C            0 'foo'\n"
       "0012    | OP_POP\n"
       "0013    | OP_NIL\n"
       "0014    | OP_RETURN\n" },
@@ -497,51 +606,51 @@ SourceToDump addStrings[] = {
 DUMP_SRC(AddStrings, addStrings, 4);
 
 SourceToDump logical[] = {
-  { true, "true and false;",
+  { true, "a and false;",
       "== <script> ==\n"
-      "0000    1 OP_TRUE\n"
-      "0001    | OP_JUMP_IF_FALSE    1 -> 6\n"
-      "0004    | OP_POP\n"
-      "0005    | OP_FALSE\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_JUMP_IF_FALSE    3 -> 8\n"
       "0006    | OP_POP\n"
-      "0007    | OP_NIL\n"
-      "0008    | OP_RETURN\n" },
-  { true, "false or true;",
+      "0007    | OP_FALSE\n"
+      "0008    | OP_POP\n"
+      "0009    | OP_NIL\n"
+      "0010    | OP_RETURN\n" },
+  { true, "a or true;",
       "== <script> ==\n"
-      "0000    1 OP_FALSE\n"
-      "0001    | OP_JUMP_IF_FALSE    1 -> 7\n"
-      "0004    | OP_JUMP             4 -> 9\n"
-      "0007    | OP_POP\n"
-      "0008    | OP_TRUE\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_JUMP_IF_FALSE    3 -> 9\n"
+      "0006    | OP_JUMP             6 -> 11\n"
       "0009    | OP_POP\n"
-      "0010    | OP_NIL\n"
-      "0011    | OP_RETURN\n" },
-  { true, "0 == 1 and 2 or 3;",
+      "0010    | OP_TRUE\n"
+      "0011    | OP_POP\n"
+      "0012    | OP_NIL\n"
+      "0013    | OP_RETURN\n" },
+  { true, "a == 1 and b or 3;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '0'\n"
-      "0003    | OP_CONSTANT         1 '1'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 '1'\n"
       "0006    | OP_EQUAL\n"
       "0007    | OP_JUMP_IF_FALSE    7 -> 14\n"
       "0010    | OP_POP\n"
-      "0011    | OP_CONSTANT         2 '2'\n"
+      "0011    | OP_GET_GLOBAL_I     1\n"
       "0014    | OP_JUMP_IF_FALSE   14 -> 20\n"
       "0017    | OP_JUMP            17 -> 24\n"
       "0020    | OP_POP\n"
-      "0021    | OP_CONSTANT         3 '3'\n"
+      "0021    | OP_CONSTANT         1 '3'\n"
       "0024    | OP_POP\n"
       "0025    | OP_NIL\n"
       "0026    | OP_RETURN\n" },
-  { true, "0 or 1 and 2 == 3;",
+  { true, "a or b and c == 3;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
       "0003    | OP_JUMP_IF_FALSE    3 -> 9\n"
       "0006    | OP_JUMP             6 -> 24\n"
       "0009    | OP_POP\n"
-      "0010    | OP_CONSTANT         1 '1'\n"
+      "0010    | OP_GET_GLOBAL_I     1\n"
       "0013    | OP_JUMP_IF_FALSE   13 -> 24\n"
       "0016    | OP_POP\n"
-      "0017    | OP_CONSTANT         2 '2'\n"
-      "0020    | OP_CONSTANT         3 '3'\n"
+      "0017    | OP_GET_GLOBAL_I     2\n"
+      "0020    | OP_CONSTANT         0 '3'\n"
       "0023    | OP_EQUAL\n"
       "0024    | OP_POP\n"
       "0025    | OP_NIL\n"
@@ -550,6 +659,193 @@ SourceToDump logical[] = {
 
 DUMP_SRC(Logical, logical, 4);
 
+SourceToDump folding[] = {
+  { true, "-1;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '-1'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "!!false;",
+      "== <script> ==\n"
+      "0000    1 OP_FALSE\n"
+      "0001    | OP_POP\n"
+      "0002    | OP_NIL\n"
+      "0003    | OP_RETURN\n" },
+  { true, "(-1 + 2) * 3 - -4;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '7'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "0 >= 1 + 2;",
+      "== <script> ==\n"
+      "0000    1 OP_FALSE\n"
+      "0001    | OP_POP\n"
+      "0002    | OP_NIL\n"
+      "0003    | OP_RETURN\n" },
+  { true, "0/0 == 0/0;",
+      "== <script> ==\n"
+      "0000    1 OP_FALSE\n"
+      "0001    | OP_POP\n"
+      "0002    | OP_NIL\n"
+      "0003    | OP_RETURN\n" },
+  { true, "\"foo\" + \"bar\" + \"baz\";",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 'foobarbaz'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "print 0; print -0;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0003    | OP_PRINT\n"
+      "0004    | OP_CONSTANT         1 '-0'\n"
+      "0007    | OP_PRINT\n"
+      "0008    | OP_NIL\n"
+      "0009    | OP_RETURN\n" },
+  { true, "1 + nil;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_NIL\n"
+      "0004    | OP_ADD\n"
+      "0005    | OP_POP\n"
+      "0006    | OP_NIL\n"
+      "0007    | OP_RETURN\n" },
+  { true, "-\"a\";",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 'a'\n"
+      "0003    | OP_NEGATE\n"
+      "0004    | OP_POP\n"
+      "0005    | OP_NIL\n"
+      "0006    | OP_RETURN\n" },
+  { true, "1 + 2 + a;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '3'\n"
+      "0003    | OP_GET_GLOBAL_I     0\n"
+      "0006    | OP_ADD\n"
+      "0007    | OP_POP\n"
+      "0008    | OP_NIL\n"
+      "0009    | OP_RETURN\n" },
+  { true, "a + (1 + 2);",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_ADD_C            0 '3'\n"
+      "0006    | OP_POP\n"
+      "0007    | OP_NIL\n"
+      "0008    | OP_RETURN\n" },
+  { true, "true and a;",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "nil and a;",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_POP\n"
+      "0002    | OP_NIL\n"
+      "0003    | OP_RETURN\n" },
+  { true, "false or a;",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "1 or a;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "floor(1.5) + ceil(1.5) + round(1.5);",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '5'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "chr(65);",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 'A'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "chr(0.5);",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 '0.5'\n"
+      "0006    | OP_CALL             1\n"
+      "0008    | OP_POP\n"
+      "0009    | OP_NIL\n"
+      "0010    | OP_RETURN\n" },
+  { true, "floor(\"a\");",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_CONSTANT         0 'a'\n"
+      "0006    | OP_CALL             1\n"
+      "0008    | OP_POP\n"
+      "0009    | OP_NIL\n"
+      "0010    | OP_RETURN\n" },
+  { true, "fun f(floor) { floor(1.5); }",
+      "== f ==\n"
+      "0000    1 OP_GET_LOCAL        1\n"
+      "0002    | OP_CONSTANT         0 '1.5'\n"
+      "0005    | OP_CALL             1\n"
+      "0007    | OP_POP\n"
+      "0008    | OP_NIL\n"
+      "0009    | OP_RETURN\n"
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '<fn f>'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_NIL\n"
+      "0007    | OP_RETURN\n" },
+  { true, "var floor = ceil; floor(1.5);",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     1\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
+      "0009    | OP_CONSTANT         0 '1.5'\n"
+      "0012    | OP_CALL             1\n"
+      "0014    | OP_POP\n"
+      "0015    | OP_NIL\n"
+      "0016    | OP_RETURN\n" },
+  { true, "if (false) print 1; else print 2;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '2'\n"
+      "0003    | OP_PRINT\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "if (1) print 1; else print 2;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_PRINT\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "while (false) print 1;",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_RETURN\n" },
+  { true, "while (true) print 1;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_PRINT\n"
+      "0004    | OP_LOOP             4 -> 0\n"
+      "0007    | OP_NIL\n"
+      "0008    | OP_RETURN\n" },
+  { true, "for (var i = 0; false; i = i + 1) print i;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "for (;nil;) print 1;",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_RETURN\n" },
+};
+
+DUMP_SRC(Folding, folding, 27);
+
 SourceToDump functions[] = {
   { false, "fun", "Expect function name." },
   { false, "fun a", "Expect '(' after function name." },
@@ -576,9 +872,9 @@ SourceToDump functions[] = {
       "0004    | OP_NIL\n"
       "0005    | OP_RETURN\n"
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '<fn a>'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'a'\n"
-      "0006    | OP_GET_GLOBAL       0 'a'\n"
+      "0000    1 OP_CONSTANT         0 '<fn a>'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
       "0009    | OP_CALL             0\n"
       "0011    | OP_POP\n"
       "0012    | OP_NIL\n"
@@ -602,10 +898,10 @@ SourceToDump functions[] = {
       "0003    | OP_NIL\n"
       "0004    | OP_RETURN\n"
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '<fn a>'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'a'\n"
-      "0006    | OP_GET_GLOBAL       0 'a'\n"
-      "0009    | OP_CONSTANT         2 '1'\n"
+      "0000    1 OP_CONSTANT         0 '<fn a>'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
+      "0009    | OP_CONSTANT         1 '1'\n"
       "0012    | OP_CALL             1\n"
       "0014    | OP_POP\n"
       "0015    | OP_NIL\n"
@@ -618,7 +914,7 @@ SourceToDump functions[] = {
       "0004    | OP_RETURN\n"
       "== <script> ==\n"
       "0000    1 OP_CONSTANT         0 '<fn ()>'\n"
-      "0003    | OP_GET_GLOBAL       1 'x'\n"
+      "0003    | OP_GET_GLOBAL_I     0\n"
       "0006    | OP_CALL             1\n"
       "0008    | OP_POP\n"
       "0009    | OP_NIL\n"
@@ -630,9 +926,9 @@ SourceToDump functions[] = {
       "0004    | OP_NIL\n"
       "0005    | OP_RETURN\n"
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '<fn a>'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'a'\n"
-      "0006    | OP_GET_GLOBAL       0 'a'\n"
+      "0000    1 OP_CONSTANT         0 '<fn a>'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
       "0009    | OP_CALL             0\n"
       "0011    | OP_PRINT\n"
       "0012    | OP_NIL\n"
@@ -658,13 +954,13 @@ SourceToDump functions[] = {
       "0006    | OP_NIL\n"
       "0007    | OP_RETURN\n"
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '<fn a>'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'a'\n"
-      "0006    | OP_GET_GLOBAL       0 'a'\n"
-      "0009    | OP_CONSTANT         2 '3'\n"
-      "0012    | OP_GET_GLOBAL       0 'a'\n"
-      "0015    | OP_CONSTANT         3 '2'\n"
-      "0018    | OP_CONSTANT         4 '1'\n"
+      "0000    1 OP_CONSTANT         0 '<fn a>'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
+      "0009    | OP_CONSTANT         1 '3'\n"
+      "0012    | OP_GET_GLOBAL_I     0\n"
+      "0015    | OP_CONSTANT         2 '2'\n"
+      "0018    | OP_CONSTANT         3 '1'\n"
       "0021    | OP_CALL             2\n"
       "0023    | OP_CALL             2\n"
       "0025    | OP_PRINT\n"
@@ -672,7 +968,7 @@ SourceToDump functions[] = {
       "0027    | OP_RETURN\n" },
   { true, "var x=1;fun a(){fun b(){print x;}b();}a();",
       "== b ==\n"
-      "0000    1 OP_GET_GLOBAL       0 'x'\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
       "0003    | OP_PRINT\n"
       "0004    | OP_NIL\n"
       "0005    | OP_RETURN\n"
@@ -684,11 +980,11 @@ SourceToDump functions[] = {
       "0008    | OP_NIL\n"
       "0009    | OP_RETURN\n"
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '1'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'x'\n"
-      "0006    | OP_CONSTANT         3 '<fn a>'\n"
-      "0009    | OP_DEFINE_GLOBAL    2 'a'\n"
-      "0012    | OP_GET_GLOBAL       2 'a'\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_CONSTANT         1 '<fn a>'\n"
+      "0009    | OP_DEFINE_GLOBAL_I    1\n"
+      "0012    | OP_GET_GLOBAL_I     1\n"
       "0015    | OP_CALL             0\n"
       "0017    | OP_POP\n"
       "0018    | OP_NIL\n"
@@ -730,19 +1026,19 @@ SourceToDump closures[] = {
       "0008    | OP_NIL\n"
       "0009    | OP_RETURN\n"
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '<fn counter>'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'counter'\n"
-      "0006    | OP_GET_GLOBAL       0 'counter'\n"
-      "0009    | OP_CONSTANT         3 '1'\n"
+      "0000    1 OP_CONSTANT         0 '<fn counter>'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
+      "0009    | OP_CONSTANT         1 '1'\n"
       "0012    | OP_CALL             1\n"
-      "0014    | OP_DEFINE_GLOBAL    2 'c'\n"
-      "0017    | OP_GET_GLOBAL       2 'c'\n"
+      "0014    | OP_DEFINE_GLOBAL_I    1\n"
+      "0017    | OP_GET_GLOBAL_I     1\n"
       "0020    | OP_CALL             0\n"
       "0022    | OP_POP\n"
-      "0023    | OP_GET_GLOBAL       2 'c'\n"
+      "0023    | OP_GET_GLOBAL_I     1\n"
       "0026    | OP_CALL             0\n"
       "0028    | OP_POP\n"
-      "0029    | OP_GET_GLOBAL       2 'c'\n"
+      "0029    | OP_GET_GLOBAL_I     1\n"
       "0032    | OP_CALL             0\n"
       "0034    | OP_POP\n"
       "0035    | OP_NIL\n"
@@ -789,9 +1085,9 @@ SourceToDump closures[] = {
       "0013    | OP_POP\n"
       "0014    | OP_CLOSE_UPVALUE\n"
       "0015    | OP_CLOSE_UPVALUE\n"
-      "0016    | OP_GET_GLOBAL       3 'f'\n"
-      "0019    | OP_CONSTANT         4 '3'\n"
-      "0022    | OP_CONSTANT         5 '4'\n"
+      "0016    | OP_GET_GLOBAL_I     0\n"
+      "0019    | OP_CONSTANT         3 '3'\n"
+      "0022    | OP_CONSTANT         4 '4'\n"
       "0025    | OP_CALL             2\n"
       "0027    | OP_POP\n"
       "0028    | OP_NIL\n"
@@ -832,14 +1128,14 @@ SourceToDump closures[] = {
       "0008    | OP_NIL\n"
       "0009    | OP_RETURN\n"
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '<fn outer>'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'outer'\n"
-      "0006    | OP_GET_GLOBAL       0 'outer'\n"
-      "0009    | OP_CONSTANT         2 '1'\n"
+      "0000    1 OP_CONSTANT         0 '<fn outer>'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
+      "0009    | OP_CONSTANT         1 '1'\n"
       "0012    | OP_CALL             1\n"
-      "0014    | OP_CONSTANT         3 '2'\n"
+      "0014    | OP_CONSTANT         2 '2'\n"
       "0017    | OP_CALL             1\n"
-      "0019    | OP_CONSTANT         4 '3'\n"
+      "0019    | OP_CONSTANT         3 '3'\n"
       "0022    | OP_CALL             1\n"
       "0024    | OP_PRINT\n"
       "0025    | OP_NIL\n"
@@ -870,28 +1166,28 @@ SourceToDump closures[] = {
       "0004    | OP_RETURN\n"
       "== <script> ==\n"
       "0000    1 OP_NIL\n"
-      "0001    | OP_DEFINE_GLOBAL    0 'f'\n"
+      "0001    | OP_DEFINE_GLOBAL_I    0\n"
       "0004    | OP_NIL\n"
-      "0005    | OP_DEFINE_GLOBAL    1 'g'\n"
+      "0005    | OP_DEFINE_GLOBAL_I    1\n"
       "0008    | OP_NIL\n"
-      "0009    | OP_DEFINE_GLOBAL    2 'h'\n"
-      "0012    | OP_CONSTANT         3 'x'\n"
-      "0015    | OP_CONSTANT         4 'y'\n"
-      "0018    | OP_CONSTANT         5 'z'\n"
-      "0021    | OP_CLOSURE          6 <fn ff>\n"
+      "0009    | OP_DEFINE_GLOBAL_I    2\n"
+      "0012    | OP_CONSTANT         0 'x'\n"
+      "0015    | OP_CONSTANT         1 'y'\n"
+      "0018    | OP_CONSTANT         2 'z'\n"
+      "0021    | OP_CLOSURE          3 <fn ff>\n"
       "0024      |                     local 3\n"
       "0026    | OP_GET_LOCAL        4\n"
-      "0028    | OP_SET_GLOBAL       0 'f'\n"
+      "0028    | OP_SET_GLOBAL_I     0\n"
       "0031    | OP_POP\n"
-      "0032    | OP_CLOSURE          7 <fn gg>\n"
+      "0032    | OP_CLOSURE          4 <fn gg>\n"
       "0035      |                     local 1\n"
       "0037    | OP_GET_LOCAL        5\n"
-      "0039    | OP_SET_GLOBAL       1 'g'\n"
+      "0039    | OP_SET_GLOBAL_I     1\n"
       "0042    | OP_POP\n"
-      "0043    | OP_CLOSURE          8 <fn hh>\n"
+      "0043    | OP_CLOSURE          5 <fn hh>\n"
       "0046      |                     local 2\n"
       "0048    | OP_GET_LOCAL        6\n"
-      "0050    | OP_SET_GLOBAL       2 'h'\n"
+      "0050    | OP_SET_GLOBAL_I     2\n"
       "0053    | OP_POP\n"
       "0054    | OP_POP\n"
       "0055    | OP_POP\n"
@@ -899,13 +1195,13 @@ SourceToDump closures[] = {
       "0057    | OP_CLOSE_UPVALUE\n"
       "0058    | OP_CLOSE_UPVALUE\n"
       "0059    | OP_CLOSE_UPVALUE\n"
-      "0060    | OP_GET_GLOBAL       0 'f'\n"
+      "0060    | OP_GET_GLOBAL_I     0\n"
       "0063    | OP_CALL             0\n"
       "0065    | OP_POP\n"
-      "0066    | OP_GET_GLOBAL       1 'g'\n"
+      "0066    | OP_GET_GLOBAL_I     1\n"
       "0069    | OP_CALL             0\n"
       "0071    | OP_POP\n"
-      "0072    | OP_GET_GLOBAL       2 'h'\n"
+      "0072    | OP_GET_GLOBAL_I     2\n"
       "0075    | OP_CALL             0\n"
       "0077    | OP_POP\n"
       "0078    | OP_NIL\n"
@@ -921,13 +1217,13 @@ SourceToDump varDecl[] = {
   { true, "var foo;",
       "== <script> ==\n"
       "0000    1 OP_NIL\n"
-      "0001    | OP_DEFINE_GLOBAL    0 'foo'\n"
+      "0001    | OP_DEFINE_GLOBAL_I    0\n"
       "0004    | OP_NIL\n"
       "0005    | OP_RETURN\n" },
   { true, "var foo=0;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '0'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'foo'\n"
+      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
       "0006    | OP_NIL\n"
       "0007    | OP_RETURN\n" },
   { true, "{var foo;}",
@@ -965,7 +1261,7 @@ SourceToDump localVars[] = {
       "0003    | OP_CONSTANT         1 '2'\n"
       "0006    | OP_GET_LOCAL        1\n"
       "0008    | OP_GET_LOCAL        2\n"
-      "0010    | OP_ADD\n"
+      "0010    | OP_ADD_NN\n"
       "0011    | OP_PRINT\n"
       "0012    | OP_POP\n"
       "0013    | OP_POP\n"
@@ -973,147 +1269,410 @@ SourceToDump localVars[] = {
       "0015    | OP_RETURN\n" },
   { true, "var a=1;{var a=2;print a;}print a;",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '1'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'a'\n"
-      "0006    | OP_CONSTANT         2 '2'\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_CONSTANT         1 '2'\n"
       "0009    | OP_GET_LOCAL        1\n"
       "0011    | OP_PRINT\n"
       "0012    | OP_POP\n"
-      "0013    | OP_GET_GLOBAL       0 'a'\n"
+      "0013    | OP_GET_GLOBAL_I     0\n"
       "0016    | OP_PRINT\n"
       "0017    | OP_NIL\n"
       "0018    | OP_RETURN\n" },
-  { true, "{var a=1;{var a=2;print a;}print a;}",
+  { true, "{var a=1;{var a=2;print a;}print a;}",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_CONSTANT         1 '2'\n"
+      "0006    | OP_GET_LOCAL        2\n"
+      "0008    | OP_PRINT\n"
+      "0009    | OP_POP\n"
+      "0010    | OP_GET_LOCAL        1\n"
+      "0012    | OP_PRINT\n"
+      "0013    | OP_POP\n"
+      "0014    | OP_NIL\n"
+      "0015    | OP_RETURN\n" },
+  { true, "var a;{var b=a;var c=b;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_DEFINE_GLOBAL_I    0\n"
+      "0004    | OP_GET_GLOBAL_I     0\n"
+      "0007    | OP_GET_LOCAL        1\n"
+      "0009    | OP_POP\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+};
+
+DUMP_SRC(LocalVars, localVars, 7);
+
+SourceToDump for_[] = {
+  { true, "for(;;)0;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_LOOP             4 -> 0\n"
+      "0007    | OP_NIL\n"
+      "0008    | OP_RETURN\n" },
+  { true, "for(var a=0;;)1;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0003    | OP_CONSTANT         1 '1'\n"
+      "0006    | OP_POP\n"
+      "0007    | OP_LOOP             7 -> 3\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+  { true, "for(0;;)1;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_CONSTANT         1 '1'\n"
+      "0007    | OP_POP\n"
+      "0008    | OP_LOOP             8 -> 4\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+  { true, "for(;false;)0;",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_RETURN\n" },
+  { true, "for(;;0)1;",
+      "== <script> ==\n"
+      "0000    1 OP_JUMP             0 -> 10\n"
+      "0003    | OP_CONSTANT         0 '0'\n"
+      "0006    | OP_POP\n"
+      "0007    | OP_LOOP             7 -> 0\n"
+      "0010    | OP_CONSTANT         1 '1'\n"
+      "0013    | OP_POP\n"
+      "0014    | OP_LOOP            14 -> 3\n"
+      "0017    | OP_NIL\n"
+      "0018    | OP_RETURN\n" },
+  { true, "for(var i=0;i<5;i=i+1)print i;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0003    | OP_JUMP_IF_NOT_LESS_LC    1    1 '5' 3 -> 28\n"
+      "0009    | OP_JUMP             9 -> 22\n"
+      "0012    | OP_INC_LOCAL        1    2 '1'\n"
+      "0016    | OP_GET_LOCAL        1\n"
+      "0018    | OP_POP\n"
+      "0019    | OP_LOOP            19 -> 3\n"
+      "0022    | OP_GET_LOCAL        1\n"
+      "0024    | OP_PRINT\n"
+      "0025    | OP_LOOP            25 -> 12\n"
+      "0028    | OP_POP\n"
+      "0029    | OP_NIL\n"
+      "0030    | OP_RETURN\n" },
+};
+
+DUMP_SRC(For, for_, 6);
+
+SourceToDump forIn[] = {
+  { true, "for(var a in[])print a;",
+      "== <script> ==\n"
+      "0000    1 OP_LIST_BUILD       0\n"
+      "0002    | OP_ITER_INIT\n"
+      "0003    | OP_NIL\n"
+      "0004    | OP_ITER_NEXT        3 (1 vars) 4 -> 15\n"
+      "0009    | OP_GET_LOCAL        3\n"
+      "0011    | OP_PRINT\n"
+      "0012    | OP_LOOP            12 -> 4\n"
+      "0015    | OP_POP\n"
+      "0016    | OP_POP\n"
+      "0017    | OP_POP\n"
+      "0018    | OP_NIL\n"
+      "0019    | OP_RETURN\n" },
+};
+
+DUMP_SRC(ForIn, forIn, 1);
+
+SourceToDump if_[] = {
+  { true, "if(true)0;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "if(false)0;else 1;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+};
+
+DUMP_SRC(If, if_, 2);
+
+SourceToDump while_[] = {
+  { true, "while(false)0;",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_RETURN\n" },
+};
+
+DUMP_SRC(While, while_, 1);
+
+SourceToDump compareJumps[] = {
+  { true, "{var a;if(a<1)print a;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_JUMP_IF_NOT_LESS_LC    1    0 '1' 1 -> 10\n"
+      "0007    | OP_GET_LOCAL        1\n"
+      "0009    | OP_PRINT\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+  { true, "{var a;if(a>=1)print a;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_JUMP_IF_LESS_LC    1    0 '1' 1 -> 10\n"
+      "0007    | OP_GET_LOCAL        1\n"
+      "0009    | OP_PRINT\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+  { true, "{var a;if(a>1)print a;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_JUMP_IF_NOT_GREATER_LC    1    0 '1' 1 -> 10\n"
+      "0007    | OP_GET_LOCAL        1\n"
+      "0009    | OP_PRINT\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+  { true, "{var a;if(a<=1)print a;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_JUMP_IF_GREATER_LC    1    0 '1' 1 -> 10\n"
+      "0007    | OP_GET_LOCAL        1\n"
+      "0009    | OP_PRINT\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+  { true, "{var a;if(a==nil)print a;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_JUMP_IF_NOT_EQUAL_LC    1    0 'nil' 1 -> 10\n"
+      "0007    | OP_GET_LOCAL        1\n"
+      "0009    | OP_PRINT\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+  { true, "{var a;if(a!=\"s\")print a;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_JUMP_IF_EQUAL_LC    1    0 's' 1 -> 10\n"
+      "0007    | OP_GET_LOCAL        1\n"
+      "0009    | OP_PRINT\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_NIL\n"
+      "0012    | OP_RETURN\n" },
+  { true, "{var a;var b;while(a<b)a=b;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_NIL\n"
+      "0002    | OP_JUMP_IF_NOT_LESS_LL    1    2 2 -> 15\n"
+      "0007    | OP_GET_LOCAL        2\n"
+      "0009    | OP_SET_LOCAL        1\n"
+      "0011    | OP_POP\n"
+      "0012    | OP_LOOP            12 -> 2\n"
+      "0015    | OP_POP\n"
+      "0016    | OP_POP\n"
+      "0017    | OP_NIL\n"
+      "0018    | OP_RETURN\n" },
+  { true, "{var a;var b;while(a>b)a=b;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_NIL\n"
+      "0002    | OP_JUMP_IF_NOT_LESS_LL    2    1 2 -> 15\n"
+      "0007    | OP_GET_LOCAL        2\n"
+      "0009    | OP_SET_LOCAL        1\n"
+      "0011    | OP_POP\n"
+      "0012    | OP_LOOP            12 -> 2\n"
+      "0015    | OP_POP\n"
+      "0016    | OP_POP\n"
+      "0017    | OP_NIL\n"
+      "0018    | OP_RETURN\n" },
+  { true, "{var a;var b;for(;a==b;)a=nil;}",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '1'\n"
-      "0003    | OP_CONSTANT         1 '2'\n"
-      "0006    | OP_GET_LOCAL        2\n"
-      "0008    | OP_PRINT\n"
-      "0009    | OP_POP\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_NIL\n"
+      "0002    | OP_JUMP_IF_NOT_EQUAL_LL    1    2 2 -> 14\n"
+      "0007    | OP_NIL\n"
+      "0008    | OP_SET_LOCAL        1\n"
+      "0010    | OP_POP\n"
+      "0011    | OP_LOOP            11 -> 2\n"
+      "0014    | OP_POP\n"
+      "0015    | OP_POP\n"
+      "0016    | OP_NIL\n"
+      "0017    | OP_RETURN\n" },
+  { true, "{var a;var b;if(a!=b)print a;else print b;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_NIL\n"
+      "0002    | OP_JUMP_IF_EQUAL_LL    1    2 2 -> 13\n"
+      "0007    | OP_GET_LOCAL        1\n"
+      "0009    | OP_PRINT\n"
+      "0010    | OP_JUMP            10 -> 16\n"
+      "0013    | OP_GET_LOCAL        2\n"
+      "0015    | OP_PRINT\n"
+      "0016    | OP_POP\n"
+      "0017    | OP_POP\n"
+      "0018    | OP_NIL\n"
+      "0019    | OP_RETURN\n" },
+  { true, "{var a;if(a<b)print a;}",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_GET_LOCAL        1\n"
+      "0003    | OP_GET_GLOBAL_I     0\n"
+      "0006    | OP_LESS\n"
+      "0007    | OP_PJMP_IF_FALSE    7 -> 13\n"
       "0010    | OP_GET_LOCAL        1\n"
       "0012    | OP_PRINT\n"
       "0013    | OP_POP\n"
       "0014    | OP_NIL\n"
       "0015    | OP_RETURN\n" },
-  { true, "var a;{var b=a;var c=b;}",
-      "== <script> ==\n"
-      "0000    1 OP_NIL\n"
-      "0001    | OP_DEFINE_GLOBAL    0 'a'\n"
-      "0004    | OP_GET_GLOBAL       0 'a'\n"
-      "0007    | OP_GET_LOCAL        1\n"
-      "0009    | OP_POP\n"
-      "0010    | OP_POP\n"
-      "0011    | OP_NIL\n"
-      "0012    | OP_RETURN\n" },
 };
 
-DUMP_SRC(LocalVars, localVars, 7);
+DUMP_SRC(CompareJumps, compareJumps, 11);
 
-SourceToDump for_[] = {
-  { true, "for(;;)0;",
+// Locals only known to hold numbers get unchecked arithmetic.
+SourceToDump numberLocals[] = {
+  { true, "{var i=0;while(i<3)i=i+1;}",
       "== <script> ==\n"
       "0000    1 OP_CONSTANT         0 '0'\n"
-      "0003    | OP_POP\n"
-      "0004    | OP_LOOP             4 -> 0\n"
-      "0007    | OP_NIL\n"
-      "0008    | OP_RETURN\n" },
-  { true, "for(var a=0;;)1;",
+      "0003    | OP_JUMP_IF_NOT_LESS_LC    1    1 '3' 3 -> 19\n"
+      "0009    | OP_INC_LOCAL        1    2 '1'\n"
+      "0013    | OP_GET_LOCAL        1\n"
+      "0015    | OP_POP\n"
+      "0016    | OP_LOOP            16 -> 3\n"
+      "0019    | OP_POP\n"
+      "0020    | OP_NIL\n"
+      "0021    | OP_RETURN\n" },
+  { true, "{var x=0;var y=1;while(y<2){y=x;x=nil;}}",
       "== <script> ==\n"
       "0000    1 OP_CONSTANT         0 '0'\n"
       "0003    | OP_CONSTANT         1 '1'\n"
-      "0006    | OP_POP\n"
-      "0007    | OP_LOOP             7 -> 3\n"
-      "0010    | OP_POP\n"
-      "0011    | OP_NIL\n"
-      "0012    | OP_RETURN\n" },
-  { true, "for(0;;)1;",
-      "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '0'\n"
+      "0006    | OP_JUMP_IF_NOT_LESS_LC    2    2 '2' 6 -> 24\n"
+      "0012    | OP_GET_LOCAL        1\n"
+      "0014    | OP_SET_LOCAL        2\n"
+      "0016    | OP_POP\n"
+      "0017    | OP_NIL\n"
+      "0018    | OP_SET_LOCAL        1\n"
+      "0020    | OP_POP\n"
+      "0021    | OP_LOOP            21 -> 6\n"
+      "0024    | OP_POP\n"
+      "0025    | OP_POP\n"
+      "0026    | OP_NIL\n"
+      "0027    | OP_RETURN\n" },
+  { true, "{var x=1;fun f(){x=nil;}print x+1;}",
+      "== f ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_SET_UPVALUE      0\n"
       "0003    | OP_POP\n"
-      "0004    | OP_CONSTANT         1 '1'\n"
-      "0007    | OP_POP\n"
-      "0008    | OP_LOOP             8 -> 4\n"
-      "0011    | OP_NIL\n"
-      "0012    | OP_RETURN\n" },
-  { true, "for(;false;)0;",
-      "== <script> ==\n"
-      "0000    1 OP_FALSE\n"
-      "0001    | OP_PJMP_IF_FALSE    1 -> 11\n"
-      "0004    | OP_CONSTANT         0 '0'\n"
-      "0007    | OP_POP\n"
-      "0008    | OP_LOOP             8 -> 0\n"
-      "0011    | OP_NIL\n"
-      "0012    | OP_RETURN\n" },
-  { true, "for(;;0)1;",
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n"
       "== <script> ==\n"
-      "0000    1 OP_JUMP             0 -> 10\n"
-      "0003    | OP_CONSTANT         0 '0'\n"
-      "0006    | OP_POP\n"
-      "0007    | OP_LOOP             7 -> 0\n"
-      "0010    | OP_CONSTANT         1 '1'\n"
-      "0013    | OP_POP\n"
-      "0014    | OP_LOOP            14 -> 3\n"
-      "0017    | OP_NIL\n"
-      "0018    | OP_RETURN\n" },
-  { true, "for(var i=0;i<5;i=i+1)print i;",
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_CLOSURE          1 <fn f>\n"
+      "0006      |                     local 1\n"
+      "0008    | OP_GET_LOCAL        1\n"
+      "0010    | OP_ADD_C            0 '1'\n"
+      "0013    | OP_PRINT\n"
+      "0014    | OP_POP\n"
+      "0015    | OP_CLOSE_UPVALUE\n"
+      "0016    | OP_NIL\n"
+      "0017    | OP_RETURN\n" },
+  { true, "{var x=1;var c;if(c)x=nil;print x-1;}",
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         0 '0'\n"
-      "0003    | OP_GET_LOCAL        1\n"
-      "0005    | OP_LESS_C           1 '5'\n"
-      "0008    | OP_PJMP_IF_FALSE    8 -> 31\n"
-      "0011    | OP_JUMP            11 -> 25\n"
-      "0014    | OP_GET_LOCAL        1\n"
-      "0016    | OP_ADD_C            2 '1'\n"
-      "0019    | OP_SET_LOCAL        1\n"
-      "0021    | OP_POP\n"
-      "0022    | OP_LOOP            22 -> 3\n"
-      "0025    | OP_GET_LOCAL        1\n"
-      "0027    | OP_PRINT\n"
-      "0028    | OP_LOOP            28 -> 14\n"
-      "0031    | OP_POP\n"
-      "0032    | OP_NIL\n"
-      "0033    | OP_RETURN\n" },
+      "0000    1 OP_CONSTANT         0 '1'\n"
+      "0003    | OP_NIL\n"
+      "0004    | OP_GET_LOCAL        2\n"
+      "0006    | OP_PJMP_IF_FALSE    6 -> 13\n"
+      "0009    | OP_NIL\n"
+      "0010    | OP_SET_LOCAL        1\n"
+      "0012    | OP_POP\n"
+      "0013    | OP_GET_LOCAL        1\n"
+      "0015    | OP_SUBTRACT_C       0 '1'\n"
+      "0018    | OP_PRINT\n"
+      "0019    | OP_POP\n"
+      "0020    | OP_POP\n"
+      "0021    | OP_NIL\n"
+      "0022    | OP_RETURN\n" },
 };
 
-DUMP_SRC(For, for_, 6);
+DUMP_SRC(NumberLocals, numberLocals, 4);
 
-SourceToDump if_[] = {
-  { true, "if(true)0;",
+// Loops cache property reads nothing in them can change.
+SourceToDump hoistedReads[] = {
+  { true, "{var f;while(f)print f.x;}",
       "== <script> ==\n"
-      "0000    1 OP_TRUE\n"
-      "0001    | OP_PJMP_IF_FALSE    1 -> 8\n"
-      "0004    | OP_CONSTANT         0 '0'\n"
-      "0007    | OP_POP\n"
-      "0008    | OP_NIL\n"
-      "0009    | OP_RETURN\n" },
-  { true, "if(false)0;else 1;",
+      "0000    1 OP_NIL\n"
+      "0001    | OP_NIL\n"
+      "0002    | OP_GET_LOCAL        1\n"
+      "0004    | OP_PJMP_IF_FALSE    4 -> 21\n"
+      "0007    | OP_GET_HOISTED      2 7 -> 17\n"
+      "0011    | OP_GET_LOCAL        1\n"
+      "0013    | OP_HOIST_PROPERTY (slot 2)    0 'x'\n"
+      "0017    | OP_PRINT\n"
+      "0018    | OP_LOOP            18 -> 2\n"
+      "0021    | OP_POP\n"
+      "0022    | OP_POP\n"
+      "0023    | OP_NIL\n"
+      "0024    | OP_RETURN\n" },
+  { true, "{var f;for(;;)for(var i=0;i<f.n;i=i+1)print f.x+f.n;}",
       "== <script> ==\n"
-      "0000    1 OP_FALSE\n"
-      "0001    | OP_PJMP_IF_FALSE    1 -> 11\n"
-      "0004    | OP_CONSTANT         0 '0'\n"
-      "0007    | OP_POP\n"
-      "0008    | OP_JUMP             8 -> 15\n"
-      "0011    | OP_CONSTANT         1 '1'\n"
-      "0014    | OP_POP\n"
-      "0015    | OP_NIL\n"
-      "0016    | OP_RETURN\n" },
-};
-
-DUMP_SRC(If, if_, 2);
-
-SourceToDump while_[] = {
-  { true, "while(false)0;",
+      "0000    1 OP_NIL\n"
+      "0001    | OP_NIL\n"
+      "0002    | OP_NIL\n"
+      "0003    | OP_CONSTANT         0 '0'\n"
+      "0006    | OP_GET_LOCAL        4\n"
+      "0008    | OP_GET_HOISTED      2 8 -> 18\n"
+      "0012    | OP_GET_LOCAL        1\n"
+      "0014    | OP_HOIST_PROPERTY (slot 2)    1 'n'\n"
+      "0018    | OP_LESS\n"
+      "0019    | OP_PJMP_IF_FALSE   19 -> 60\n"
+      "0022    | OP_JUMP            22 -> 35\n"
+      "0025    | OP_INC_LOCAL        4    2 '1'\n"
+      "0029    | OP_GET_LOCAL        4\n"
+      "0031    | OP_POP\n"
+      "0032    | OP_LOOP            32 -> 6\n"
+      "0035    | OP_GET_HOISTED      3 35 -> 45\n"
+      "0039    | OP_GET_LOCAL        1\n"
+      "0041    | OP_HOIST_PROPERTY (slot 3)    3 'x'\n"
+      "0045    | OP_GET_HOISTED      2 45 -> 55\n"
+      "0049    | OP_GET_LOCAL        1\n"
+      "0051    | OP_HOIST_PROPERTY (slot 2)    1 'n'\n"
+      "0055    | OP_ADD\n"
+      "0056    | OP_PRINT\n"
+      "0057    | OP_LOOP            57 -> 25\n"
+      "0060    | OP_POP\n"
+      "0061    | OP_LOOP            61 -> 3\n"
+      "0064    | OP_POP\n"
+      "0065    | OP_POP\n"
+      "0066    | OP_POP\n"
+      "0067    | OP_NIL\n"
+      "0068    | OP_RETURN\n" },
+  { true, "{var f;while(f){print f.x;f.y=1;f.z();}}",
       "== <script> ==\n"
-      "0000    1 OP_FALSE\n"
-      "0001    | OP_PJMP_IF_FALSE    1 -> 11\n"
-      "0004    | OP_CONSTANT         0 '0'\n"
-      "0007    | OP_POP\n"
-      "0008    | OP_LOOP             8 -> 0\n"
-      "0011    | OP_NIL\n"
-      "0012    | OP_RETURN\n" },
+      "0000    1 OP_NIL\n"
+      "0001    | OP_GET_LOCAL        1\n"
+      "0003    | OP_PJMP_IF_FALSE    3 -> 31\n"
+      "0006    | OP_GET_LOCAL        1\n"
+      "0008    | OP_GET_PROPERTY     0 'x'\n"
+      "0011    | OP_PRINT\n"
+      "0012    | OP_GET_LOCAL        1\n"
+      "0014    | OP_CONSTANT         2 '1'\n"
+      "0017    | OP_SET_PROPERTY     1 'y'\n"
+      "0020    | OP_POP\n"
+      "0021    | OP_GET_LOCAL        1\n"
+      "0023    | OP_INVOKE        (0 args)    3 'z'\n"
+      "0027    | OP_POP\n"
+      "0028    | OP_LOOP            28 -> 1\n"
+      "0031    | OP_POP\n"
+      "0032    | OP_NIL\n"
+      "0033    | OP_RETURN\n" },
 };
 
-DUMP_SRC(While, while_, 1);
+DUMP_SRC(HoistedReads, hoistedReads, 3);
 
 SourceToDump classes[] = {
   { false, "1+f.x=2;", "Invalid assignment target." },
@@ -1122,8 +1681,8 @@ SourceToDump classes[] = {
   { true, "class F{}",
       "== <script> ==\n"
       "0000    1 OP_CLASS            0 'F'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'F'\n"
-      "0006    | OP_GET_GLOBAL       0 'F'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
       "0009    | OP_POP\n"
       "0010    | OP_NIL\n"
       "0011    | OP_RETURN\n" },
@@ -1135,25 +1694,25 @@ SourceToDump classes[] = {
       "0006    | OP_NIL\n"
       "0007    | OP_RETURN\n"
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '<fn g>'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'g'\n"
+      "0000    1 OP_CONSTANT         0 '<fn g>'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
       "0006    | OP_NIL\n"
       "0007    | OP_RETURN\n" },
   { true, "class F{}var f=F();f.x=1;print f.x;",
       "== <script> ==\n"
       "0000    1 OP_CLASS            0 'F'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'F'\n"
-      "0006    | OP_GET_GLOBAL       0 'F'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
       "0009    | OP_POP\n"
-      "0010    | OP_GET_GLOBAL       0 'F'\n"
+      "0010    | OP_GET_GLOBAL_I     0\n"
       "0013    | OP_CALL             0\n"
-      "0015    | OP_DEFINE_GLOBAL    1 'f'\n"
-      "0018    | OP_GET_GLOBAL       1 'f'\n"
-      "0021    | OP_CONSTANT         3 '1'\n"
-      "0024    | OP_SET_PROPERTY     2 'x'\n"
+      "0015    | OP_DEFINE_GLOBAL_I    1\n"
+      "0018    | OP_GET_GLOBAL_I     1\n"
+      "0021    | OP_CONSTANT         2 '1'\n"
+      "0024    | OP_SET_PROPERTY     1 'x'\n"
       "0027    | OP_POP\n"
-      "0028    | OP_GET_GLOBAL       1 'f'\n"
-      "0031    | OP_GET_PROPERTY     2 'x'\n"
+      "0028    | OP_GET_GLOBAL_I     1\n"
+      "0031    | OP_GET_PROPERTY     1 'x'\n"
       "0034    | OP_PRINT\n"
       "0035    | OP_NIL\n"
       "0036    | OP_RETURN\n" },
@@ -1174,26 +1733,26 @@ SourceToDump classes[] = {
       "0025    | OP_NIL\n"
       "0026    | OP_RETURN\n"
       "== <script> ==\n"
-      "0000    1 OP_CONSTANT         1 '<fn g>'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'g'\n"
+      "0000    1 OP_CONSTANT         0 '<fn g>'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
       "0006    | OP_NIL\n"
       "0007    | OP_RETURN\n" },
   { true, "class F{}var f=F();f[\"x\"]=1;print f[\"x\"];",
       "== <script> ==\n"
       "0000    1 OP_CLASS            0 'F'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'F'\n"
-      "0006    | OP_GET_GLOBAL       0 'F'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
       "0009    | OP_POP\n"
-      "0010    | OP_GET_GLOBAL       0 'F'\n"
+      "0010    | OP_GET_GLOBAL_I     0\n"
       "0013    | OP_CALL             0\n"
-      "0015    | OP_DEFINE_GLOBAL    1 'f'\n"
-      "0018    | OP_GET_GLOBAL       1 'f'\n"
-      "0021    | OP_CONSTANT         2 'x'\n"
-      "0024    | OP_CONSTANT         3 '1'\n"
+      "0015    | OP_DEFINE_GLOBAL_I    1\n"
+      "0018    | OP_GET_GLOBAL_I     1\n"
+      "0021    | OP_CONSTANT         1 'x'\n"
+      "0024    | OP_CONSTANT         2 '1'\n"
       "0027    | OP_SET_INDEX\n"
       "0028    | OP_POP\n"
-      "0029    | OP_GET_GLOBAL       1 'f'\n"
-      "0032    | OP_CONSTANT         2 'x'\n"
+      "0029    | OP_GET_GLOBAL_I     1\n"
+      "0032    | OP_CONSTANT         1 'x'\n"
       "0035    | OP_GET_INDEX\n"
       "0036    | OP_PRINT\n"
       "0037    | OP_NIL\n"
@@ -1216,8 +1775,8 @@ SourceToDump methods[] = {
       "0005    | OP_RETURN\n"
       "== <script> ==\n"
       "0000    1 OP_CLASS            0 'F'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'F'\n"
-      "0006    | OP_GET_GLOBAL       0 'F'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
       "0009    | OP_CONSTANT         2 '<fn inin>'\n"
       "0012    | OP_METHOD           1 'inin'\n"
       "0015    | OP_POP\n"
@@ -1240,7 +1799,7 @@ SourceToDump methods[] = {
       "0008    | OP_GET_LOCAL        0\n"
       "0010    | OP_RETURN\n"
       "== get ==\n"
-      "0000    1 OP_GET_GLOBAL       0 'n'\n"
+      "0000    1 OP_GET_GLOBAL_I     1\n"
       "0003    | OP_RETURN\n"
       "0004    | OP_NIL\n"
       "0005    | OP_RETURN\n"
@@ -1253,8 +1812,8 @@ SourceToDump methods[] = {
       "0009    | OP_RETURN\n"
       "== <script> ==\n"
       "0000    1 OP_CLASS            0 'F'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'F'\n"
-      "0006    | OP_GET_GLOBAL       0 'F'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
       "0009    | OP_CONSTANT         2 '<fn init>'\n"
       "0012    | OP_METHOD           1 'init'\n"
       "0015    | OP_CONSTANT         4 '<fn get>'\n"
@@ -1262,34 +1821,34 @@ SourceToDump methods[] = {
       "0021    | OP_CONSTANT         6 '<fn set>'\n"
       "0024    | OP_METHOD           5 'set'\n"
       "0027    | OP_POP\n"
-      "0028    | OP_GET_GLOBAL       0 'F'\n"
-      "0031    | OP_CONSTANT         8 '1'\n"
+      "0028    | OP_GET_GLOBAL_I     0\n"
+      "0031    | OP_CONSTANT         7 '1'\n"
       "0034    | OP_CALL             1\n"
-      "0036    | OP_DEFINE_GLOBAL    7 'f'\n"
-      "0039    | OP_GET_GLOBAL       7 'f'\n"
+      "0036    | OP_DEFINE_GLOBAL_I    2\n"
+      "0039    | OP_GET_GLOBAL_I     2\n"
       "0042    | OP_INVOKE        (0 args)    3 'get'\n"
       "0046    | OP_PRINT\n"
-      "0047    | OP_GET_GLOBAL       7 'f'\n"
-      "0050    | OP_CONSTANT         9 '2'\n"
+      "0047    | OP_GET_GLOBAL_I     2\n"
+      "0050    | OP_CONSTANT         8 '2'\n"
       "0053    | OP_INVOKE        (1 args)    5 'set'\n"
       "0057    | OP_POP\n"
-      "0058    | OP_GET_GLOBAL       7 'f'\n"
+      "0058    | OP_GET_GLOBAL_I     2\n"
       "0061    | OP_INVOKE        (0 args)    3 'get'\n"
       "0065    | OP_PRINT\n"
-      "0066    | OP_GET_GLOBAL       7 'f'\n"
+      "0066    | OP_GET_GLOBAL_I     2\n"
       "0069    | OP_GET_PROPERTY     3 'get'\n"
-      "0072    | OP_DEFINE_GLOBAL   10 'g'\n"
-      "0075    | OP_GET_GLOBAL       7 'f'\n"
+      "0072    | OP_DEFINE_GLOBAL_I    3\n"
+      "0075    | OP_GET_GLOBAL_I     2\n"
       "0078    | OP_GET_PROPERTY     5 'set'\n"
-      "0081    | OP_DEFINE_GLOBAL   11 's'\n"
-      "0084    | OP_GET_GLOBAL      10 'g'\n"
+      "0081    | OP_DEFINE_GLOBAL_I    4\n"
+      "0084    | OP_GET_GLOBAL_I     3\n"
       "0087    | OP_CALL             0\n"
       "0089    | OP_PRINT\n"
-      "0090    | OP_GET_GLOBAL      11 's'\n"
-      "0093    | OP_CONSTANT        12 '3'\n"
+      "0090    | OP_GET_GLOBAL_I     4\n"
+      "0093    | OP_CONSTANT         9 '3'\n"
       "0096    | OP_CALL             1\n"
       "0098    | OP_POP\n"
-      "0099    | OP_GET_GLOBAL      10 'g'\n"
+      "0099    | OP_GET_GLOBAL_I     3\n"
       "0102    | OP_CALL             0\n"
       "0104    | OP_PRINT\n"
       "0105    | OP_NIL\n"
@@ -1317,17 +1876,17 @@ SourceToDump superclasses[] = {
       "0010    | OP_RETURN\n"
       "== <script> ==\n"
       "0000    1 OP_CLASS            0 'A'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'A'\n"
-      "0006    | OP_GET_GLOBAL       0 'A'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
       "0009    | OP_CONSTANT         2 '<fn f>'\n"
       "0012    | OP_METHOD           1 'f'\n"
       "0015    | OP_POP\n"
       "0016    | OP_CLASS            3 'B'\n"
-      "0019    | OP_DEFINE_GLOBAL    3 'B'\n"
-      "0022    | OP_GET_GLOBAL       0 'A'\n"
-      "0025    | OP_GET_GLOBAL       3 'B'\n"
+      "0019    | OP_DEFINE_GLOBAL_I    1\n"
+      "0022    | OP_GET_GLOBAL_I     0\n"
+      "0025    | OP_GET_GLOBAL_I     1\n"
       "0028    | OP_INHERIT\n"
-      "0029    | OP_GET_GLOBAL       3 'B'\n"
+      "0029    | OP_GET_GLOBAL_I     1\n"
       "0032    | OP_CLOSURE          4 <fn f>\n"
       "0035      |                     local 1\n"
       "0037    | OP_METHOD           1 'f'\n"
@@ -1350,17 +1909,17 @@ SourceToDump superclasses[] = {
       "0013    | OP_RETURN\n"
       "== <script> ==\n"
       "0000    1 OP_CLASS            0 'A'\n"
-      "0003    | OP_DEFINE_GLOBAL    0 'A'\n"
-      "0006    | OP_GET_GLOBAL       0 'A'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_GET_GLOBAL_I     0\n"
       "0009    | OP_CONSTANT         2 '<fn f>'\n"
       "0012    | OP_METHOD           1 'f'\n"
       "0015    | OP_POP\n"
       "0016    | OP_CLASS            3 'B'\n"
-      "0019    | OP_DEFINE_GLOBAL    3 'B'\n"
-      "0022    | OP_GET_GLOBAL       0 'A'\n"
-      "0025    | OP_GET_GLOBAL       3 'B'\n"
+      "0019    | OP_DEFINE_GLOBAL_I    1\n"
+      "0022    | OP_GET_GLOBAL_I     0\n"
+      "0025    | OP_GET_GLOBAL_I     1\n"
       "0028    | OP_INHERIT\n"
-      "0029    | OP_GET_GLOBAL       3 'B'\n"
+      "0029    | OP_GET_GLOBAL_I     1\n"
       "0032    | OP_CLOSURE          4 <fn f>\n"
       "0035      |                     local 1\n"
       "0037    | OP_METHOD           1 'f'\n"
@@ -1379,53 +1938,33 @@ SourceToDump lists[] = {
   { false, "[0,", "Expect expression." },
   { true, "[];",
       "== <script> ==\n"
-      "0000    1 OP_LIST_INIT\n"
-      "0001    | OP_POP\n"
-      "0002    | OP_NIL\n"
-      "0003    | OP_RETURN\n" },
+      "0000    1 OP_LIST_BUILD       0\n"
+      "0002    | OP_POP\n"
+      "0003    | OP_NIL\n"
+      "0004    | OP_RETURN\n" },
   { true, "[nil];",
       "== <script> ==\n"
-      "0000    1 OP_LIST_INIT\n"
-      "0001    | OP_NIL\n"
-      "0002    | OP_LIST_DATA\n"
+      "0000    1 OP_LIST_TEMPLATE    0 <list 1>\n"
       "0003    | OP_POP\n"
       "0004    | OP_NIL\n"
       "0005    | OP_RETURN\n" },
-  { true, "[nil,false,true,];",
+  { true, "[nil,false,true,\"hi\",];",
       "== <script> ==\n"
-      "0000    1 OP_LIST_INIT\n"
-      "0001    | OP_NIL\n"
-      "0002    | OP_LIST_DATA\n"
-      "0003    | OP_FALSE\n"
-      "0004    | OP_LIST_DATA\n"
-      "0005    | OP_TRUE\n"
-      "0006    | OP_LIST_DATA\n"
-      "0007    | OP_POP\n"
-      "0008    | OP_NIL\n"
-      "0009    | OP_RETURN\n" },
+      "0000    1 OP_LIST_TEMPLATE    0 <list 4>\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
   { true, "[nil,true or false,3*2+1,\"hi\",[]];",
       "== <script> ==\n"
-      "0000    1 OP_LIST_INIT\n"
-      "0001    | OP_NIL\n"
-      "0002    | OP_LIST_DATA\n"
-      "0003    | OP_TRUE\n"
-      "0004    | OP_JUMP_IF_FALSE    4 -> 10\n"
-      "0007    | OP_JUMP             7 -> 12\n"
-      "0010    | OP_POP\n"
-      "0011    | OP_FALSE\n"
-      "0012    | OP_LIST_DATA\n"
-      "0013    | OP_CONSTANT         0 '3'\n"
-      "0016    | OP_CONSTANT         1 '2'\n"
-      "0019    | OP_MULTIPLY\n"
-      "0020    | OP_ADD_C            2 '1'\n"
-      "0023    | OP_LIST_DATA\n"
-      "0024    | OP_CONSTANT         3 'hi'\n"
-      "0027    | OP_LIST_DATA\n"
-      "0028    | OP_LIST_INIT\n"
-      "0029    | OP_LIST_DATA\n"
-      "0030    | OP_POP\n"
-      "0031    | OP_NIL\n"
-      "0032    | OP_RETURN\n" },
+      "0000    1 OP_NIL\n"
+      "0001    | OP_TRUE\n"
+      "0002    | OP_CONSTANT         0 '7'\n"
+      "0005    | OP_CONSTANT         1 'hi'\n"
+      "0008    | OP_LIST_BUILD       0\n"
+      "0010    | OP_LIST_BUILD       5\n"
+      "0012    | OP_POP\n"
+      "0013    | OP_NIL\n"
+      "0014    | OP_RETURN\n" },
 };
 
 DUMP_SRC(Lists, lists, 8);
@@ -1444,66 +1983,48 @@ SourceToDump maps[] = {
   { false, "({[\"a\"])", "Expect ':' after map key." },
   { true, "({});",
       "== <script> ==\n"
-      "0000    1 OP_MAP_INIT\n"
-      "0001    | OP_POP\n"
-      "0002    | OP_NIL\n"
-      "0003    | OP_RETURN\n" },
+      "0000    1 OP_MAP_BUILD        0\n"
+      "0002    | OP_POP\n"
+      "0003    | OP_NIL\n"
+      "0004    | OP_RETURN\n" },
   { true, "({a:1});",
       "== <script> ==\n"
-      "0000    1 OP_MAP_INIT\n"
-      "0001    | OP_CONSTANT         0 'a'\n"
-      "0004    | OP_CONSTANT         1 '1'\n"
-      "0007    | OP_MAP_DATA\n"
-      "0008    | OP_POP\n"
-      "0009    | OP_NIL\n"
-      "0010    | OP_RETURN\n" },
+      "0000    1 OP_MAP_TEMPLATE     0 <map>\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
   { true, "({a:1,});",
       "== <script> ==\n"
-      "0000    1 OP_MAP_INIT\n"
-      "0001    | OP_CONSTANT         0 'a'\n"
-      "0004    | OP_CONSTANT         1 '1'\n"
-      "0007    | OP_MAP_DATA\n"
-      "0008    | OP_POP\n"
-      "0009    | OP_NIL\n"
-      "0010    | OP_RETURN\n" },
+      "0000    1 OP_MAP_TEMPLATE     0 <map>\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
   { true, "({[\"a\"+\"b\"]:1+2});",
       "== <script> ==\n"
-      "0000    1 OP_MAP_INIT\n"
-      "0001    | OP_CONSTANT         0 'a'\n"
-      "0004    | OP_ADD_C            1 'b'\n"
-      "0007    | OP_CONSTANT         2 '1'\n"
-      "0010    | OP_ADD_C            3 '2'\n"
-      "0013    | OP_MAP_DATA\n"
+      "0000    1 OP_MAP_TEMPLATE     0 <map>\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "({a:1,b:x});",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 'a'\n"
+      "0003    | OP_CONSTANT         1 '1'\n"
+      "0006    | OP_CONSTANT         2 'b'\n"
+      "0009    | OP_GET_GLOBAL_I     0\n"
+      "0012    | OP_MAP_BUILD        2\n"
       "0014    | OP_POP\n"
       "0015    | OP_NIL\n"
       "0016    | OP_RETURN\n" },
-  { true, "({a:1,b:2});",
-      "== <script> ==\n"
-      "0000    1 OP_MAP_INIT\n"
-      "0001    | OP_CONSTANT         0 'a'\n"
-      "0004    | OP_CONSTANT         1 '1'\n"
-      "0007    | OP_MAP_DATA\n"
-      "0008    | OP_CONSTANT         2 'b'\n"
-      "0011    | OP_CONSTANT         3 '2'\n"
-      "0014    | OP_MAP_DATA\n"
-      "0015    | OP_POP\n"
-      "0016    | OP_NIL\n"
-      "0017    | OP_RETURN\n" },
   { true, "({a:1,b:{c:2}});",
       "== <script> ==\n"
-      "0000    1 OP_MAP_INIT\n"
-      "0001    | OP_CONSTANT         0 'a'\n"
-      "0004    | OP_CONSTANT         1 '1'\n"
-      "0007    | OP_MAP_DATA\n"
-      "0008    | OP_CONSTANT         2 'b'\n"
-      "0011    | OP_MAP_INIT\n"
-      "0012    | OP_CONSTANT         3 'c'\n"
-      "0015    | OP_CONSTANT         4 '2'\n"
-      "0018    | OP_MAP_DATA\n"
-      "0019    | OP_MAP_DATA\n"
-      "0020    | OP_POP\n"
-      "0021    | OP_NIL\n"
-      "0022    | OP_RETURN\n" },
+      "0000    1 OP_CONSTANT         0 'a'\n"
+      "0003    | OP_CONSTANT         1 '1'\n"
+      "0006    | OP_CONSTANT         2 'b'\n"
+      "0009    | OP_MAP_TEMPLATE     3 <map>\n"
+      "0012    | OP_MAP_BUILD        2\n"
+      "0014    | OP_POP\n"
+      "0015    | OP_NIL\n"
+      "0016    | OP_RETURN\n" },
 };
 
 DUMP_SRC(Maps, maps, 17);
@@ -1551,272 +2072,119 @@ SourceToDump constants[] = {
       "240 + 241 + 242 + 243 + 244 + 245 + 246 + 247 + 248 + 249 +\n"
       "250 + 251 + 252 + 253 + 254 + 255 + 256 + 257 + 258 + 259 ;\n",
       "== <script> ==\n"
-      "0000    2 OP_CONSTANT         0 '0'\n"
-      "0003    | OP_ADD_C            1 '1'\n"
-      "0006    | OP_ADD_C            2 '2'\n"
-      "0009    | OP_ADD_C            3 '3'\n"
-      "0012    | OP_ADD_C            4 '4'\n"
-      "0015    | OP_ADD_C            5 '5'\n"
-      "0018    | OP_ADD_C            6 '6'\n"
-      "0021    | OP_ADD_C            7 '7'\n"
-      "0024    | OP_ADD_C            8 '8'\n"
-      "0027    | OP_ADD_C            9 '9'\n"
-      "0030    3 OP_ADD_C           10 '10'\n"
-      "0033    | OP_ADD_C           11 '11'\n"
-      "0036    | OP_ADD_C           12 '12'\n"
-      "0039    | OP_ADD_C           13 '13'\n"
-      "0042    | OP_ADD_C           14 '14'\n"
-      "0045    | OP_ADD_C           15 '15'\n"
-      "0048    | OP_ADD_C           16 '16'\n"
-      "0051    | OP_ADD_C           17 '17'\n"
-      "0054    | OP_ADD_C           18 '18'\n"
-      "0057    | OP_ADD_C           19 '19'\n"
-      "0060    4 OP_ADD_C           20 '20'\n"
-      "0063    | OP_ADD_C           21 '21'\n"
-      "0066    | OP_ADD_C           22 '22'\n"
-      "0069    | OP_ADD_C           23 '23'\n"
-      "0072    | OP_ADD_C           24 '24'\n"
-      "0075    | OP_ADD_C           25 '25'\n"
-      "0078    | OP_ADD_C           26 '26'\n"
-      "0081    | OP_ADD_C           27 '27'\n"
-      "0084    | OP_ADD_C           28 '28'\n"
-      "0087    | OP_ADD_C           29 '29'\n"
-      "0090    5 OP_ADD_C           30 '30'\n"
-      "0093    | OP_ADD_C           31 '31'\n"
-      "0096    | OP_ADD_C           32 '32'\n"
-      "0099    | OP_ADD_C           33 '33'\n"
-      "0102    | OP_ADD_C           34 '34'\n"
-      "0105    | OP_ADD_C           35 '35'\n"
-      "0108    | OP_ADD_C           36 '36'\n"
-      "0111    | OP_ADD_C           37 '37'\n"
-      "0114    | OP_ADD_C           38 '38'\n"
-      "0117    | OP_ADD_C           39 '39'\n"
-      "0120    6 OP_ADD_C           40 '40'\n"
-      "0123    | OP_ADD_C           41 '41'\n"
-      "0126    | OP_ADD_C           42 '42'\n"
-      "0129    | OP_ADD_C           43 '43'\n"
-      "0132    | OP_ADD_C           44 '44'\n"
-      "0135    | OP_ADD_C           45 '45'\n"
-      "0138    | OP_ADD_C           46 '46'\n"
-      "0141    | OP_ADD_C           47 '47'\n"
-      "0144    | OP_ADD_C           48 '48'\n"
-      "0147    | OP_ADD_C           49 '49'\n"
-      "0150    7 OP_ADD_C           50 '50'\n"
-      "0153    | OP_ADD_C           51 '51'\n"
-      "0156    | OP_ADD_C           52 '52'\n"
-      "0159    | OP_ADD_C           53 '53'\n"
-      "0162    | OP_ADD_C           54 '54'\n"
-      "0165    | OP_ADD_C           55 '55'\n"
-      "0168    | OP_ADD_C           56 '56'\n"
-      "0171    | OP_ADD_C           57 '57'\n"
-      "0174    | OP_ADD_C           58 '58'\n"
-      "0177    | OP_ADD_C           59 '59'\n"
-      "0180    8 OP_ADD_C           60 '60'\n"
-      "0183    | OP_ADD_C           61 '61'\n"
-      "0186    | OP_ADD_C           62 '62'\n"
-      "0189    | OP_ADD_C           63 '63'\n"
-      "0192    | OP_ADD_C           64 '64'\n"
-      "0195    | OP_ADD_C           65 '65'\n"
-      "0198    | OP_ADD_C           66 '66'\n"
-      "0201    | OP_ADD_C           67 '67'\n"
-      "0204    | OP_ADD_C           68 '68'\n"
-      "0207    | OP_ADD_C           69 '69'\n"
-      "0210    9 OP_ADD_C           70 '70'\n"
-      "0213    | OP_ADD_C           71 '71'\n"
-      "0216    | OP_ADD_C           72 '72'\n"
-      "0219    | OP_ADD_C           73 '73'\n"
-      "0222    | OP_ADD_C           74 '74'\n"
-      "0225    | OP_ADD_C           75 '75'\n"
-      "0228    | OP_ADD_C           76 '76'\n"
-      "0231    | OP_ADD_C           77 '77'\n"
-      "0234    | OP_ADD_C           78 '78'\n"
-      "0237    | OP_ADD_C           79 '79'\n"
-      "0240   10 OP_ADD_C           80 '80'\n"
-      "0243    | OP_ADD_C           81 '81'\n"
-      "0246    | OP_ADD_C           82 '82'\n"
-      "0249    | OP_ADD_C           83 '83'\n"
-      "0252    | OP_ADD_C           84 '84'\n"
-      "0255    | OP_ADD_C           85 '85'\n"
-      "0258    | OP_ADD_C           86 '86'\n"
-      "0261    | OP_ADD_C           87 '87'\n"
-      "0264    | OP_ADD_C           88 '88'\n"
-      "0267    | OP_ADD_C           89 '89'\n"
-      "0270   11 OP_ADD_C           90 '90'\n"
-      "0273    | OP_ADD_C           91 '91'\n"
-      "0276    | OP_ADD_C           92 '92'\n"
-      "0279    | OP_ADD_C           93 '93'\n"
-      "0282    | OP_ADD_C           94 '94'\n"
-      "0285    | OP_ADD_C           95 '95'\n"
-      "0288    | OP_ADD_C           96 '96'\n"
-      "0291    | OP_ADD_C           97 '97'\n"
-      "0294    | OP_ADD_C           98 '98'\n"
-      "0297    | OP_ADD_C           99 '99'\n"
-      "0300   12 OP_ADD_C          100 '100'\n"
-      "0303    | OP_ADD_C          101 '101'\n"
-      "0306    | OP_ADD_C          102 '102'\n"
-      "0309    | OP_ADD_C          103 '103'\n"
-      "0312    | OP_ADD_C          104 '104'\n"
-      "0315    | OP_ADD_C          105 '105'\n"
-      "0318    | OP_ADD_C          106 '106'\n"
-      "0321    | OP_ADD_C          107 '107'\n"
-      "0324    | OP_ADD_C          108 '108'\n"
-      "0327    | OP_ADD_C          109 '109'\n"
-      "0330   13 OP_ADD_C          110 '110'\n"
-      "0333    | OP_ADD_C          111 '111'\n"
-      "0336    | OP_ADD_C          112 '112'\n"
-      "0339    | OP_ADD_C          113 '113'\n"
-      "0342    | OP_ADD_C          114 '114'\n"
-      "0345    | OP_ADD_C          115 '115'\n"
-      "0348    | OP_ADD_C          116 '116'\n"
-      "0351    | OP_ADD_C          117 '117'\n"
-      "0354    | OP_ADD_C          118 '118'\n"
-      "0357    | OP_ADD_C          119 '119'\n"
-      "0360   14 OP_ADD_C          120 '120'\n"
-      "0363    | OP_ADD_C          121 '121'\n"
-      "0366    | OP_ADD_C          122 '122'\n"
-      "0369    | OP_ADD_C          123 '123'\n"
-      "0372    | OP_ADD_C          124 '124'\n"
-      "0375    | OP_ADD_C          125 '125'\n"
-      "0378    | OP_ADD_C          126 '126'\n"
-      "0381    | OP_ADD_C          127 '127'\n"
-      "0384    | OP_ADD_C          128 '128'\n"
-      "0387    | OP_ADD_C          129 '129'\n"
-      "0390   15 OP_ADD_C          130 '130'\n"
-      "0393    | OP_ADD_C          131 '131'\n"
-      "0396    | OP_ADD_C          132 '132'\n"
-      "0399    | OP_ADD_C          133 '133'\n"
-      "0402    | OP_ADD_C          134 '134'\n"
-      "0405    | OP_ADD_C          135 '135'\n"
-      "0408    | OP_ADD_C          136 '136'\n"
-      "0411    | OP_ADD_C          137 '137'\n"
-      "0414    | OP_ADD_C          138 '138'\n"
-      "0417    | OP_ADD_C          139 '139'\n"
-      "0420   16 OP_ADD_C          140 '140'\n"
-      "0423    | OP_ADD_C          141 '141'\n"
-      "0426    | OP_ADD_C          142 '142'\n"
-      "0429    | OP_ADD_C          143 '143'\n"
-      "0432    | OP_ADD_C          144 '144'\n"
-      "0435    | OP_ADD_C          145 '145'\n"
-      "0438    | OP_ADD_C          146 '146'\n"
-      "0441    | OP_ADD_C          147 '147'\n"
-      "0444    | OP_ADD_C          148 '148'\n"
-      "0447    | OP_ADD_C          149 '149'\n"
-      "0450   17 OP_ADD_C          150 '150'\n"
-      "0453    | OP_ADD_C          151 '151'\n"
-      "0456    | OP_ADD_C          152 '152'\n"
-      "0459    | OP_ADD_C          153 '153'\n"
-      "0462    | OP_ADD_C          154 '154'\n"
-      "0465    | OP_ADD_C          155 '155'\n"
-      "0468    | OP_ADD_C          156 '156'\n"
-      "0471    | OP_ADD_C          157 '157'\n"
-      "0474    | OP_ADD_C          158 '158'\n"
-      "0477    | OP_ADD_C          159 '159'\n"
-      "0480   18 OP_ADD_C          160 '160'\n"
-      "0483    | OP_ADD_C          161 '161'\n"
-      "0486    | OP_ADD_C          162 '162'\n"
-      "0489    | OP_ADD_C          163 '163'\n"
-      "0492    | OP_ADD_C          164 '164'\n"
-      "0495    | OP_ADD_C          165 '165'\n"
-      "0498    | OP_ADD_C          166 '166'\n"
-      "0501    | OP_ADD_C          167 '167'\n"
-      "0504    | OP_ADD_C          168 '168'\n"
-      "0507    | OP_ADD_C          169 '169'\n"
-      "0510   19 OP_ADD_C          170 '170'\n"
-      "0513    | OP_ADD_C          171 '171'\n"
-      "0516    | OP_ADD_C          172 '172'\n"
-      "0519    | OP_ADD_C          173 '173'\n"
-      "0522    | OP_ADD_C          174 '174'\n"
-      "0525    | OP_ADD_C          175 '175'\n"
-      "0528    | OP_ADD_C          176 '176'\n"
-      "0531    | OP_ADD_C          177 '177'\n"
-      "0534    | OP_ADD_C          178 '178'\n"
-      "0537    | OP_ADD_C          179 '179'\n"
-      "0540   20 OP_ADD_C          180 '180'\n"
-      "0543    | OP_ADD_C          181 '181'\n"
-      "0546    | OP_ADD_C          182 '182'\n"
-      "0549    | OP_ADD_C          183 '183'\n"
-      "0552    | OP_ADD_C          184 '184'\n"
-      "0555    | OP_ADD_C          185 '185'\n"
-      "0558    | OP_ADD_C          186 '186'\n"
-      "0561    | OP_ADD_C          187 '187'\n"
-      "0564    | OP_ADD_C          188 '188'\n"
-      "0567    | OP_ADD_C          189 '189'\n"
-      "0570   21 OP_ADD_C          190 '190'\n"
-      "0573    | OP_ADD_C          191 '191'\n"
-      "0576    | OP_ADD_C          192 '192'\n"
-      "0579    | OP_ADD_C          193 '193'\n"
-      "0582    | OP_ADD_C          194 '194'\n"
-      "0585    | OP_ADD_C          195 '195'\n"
-      "0588    | OP_ADD_C          196 '196'\n"
-      "0591    | OP_ADD_C          197 '197'\n"
-      "0594    | OP_ADD_C          198 '198'\n"
-      "0597    | OP_ADD_C          199 '199'\n"
-      "0600   22 OP_ADD_C          200 '200'\n"
-      "0603    | OP_ADD_C          201 '201'\n"
-      "0606    | OP_ADD_C          202 '202'\n"
-      "0609    | OP_ADD_C          203 '203'\n"
-      "0612    | OP_ADD_C          204 '204'\n"
-      "0615    | OP_ADD_C          205 '205'\n"
-      "0618    | OP_ADD_C          206 '206'\n"
-      "0621    | OP_ADD_C          207 '207'\n"
-      "0624    | OP_ADD_C          208 '208'\n"
-      "0627    | OP_ADD_C          209 '209'\n"
-      "0630   23 OP_ADD_C          210 '210'\n"
-      "0633    | OP_ADD_C          211 '211'\n"
-      "0636    | OP_ADD_C          212 '212'\n"
-      "0639    | OP_ADD_C          213 '213'\n"
-      "0642    | OP_ADD_C          214 '214'\n"
-      "0645    | OP_ADD_C          215 '215'\n"
-      "0648    | OP_ADD_C          216 '216'\n"
-      "0651    | OP_ADD_C          217 '217'\n"
-      "0654    | OP_ADD_C          218 '218'\n"
-      "0657    | OP_ADD_C          219 '219'\n"
-      "0660   24 OP_ADD_C          220 '220'\n"
-      "0663    | OP_ADD_C          221 '221'\n"
-      "0666    | OP_ADD_C          222 '222'\n"
-      "0669    | OP_ADD_C          223 '223'\n"
-      "0672    | OP_ADD_C          224 '224'\n"
-      "0675    | OP_ADD_C          225 '225'\n"
-      "0678    | OP_ADD_C          226 '226'\n"
-      "0681    | OP_ADD_C          227 '227'\n"
-      "0684    | OP_ADD_C          228 '228'\n"
-      "0687    | OP_ADD_C          229 '229'\n"
-      "0690   25 OP_ADD_C          230 '230'\n"
-      "0693    | OP_ADD_C          231 '231'\n"
-      "0696    | OP_ADD_C          232 '232'\n"
-      "0699    | OP_ADD_C          233 '233'\n"
-      "0702    | OP_ADD_C          234 '234'\n"
-      "0705    | OP_ADD_C          235 '235'\n"
-      "0708    | OP_ADD_C          236 '236'\n"
-      "0711    | OP_ADD_C          237 '237'\n"
-      "0714    | OP_ADD_C          238 '238'\n"
-      "0717    | OP_ADD_C          239 '239'\n"
-      "0720   26 OP_ADD_C          240 '240'\n"
-      "0723    | OP_ADD_C          241 '241'\n"
-      "0726    | OP_ADD_C          242 '242'\n"
-      "0729    | OP_ADD_C          243 '243'\n"
-      "0732    | OP_ADD_C          244 '244'\n"
-      "0735    | OP_ADD_C          245 '245'\n"
-      "0738    | OP_ADD_C          246 '246'\n"
-      "0741    | OP_ADD_C          247 '247'\n"
-      "0744    | OP_ADD_C          248 '248'\n"
-      "0747    | OP_ADD_C          249 '249'\n"
-      "0750   27 OP_ADD_C          250 '250'\n"
-      "0753    | OP_ADD_C          251 '251'\n"
-      "0756    | OP_ADD_C          252 '252'\n"
-      "0759    | OP_ADD_C          253 '253'\n"
-      "0762    | OP_ADD_C          254 '254'\n"
-      "0765    | OP_ADD_C          255 '255'\n"
-      "0768    | OP_ADD_C          256 '256'\n"
-      "0771    | OP_ADD_C          257 '257'\n"
-      "0774    | OP_ADD_C          258 '258'\n"
-      "0777    | OP_ADD_C          259 '259'\n"
-      "0780    | OP_PRINT\n"
-      "0781   28 OP_NIL\n"
-      "0782    | OP_RETURN\n" },
+      "0000   27 OP_CONSTANT         0 '33670'\n"
+      "0003    | OP_PRINT\n"
+      "0004   28 OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "print 1 + 2; print 1; print 3;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '3'\n"
+      "0003    | OP_PRINT\n"
+      "0004    | OP_CONSTANT         1 '1'\n"
+      "0007    | OP_PRINT\n"
+      "0008    | OP_CONSTANT         0 '3'\n"
+      "0011    | OP_PRINT\n"
+      "0012    | OP_NIL\n"
+      "0013    | OP_RETURN\n" },
+  { true, "print -0; print 0; print -0; print 0;",
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '-0'\n"
+      "0003    | OP_PRINT\n"
+      "0004    | OP_CONSTANT         1 '0'\n"
+      "0007    | OP_PRINT\n"
+      "0008    | OP_CONSTANT         0 '-0'\n"
+      "0011    | OP_PRINT\n"
+      "0012    | OP_CONSTANT         1 '0'\n"
+      "0015    | OP_PRINT\n"
+      "0016    | OP_NIL\n"
+      "0017    | OP_RETURN\n" },
+};
+
+DUMP_SRC(Constants, constants, 3);
+
+SourceToDump optimized[] = {
+  { true, "fun f(a) { if (a) return 1; else return 2; }",
+      "== f ==\n"
+      "0000    1 OP_GET_LOCAL        1\n"
+      "0002    | OP_PJMP_IF_FALSE    2 -> 9\n"
+      "0005    | OP_CONSTANT         0 '1'\n"
+      "0008    | OP_RETURN\n"
+      "0009    | OP_CONSTANT         1 '2'\n"
+      "0012    | OP_RETURN\n"
+      "== <script> ==\n"
+      "0000    1 OP_CONSTANT         0 '<fn f>'\n"
+      "0003    | OP_DEFINE_GLOBAL_I    0\n"
+      "0006    | OP_NIL\n"
+      "0007    | OP_RETURN\n" },
+  { true, "print a and b and c;",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_JUMP_IF_FALSE    3 -> 17\n"
+      "0006    | OP_POP\n"
+      "0007    | OP_GET_GLOBAL_I     1\n"
+      "0010    | OP_JUMP_IF_FALSE   10 -> 17\n"
+      "0013    | OP_POP\n"
+      "0014    | OP_GET_GLOBAL_I     2\n"
+      "0017    | OP_PRINT\n"
+      "0018    | OP_NIL\n"
+      "0019    | OP_RETURN\n" },
+  { true, "for (;;0) 1;",
+      "== <script> ==\n"
+      "0000    1 OP_LOOP             0 -> 0\n" },
+  { true, "while (a) { if (b) print 1; else print 2; }",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_PJMP_IF_FALSE    3 -> 26\n"
+      "0006    | OP_GET_GLOBAL_I     1\n"
+      "0009    | OP_PJMP_IF_FALSE    9 -> 19\n"
+      "0012    | OP_CONSTANT         0 '1'\n"
+      "0015    | OP_PRINT\n"
+      "0016    | OP_LOOP            16 -> 0\n"
+      "0019    | OP_CONSTANT         1 '2'\n"
+      "0022    | OP_PRINT\n"
+      "0023    | OP_LOOP            23 -> 0\n"
+      "0026    | OP_NIL\n"
+      "0027    | OP_RETURN\n" },
+  { true, "a; 1; \"x\"; { var b; b; }",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_POP\n"
+      "0004    | OP_NIL\n"
+      "0005    | OP_RETURN\n" },
+  { true, "print a != b; print a >= b; print a <= b; print a >= 1;",
+      "== <script> ==\n"
+      "0000    1 OP_GET_GLOBAL_I     0\n"
+      "0003    | OP_GET_GLOBAL_I     1\n"
+      "0006    | OP_NOT_EQUAL\n"
+      "0007    | OP_PRINT\n"
+      "0008    | OP_GET_GLOBAL_I     0\n"
+      "0011    | OP_GET_GLOBAL_I     1\n"
+      "0014    | OP_NOT_LESS\n"
+      "0015    | OP_PRINT\n"
+      "0016    | OP_GET_GLOBAL_I     0\n"
+      "0019    | OP_GET_GLOBAL_I     1\n"
+      "0022    | OP_NOT_GREATER\n"
+      "0023    | OP_PRINT\n"
+      "0024    | OP_GET_GLOBAL_I     0\n"
+      "0027    | OP_NOT_LESS_C       0 '1'\n"
+      "0030    | OP_PRINT\n"
+      "0031    | OP_NIL\n"
+      "0032    | OP_RETURN\n" },
+  { true, "var a; a = 1; { var b; b = 2; }",
+      "== <script> ==\n"
+      "0000    1 OP_NIL\n"
+      "0001    | OP_DEFINE_GLOBAL_I    0\n"
+      "0004    | OP_CONSTANT         0 '1'\n"
+      "0007    | OP_SET_GLOBAL_I_POP    0\n"
+      "0010    | OP_NIL\n"
+      "0011    | OP_CONSTANT         1 '2'\n"
+      "0014    | OP_SET_LOCAL_POP    1\n"
+      "0016    | OP_POP\n"
+      "0017    | OP_NIL\n"
+      "0018    | OP_RETURN\n" },
 };
 
-DUMP_SRC(Constants, constants, 1);
+DUMP_OPTIMIZED_SRC(Optimized, optimized, 7);
 
 UTEST_STATE();
 
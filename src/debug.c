@@ -23,6 +23,17 @@ static int constantInstruction(
   return offset + 3;
 }
 
+// Like constantInstruction, but without printing every element.
+static int templateInstruction(
+    FILE* ferr, const char* name, Chunk* chunk, int offset) {
+  uint16_t constant = (uint16_t)(chunk->code[offset + 1] << 8);
+  constant |= chunk->code[offset + 2];
+  fprintf(ferr, "%-16s %4d ", name, constant);
+  printValueShallow(ferr, chunk->constants.values[constant]);
+  fprintf(ferr, "\n");
+  return offset + 3;
+}
+
 static int invokeInstruction(
     FILE* ferr, const char* name, Chunk* chunk, int offset) {
   uint16_t constant = (uint16_t)(chunk->code[offset + 1] << 8);
@@ -63,14 +74,85 @@ static int jumpInstruction(
   return offset + 3;
 }
 
+static int compareJumpLCInstruction(
+    FILE* ferr, const char* name, Chunk* chunk, int offset) {
+  uint8_t slot = chunk->code[offset + 1];
+  uint16_t constant = (uint16_t)(chunk->code[offset + 2] << 8);
+  constant |= chunk->code[offset + 3];
+  uint16_t jump = (uint16_t)(chunk->code[offset + 4] << 8);
+  jump |= chunk->code[offset + 5];
+  fprintf(ferr, "%-16s %4d %4d '", name, slot, constant);
+  printValue(ferr, chunk->constants.values[constant]);
+  fprintf(ferr, "' %d -> %d\n", offset, offset + 6 + jump);
+  return offset + 6;
+}
+
+static int compareJumpLLInstruction(
+    FILE* ferr, const char* name, Chunk* chunk, int offset) {
+  uint8_t a = chunk->code[offset + 1];
+  uint8_t b = chunk->code[offset + 2];
+  uint16_t jump = (uint16_t)(chunk->code[offset + 3] << 8);
+  jump |= chunk->code[offset + 4];
+  fprintf(ferr, "%-16s %4d %4d %d -> %d\n", name, a, b, offset,
+      offset + 5 + jump);
+  return offset + 5;
+}
+
+static int iterNextInstruction(
+    FILE* ferr, const char* name, Chunk* chunk, int offset) {
+  uint8_t slot = chunk->code[offset + 1];
+  uint8_t varCount = chunk->code[offset + 2];
+  uint16_t jump = (uint16_t)(chunk->code[offset + 3] << 8);
+  jump |= chunk->code[offset + 4];
+  fprintf(ferr, "%-16s %4d (%d vars) %d -> %d\n", name, slot, varCount,
+      offset, offset + 5 + jump);
+  return offset + 5;
+}
+
+static int hoistPropertyInstruction(
+    FILE* ferr, const char* name, Chunk* chunk, int offset) {
+  uint16_t constant = (uint16_t)(chunk->code[offset + 1] << 8);
+  constant |= chunk->code[offset + 2];
+  uint8_t slot = chunk->code[offset + 3];
+  fprintf(ferr, "%-16s (slot %d) %4d '", name, slot, constant);
+  printValue(ferr, chunk->constants.values[constant]);
+  fprintf(ferr, "'\n");
+  return offset + 4;
+}
+
+static int incLocalInstruction(
+    FILE* ferr, const char* name, Chunk* chunk, int offset) {
+  uint8_t slot = chunk->code[offset + 1];
+  uint16_t constant = (uint16_t)(chunk->code[offset + 2] << 8);
+  constant |= chunk->code[offset + 3];
+  fprintf(ferr, "%-16s %4d %4d '", name, slot, constant);
+  printValue(ferr, chunk->constants.values[constant]);
+  fprintf(ferr, "'\n");
+  return offset + 4;
+}
+
+static int getHoistedInstruction(
+    FILE* ferr, const char* name, Chunk* chunk, int offset) {
+  uint8_t slot = chunk->code[offset + 1];
+  uint16_t jump = (uint16_t)(chunk->code[offset + 2] << 8);
+  jump |= chunk->code[offset + 3];
+  fprintf(ferr, "%-16s %4d %d -> %d\n", name, slot, offset,
+      offset + 4 + jump);
+  return offset + 4;
+}
+
 int disassembleInstruction(FILE* ferr, Chunk* chunk, int offset) {
   fprintf(ferr, "%04d ", offset);
-  if (offset > 0 && chunk->lines[offset] == chunk->lines[offset - 1]) {
+  int line = getLine(chunk, offset);
+  if (offset > 0 && line == getLine(chunk, offset - 1)) {
     fprintf(ferr, "   | ");
   } else {
-    fprintf(ferr, "%4d ", chunk->lines[offset]);
+    fprintf(ferr, "%4d ", line);
   }
+  return disassembleOperation(ferr, chunk, offset);
+}
 
+int disassembleOperation(FILE* ferr, Chunk* chunk, int offset) {
   uint8_t instruction = chunk->code[offset];
   switch (instruction) {
     case OP_CONSTANT:
@@ -79,10 +161,15 @@ int disassembleInstruction(FILE* ferr, Chunk* chunk, int offset) {
     case OP_TRUE: return simpleInstruction(ferr, "OP_TRUE", offset);
     case OP_FALSE: return simpleInstruction(ferr, "OP_FALSE", offset);
     case OP_POP: return simpleInstruction(ferr, "OP_POP", offset);
+    case OP_DUP: return simpleInstruction(ferr, "OP_DUP", offset);
     case OP_GET_LOCAL:
       return byteInstruction(ferr, "OP_GET_LOCAL", chunk, offset);
     case OP_SET_LOCAL:
       return byteInstruction(ferr, "OP_SET_LOCAL", chunk, offset);
+    case OP_SET_LOCAL_POP:
+      return byteInstruction(ferr, "OP_SET_LOCAL_POP", chunk, offset);
+    case OP_INC_LOCAL:
+      return incLocalInstruction(ferr, "OP_INC_LOCAL", chunk, offset);
     case OP_GET_GLOBAL:
       return constantInstruction(ferr, "OP_GET_GLOBAL", chunk, offset);
     case OP_GET_GLOBAL_I:
@@ -90,10 +177,16 @@ int disassembleInstruction(FILE* ferr, Chunk* chunk, int offset) {
     case OP_DEFINE_GLOBAL:
       return constantInstruction(
           ferr, "OP_DEFINE_GLOBAL", chunk, offset);
+    case OP_DEFINE_GLOBAL_I:
+      return shortInstruction(
+          ferr, "OP_DEFINE_GLOBAL_I", chunk, offset);
     case OP_SET_GLOBAL:
       return constantInstruction(ferr, "OP_SET_GLOBAL", chunk, offset);
     case OP_SET_GLOBAL_I:
       return shortInstruction(ferr, "OP_SET_GLOBAL_I", chunk, offset);
+    case OP_SET_GLOBAL_I_POP:
+      return shortInstruction(
+          ferr, "OP_SET_GLOBAL_I_POP", chunk, offset);
     case OP_GET_UPVALUE:
       return byteInstruction(ferr, "OP_GET_UPVALUE", chunk, offset);
     case OP_SET_UPVALUE:
@@ -101,31 +194,93 @@ int disassembleInstruction(FILE* ferr, Chunk* chunk, int offset) {
     case OP_GET_PROPERTY:
       return constantInstruction(
           ferr, "OP_GET_PROPERTY", chunk, offset);
+    case OP_HOIST_PROPERTY:
+      return hoistPropertyInstruction(
+          ferr, "OP_HOIST_PROPERTY", chunk, offset);
+    case OP_GET_HOISTED:
+      return getHoistedInstruction(
+          ferr, "OP_GET_HOISTED", chunk, offset);
     case OP_SET_PROPERTY:
       return constantInstruction(
           ferr, "OP_SET_PROPERTY", chunk, offset);
+    case OP_GET_PROPERTY_KEEP:
+      return constantInstruction(
+          ferr, "OP_GET_PROPERTY_KEEP", chunk, offset);
+    case OP_ADD_PROPERTY:
+      return constantInstruction(
+          ferr, "OP_ADD_PROPERTY", chunk, offset);
+    case OP_SUBTRACT_PROPERTY:
+      return constantInstruction(
+          ferr, "OP_SUBTRACT_PROPERTY", chunk, offset);
+    case OP_MULTIPLY_PROPERTY:
+      return constantInstruction(
+          ferr, "OP_MULTIPLY_PROPERTY", chunk, offset);
+    case OP_DIVIDE_PROPERTY:
+      return constantInstruction(
+          ferr, "OP_DIVIDE_PROPERTY", chunk, offset);
+    case OP_MODULO_PROPERTY:
+      return constantInstruction(
+          ferr, "OP_MODULO_PROPERTY", chunk, offset);
     case OP_GET_INDEX:
       return simpleInstruction(ferr, "OP_GET_INDEX", offset);
     case OP_SET_INDEX:
       return simpleInstruction(ferr, "OP_SET_INDEX", offset);
+    case OP_GET_INDEX_KEEP:
+      return simpleInstruction(ferr, "OP_GET_INDEX_KEEP", offset);
+    case OP_ADD_INDEX:
+      return simpleInstruction(ferr, "OP_ADD_INDEX", offset);
+    case OP_SUBTRACT_INDEX:
+      return simpleInstruction(ferr, "OP_SUBTRACT_INDEX", offset);
+    case OP_MULTIPLY_INDEX:
+      return simpleInstruction(ferr, "OP_MULTIPLY_INDEX", offset);
+    case OP_DIVIDE_INDEX:
+      return simpleInstruction(ferr, "OP_DIVIDE_INDEX", offset);
+    case OP_MODULO_INDEX:
+      return simpleInstruction(ferr, "OP_MODULO_INDEX", offset);
     case OP_GET_SUPER:
       return constantInstruction(ferr, "OP_GET_SUPER", chunk, offset);
     case OP_EQUAL: return simpleInstruction(ferr, "OP_EQUAL", offset);
+    case OP_NOT_EQUAL:
+      return simpleInstruction(ferr, "OP_NOT_EQUAL", offset);
     case OP_GREATER:
       return simpleInstruction(ferr, "OP_GREATER", offset);
+    case OP_GREATER_NN:
+      return simpleInstruction(ferr, "OP_GREATER_NN", offset);
+    case OP_NOT_GREATER:
+      return simpleInstruction(ferr, "OP_NOT_GREATER", offset);
     case OP_LESS: return simpleInstruction(ferr, "OP_LESS", offset);
+    case OP_LESS_NN:
+      return simpleInstruction(ferr, "OP_LESS_NN", offset);
+    case OP_NOT_LESS:
+      return simpleInstruction(ferr, "OP_NOT_LESS", offset);
     case OP_LESS_C:
       return constantInstruction(ferr, "OP_LESS_C", chunk, offset);
+    case OP_LESS_C_NN:
+      return constantInstruction(ferr, "OP_LESS_C_NN", chunk, offset);
+    case OP_NOT_LESS_C:
+      return constantInstruction(ferr, "OP_NOT_LESS_C", chunk, offset);
     case OP_ADD: return simpleInstruction(ferr, "OP_ADD", offset);
+    case OP_ADD_NN: return simpleInstruction(ferr, "OP_ADD_NN", offset);
     case OP_ADD_C:
       return constantInstruction(ferr, "OP_ADD_C", chunk, offset);
+    case OP_ADD_C_NN:
+      return constantInstruction(ferr, "OP_ADD_C_NN", chunk, offset);
     case OP_SUBTRACT:
       return simpleInstruction(ferr, "OP_SUBTRACT", offset);
+    case OP_SUBTRACT_NN:
+      return simpleInstruction(ferr, "OP_SUBTRACT_NN", offset);
     case OP_SUBTRACT_C:
       return constantInstruction(ferr, "OP_SUBTRACT_C", chunk, offset);
+    case OP_SUBTRACT_C_NN:
+      return constantInstruction(
+          ferr, "OP_SUBTRACT_C_NN", chunk, offset);
     case OP_MULTIPLY:
       return simpleInstruction(ferr, "OP_MULTIPLY", offset);
+    case OP_MULTIPLY_NN:
+      return simpleInstruction(ferr, "OP_MULTIPLY_NN", offset);
     case OP_DIVIDE: return simpleInstruction(ferr, "OP_DIVIDE", offset);
+    case OP_DIVIDE_NN:
+      return simpleInstruction(ferr, "OP_DIVIDE_NN", offset);
     case OP_MODULO: return simpleInstruction(ferr, "OP_MODULO", offset);
     case OP_NOT: return simpleInstruction(ferr, "OP_NOT", offset);
     case OP_NEGATE: return simpleInstruction(ferr, "OP_NEGATE", offset);
@@ -138,6 +293,36 @@ int disassembleInstruction(FILE* ferr, Chunk* chunk, int offset) {
     case OP_PJMP_IF_FALSE:
       return jumpInstruction(
           ferr, "OP_PJMP_IF_FALSE", 1, chunk, offset);
+    case OP_JUMP_IF_LESS_LC:
+      return compareJumpLCInstruction(
+          ferr, "OP_JUMP_IF_LESS_LC", chunk, offset);
+    case OP_JUMP_IF_NOT_LESS_LC:
+      return compareJumpLCInstruction(
+          ferr, "OP_JUMP_IF_NOT_LESS_LC", chunk, offset);
+    case OP_JUMP_IF_GREATER_LC:
+      return compareJumpLCInstruction(
+          ferr, "OP_JUMP_IF_GREATER_LC", chunk, offset);
+    case OP_JUMP_IF_NOT_GREATER_LC:
+      return compareJumpLCInstruction(
+          ferr, "OP_JUMP_IF_NOT_GREATER_LC", chunk, offset);
+    case OP_JUMP_IF_EQUAL_LC:
+      return compareJumpLCInstruction(
+          ferr, "OP_JUMP_IF_EQUAL_LC", chunk, offset);
+    case OP_JUMP_IF_NOT_EQUAL_LC:
+      return compareJumpLCInstruction(
+          ferr, "OP_JUMP_IF_NOT_EQUAL_LC", chunk, offset);
+    case OP_JUMP_IF_LESS_LL:
+      return compareJumpLLInstruction(
+          ferr, "OP_JUMP_IF_LESS_LL", chunk, offset);
+    case OP_JUMP_IF_NOT_LESS_LL:
+      return compareJumpLLInstruction(
+          ferr, "OP_JUMP_IF_NOT_LESS_LL", chunk, offset);
+    case OP_JUMP_IF_EQUAL_LL:
+      return compareJumpLLInstruction(
+          ferr, "OP_JUMP_IF_EQUAL_LL", chunk, offset);
+    case OP_JUMP_IF_NOT_EQUAL_LL:
+      return compareJumpLLInstruction(
+          ferr, "OP_JUMP_IF_NOT_EQUAL_LL", chunk, offset);
     case OP_LOOP:
       return jumpInstruction(ferr, "OP_LOOP", -1, chunk, offset);
     case OP_CALL:
@@ -167,14 +352,24 @@ int disassembleInstruction(FILE* ferr, Chunk* chunk, int offset) {
     }
     case OP_CLOSE_UPVALUE:
       return simpleInstruction(ferr, "OP_CLOSE_UPVALUE", offset);
-    case OP_LIST_INIT:
-      return simpleInstruction(ferr, "OP_LIST_INIT", offset);
+    case OP_LIST_BUILD:
+      return byteInstruction(ferr, "OP_LIST_BUILD", chunk, offset);
     case OP_LIST_DATA:
-      return simpleInstruction(ferr, "OP_LIST_DATA", offset);
-    case OP_MAP_INIT:
-      return simpleInstruction(ferr, "OP_MAP_INIT", offset);
+      return byteInstruction(ferr, "OP_LIST_DATA", chunk, offset);
+    case OP_LIST_TEMPLATE:
+      return templateInstruction(
+          ferr, "OP_LIST_TEMPLATE", chunk, offset);
+    case OP_MAP_BUILD:
+      return byteInstruction(ferr, "OP_MAP_BUILD", chunk, offset);
     case OP_MAP_DATA:
-      return simpleInstruction(ferr, "OP_MAP_DATA", offset);
+      return byteInstruction(ferr, "OP_MAP_DATA", chunk, offset);
+    case OP_MAP_TEMPLATE:
+      return templateInstruction(
+          ferr, "OP_MAP_TEMPLATE", chunk, offset);
+    case OP_ITER_INIT:
+      return simpleInstruction(ferr, "OP_ITER_INIT", offset);
+    case OP_ITER_NEXT:
+      return iterNextInstruction(ferr, "OP_ITER_NEXT", chunk, offset);
     case OP_RETURN: return simpleInstruction(ferr, "OP_RETURN", offset);
     case OP_CLASS:
       return constantInstruction(ferr, "OP_CLASS", chunk, offset);
@@ -8,5 +8,7 @@
 
 void disassembleChunk(FILE* ferr, Chunk* chunk, const char* name);
 int disassembleInstruction(FILE* ferr, Chunk* chunk, int offset);
+// Like disassembleInstruction, but without the offset and line.
+int disassembleOperation(FILE* ferr, Chunk* chunk, int offset);
 
 #endif
@@ -68,6 +68,31 @@ UTEST_F(DisassembleChunk, OpSetLocal) {
   EXPECT_STREQ(msg, ufx->err.buf);
 }
 
+UTEST_F(DisassembleChunk, OpSetLocalPop) {
+  writeChunk(&ufx->gc, &ufx->chunk, OP_SET_LOCAL_POP, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 0, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_SET_LOCAL_POP    0\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
+UTEST_F(DisassembleChunk, OpIncLocal) {
+  uint8_t constantIndex =
+      addConstant(&ufx->gc, &ufx->chunk, NUMBER_VAL(-1.0));
+  writeChunk(&ufx->gc, &ufx->chunk, OP_INC_LOCAL, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(constantIndex >> 8), 123);
+  writeChunk(
+      &ufx->gc, &ufx->chunk, (uint8_t)(constantIndex & 0xff), 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_INC_LOCAL        2    0 '-1'\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
 UTEST_F(DisassembleChunk, OpGetGlobal) {
   Table strings;
   initTable(&strings, 0.75);
@@ -125,6 +150,17 @@ UTEST_F(DisassembleChunk, OpDefineGlobal) {
   freeTable(&ufx->gc, &strings);
 }
 
+UTEST_F(DisassembleChunk, OpDefineGlobalI) {
+  writeChunk(&ufx->gc, &ufx->chunk, OP_DEFINE_GLOBAL_I, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 1, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_DEFINE_GLOBAL_I  258\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
 UTEST_F(DisassembleChunk, OpSetGlobal) {
   Table strings;
   initTable(&strings, 0.75);
@@ -159,6 +195,17 @@ UTEST_F(DisassembleChunk, OpSetGlobalI) {
   EXPECT_STREQ(msg, ufx->err.buf);
 }
 
+UTEST_F(DisassembleChunk, OpSetGlobalIPop) {
+  writeChunk(&ufx->gc, &ufx->chunk, OP_SET_GLOBAL_I_POP, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 1, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_SET_GLOBAL_I_POP  258\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
 UTEST_F(DisassembleChunk, OpGetUpvalue) {
   writeChunk(&ufx->gc, &ufx->chunk, OP_GET_UPVALUE, 123);
   writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
@@ -225,6 +272,39 @@ UTEST_F(DisassembleChunk, OpSetProperty) {
   freeTable(&ufx->gc, &strings);
 }
 
+UTEST_F(DisassembleChunk, OpAddProperty) {
+  Table strings;
+  initTable(&strings, 0.75);
+
+  ObjString* nameOStr = copyString(&ufx->gc, &strings, "foo", 3);
+  pushTemp(&ufx->gc, OBJ_VAL(nameOStr));
+
+  uint8_t name = addConstant(&ufx->gc, &ufx->chunk, OBJ_VAL(nameOStr));
+  writeChunk(&ufx->gc, &ufx->chunk, OP_GET_PROPERTY_KEEP, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(name >> 8), 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(name & 0xff), 123);
+  writeChunk(&ufx->gc, &ufx->chunk, OP_ADD_PROPERTY, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(name >> 8), 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(name & 0xff), 123);
+  writeChunk(&ufx->gc, &ufx->chunk, OP_GET_INDEX_KEEP, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, OP_MODULO_INDEX, 123);
+
+  popTemp(&ufx->gc);
+  int offset = 0;
+  for (int i = 0; i < 4; ++i) {
+    offset = disassembleInstruction(ufx->err.fptr, &ufx->chunk, offset);
+  }
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_GET_PROPERTY_KEEP    0 'foo'\n"
+                     "0003    | OP_ADD_PROPERTY     0 'foo'\n"
+                     "0006    | OP_GET_INDEX_KEEP\n"
+                     "0007    | OP_MODULO_INDEX\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+
+  freeTable(&ufx->gc, &strings);
+}
+
 UTEST_F(DisassembleChunk, OpGetSuper) {
   Table strings;
   initTable(&strings, 0.75);
@@ -262,6 +342,70 @@ UTEST_F(DisassembleChunk, OpLessC) {
   EXPECT_STREQ(msg, ufx->err.buf);
 }
 
+UTEST_F(DisassembleChunk, OpNotLessC) {
+  uint8_t constantIndex =
+      addConstant(&ufx->gc, &ufx->chunk, NUMBER_VAL(1.0));
+  writeChunk(&ufx->gc, &ufx->chunk, OP_NOT_LESS_C, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(constantIndex >> 8), 123);
+  writeChunk(
+      &ufx->gc, &ufx->chunk, (uint8_t)(constantIndex & 0xff), 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_NOT_LESS_C       0 '1'\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
+UTEST_F(DisassembleChunk, OpAddNN) {
+  writeChunk(&ufx->gc, &ufx->chunk, OP_ADD_NN, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_ADD_NN\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
+UTEST_F(DisassembleChunk, OpLessCNN) {
+  uint8_t constantIndex =
+      addConstant(&ufx->gc, &ufx->chunk, NUMBER_VAL(1.0));
+  writeChunk(&ufx->gc, &ufx->chunk, OP_LESS_C_NN, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(constantIndex >> 8), 123);
+  writeChunk(
+      &ufx->gc, &ufx->chunk, (uint8_t)(constantIndex & 0xff), 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_LESS_C_NN        0 '1'\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
+UTEST_F(DisassembleChunk, OpHoistProperty) {
+  uint8_t constantIndex =
+      addConstant(&ufx->gc, &ufx->chunk, NUMBER_VAL(1.0));
+  writeChunk(&ufx->gc, &ufx->chunk, OP_HOIST_PROPERTY, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(constantIndex >> 8), 123);
+  writeChunk(
+      &ufx->gc, &ufx->chunk, (uint8_t)(constantIndex & 0xff), 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_HOIST_PROPERTY (slot 2)    0 '1'\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
+UTEST_F(DisassembleChunk, OpGetHoisted) {
+  writeChunk(&ufx->gc, &ufx->chunk, OP_GET_HOISTED, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 0, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 7, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_GET_HOISTED      2 0 -> 11\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
 UTEST_F(DisassembleChunk, OpAddC) {
   uint8_t constantIndex =
       addConstant(&ufx->gc, &ufx->chunk, NUMBER_VAL(1.0));
@@ -323,6 +467,38 @@ UTEST_F(DisassembleChunk, OpPjmpIfFalse) {
   EXPECT_STREQ(msg, ufx->err.buf);
 }
 
+UTEST_F(DisassembleChunk, OpJumpIfNotLessLC) {
+  uint8_t constantIndex =
+      addConstant(&ufx->gc, &ufx->chunk, NUMBER_VAL(1.0));
+  writeChunk(&ufx->gc, &ufx->chunk, OP_JUMP_IF_NOT_LESS_LC, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(constantIndex >> 8), 123);
+  writeChunk(
+      &ufx->gc, &ufx->chunk, (uint8_t)(constantIndex & 0xff), 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 0, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 7, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] =
+      "0000  123 OP_JUMP_IF_NOT_LESS_LC    2    0 '1' 0 -> 13\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
+UTEST_F(DisassembleChunk, OpJumpIfEqualLL) {
+  writeChunk(&ufx->gc, &ufx->chunk, OP_JUMP_IF_EQUAL_LL, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 1, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 0, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 7, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] =
+      "0000  123 OP_JUMP_IF_EQUAL_LL    1    2 0 -> 12\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
 UTEST_F(DisassembleChunk, OpLoop) {
   writeChunk(&ufx->gc, &ufx->chunk, OP_NIL, 123);
   writeChunk(&ufx->gc, &ufx->chunk, OP_LOOP, 123);
@@ -335,6 +511,59 @@ UTEST_F(DisassembleChunk, OpLoop) {
   EXPECT_STREQ(msg, ufx->err.buf);
 }
 
+UTEST_F(DisassembleChunk, OpIterNext) {
+  writeChunk(&ufx->gc, &ufx->chunk, OP_ITER_NEXT, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 3, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 1, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] =
+      "0000  123 OP_ITER_NEXT        3 (2 vars) 0 -> 263\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
+UTEST_F(DisassembleChunk, OpListBuild) {
+  writeChunk(&ufx->gc, &ufx->chunk, OP_LIST_BUILD, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 255, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_LIST_BUILD     255\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
+UTEST_F(DisassembleChunk, OpMapData) {
+  writeChunk(&ufx->gc, &ufx->chunk, OP_MAP_DATA, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, 2, 123);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_MAP_DATA         2\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
+UTEST_F(DisassembleChunk, OpListTemplate) {
+  ObjList* list = newList(&ufx->gc);
+  pushTemp(&ufx->gc, OBJ_VAL(list));
+  writeValueArray(&ufx->gc, &list->elements, NUMBER_VAL(1.0));
+  writeValueArray(&ufx->gc, &list->elements, NUMBER_VAL(2.0));
+
+  uint16_t constant = addConstant(&ufx->gc, &ufx->chunk, OBJ_VAL(list));
+  writeChunk(&ufx->gc, &ufx->chunk, OP_LIST_TEMPLATE, 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(constant >> 8), 123);
+  writeChunk(&ufx->gc, &ufx->chunk, (uint8_t)(constant & 0xff), 123);
+
+  popTemp(&ufx->gc);
+  disassembleInstruction(ufx->err.fptr, &ufx->chunk, 0);
+
+  fflush(ufx->err.fptr);
+  const char msg[] = "0000  123 OP_LIST_TEMPLATE    0 <list 2>\n";
+  EXPECT_STREQ(msg, ufx->err.buf);
+}
+
 UTEST_F(DisassembleChunk, OpCall) {
   writeChunk(&ufx->gc, &ufx->chunk, OP_CALL, 123);
   writeChunk(&ufx->gc, &ufx->chunk, 45, 123);
@@ -616,8 +845,11 @@ OpCodeToString simpleOps[] = {
   SIMPLE_OP(OP_GET_INDEX),
   SIMPLE_OP(OP_SET_INDEX),
   SIMPLE_OP(OP_EQUAL),
+  SIMPLE_OP(OP_NOT_EQUAL),
   SIMPLE_OP(OP_GREATER),
+  SIMPLE_OP(OP_NOT_GREATER),
   SIMPLE_OP(OP_LESS),
+  SIMPLE_OP(OP_NOT_LESS),
   SIMPLE_OP(OP_ADD),
   SIMPLE_OP(OP_SUBTRACT),
   SIMPLE_OP(OP_MULTIPLY),
@@ -627,10 +859,7 @@ OpCodeToString simpleOps[] = {
   SIMPLE_OP(OP_NEGATE),
   SIMPLE_OP(OP_PRINT),
   SIMPLE_OP(OP_CLOSE_UPVALUE),
-  SIMPLE_OP(OP_LIST_INIT),
-  SIMPLE_OP(OP_LIST_DATA),
-  SIMPLE_OP(OP_MAP_INIT),
-  SIMPLE_OP(OP_MAP_DATA),
+  SIMPLE_OP(OP_ITER_INIT),
   SIMPLE_OP(OP_RETURN),
   SIMPLE_OP(OP_INHERIT),
   { 255, "0000  123 Unknown opcode 255\n" }
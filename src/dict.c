@@ -0,0 +1,306 @@
+#include "dict.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "memory.h"
+#include "object.h"
+
+// Entries per index slot; keeps the index at most 3/4 full.
+#define ENTRY_CAPACITY(capacity) ((capacity) / 4 * 3)
+
+void initDict(Dict* dict) {
+  dict->count = 0;
+  dict->entryCount = 0;
+  dict->capacity = 0;
+  dict->entries = NULL;
+  dict->indices = NULL;
+}
+
+// Log2 of the bytes needed for each slot of the index.
+static int indexShift(int capacity) {
+  if (capacity <= 1 << 8) {
+    return 0;
+  }
+  if (capacity <= 1 << 16) {
+    return 1;
+  }
+  return 2;
+}
+
+void freeDict(GC* gc, Dict* dict) {
+  FREE_ARRAY(gc, DictEntry, dict->entries,
+      ENTRY_CAPACITY(dict->capacity));
+  FREE_ARRAY(gc, uint8_t, dict->indices,
+      (size_t)dict->capacity << indexShift(dict->capacity));
+  initDict(dict);
+}
+
+static uint32_t getSlot(void* indices, int capacity, uint32_t index) {
+  switch (indexShift(capacity)) {
+    case 0: return ((uint8_t*)indices)[index];
+    case 1: return ((uint16_t*)indices)[index];
+    default: return ((uint32_t*)indices)[index];
+  }
+}
+
+static void setSlot(
+    void* indices, int capacity, uint32_t index, uint32_t slot) {
+  switch (indexShift(capacity)) {
+    case 0: ((uint8_t*)indices)[index] = (uint8_t)slot; break;
+    case 1: ((uint16_t*)indices)[index] = (uint16_t)slot; break;
+    default: ((uint32_t*)indices)[index] = slot; break;
+  }
+}
+
+static uint32_t hashBits(uint64_t bits) {
+  bits ^= bits >> 33;
+  bits *= UINT64_C(0xff51afd7ed558ccd);
+  bits ^= bits >> 33;
+  bits *= UINT64_C(0xc4ceb9fe1a85ec53);
+  bits ^= bits >> 33;
+  return (uint32_t)bits;
+}
+
+// Strings use their cached hashes, numbers hash their bits and
+// everything else hashes its identity.
+static uint32_t hashValue(Value value) {
+  if (IS_STRING(value)) {
+    return AS_STRING(value)->hash;
+  }
+  if (IS_NUMBER(value)) {
+    double num = AS_NUMBER(value);
+    if (num == 0.0) {
+      num = 0.0; // Hash -0 like 0, since they're equal.
+    } else if (isnan(num)) {
+      num = NAN;
+    }
+    uint64_t bits;
+    memcpy(&bits, &num, sizeof(bits));
+    return hashBits(bits);
+  }
+#if NAN_BOXING == 1
+  return hashBits(value);
+#else
+  if (IS_OBJ(value)) {
+    return hashBits((uint64_t)(uintptr_t)AS_OBJ(value));
+  }
+  bool isTrue = IS_BOOL(value) && AS_BOOL(value);
+  return hashBits(((uint64_t)value.type << 1) | isTrue);
+#endif
+}
+
+// Like valuesEqual(), except NaN matches itself so it can be a key.
+static bool keysEqual(Value a, Value b) {
+  if (IS_NUMBER(a) && IS_NUMBER(b)) {
+    double x = AS_NUMBER(a);
+    double y = AS_NUMBER(b);
+    return x == y || (isnan(x) && isnan(y));
+  }
+#if NAN_BOXING == 1
+  return a == b;
+#else
+  return valuesEqual(a, b);
+#endif
+}
+
+// Return the index slot of the key, or the unused slot where it would
+// go.
+static uint32_t findIndex(Dict* dict, Value key) {
+  uint32_t mask = (uint32_t)dict->capacity - 1;
+  uint32_t index = hashValue(key) & mask;
+
+  for (;;) {
+    uint32_t slot = getSlot(dict->indices, dict->capacity, index);
+    if (slot == 0 || keysEqual(dict->entries[slot - 1].key, key)) {
+      return index;
+    }
+    index = (index + 1) & mask;
+  }
+}
+
+bool dictGet(Dict* dict, Value key, Value* value) {
+  if (dict->count == 0) {
+    return false;
+  }
+
+  uint32_t slot =
+      getSlot(dict->indices, dict->capacity, findIndex(dict, key));
+  if (slot == 0) {
+    return false;
+  }
+
+  *value = dict->entries[slot - 1].value;
+  return true;
+}
+
+// Return a pointer to the value of key, or NULL if it has none. It
+// stays valid until the dict is next changed.
+Value* dictFind(Dict* dict, Value key) {
+  if (dict->count == 0) {
+    return NULL;
+  }
+
+  uint32_t slot =
+      getSlot(dict->indices, dict->capacity, findIndex(dict, key));
+  if (slot == 0) {
+    return NULL;
+  }
+  return &dict->entries[slot - 1].value;
+}
+
+// Rebuild the entries without deleted ones, and the index to match.
+static void adjustCapacity(GC* gc, Dict* dict, int capacity) {
+  size_t indexSize = (size_t)capacity << indexShift(capacity);
+  void* indices = ALLOCATE(gc, uint8_t, indexSize);
+  memset(indices, 0, indexSize);
+  DictEntry* entries =
+      ALLOCATE(gc, DictEntry, ENTRY_CAPACITY(capacity));
+
+  uint32_t mask = (uint32_t)capacity - 1;
+  int count = 0;
+  for (int i = 0; i < dict->entryCount; i++) {
+    DictEntry* entry = &dict->entries[i];
+    if (IS_EMPTY(entry->key)) {
+      continue;
+    }
+
+    uint32_t index = hashValue(entry->key) & mask;
+    while (getSlot(indices, capacity, index) != 0) {
+      index = (index + 1) & mask;
+    }
+    entries[count] = *entry;
+    setSlot(indices, capacity, index, (uint32_t)++count);
+  }
+
+  FREE_ARRAY(gc, DictEntry, dict->entries,
+      ENTRY_CAPACITY(dict->capacity));
+  FREE_ARRAY(gc, uint8_t, dict->indices,
+      (size_t)dict->capacity << indexShift(dict->capacity));
+  dict->entryCount = count;
+  dict->capacity = capacity;
+  dict->entries = entries;
+  dict->indices = indices;
+}
+
+bool dictSet(GC* gc, Dict* dict, Value key, Value value) {
+  assert(!IS_EMPTY(key)); // GCOV_EXCL_LINE
+  if (dict->count > 0) {
+    uint32_t slot =
+        getSlot(dict->indices, dict->capacity, findIndex(dict, key));
+    if (slot != 0) {
+      dict->entries[slot - 1].value = value;
+      return false;
+    }
+  }
+
+  if (dict->entryCount == ENTRY_CAPACITY(dict->capacity)) {
+    // Compact in place only if deletions freed half the entries, else
+    // grow, so each rebuild is paid for by as many cheap inserts.
+    int capacity = dict->capacity;
+    while (dict->count + 1 > ENTRY_CAPACITY(capacity) ||
+        dict->count > ENTRY_CAPACITY(capacity) / 2) {
+      capacity = GROW_CAPACITY(capacity);
+    }
+    adjustCapacity(gc, dict, capacity);
+  }
+
+  uint32_t index = findIndex(dict, key);
+  dict->entries[dict->entryCount].key = key;
+  dict->entries[dict->entryCount].value = value;
+  dict->entryCount++;
+  setSlot(dict->indices, dict->capacity, index,
+      (uint32_t)dict->entryCount);
+  dict->count++;
+  return true;
+}
+
+bool dictDelete(Dict* dict, Value key) {
+  if (dict->count == 0) {
+    return false;
+  }
+
+  void* indices = dict->indices;
+  int capacity = dict->capacity;
+  uint32_t mask = (uint32_t)capacity - 1;
+  uint32_t hole = findIndex(dict, key);
+  uint32_t slot = getSlot(indices, capacity, hole);
+  if (slot == 0) {
+    return false;
+  }
+
+  dict->entries[slot - 1].key = EMPTY_VAL;
+  dict->entries[slot - 1].value = NIL_VAL;
+  dict->count--;
+  // Trailing deleted entries can be reused right away.
+  while (dict->entryCount > 0 &&
+         IS_EMPTY(dict->entries[dict->entryCount - 1].key)) {
+    dict->entryCount--;
+  }
+
+  // Move back later slots of the cluster that would become
+  // unreachable, like tableDelete() does.
+  uint32_t next = (hole + 1) & mask;
+  while ((slot = getSlot(indices, capacity, next)) != 0) {
+    uint32_t home = hashValue(dict->entries[slot - 1].key) & mask;
+    bool reachable = hole <= next ? (hole < home && home <= next)
+                                  : (hole < home || home <= next);
+    if (!reachable) {
+      setSlot(indices, capacity, hole, slot);
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+
+  setSlot(indices, capacity, hole, 0);
+  return true;
+}
+
+// Make room for count entries without growing.
+void dictReserve(GC* gc, Dict* dict, int count) {
+  if (ENTRY_CAPACITY(dict->capacity) >= count) {
+    return;
+  }
+  int capacity = dict->capacity;
+  while (ENTRY_CAPACITY(capacity) < count) {
+    capacity = GROW_CAPACITY(capacity);
+  }
+  adjustCapacity(gc, dict, capacity);
+}
+
+void dictAddAll(GC* gc, Dict* from, Dict* to) {
+  if (to->capacity == 0 && from->count > 0) {
+    // Copy the index and entries as-is into an empty dict.
+    size_t indexSize = (size_t)from->capacity
+                       << indexShift(from->capacity);
+    void* indices = ALLOCATE(gc, uint8_t, indexSize);
+    memcpy(indices, from->indices, indexSize);
+    DictEntry* entries =
+        ALLOCATE(gc, DictEntry, ENTRY_CAPACITY(from->capacity));
+    memcpy(entries, from->entries,
+        sizeof(DictEntry) * (size_t)from->entryCount);
+    to->count = from->count;
+    to->entryCount = from->entryCount;
+    to->capacity = from->capacity;
+    to->entries = entries;
+    to->indices = indices;
+    return;
+  }
+  for (int i = 0; i < from->entryCount; i++) {
+    DictEntry* entry = &from->entries[i];
+    if (!IS_EMPTY(entry->key)) {
+      dictSet(gc, to, entry->key, entry->value);
+    }
+  }
+}
+
+void markDict(GC* gc, Dict* dict) {
+  for (int i = 0; i < dict->entryCount; i++) {
+    DictEntry* entry = &dict->entries[i];
+    if (!IS_EMPTY(entry->key)) {
+      markValue(gc, entry->key);
+      markValue(gc, entry->value);
+    }
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef clox_dict_h
+#define clox_dict_h
+
+#include "common.h"
+#include "value.h"
+
+typedef struct GC GC;
+
+// Deleted entries have EMPTY_VAL as their key.
+typedef struct {
+  Value key;
+  Value value;
+} DictEntry;
+
+// A hash table keyed by any value other than EMPTY_VAL that remembers
+// insertion order. Entries are stored densely in insertion order, and
+// hashed into a separate index array whose slots are 1, 2 or 4 bytes
+// wide depending on the capacity, and hold entry index + 1, or 0 if
+// unused.
+typedef struct {
+  int count;
+  int entryCount;
+  int capacity;
+  DictEntry* entries;
+  void* indices;
+} Dict;
+
+void initDict(Dict* dict);
+void freeDict(GC* gc, Dict* dict);
+bool dictGet(Dict* dict, Value key, Value* value);
+Value* dictFind(Dict* dict, Value key);
+bool dictSet(GC* gc, Dict* dict, Value key, Value value);
+bool dictDelete(Dict* dict, Value key);
+void dictReserve(GC* gc, Dict* dict, int count);
+void dictAddAll(GC* gc, Dict* from, Dict* to);
+void markDict(GC* gc, Dict* dict);
+
+#endif
@@ -0,0 +1,276 @@
+#include "dict.h"
+
+#include <math.h>
+
+#include "utest.h"
+
+#include "gc.h"
+#include "memory.h"
+#include "object.h"
+
+#define ufx utest_fixture
+
+struct Dict {
+  GC gc;
+  Dict d;
+  Table strings;
+};
+
+UTEST_F_SETUP(Dict) {
+  initGC(&ufx->gc);
+  initDict(&ufx->d);
+  initTable(&ufx->strings, 0.75);
+  ASSERT_TRUE(1);
+}
+
+UTEST_F_TEARDOWN(Dict) {
+  freeDict(&ufx->gc, &ufx->d);
+  freeTable(&ufx->gc, &ufx->strings);
+  freeGC(&ufx->gc);
+  ASSERT_TRUE(1);
+}
+
+UTEST_F(Dict, InitFree) {
+  EXPECT_EQ(ufx->d.count, 0);
+}
+
+UTEST_F(Dict, GetSetDelete) {
+  ObjString* foo = copyString(&ufx->gc, &ufx->strings, "foo", 3);
+  pushTemp(&ufx->gc, OBJ_VAL(foo));
+  Value keys[] = { NIL_VAL, BOOL_VAL(false), BOOL_VAL(true),
+    NUMBER_VAL(0.0), NUMBER_VAL(1.5), NUMBER_VAL(-7.0), OBJ_VAL(foo) };
+  Value value;
+
+  for (size_t i = 0; i < ARRAY_SIZE(keys); ++i) {
+    EXPECT_FALSE(dictGet(&ufx->d, keys[i], &value));
+    EXPECT_FALSE(dictDelete(&ufx->d, keys[i]));
+  }
+
+  for (size_t i = 0; i < ARRAY_SIZE(keys); ++i) {
+    EXPECT_TRUE(
+        dictSet(&ufx->gc, &ufx->d, keys[i], NUMBER_VAL((double)i)));
+  }
+  EXPECT_EQ(ufx->d.count, (int)ARRAY_SIZE(keys));
+
+  for (size_t i = 0; i < ARRAY_SIZE(keys); ++i) {
+    EXPECT_TRUE(dictGet(&ufx->d, keys[i], &value));
+    EXPECT_VALEQ(NUMBER_VAL((double)i), value);
+  }
+
+  // Updating an existing key doesn't add a new entry.
+  EXPECT_FALSE(dictSet(&ufx->gc, &ufx->d, NIL_VAL, NUMBER_VAL(9.0)));
+  EXPECT_TRUE(dictGet(&ufx->d, NIL_VAL, &value));
+  EXPECT_VALEQ(NUMBER_VAL(9.0), value);
+  EXPECT_EQ(ufx->d.count, (int)ARRAY_SIZE(keys));
+
+  for (size_t i = 0; i < ARRAY_SIZE(keys); ++i) {
+    EXPECT_TRUE(dictDelete(&ufx->d, keys[i]));
+    EXPECT_FALSE(dictGet(&ufx->d, keys[i], &value));
+  }
+  EXPECT_EQ(ufx->d.count, 0);
+
+  popTemp(&ufx->gc);
+}
+
+UTEST_F(Dict, Find) {
+  EXPECT_TRUE(dictFind(&ufx->d, NIL_VAL) == NULL);
+  EXPECT_TRUE(dictSet(&ufx->gc, &ufx->d, NIL_VAL, NUMBER_VAL(1.0)));
+  EXPECT_TRUE(dictFind(&ufx->d, BOOL_VAL(true)) == NULL);
+
+  // Values can be changed through the pointer.
+  Value* found = dictFind(&ufx->d, NIL_VAL);
+  ASSERT_TRUE(found != NULL);
+  EXPECT_VALEQ(NUMBER_VAL(1.0), *found);
+  *found = NUMBER_VAL(2.0);
+  Value value;
+  EXPECT_TRUE(dictGet(&ufx->d, NIL_VAL, &value));
+  EXPECT_VALEQ(NUMBER_VAL(2.0), value);
+
+  EXPECT_TRUE(dictDelete(&ufx->d, NIL_VAL));
+  EXPECT_TRUE(dictFind(&ufx->d, NIL_VAL) == NULL);
+}
+
+UTEST_F(Dict, NumberKeys) {
+  Value value;
+
+  // -0 and 0 are the same key.
+  EXPECT_TRUE(dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(0.0), NIL_VAL));
+  EXPECT_FALSE(dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(-0.0), NIL_VAL));
+  EXPECT_TRUE(dictGet(&ufx->d, NUMBER_VAL(-0.0), &value));
+
+  // NaN matches itself.
+  EXPECT_TRUE(dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(NAN), NIL_VAL));
+  EXPECT_FALSE(dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(-NAN), NIL_VAL));
+  EXPECT_TRUE(dictGet(&ufx->d, NUMBER_VAL(NAN), &value));
+  EXPECT_EQ(ufx->d.count, 2);
+}
+
+UTEST_F(Dict, SetGetDeleteMany) {
+  Value value;
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(dictSet(
+        &ufx->gc, &ufx->d, NUMBER_VAL(i), NUMBER_VAL(i * 2)));
+  }
+  EXPECT_EQ(ufx->d.count, 1000);
+
+  // Deleting every other key must not strand the keys probed past it.
+  for (int i = 0; i < 1000; i += 2) {
+    EXPECT_TRUE(dictDelete(&ufx->d, NUMBER_VAL(i)));
+  }
+  EXPECT_EQ(ufx->d.count, 500);
+
+  for (int i = 0; i < 1000; ++i) {
+    if (i % 2 == 0) {
+      EXPECT_FALSE(dictGet(&ufx->d, NUMBER_VAL(i), &value));
+    } else {
+      EXPECT_TRUE(dictGet(&ufx->d, NUMBER_VAL(i), &value));
+      EXPECT_VALEQ(NUMBER_VAL(i * 2), value);
+    }
+  }
+}
+
+UTEST_F(Dict, InsertionOrder) {
+  for (int i = 0; i < 100; ++i) {
+    dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(99 - i), NUMBER_VAL(i));
+  }
+  for (int i = 0; i < 100; i += 3) {
+    dictDelete(&ufx->d, NUMBER_VAL(i));
+  }
+  // Re-adding a deleted key puts it at the end.
+  dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(0), NIL_VAL);
+
+  double last = 100;
+  int count = 0;
+  for (int i = 0; i < ufx->d.entryCount; ++i) {
+    Value key = ufx->d.entries[i].key;
+    if (IS_EMPTY(key)) {
+      continue;
+    }
+    if (count < ufx->d.count - 1) {
+      EXPECT_LT(AS_NUMBER(key), last);
+      int n = (int)AS_NUMBER(key);
+      EXPECT_NE(n / 3 * 3, n);
+      last = AS_NUMBER(key);
+    } else {
+      EXPECT_VALEQ(NUMBER_VAL(0), key);
+    }
+    count++;
+  }
+  EXPECT_EQ(ufx->d.count, count);
+}
+
+UTEST_F(Dict, ChurnReusesEntries) {
+  Value value;
+  dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(-1), NIL_VAL);
+  int capacity = ufx->d.capacity;
+
+  // Replacing keys one by one compacts instead of growing.
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(i), NIL_VAL));
+    EXPECT_TRUE(dictDelete(&ufx->d, NUMBER_VAL(i - 1)));
+  }
+  EXPECT_EQ(ufx->d.count, 1);
+  EXPECT_EQ(ufx->d.capacity, capacity);
+  EXPECT_TRUE(dictGet(&ufx->d, NUMBER_VAL(9999), &value));
+}
+
+UTEST_F(Dict, ChurnWhenFull) {
+  // Fill the entries, then replace keys one by one.
+  int next = 0;
+  do {
+    dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(next++), NIL_VAL);
+  } while (next < 1000 ||
+      ufx->d.entryCount < ufx->d.capacity / 4 * 3);
+  int count = ufx->d.count;
+
+  // Each rebuild allocates new entries, so count how often they move.
+  int rebuilds = 0;
+  DictEntry* entries = ufx->d.entries;
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(dictDelete(&ufx->d, NUMBER_VAL(i)));
+    EXPECT_TRUE(
+        dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(next++), NIL_VAL));
+    if (ufx->d.entries != entries) {
+      entries = ufx->d.entries;
+      rebuilds++;
+    }
+  }
+  EXPECT_EQ(ufx->d.count, count);
+  EXPECT_LE(rebuilds, 2);
+}
+
+UTEST_F(Dict, WideIndices) {
+  // Cross the 1-byte and 2-byte index slot boundaries.
+  Value value;
+  for (int i = 0; i < 70000; ++i) {
+    dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(i), NUMBER_VAL(-i));
+  }
+  EXPECT_EQ(ufx->d.count, 70000);
+  for (int i = 0; i < 70000; ++i) {
+    EXPECT_TRUE(dictGet(&ufx->d, NUMBER_VAL(i), &value));
+    EXPECT_VALEQ(NUMBER_VAL(-i), value);
+  }
+  for (int i = 0; i < 70000; i += 2) {
+    EXPECT_TRUE(dictDelete(&ufx->d, NUMBER_VAL(i)));
+  }
+  for (int i = 1; i < 70000; i += 2) {
+    EXPECT_TRUE(dictGet(&ufx->d, NUMBER_VAL(i), &value));
+  }
+}
+
+UTEST_F(Dict, Reserve) {
+  dictReserve(&ufx->gc, &ufx->d, 100);
+  int capacity = ufx->d.capacity;
+  EXPECT_GE(capacity / 4 * 3, 100);
+
+  // Filling the reserved entries doesn't grow.
+  for (int i = 0; i < 100; ++i) {
+    dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(i), NIL_VAL);
+  }
+  EXPECT_EQ(ufx->d.capacity, capacity);
+
+  // Reserving less than the capacity does nothing.
+  dictReserve(&ufx->gc, &ufx->d, 10);
+  EXPECT_EQ(ufx->d.capacity, capacity);
+}
+
+UTEST_F(Dict, AddAll) {
+  Dict from;
+  Value value;
+  initDict(&from);
+  for (int i = 0; i < 100; ++i) {
+    dictSet(&ufx->gc, &from, NUMBER_VAL(i), NUMBER_VAL(-i));
+  }
+  dictDelete(&from, NUMBER_VAL(0));
+
+  // Into an empty dict.
+  dictAddAll(&ufx->gc, &from, &ufx->d);
+  EXPECT_EQ(ufx->d.count, 99);
+  EXPECT_FALSE(dictGet(&ufx->d, NUMBER_VAL(0), &value));
+  for (int i = 1; i < 100; ++i) {
+    EXPECT_TRUE(dictGet(&ufx->d, NUMBER_VAL(i), &value));
+    EXPECT_VALEQ(NUMBER_VAL(-i), value);
+  }
+
+  // The copy is independent of the original.
+  dictSet(&ufx->gc, &ufx->d, NUMBER_VAL(1), NIL_VAL);
+  EXPECT_TRUE(dictGet(&from, NUMBER_VAL(1), &value));
+  EXPECT_VALEQ(NUMBER_VAL(-1), value);
+
+  // Into a non-empty dict, overwriting existing keys.
+  dictSet(&ufx->gc, &from, NUMBER_VAL(1000), NIL_VAL);
+  dictAddAll(&ufx->gc, &from, &ufx->d);
+  EXPECT_EQ(ufx->d.count, 100);
+  EXPECT_TRUE(dictGet(&ufx->d, NUMBER_VAL(1), &value));
+  EXPECT_VALEQ(NUMBER_VAL(-1), value);
+  EXPECT_TRUE(dictGet(&ufx->d, NUMBER_VAL(1000), &value));
+
+  freeDict(&ufx->gc, &from);
+}
+
+UTEST_STATE();
+
+int main(int argc, const char* argv[]) {
+  debugStressGC = true;
+  return utest_main(argc, argv);
+}
@@ -0,0 +1,230 @@
+#include "f64.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+
+#define VEC_LANES 4
+
+typedef __m256d Vec;
+
+static inline Vec vecLoad(const double* p) {
+  return _mm256_loadu_pd(p);
+}
+static inline void vecStore(double* p, Vec v) {
+  _mm256_storeu_pd(p, v);
+}
+static inline Vec vecSplat(double x) {
+  return _mm256_set1_pd(x);
+}
+static inline Vec vecAdd(Vec a, Vec b) {
+  return _mm256_add_pd(a, b);
+}
+static inline Vec vecMul(Vec a, Vec b) {
+  return _mm256_mul_pd(a, b);
+}
+static inline Vec vecMin(Vec a, Vec b) {
+  return _mm256_min_pd(a, b);
+}
+static inline Vec vecMax(Vec a, Vec b) {
+  return _mm256_max_pd(a, b);
+}
+// Set every lane of the result if the lane of any of a or b is NaN.
+static inline Vec vecOrNan(Vec a, Vec b) {
+  return _mm256_or_pd(a, _mm256_cmp_pd(b, b, _CMP_UNORD_Q));
+}
+static inline bool vecAny(Vec v) {
+  return _mm256_movemask_pd(v) != 0;
+}
+
+#elif defined(__SSE2__)
+
+#define VEC_LANES 2
+
+typedef __m128d Vec;
+
+static inline Vec vecLoad(const double* p) {
+  return _mm_loadu_pd(p);
+}
+static inline void vecStore(double* p, Vec v) {
+  _mm_storeu_pd(p, v);
+}
+static inline Vec vecSplat(double x) {
+  return _mm_set1_pd(x);
+}
+static inline Vec vecAdd(Vec a, Vec b) {
+  return _mm_add_pd(a, b);
+}
+static inline Vec vecMul(Vec a, Vec b) {
+  return _mm_mul_pd(a, b);
+}
+static inline Vec vecMin(Vec a, Vec b) {
+  return _mm_min_pd(a, b);
+}
+static inline Vec vecMax(Vec a, Vec b) {
+  return _mm_max_pd(a, b);
+}
+static inline Vec vecOrNan(Vec a, Vec b) {
+  return _mm_or_pd(a, _mm_cmpunord_pd(b, b));
+}
+static inline bool vecAny(Vec v) {
+  return _mm_movemask_pd(v) != 0;
+}
+
+#endif
+
+// The vector loops handle whole groups of VEC_LANES values; the scalar
+// loops after them handle the rest, or everything without SIMD.
+
+double f64Sum(const double* values, int count) {
+  double sum = 0.0;
+  int i = 0;
+#ifdef VEC_LANES
+  // Two accumulators hide some of the latency of each addition.
+  Vec acc0 = vecSplat(0.0);
+  Vec acc1 = vecSplat(0.0);
+  for (; i + 2 * VEC_LANES <= count; i += 2 * VEC_LANES) {
+    acc0 = vecAdd(acc0, vecLoad(values + i));
+    acc1 = vecAdd(acc1, vecLoad(values + i + VEC_LANES));
+  }
+  double lanes[VEC_LANES];
+  vecStore(lanes, vecAdd(acc0, acc1));
+  for (int j = 0; j < VEC_LANES; ++j) {
+    sum += lanes[j];
+  }
+#endif
+  for (; i < count; ++i) {
+    sum += values[i];
+  }
+  return sum;
+}
+
+double f64Min(const double* values, int count) {
+  assert(count > 0); // GCOV_EXCL_LINE
+  double min = values[0];
+  bool hasNan = false;
+  int i = 0;
+#ifdef VEC_LANES
+  if (count >= VEC_LANES) {
+    Vec acc = vecLoad(values);
+    Vec nan = vecOrNan(vecSplat(0.0), acc);
+    for (i = VEC_LANES; i + VEC_LANES <= count; i += VEC_LANES) {
+      Vec v = vecLoad(values + i);
+      acc = vecMin(acc, v);
+      nan = vecOrNan(nan, v);
+    }
+    hasNan = vecAny(nan);
+    double lanes[VEC_LANES];
+    vecStore(lanes, acc);
+    min = lanes[0];
+    for (int j = 1; j < VEC_LANES; ++j) {
+      min = lanes[j] < min ? lanes[j] : min;
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    hasNan |= isnan(values[i]);
+    min = values[i] < min ? values[i] : min;
+  }
+  return hasNan ? NAN : min;
+}
+
+double f64Max(const double* values, int count) {
+  assert(count > 0); // GCOV_EXCL_LINE
+  double max = values[0];
+  bool hasNan = false;
+  int i = 0;
+#ifdef VEC_LANES
+  if (count >= VEC_LANES) {
+    Vec acc = vecLoad(values);
+    Vec nan = vecOrNan(vecSplat(0.0), acc);
+    for (i = VEC_LANES; i + VEC_LANES <= count; i += VEC_LANES) {
+      Vec v = vecLoad(values + i);
+      acc = vecMax(acc, v);
+      nan = vecOrNan(nan, v);
+    }
+    hasNan = vecAny(nan);
+    double lanes[VEC_LANES];
+    vecStore(lanes, acc);
+    max = lanes[0];
+    for (int j = 1; j < VEC_LANES; ++j) {
+      max = lanes[j] > max ? lanes[j] : max;
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    hasNan |= isnan(values[i]);
+    max = values[i] > max ? values[i] : max;
+  }
+  return hasNan ? NAN : max;
+}
+
+double f64Dot(const double* a, const double* b, int count) {
+  double sum = 0.0;
+  int i = 0;
+#ifdef VEC_LANES
+  Vec acc0 = vecSplat(0.0);
+  Vec acc1 = vecSplat(0.0);
+  for (; i + 2 * VEC_LANES <= count; i += 2 * VEC_LANES) {
+    acc0 = vecAdd(acc0, vecMul(vecLoad(a + i), vecLoad(b + i)));
+    acc1 = vecAdd(acc1,
+        vecMul(vecLoad(a + i + VEC_LANES), vecLoad(b + i + VEC_LANES)));
+  }
+  double lanes[VEC_LANES];
+  vecStore(lanes, vecAdd(acc0, acc1));
+  for (int j = 0; j < VEC_LANES; ++j) {
+    sum += lanes[j];
+  }
+#endif
+  for (; i < count; ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+void f64Scale(double* values, int count, double factor) {
+  int i = 0;
+#ifdef VEC_LANES
+  Vec f = vecSplat(factor);
+  for (; i + VEC_LANES <= count; i += VEC_LANES) {
+    vecStore(values + i, vecMul(vecLoad(values + i), f));
+  }
+#endif
+  for (; i < count; ++i) {
+    values[i] *= factor;
+  }
+}
+
+void f64AddScalar(double* values, int count, double addend) {
+  int i = 0;
+#ifdef VEC_LANES
+  Vec a = vecSplat(addend);
+  for (; i + VEC_LANES <= count; i += VEC_LANES) {
+    vecStore(values + i, vecAdd(vecLoad(values + i), a));
+  }
+#endif
+  for (; i < count; ++i) {
+    values[i] += addend;
+  }
+}
+
+void f64Add(double* values, const double* addends, int count) {
+  int i = 0;
+#ifdef VEC_LANES
+  for (; i + VEC_LANES <= count; i += VEC_LANES) {
+    vecStore(values + i,
+        vecAdd(vecLoad(values + i), vecLoad(addends + i)));
+  }
+#endif
+  for (; i < count; ++i) {
+    values[i] += addends[i];
+  }
+}
@@ -0,0 +1,18 @@
+#pragma once
+#ifndef clox_f64_h
+#define clox_f64_h
+
+// Kernels over contiguous arrays of doubles, vectorized with AVX or
+// SSE2 when the compiler targets them.
+
+// May round differently than adding the numbers left to right.
+double f64Sum(const double* values, int count);
+// Return NaN if any value is NaN; count must be positive.
+double f64Min(const double* values, int count);
+double f64Max(const double* values, int count);
+double f64Dot(const double* a, const double* b, int count);
+void f64Scale(double* values, int count, double factor);
+void f64AddScalar(double* values, int count, double addend);
+void f64Add(double* values, const double* addends, int count);
+
+#endif
@@ -0,0 +1,63 @@
+#include "f64.h"
+
+#include "ubench.h"
+
+#define COUNT 100000
+
+static double a[COUNT];
+static double b[COUNT];
+
+static void fillArrays(void) {
+  for (int i = 0; i < COUNT; ++i) {
+    a[i] = (double)(i % 97) * 0.25;
+    b[i] = (double)(i % 89) * 0.5;
+  }
+}
+
+UBENCH_EX(F64, SumLoop) {
+  fillArrays();
+  UBENCH_DO_BENCHMARK() {
+    double sum = 0.0;
+    for (int i = 0; i < COUNT; ++i) {
+      sum += a[i];
+    }
+    UBENCH_DO_NOTHING(&sum);
+  }
+}
+
+UBENCH_EX(F64, Sum) {
+  fillArrays();
+  UBENCH_DO_BENCHMARK() {
+    double sum = f64Sum(a, COUNT);
+    UBENCH_DO_NOTHING(&sum);
+  }
+}
+
+UBENCH_EX(F64, DotLoop) {
+  fillArrays();
+  UBENCH_DO_BENCHMARK() {
+    double sum = 0.0;
+    for (int i = 0; i < COUNT; ++i) {
+      sum += a[i] * b[i];
+    }
+    UBENCH_DO_NOTHING(&sum);
+  }
+}
+
+UBENCH_EX(F64, Dot) {
+  fillArrays();
+  UBENCH_DO_BENCHMARK() {
+    double sum = f64Dot(a, b, COUNT);
+    UBENCH_DO_NOTHING(&sum);
+  }
+}
+
+UBENCH_EX(F64, Max) {
+  fillArrays();
+  UBENCH_DO_BENCHMARK() {
+    double max = f64Max(a, COUNT);
+    UBENCH_DO_NOTHING(&max);
+  }
+}
+
+UBENCH_MAIN();
@@ -0,0 +1,85 @@
+#include "f64.h"
+
+#include <math.h>
+
+#include "utest.h"
+
+#define MAX_COUNT 19
+
+// Small whole numbers keep every sum exact in any order.
+static void fill(double* values, int count, int seed) {
+  for (int i = 0; i < count; ++i) {
+    values[i] = (double)((i * 7 + seed) % 11 - 5);
+  }
+}
+
+UTEST(F64, Sum) {
+  double values[MAX_COUNT];
+  for (int count = 0; count <= MAX_COUNT; ++count) {
+    fill(values, count, count);
+    double expected = 0.0;
+    for (int i = 0; i < count; ++i) {
+      expected += values[i];
+    }
+    EXPECT_EQ(expected, f64Sum(values, count));
+  }
+}
+
+UTEST(F64, MinMax) {
+  double values[MAX_COUNT];
+  for (int count = 1; count <= MAX_COUNT; ++count) {
+    fill(values, count, count);
+    double min = values[0];
+    double max = values[0];
+    for (int i = 1; i < count; ++i) {
+      min = values[i] < min ? values[i] : min;
+      max = values[i] > max ? values[i] : max;
+    }
+    EXPECT_EQ(min, f64Min(values, count));
+    EXPECT_EQ(max, f64Max(values, count));
+  }
+}
+
+UTEST(F64, MinMaxNan) {
+  // A NaN in any position, vector lanes or tail, poisons the result.
+  double values[MAX_COUNT];
+  for (int pos = 0; pos < MAX_COUNT; ++pos) {
+    fill(values, MAX_COUNT, pos);
+    values[pos] = NAN;
+    EXPECT_TRUE(isnan(f64Min(values, MAX_COUNT)));
+    EXPECT_TRUE(isnan(f64Max(values, MAX_COUNT)));
+  }
+}
+
+UTEST(F64, Dot) {
+  double a[MAX_COUNT];
+  double b[MAX_COUNT];
+  for (int count = 0; count <= MAX_COUNT; ++count) {
+    fill(a, count, 1);
+    fill(b, count, 4);
+    double expected = 0.0;
+    for (int i = 0; i < count; ++i) {
+      expected += a[i] * b[i];
+    }
+    EXPECT_EQ(expected, f64Dot(a, b, count));
+  }
+}
+
+UTEST(F64, ScaleAdd) {
+  double values[MAX_COUNT];
+  double addends[MAX_COUNT];
+  for (int count = 0; count <= MAX_COUNT; ++count) {
+    fill(values, count, 2);
+    fill(addends, count, 3);
+    f64Scale(values, count, 3.0);
+    f64AddScalar(values, count, 0.5);
+    f64Add(values, addends, count);
+    for (int i = 0; i < count; ++i) {
+      double v = (double)((i * 7 + 2) % 11 - 5);
+      double a = (double)((i * 7 + 3) % 11 - 5);
+      EXPECT_EQ(v * 3.0 + 0.5 + a, values[i]);
+    }
+  }
+}
+
+UTEST_MAIN();
@@ -118,6 +118,31 @@ InterpretCase stringReUseAfterError[] = {
 
 INTERPRET_MULTI(StringReUseAfterError, stringReUseAfterError);
 
+InterpretCase redefineGlobal[] = {
+  { INTERPRET_OK, "1\n", "var a=1;print a;" },
+  { INTERPRET_OK, "2\n", "var a=2;for(var x in [a])print x;" },
+};
+
+INTERPRET_MULTI(RedefineGlobal, redefineGlobal);
+
+InterpretCase laterGlobal[] = {
+  { INTERPRET_OK, "", "fun f(){print y;}" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined variable 'y'.", "f();" },
+  { INTERPRET_COMPILE_ERROR, "Expect ';' after value.", "print z" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined variable 'z'.", "z=1;" },
+  { INTERPRET_OK, "1\n2\n", "var y=1;f();var z=2;print z;" },
+};
+
+INTERPRET_MULTI(LaterGlobal, laterGlobal);
+
+InterpretCase reboundNative[] = {
+  { INTERPRET_OK, "1\n", "print floor(1.5);" },
+  { INTERPRET_OK, "", "fun f(){floor=ceil;}" },
+  { INTERPRET_OK, "2\n", "f();print floor(1.5);" },
+};
+
+INTERPRET_MULTI(ReboundNative, reboundNative);
+
 struct Interpret {
   InterpretCase* cases;
 };
@@ -263,6 +288,28 @@ InterpretCase binaryNum[] = {
 
 INTERPRET(BinaryNum, binaryNum, 15);
 
+InterpretCase folding[] = {
+  { INTERPRET_OK, "0\n-0\n", "print 0;print -0;" },
+  { INTERPRET_OK, "-0\n", "print 0*-1;" },
+  { INTERPRET_OK, "false\ntrue\ntrue\n",
+      "print 0/0==0/0;print 0/0>=1;print !(0/0<1);" },
+  { INTERPRET_OK, "ab\n", "print \"a\"+\"b\";" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Operands must be two numbers or two strings.",
+      "print 1+2+nil;" },
+  { INTERPRET_RUNTIME_ERROR, "Operand must be a number.",
+      "print -\"a\";" },
+  { INTERPRET_OK, "2\n", "if(false)print 1;else print 2;" },
+  { INTERPRET_OK, "1\n", "while(nil)print 1;print 1;" },
+  { INTERPRET_OK, "3\n",
+      "fun f(){var i=0;while(true){i=i+1;if(i>2)return i;}}"
+      "print f();" },
+  { INTERPRET_OK, "2\n", "var floor=ceil;print floor(1.5);" },
+  { INTERPRET_OK, "2\n", "fun f(){floor=ceil;}f();print floor(1.5);" },
+};
+
+INTERPRET(Folding, folding, 11);
+
 InterpretCase comments[] = {
   { INTERPRET_OK, "", "//print 1;" },
   { INTERPRET_OK, "1\n", "print 1;//" },
@@ -516,6 +563,41 @@ InterpretCase nativeExit[] = {
 
 INTERPRET(NativeExit, nativeExit, 5);
 
+InterpretCase nativeFloat64Array[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
+      "Float64Array();" },
+  { INTERPRET_RUNTIME_ERROR, "Argument must be a size or a list.",
+      "Float64Array(nil);" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Size (-1) must be a whole number between 0 and 2147483647.",
+      "Float64Array(-1);" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Size (1.5) must be a whole number between 0 and 2147483647.",
+      "Float64Array(1.5);" },
+  { INTERPRET_RUNTIME_ERROR, "List elements must be numbers.",
+      "Float64Array([1,nil]);" },
+  { INTERPRET_OK, "<float64 array>\nfloat64 array\n",
+      "var a=Float64Array(2);print a;print type(a);" },
+  { INTERPRET_OK, "[0, 0, 0]\n[1.5, -2]\n[]\n",
+      "print Float64Array(3).toList();"
+      "print Float64Array([1.5,-2]).toList();"
+      "print Float64Array([]).toList();" },
+  { INTERPRET_OK, "2\n5\n", "var a=Float64Array([1,2]);print a[1];"
+      "print a[0]=5;" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Float64Array index (2) out of bounds (2).",
+      "Float64Array(2)[2];" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Float64Array index (-1) out of bounds (2).",
+      "Float64Array(2)[-1]=0;" },
+  { INTERPRET_RUNTIME_ERROR, "Float64Array elements must be numbers.",
+      "Float64Array(2)[0]=\"x\";" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined property 'x'.",
+      "Float64Array(0).x();" },
+};
+
+INTERPRET(NativeFloat64Array, nativeFloat64Array, 12);
+
 InterpretCase nativeFloor[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       "floor();" },
@@ -526,6 +608,38 @@ InterpretCase nativeFloor[] = {
 
 INTERPRET(NativeFloor, nativeFloor, 3);
 
+InterpretCase nativeList[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 to 2 arguments but got 0.",
+      "List();" },
+  { INTERPRET_RUNTIME_ERROR, "Size must be a number.", "List(nil);" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Size (-1) must be a whole number between 0 and 2147483647.",
+      "List(-1);" },
+  { INTERPRET_OK, "[]\n[nil, nil]\n[0, 0, 0]\n",
+      "print List(0);print List(2);print List(3,0);" },
+  { INTERPRET_OK, "1\n",
+      "var l=List(2,[]);l[0].push(1);print l[1].size();" },
+};
+
+INTERPRET(NativeList, nativeList, 5);
+
+InterpretCase nativeRange[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 to 3 arguments but got 0.",
+      "range();" },
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 to 3 arguments but got 4.",
+      "range(1,2,3,4);" },
+  { INTERPRET_RUNTIME_ERROR, "Arguments must be numbers.",
+      "range(0,nil);" },
+  { INTERPRET_RUNTIME_ERROR, "Step must be a non-zero number.",
+      "range(0,1,0);" },
+  { INTERPRET_RUNTIME_ERROR, "Step must be a non-zero number.",
+      "range(0,1,0/0);" },
+  { INTERPRET_OK, "<range>\nrange\n",
+      "var r=range(3);print r;print type(r);" },
+};
+
+INTERPRET(NativeRange, nativeRange, 6);
+
 InterpretCase nativeRound[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       "round();" },
@@ -545,6 +659,19 @@ InterpretCase nativeStr[] = {
 
 INTERPRET(NativeStr, nativeStr, 2);
 
+InterpretCase nativeStringBuilder[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
+      "StringBuilder(0);" },
+  { INTERPRET_OK, "<string builder>\nstring builder\n",
+      "var b=StringBuilder();print b;print type(b);" },
+  { INTERPRET_OK, "\n0\n", "var b=StringBuilder();"
+      "print b.build();print b.size();" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined property 'x'.",
+      "StringBuilder().x();" },
+};
+
+INTERPRET(NativeStringBuilder, nativeStringBuilder, 4);
+
 InterpretCase nativeType[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       "type();" },
@@ -677,9 +804,11 @@ InterpretCase globalVars[] = {
   { INTERPRET_OK, "1\nhi\n", "var x=1;print x;var x=\"hi\";print x;" },
   { INTERPRET_OK, "1\nhi\n",
       "fun f(){print x;}var x=1;f();x=\"hi\";f();" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined variable 'x'.",
+      "fun f(){x=1;}f();var x;" },
 };
 
-INTERPRET(GlobalVars, globalVars, 11);
+INTERPRET(GlobalVars, globalVars, 12);
 
 InterpretCase localVars[] = {
   { INTERPRET_COMPILE_ERROR,
@@ -700,6 +829,71 @@ InterpretCase localVars[] = {
 
 INTERPRET(LocalVars, localVars, 9);
 
+InterpretCase compoundAssign[] = {
+  { INTERPRET_OK, "15\n3\nab\n",
+      "var g=1;g+=2;g*=5;print g;g-=1;g/=2;g%=4;print g;"
+      "var s=\"a\";s+=\"b\";print s;" },
+  { INTERPRET_OK, "3\n2.5\n1\n",
+      "{var i=0;print i+=3;i-=0.5;print i;var n;n=1;n*=1;print n;}" },
+  { INTERPRET_OK, "4\n5\n",
+      "fun f(){var u=3;fun g(){u+=1;return u;}return g;}"
+      "var g=f();print g();print g();" },
+  { INTERPRET_OK, "10\n0\n",
+      "{var j=0;for(var k=0;k<5;k+=1)j+=k;print j;"
+      "var n=3;while(n>0)n-=1;print n;}" },
+  { INTERPRET_OK, "5\n10\nqr\n9\n109\n",
+      "class P{init(){this.x=1;this.s=\"q\";}}"
+      "var p=P();p.x+=4;print p.x;p.x*=2;print p.x;"
+      "p.s+=\"r\";print p.s;print p.x-=1;p[\"x\"]+=100;print p.x;" },
+  { INTERPRET_OK, "[1, 12, 3]\n[0, 12, 3]\n{a: 0.25}\n2.5\n",
+      "var l=[1,2,3];l[1]+=10;print l;l[0]%=1;print l;"
+      "var m={a:1};m[\"a\"]/=4;print m;"
+      "var f=Float64Array(1);f[0]+=2.5;print f[0];" },
+  { INTERPRET_OK, "2\n",
+      "class C{init(){this.n=0;}inc(){this.n+=1;return this;}}"
+      "print C().inc().inc().n;" },
+  { INTERPRET_OK, "1\n2\n3\n",
+      "class P{init(){this.x=1;}}"
+      "{var p=P();var i=0;while(i<3){print p.x;p.x+=1;i+=1;}}" },
+  { INTERPRET_RUNTIME_ERROR, "Only instances have fields.",
+      "var p=nil;p.x+=1;" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined property 'x'.",
+      "class A{}A().x+=1;" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Operands must be two numbers or two strings.",
+      "class A{}var a=A();a.x=\"s\";a.x+=1;" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "class A{}var a=A();a.x=\"s\";a.x-=1;" },
+  { INTERPRET_RUNTIME_ERROR, "List index (3) out of bounds (1).",
+      "var l=[1];l[3]+=1;" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined key '1'.",
+      "var m={};m[1]+=1;" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Operands must be two numbers or two strings.",
+      "var f=Float64Array(1);f[0]+=\"x\";" },
+  { INTERPRET_RUNTIME_ERROR, "Instances can only be indexed by string.",
+      "class A{}A()[1]*=1;" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined property 'x'.",
+      "class A{}A()[\"x\"]*=1;" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Can only set index of lists, maps and instances.",
+      "var s=\"ab\";s[0]+=1;" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Operands must be two numbers or two strings.",
+      "{var a;a+=1;}" },
+  { INTERPRET_COMPILE_ERROR, "Invalid assignment target.",
+      "var a;var b;a+b-=1;" },
+  { INTERPRET_OK, "2\n2\n2\n",
+      "var g=1;fun f(){g=100;return 1;}g+=f();print g;"
+      "class P{}var p=P();p.x=1;"
+      "fun h(){p.x=100;return 1;}p.x+=h();print p.x;"
+      "var l=[1];fun k(){l[0]=100;return 1;}l[0]+=k();print l[0];" },
+  { INTERPRET_RUNTIME_ERROR, "List index (0) out of bounds (0).",
+      "var l=[1];l[0]+=l.pop();" },
+};
+
+INTERPRET(CompoundAssign, compoundAssign, 22);
+
 InterpretCase andOr[] = {
   { INTERPRET_OK, "false\n", "print false and 1;" },
   { INTERPRET_OK, "1\n", "print true and 1;" },
@@ -736,6 +930,54 @@ InterpretCase forStmt[] = {
 
 INTERPRET(ForStmt, forStmt, 9);
 
+InterpretCase forInStmt[] = {
+  { INTERPRET_COMPILE_ERROR, "Expect variable name.", "for(var" },
+  { INTERPRET_COMPILE_ERROR, "Expect variable name.", "for(var a," },
+  { INTERPRET_COMPILE_ERROR, "Expect 'in' after loop variables.",
+      "for(var a,b;" },
+  { INTERPRET_COMPILE_ERROR, "Already a variable with this name",
+      "for(var a,a in[])0;" },
+  { INTERPRET_COMPILE_ERROR, "Expect ')' after for clauses.",
+      "for(var a in[];" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Can only iterate over lists, maps, strings and ranges.",
+      "for(var a in 1)0;" },
+  { INTERPRET_OK, "", "for(var a in[])print a;" },
+  { INTERPRET_OK, "1\n2\n3\n", "for(var a in[1,2,3])print a;" },
+  { INTERPRET_OK, "0a\n1b\n",
+      "for(var i,a in[\"a\",\"b\"])print str(i)+a;" },
+  { INTERPRET_OK, "b\na\nb2\na1\n",
+      "var m={b:2,a:1};for(var k in m)print k;"
+      "for(var k,v in m)print k+str(v);" },
+  { INTERPRET_OK, "a\nc\n",
+      "var m={a:1,b:2,c:3};m.remove(\"b\");for(var k in m)print k;" },
+  { INTERPRET_OK, "104\n105\n1:105\n",
+      "for(var c in\"hi\")print c;"
+      "for(var i,c in\"hi\")if(i>0)print str(i)+\":\"+str(c);" },
+  { INTERPRET_OK, "0\n1\n2\n", "for(var i in range(3))print i;" },
+  { INTERPRET_OK, "10\n7\n4\n1\n",
+      "for(var i in range(10,0,-3))print i;" },
+  { INTERPRET_OK, "0:1\n1:1.5\n",
+      "for(var i,v in range(1,2,0.5))print str(i)+\":\"+str(v);" },
+  { INTERPRET_OK, "", "for(var i in range(1,1))print i;" },
+  { INTERPRET_OK, "1\n2\n3\n",
+      "var l=[1];for(var a in l){print a;if(a<3)l.push(a+1);}" },
+  { INTERPRET_OK, "3\n",
+      "var fs=[];for(var a in[1,2]){var b=a;fs.push(fun(){return b;});}"
+      "print fs[0]()+fs[1]();" },
+  { INTERPRET_OK, "2\n",
+      "var f;for(var a in[1,2])f=fun(){return a;};print f();" },
+  { INTERPRET_OK, "4950\n",
+      "fun f(){var t=0;for(var x in range(100))t=t+x;return t;}"
+      "print f();" },
+  { INTERPRET_OK, "x\n",
+      "var a=\"x\";for(var a in[a])print a;" },
+  { INTERPRET_OK, "0\n1\n",
+      "var in=2;for(var i=0;i<in;i=i+1)print i;" },
+};
+
+INTERPRET(ForInStmt, forInStmt, 22);
+
 InterpretCase ifStmt[] = {
   { INTERPRET_COMPILE_ERROR, "Expect '(' after 'if'.", "if" },
   { INTERPRET_COMPILE_ERROR, "Expect expression.", "if(" },
@@ -765,6 +1007,135 @@ InterpretCase whileStmt[] = {
 
 INTERPRET(WhileStmt, whileStmt, 7);
 
+InterpretCase compareJumps[] = {
+  { INTERPRET_OK, "0\n1\n2\n",
+      "{var i=0;while(i<3){print i;i=i+1;}}" },
+  { INTERPRET_OK, "lt\nle\nne\nge\ngt\n",
+      "{var a=1;var b=2;if(a<b)print \"lt\";if(a<=b)print \"le\";"
+      "if(a==b)print \"eq\";if(a!=b)print \"ne\";"
+      "if(b>=a)print \"ge\";if(b>a)print \"gt\";}" },
+  { INTERPRET_OK, "le\neq\nge\n",
+      "{var a=2;if(a<2)print \"lt\";if(a<=2)print \"le\";"
+      "if(a==2)print \"eq\";if(a!=2)print \"ne\";"
+      "if(a>=2)print \"ge\";if(a>2)print \"gt\";}" },
+  { INTERPRET_OK, "ne\nle\nge\n",
+      "{var a=0/0;if(a==a)print \"eq\";if(a!=a)print \"ne\";"
+      "if(a<=1)print \"le\";if(a>=1)print \"ge\";"
+      "if(a<1)print \"lt\";}" },
+  { INTERPRET_OK, "3\nnil\nyes\n",
+      "{var n=nil;var l=[1,2,3];var c=0;"
+      "for(var i=0;i!=3;i+=1)c+=1;print c;if(n==nil)print n;"
+      "var s=\"x\";if(s==\"x\")print \"yes\";"
+      "if(s!=\"x\")print \"no\";}" },
+  { INTERPRET_OK, "x\n",
+      "{var t=true;if(t!=false)print \"x\";}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var a;if(a<1)print a;}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var a=1;var b=\"b\";while(a>b)a=b;}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var a=1;if(a<\"x\")print a;}" },
+};
+
+INTERPRET(CompareJumps, compareJumps, 9);
+
+// Locals that stop holding numbers keep their type checks.
+InterpretCase numberLocals[] = {
+  { INTERPRET_OK, "20\n",
+      "{var t=0;for(var i=0;i<5;i=i+1)t=t+i*2;print t;}" },
+  { INTERPRET_OK, "false\ntrue\n",
+      "{var x=0/0;print x<1;print x>=1;}" },
+  { INTERPRET_OK, "2\nst\n",
+      "{var x=1;if(false)x=\"s\";print x+1;"
+      "var y=\"s\";if(false)y=1;print y+\"t\";}" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Operands must be two numbers or two strings.",
+      "{var x=1;var i=0;while(i<2){print x+1;x=\"s\";i=i+1;}}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var x=1;var y=2;var i=0;"
+      "while(i<3){print x*2;x=y;y=\"s\";i=i+1;}}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var x=0;for(var i=0;i<2;x=\"s\"){print x-1;i=i+1;}}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var x=0;for(var i=0;i<2;i=i+1){"
+      "for(var j=0;j<2;j=j+1)print x-1;x=\"s\";}}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var x=1;for(var a in[\"s\",\"t\"]){print x-1;x=a;}}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var x=1;fun f(){x=\"s\";}f();print x-1;}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var x=1;var i=0;"
+      "while(i<2){print x-1;fun f(){x=\"s\";}f();i=i+1;}}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var x=1;var c=true;if(c)x=\"s\";print x-1;}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var x=1;var c=false;if(c)x=2;else x=\"s\";print x-1;}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var x=1;var c=true;c and(x=\"s\");print x-1;}" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "{var x=1;var c=false;c or(x=\"s\");print x-1;}" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Operands must be two numbers or two strings.",
+      "{var c;var x=c and 1;print x+1;}" },
+};
+
+INTERPRET(NumberLocals, numberLocals, 15);
+
+// Property reads hoisted out of loops see every change the loop makes.
+InterpretCase hoistedReads[] = {
+  { INTERPRET_OK, "6\n",
+      "class F{}var f=F();f.x=2;var t=0;"
+      "for(var i=0;i<3;i=i+1)t=t+f.x;print t;" },
+  { INTERPRET_OK, "nil\nnil\n",
+      "class F{}{var f=F();f.x=nil;var i=0;"
+      "while(i<2){print f.x;i=i+1;}}" },
+  { INTERPRET_OK, "3\n",
+      "class F{}{var f=F();f.n=3;var i=0;while(i<f.n)i=i+1;print i;}" },
+  { INTERPRET_OK, "8\n",
+      "class F{}{var f=F();f.x=2;var t=0;for(var i=0;i<2;i=i+1)"
+      "for(var j=0;j<2;j=j+1)t=t+f.x;print t;}" },
+  { INTERPRET_OK, "3\n",
+      "class F{}{var f=F();f.x=0;"
+      "for(var i=0;i<3;i=i+1)f.x=f.x+1;print f.x;}" },
+  { INTERPRET_OK, "4\n",
+      "class F{}{var f=F();var g=f;f.x=1;var t=0;"
+      "for(var i=0;i<3;i=i+1){t=t+f.x;g.x=t;}print t;}" },
+  { INTERPRET_OK, "4\n",
+      "class F{}{var f=F();f.x=1;var t=0;"
+      "for(var i=0;i<3;i=i+1){t=t+f.x;f[\"x\"]=t;}print t;}" },
+  { INTERPRET_OK, "6\n",
+      "class F{}{var f=F();f.x=1;fun g(){f.x=f.x+1;}var t=0;"
+      "for(var i=0;i<3;i=i+1){t=t+f.x;g();}print t;}" },
+  { INTERPRET_OK, "6\n",
+      "class F{bump(){this.x=this.x+1;}}{var f=F();f.x=1;var t=0;"
+      "for(var i=0;i<3;i=i+1){t=t+f.x;f.bump();}print t;}" },
+  { INTERPRET_OK, "11\n",
+      "class F{}{var f=F();var h=F();f.x=1;h.x=10;var t=0;"
+      "for(var i=0;i<2;i=i+1){t=t+f.x;f=h;}print t;}" },
+  { INTERPRET_OK, "3\n",
+      "class F{}{var a=F();a.x=1;var b=F();b.x=2;var t=0;"
+      "for(var o in[a,b])t=t+o.x;print t;}" },
+  { INTERPRET_OK, "6\n",
+      "class F{init(){this.x=2;}"
+      "sum(){var t=0;var i=0;while(i<3){t=t+this.x;i=i+1;}return t;}}"
+      "print F().sum();" },
+  { INTERPRET_OK, "false\n",
+      "class F{m(){}}var f=F();var a;var same=true;"
+      "for(var i=0;i<2;i=i+1){var m=f.m;if(a!=nil)same=a==m;a=m;}"
+      "print same;" },
+  { INTERPRET_OK, "1\n",
+      "class F{}{var f=F();for(var i=0;i<0;i=i+1)print f.x;print 1;}" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined property 'x'.",
+      "class F{}{var f=F();var i=0;while(i<2){print f.x;i=i+1;}}" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Only lists and instances have properties.",
+      "{var n=1;while(true)print n.x;}" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined variable 'u'.",
+      "for(var i=0;i<1;i=i+1)print u.x;" },
+};
+
+INTERPRET(HoistedReads, hoistedReads, 17);
+
 InterpretCase classes[] = {
   { INTERPRET_COMPILE_ERROR, "Expect class name.", "class" },
   { INTERPRET_COMPILE_ERROR, "Expect class name.", "class 0" },
@@ -917,6 +1288,47 @@ InterpretCase superclasses[] = {
 
 INTERPRET(Superclasses, superclasses, 15);
 
+// Calls to functions that just return a constant or a field of this
+// skip running them, with the same results.
+InterpretCase inlinedCalls[] = {
+  { INTERPRET_OK, "1\n2\n",
+      "class F{init(){this.x=1;}get(){return this.x;}}"
+      "var f=F();print f.get();f.x=2;print f.get();" },
+  { INTERPRET_OK, "4\n",
+      "class F{init(){this.x=4;}get(){return this.x;}}"
+      "var g=F().get;print g();" },
+  { INTERPRET_OK, "2\n",
+      "class F{m(){return 2;}get(){return this.m;}}"
+      "print F().get()();" },
+  { INTERPRET_OK, "3\n",
+      "class F{init(){this.x=1;}get(){return this.x;}}"
+      "fun g(){return 3;}var f=F();f.get=g;print f.get();" },
+  { INTERPRET_OK, "2\n1\n",
+      "class A{get(){return 1;}}class B<A{get(){return 2;}}"
+      "print B().get();print A().get();" },
+  { INTERPRET_OK, "2\n",
+      "class A{init(){this.x=1;}get(){return this.x;}}"
+      "class B<A{get(){return super.get()+1;}}print B().get();" },
+  { INTERPRET_OK, "nil\ntrue\nfalse\ns\n",
+      "class F{m(){}}print F().m();fun t(){return true;}print t();"
+      "fun u(){return false;}print u();"
+      "fun f(a,b){return \"s\";}print f(1,2);" },
+  { INTERPRET_OK, "3\n", "fun one(){return 1;}print 1+one()+one();" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined property 'x'.",
+      "class F{get(){return this.x;}}F().get();" },
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
+      "fun f(a){}f();" },
+  { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
+      "class F{init(){this.x=1;}get(){return this.x;}}F().get(1);" },
+};
+
+INTERPRET(InlinedCalls, inlinedCalls, 11);
+
+// Elements for literals longer than one batch.
+#define ONES_10 "1,1,1,1,1,1,1,1,1,1,"
+#define ONES_50 ONES_10 ONES_10 ONES_10 ONES_10 ONES_10
+#define ONES_100 ONES_50 ONES_50
+
 InterpretCase list[] = {
   { INTERPRET_COMPILE_ERROR, "Expect expression.", "[" },
   { INTERPRET_COMPILE_ERROR, "Expect expression.", "[," },
@@ -953,9 +1365,143 @@ InterpretCase list[] = {
       "var a=[1,2,3];var b=[4,5,a];print a;print b;print b[2];" },
   { INTERPRET_OK, "[1, 2, 3]\n[1, 2, <list 3>]\n",
       "var a=[1,2,3];print a;a[2]=a;print a;" },
+  // Literal lists of constants are copied, not shared.
+  { INTERPRET_OK, "[1, 2, 3]\n[1, 2]\n",
+      "fun f(){return[1,2];}var a=f();a.push(3);print a;print f();" },
+  // Long literals are built in batches.
+  { INTERPRET_OK, "255\n300\n",
+      "print[" ONES_100 ONES_100 ONES_50 "1,1,1,1,1].size();"
+      "print[" ONES_100 ONES_100 ONES_100 "].size();" },
+  { INTERPRET_OK, "255\n301\n301\n",
+      "var x=1;var l=[" ONES_100 ONES_100 ONES_50 "1,1,1,1,x];"
+      "print l.size();l=[" ONES_100 ONES_100 ONES_100 "x];"
+      "print l.size();var sum=0;for(var e in l)sum=sum+e;print sum;" },
+};
+
+INTERPRET(List, list, 23);
+
+InterpretCase float64ArrayAdd[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
+      "Float64Array(1).add();" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Argument must be a number or Float64Array.",
+      "Float64Array(1).add(nil);" },
+  { INTERPRET_RUNTIME_ERROR, "Float64Array sizes must match (1 and 2).",
+      "Float64Array(1).add(Float64Array(2));" },
+  { INTERPRET_OK, "[1.5, 2.5, 3.5, 4.5, 5.5]\n",
+      "print Float64Array([1,2,3,4,5]).add(0.5).toList();" },
+  { INTERPRET_OK, "[11, 22, 33, 44, 55]\n",
+      "var a=Float64Array([1,2,3,4,5]);"
+      "a.add(Float64Array([10,20,30,40,50]));print a.toList();" },
+};
+
+INTERPRET(Float64ArrayAdd, float64ArrayAdd, 5);
+
+InterpretCase float64ArrayDot[] = {
+  { INTERPRET_RUNTIME_ERROR, "Argument must be a Float64Array.",
+      "Float64Array(1).dot([1]);" },
+  { INTERPRET_RUNTIME_ERROR, "Float64Array sizes must match (2 and 1).",
+      "Float64Array(2).dot(Float64Array(1));" },
+  { INTERPRET_OK, "0\n",
+      "print Float64Array(0).dot(Float64Array(0));" },
+  { INTERPRET_OK, "55\n", "var a=Float64Array([1,2,3,4,5]);"
+      "print a.dot(Float64Array([1,2,3,4,5]));" },
 };
 
-INTERPRET(List, list, 20);
+INTERPRET(Float64ArrayDot, float64ArrayDot, 4);
+
+InterpretCase float64ArrayMap[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
+      "Float64Array(1).map();" },
+  { INTERPRET_RUNTIME_ERROR, "Can only call functions and classes.",
+      "Float64Array(1).map(nil);" },
+  { INTERPRET_RUNTIME_ERROR, "Map function must return a number.",
+      "fun f(x){}Float64Array(1).map(f);" },
+  { INTERPRET_RUNTIME_ERROR, "Operand must be a number.",
+      "fun f(x){return -nil;}Float64Array(1).map(f);" },
+  { INTERPRET_OK, "[1, 4, 9]\n",
+      "fun f(x){return x*x;}"
+      "print Float64Array([1,2,3]).map(f).toList();" },
+  { INTERPRET_OK, "[2, 3]\n",
+      "class A{init(n){this.n=n;}add(x){return x+this.n;}}"
+      "print Float64Array([1,2]).map(A(1).add).toList();" },
+  { INTERPRET_OK, "1\n",
+      "print Float64Array([1.5]).map(floor)[0];" },
+};
+
+INTERPRET(Float64ArrayMap, float64ArrayMap, 7);
+
+InterpretCase float64ArrayMinMax[] = {
+  { INTERPRET_RUNTIME_ERROR,
+      "Can't take the min of an empty Float64Array.",
+      "Float64Array(0).min();" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Can't take the max of an empty Float64Array.",
+      "Float64Array(0).max();" },
+  { INTERPRET_OK, "-3\n9\n",
+      "var a=Float64Array([4,-3,7,9,0,1,2]);"
+      "print a.min();print a.max();" },
+  { INTERPRET_OK, "nan\nnan\n",
+      "var a=Float64Array([1,2,3,4,5]);a[3]=0/0;"
+      "print a.min();print a.max();" },
+};
+
+INTERPRET(Float64ArrayMinMax, float64ArrayMinMax, 4);
+
+InterpretCase float64ArrayScale[] = {
+  { INTERPRET_RUNTIME_ERROR, "Argument must be a number.",
+      "Float64Array(1).scale(nil);" },
+  { INTERPRET_OK, "[-2, -4, -6, -8, -10]\n",
+      "print Float64Array([1,2,3,4,5]).scale(-2).toList();" },
+};
+
+INTERPRET(Float64ArrayScale, float64ArrayScale, 2);
+
+InterpretCase float64ArraySizeSum[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
+      "Float64Array(0).size(1);" },
+  { INTERPRET_OK, "0\n0\n",
+      "var a=Float64Array(0);print a.size();print a.sum();" },
+  { INTERPRET_OK, "9\n45\n",
+      "var a=Float64Array([1,2,3,4,5,6,7,8,9]);"
+      "print a.size();print a.sum();" },
+};
+
+INTERPRET(Float64ArraySizeSum, float64ArraySizeSum, 3);
+
+InterpretCase listExtend[] = {
+  { INTERPRET_RUNTIME_ERROR, "Argument must be a list.",
+      "[].extend(nil);" },
+  { INTERPRET_OK, "nil\n[1, 2, 3]\n",
+      "var l=[1];print l.extend([2,3]);print l;" },
+  { INTERPRET_OK, "[1, 2, 1, 2]\n[1, 2, 1, 2]\n",
+      "var l=[1,2];l.extend(l);print l;l.extend([]);print l;" },
+  { INTERPRET_OK, "100\n99\n",
+      "var l=[];for(var i in range(100))l.extend([i]);"
+      "print l.size();print l[99];" },
+};
+
+INTERPRET(ListExtend, listExtend, 4);
+
+InterpretCase listFill[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
+      "[].fill();" },
+  { INTERPRET_OK, "nil\n[x, x, x]\n[]\n",
+      "var l=[1,2,3];print l.fill(\"x\");print l;"
+      "l=[];l.fill(0);print l;" },
+};
+
+INTERPRET(ListFill, listFill, 2);
+
+InterpretCase listIndexOf[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
+      "[].indexOf();" },
+  { INTERPRET_OK, "-1\n1\n2\n-1\n",
+      "var l=[nil,1,\"a\",1];print[].indexOf(nil);print l.indexOf(1);"
+      "print l.indexOf(\"a\");print l.indexOf(\"b\");" },
+};
+
+INTERPRET(ListIndexOf, listIndexOf, 2);
 
 InterpretCase listInsert[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 2 arguments but got 0.",
@@ -987,6 +1533,22 @@ InterpretCase listPop[] = {
 
 INTERPRET(ListPop, listPop, 4);
 
+InterpretCase listPopFront[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
+      "[].popFront(0);" },
+  { INTERPRET_RUNTIME_ERROR, "Can't pop from an empty list.",
+      "[].popFront();" },
+  { INTERPRET_OK, "0\n1\n2\n3\n4\n5\n6\n7\n[]\n",
+      "var l=[0,1,2,3,4,5,6,7];"
+      "for(var i=0;i<8;i=i+1)print l.popFront();"
+      "print l;" },
+  { INTERPRET_OK, "[97, 98, 99]\n",
+      "var q=[0,1,2];"
+      "for(var i in range(3,100)){q.push(i);q.popFront();}print q;" },
+};
+
+INTERPRET(ListPopFront, listPopFront, 4);
+
 InterpretCase listPush[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       "[].push();" },
@@ -997,6 +1559,23 @@ InterpretCase listPush[] = {
 
 INTERPRET(ListPush, listPush, 3);
 
+InterpretCase listPushFront[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
+      "[].pushFront();" },
+  { INTERPRET_OK, "nil\n[0]\n",
+      "var l=[];print l.pushFront(0);print l;" },
+  { INTERPRET_OK, "[7, 6, 5, 4, 3, 2, 1, 0]\n",
+      "var l=[];for(var i=0;i<8;i=i+1)l.pushFront(i);print l;" },
+  { INTERPRET_OK, "[-2, -1, 0, 1, 2]\n-1\n[-2, 9, 0, 1, 2]\n",
+      "var l=[0];l.push(1);l.pushFront(-1);l.push(2);l.pushFront(-2);"
+      "print l;print l[1];l[1]=9;print l;" },
+  { INTERPRET_OK, "[-3, 5, -2, 0, 1]\n",
+      "var l=[0,1];l.pushFront(-1);l.pushFront(-2);l.pushFront(-3);"
+      "l.insert(1,5);l.remove(3);print l;" },
+};
+
+INTERPRET(ListPushFront, listPushFront, 5);
+
 InterpretCase listRemove[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       "[].remove();" },
@@ -1012,6 +1591,30 @@ InterpretCase listRemove[] = {
 
 INTERPRET(ListRemove, listRemove, 4);
 
+InterpretCase listReserve[] = {
+  { INTERPRET_RUNTIME_ERROR, "Size must be a number.",
+      "[].reserve(nil);" },
+  { INTERPRET_RUNTIME_ERROR,
+      "Size (0.5) must be a whole number between 0 and 2147483647.",
+      "[].reserve(0.5);" },
+  { INTERPRET_OK, "nil\n[1, 2]\n[1, 2, 3]\n",
+      "var l=[1,2];print l.reserve(1);print l;"
+      "l.reserve(100);l.push(3);print l;" },
+};
+
+INTERPRET(ListReserve, listReserve, 3);
+
+InterpretCase listReverse[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
+      "[].reverse(1);" },
+  { INTERPRET_OK, "nil\n[]\n[1]\n[2, 1]\n[3, 2, 1]\n",
+      "var l=[];print l.reverse();print l;"
+      "l=[1];l.reverse();print l;l=[1,2];l.reverse();print l;"
+      "l=[1,2,3];l.reverse();print l;" },
+};
+
+INTERPRET(ListReverse, listReverse, 2);
+
 InterpretCase listSize[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
       "[].size(0);" },
@@ -1026,6 +1629,65 @@ InterpretCase listSize[] = {
 
 INTERPRET(ListSize, listSize, 4);
 
+InterpretCase listSort[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 0 to 1 arguments but got 2.",
+      "[].sort(nil,nil);" },
+  { INTERPRET_RUNTIME_ERROR,
+      "List elements must be all numbers or all strings "
+      "to sort without a comparator.",
+      "[1,\"a\"].sort();" },
+  { INTERPRET_RUNTIME_ERROR,
+      "List elements must be all numbers or all strings "
+      "to sort without a comparator.",
+      "[nil,nil].sort();" },
+  { INTERPRET_OK, "nil\n[]\n[-2, 0, 1, 1, 3, 5, 7, 9]\n",
+      "var a=[];print a.sort();print a;"
+      "a=[5,3,9,1,1,0,-2,7];a.sort();print a;" },
+  { INTERPRET_OK, "[, a, ab, abc, b]\n",
+      "var a=[\"b\",\"abc\",\"\",\"a\",\"ab\"];a.sort();print a;" },
+  { INTERPRET_OK, "[3, 2, 1]\n",
+      "var a=[1,3,2];a.sort(fun(x,y){return y-x;});print a;" },
+  { INTERPRET_RUNTIME_ERROR, "Comparator must return a number.",
+      "[1,2].sort(fun(x,y){return x<y;});" },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.",
+      "[1,nil].sort(fun(x,y){return x-y;});" },
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 2.",
+      "[1,2].sort(fun(x){return 0;});" },
+  { INTERPRET_OK, "[1, 2, 3]\n",
+      "var a=[3,1,2];"
+      "a.sort(fun(x,y){a.push(0);return x-y;});print a;" },
+  { INTERPRET_OK, "true\n",
+      "var a=[];for(var i in range(200))a.push((i*37)%200);a.sort();"
+      "var ok=true;for(var i in range(200))if(a[i]!=i)ok=false;"
+      "print ok;" },
+  { INTERPRET_OK, "true\n",
+      "class P{init(k,v){this.k=k;this.v=v;}}"
+      "var a=[];for(var i in range(200))a.push(P((i*7)%5,i));"
+      "a.sort(fun(x,y){return x.k-y.k;});var ok=true;"
+      "for(var i in range(1,200))"
+      "if(a[i-1].k>a[i].k or (a[i-1].k==a[i].k and a[i-1].v>a[i].v))"
+      "ok=false;"
+      "print ok;" },
+};
+
+INTERPRET(ListSort, listSort, 12);
+
+InterpretCase listSlice[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 2 arguments but got 0.",
+      "[].slice();" },
+  { INTERPRET_RUNTIME_ERROR, "Start must be a number.",
+      "[].slice(nil,0);" },
+  { INTERPRET_RUNTIME_ERROR, "End (0.5) must be a whole number.",
+      "[].slice(0,0.5);" },
+  { INTERPRET_OK, "[1, 2]\n[0, 1, 2, 3]\n[2, 3]\n[]\n[]\n",
+      "var l=[0,1,2,3];print l.slice(1,3);print l.slice(0,-1);"
+      "print l.slice(-3,99);print l.slice(3,1);print[].slice(0,1);" },
+  { INTERPRET_OK, "[9, 1]\n[0, 1]\n",
+      "var l=[0,1];var s=l.slice(0,2);s[0]=9;print s;print l;" },
+};
+
+INTERPRET(ListSlice, listSlice, 5);
+
 InterpretCase map[] = {
   { INTERPRET_COMPILE_ERROR, "Expect identifier or '['.", "({)" },
   { INTERPRET_COMPILE_ERROR, "Expect identifier or '['.", "({,)" },
@@ -1040,15 +1702,13 @@ InterpretCase map[] = {
       "({[\"a\")" },
   { INTERPRET_COMPILE_ERROR, "Expect ':' after map key.",
       "({[\"a\"])" },
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      "({}[nil]);" },
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      "({}[{}]);" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined key 'nil'.", "({}[nil]);" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined key '<map>'.", "({}[{}]);" },
   { INTERPRET_RUNTIME_ERROR, "Undefined key 'a'.", "({}[\"a\"]);" },
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      "({}[nil]=nil);" },
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      "({}[{}]=nil);" },
+  { INTERPRET_RUNTIME_ERROR, "Undefined key '1.5'.", "({}[1.5]);" },
+  { INTERPRET_OK, "{nil: 1}\n", "var m={};m[nil]=1;print m;" },
+  { INTERPRET_OK, "{z: 1, 2: y, x: 3}\n", "print{z:1,[2]:\"y\",x:3};" },
+  { INTERPRET_OK, "1\n", "var m={};var k={};m[k]=1;print m[k];" },
   { INTERPRET_OK, "{}\n", "print{};" },
   { INTERPRET_OK, "{a: 1}\n", "print{a:1};" },
   { INTERPRET_OK, "{a: 1}\n", "print{a:1,};" },
@@ -1060,26 +1720,62 @@ InterpretCase map[] = {
   { INTERPRET_OK, "1\n2\n1\n2\n",
       "var m={};print m[\"a\"]=1;print m[\"b\"]=2;"
       "print m[\"a\"];print m[\"b\"];" },
+  { INTERPRET_OK, "{a: 2}\n{a: 3}\n",
+      "var x=3;print{a:1,a:2};print{a:1,a:x};" },
+  // Literal maps of constants are copied, not shared.
+  { INTERPRET_OK, "{a: 1, b: 3}\n{a: 1}\n",
+      "fun f(){return{a:1};}var m=f();m[\"b\"]=3;print m;print f();" },
 };
 
-INTERPRET(Map, map, 24);
+InterpretCase mapValueKeys[] = {
+  { INTERPRET_OK, "a\nb\nc\nd\n",
+      "var m={[1]:\"a\",[true]:\"b\",[nil]:\"c\",[\"1\"]:\"d\"};"
+      "print m[1];print m[true];print m[nil];print m[\"1\"];" },
+  { INTERPRET_OK, "zero\nzero\n1\n",
+      "var m={};m[0]=\"zero\";print m[-0];m[-0]=\"zero\";"
+      "print m[0];print m.count();" },
+  { INTERPRET_OK, "nan\n1\n",
+      "var m={};var n=0/0;m[n]=\"nan\";print m[n];print m.count();" },
+  { INTERPRET_OK, "false\ntrue\n",
+      "class C{}var a=C();var b=C();var m={[a]:1};"
+      "print m.has(b);print m.has(a);" },
+  { INTERPRET_OK, "true\n",
+      "var m={[[]]:1};print m.has(m.keys()[0]);" },
+  { INTERPRET_OK, "1000\n499500\n",
+      "var m={};for(var i=0;i<1000;i=i+1)m[i]=i;"
+      "var sum=0;for(var i=0;i<1000;i=i+1)sum=sum+m[i];"
+      "print m.count();print sum;" },
+  { INTERPRET_OK, "500\nfalse\ntrue\n",
+      "var m={};for(var i=0;i<1000;i=i+1)m[i]=i;"
+      "for(var i=0;i<1000;i=i+2)m.remove(i);"
+      "print m.count();print m.has(10);print m.has(11);" },
+};
+
+INTERPRET(Map, map, 28);
+INTERPRET(MapValueKeys, mapValueKeys, 7);
 
 InterpretCase mapCount[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
       "({}).count(nil);" },
   { INTERPRET_OK, "0\n", "print{}.count();" },
   { INTERPRET_OK, "3\n", "print{a:4,b:5,c:6}.count();" },
+  { INTERPRET_OK, "2\n2\n",
+      "var m={a:4,b:5,c:6};m.remove(\"b\");print m.count();"
+      "m.remove(\"b\");print m.count();" },
+  { INTERPRET_OK, "3\n", "var m={a:4,b:5};m[\"a\"]=1;m[\"c\"]=6;"
+      "m[\"a\"]=2;print m.count();" },
+  { INTERPRET_OK, "0\n",
+      "var m={};for(var i=0;i<100;i=i+1)m[i]=i;var i=0;"
+      "while(m.count()>0){m.remove(i);i=i+1;}print m.count();" },
 };
 
-INTERPRET(MapCount, mapCount, 3);
+INTERPRET(MapCount, mapCount, 6);
 
 InterpretCase mapHas[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       "({}).has();" },
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      "({}).has(nil);" },
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      "({}).has({});" },
+  { INTERPRET_OK, "false\n", "print{}.has(nil);" },
+  { INTERPRET_OK, "true\n", "print{[nil]:1}.has(nil);" },
   { INTERPRET_OK, "false\n", "print{}.has(\"\");" },
   { INTERPRET_OK, "true\n", "print{a:1}.has(\"a\");" },
   { INTERPRET_OK, "false\n", "print{a:1}.has(\"b\");" },
@@ -1098,17 +1794,20 @@ InterpretCase mapKeys[] = {
       "var m={a:1,b:2,c:3};var ks=m.keys();var sum=0;"
       "for(var i=0;i<ks.size();i=i+1)sum=sum+m[ks[i]];"
       "print sum;" },
+  { INTERPRET_OK, "[c, a, b]\n", "print{c:1,a:2,b:3}.keys();" },
+  { INTERPRET_OK, "[a, c, b]\n",
+      "var m={a:1,b:2,c:3};m.remove(\"b\");m[\"b\"]=4;m[\"a\"]=5;"
+      "print m.keys();" },
 };
 
-INTERPRET(MapKeys, mapKeys, 5);
+INTERPRET(MapKeys, mapKeys, 7);
 
 InterpretCase mapRemove[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       "({}).remove();" },
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      "({}).remove(nil);" },
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      "({}).remove({});" },
+  { INTERPRET_OK, "false\n", "print{}.remove(nil);" },
+  { INTERPRET_OK, "true\n{}\n",
+      "var m={[2]:1};print m.remove(2);print m;" },
   { INTERPRET_OK, "false\n", "print{}.remove(\"\");" },
   { INTERPRET_OK, "{a: 1}\ntrue\n{}\n",
       "var m={a:1};print m;print m.remove(\"a\");print m;" },
@@ -1118,6 +1817,64 @@ InterpretCase mapRemove[] = {
 
 INTERPRET(MapRemove, mapRemove, 6);
 
+InterpretCase stringBuilderAppend[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
+      "StringBuilder().append();" },
+  { INTERPRET_OK, "nil\n", "print StringBuilder().append(1);" },
+  { INTERPRET_OK, "a1.5truenil[1, 2]\n",
+      "var b=StringBuilder();b.append(\"a\");b.append(1.5);"
+      "b.append(true);b.append(nil);b.append([1,2]);print b.build();" },
+  { INTERPRET_OK, "0123456789\n10\n",
+      "var b=StringBuilder();for(var i=0;i<10;i=i+1)b.append(i);"
+      "print b.build();print b.size();" },
+  { INTERPRET_OK, "true\n",
+      "var b=StringBuilder();b.append(\"ab\");b.append(\"c\");"
+      "print b.build()==\"abc\";" },
+  { INTERPRET_OK, "1000\n",
+      "var b=StringBuilder();var app=b.append;"
+      "for(var i=0;i<1000;i=i+1)app(\"x\");print b.build().size();" },
+};
+
+INTERPRET(StringBuilderAppend, stringBuilderAppend, 6);
+
+InterpretCase stringBuilderAppendAll[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 2 arguments but got 1.",
+      "StringBuilder().appendAll([]);" },
+  { INTERPRET_RUNTIME_ERROR, "First argument must be a list.",
+      "StringBuilder().appendAll(nil,\"\");" },
+  { INTERPRET_RUNTIME_ERROR, "Second argument must be a string.",
+      "StringBuilder().appendAll([],nil);" },
+  { INTERPRET_OK, "\n", "var b=StringBuilder();"
+      "b.appendAll([],\",\");print b.build();" },
+  { INTERPRET_OK, "1,a,nil\n", "var b=StringBuilder();"
+      "b.appendAll([1,\"a\",nil],\",\");print b.build();" },
+  { INTERPRET_OK, "x: 1 2 3;\n", "var b=StringBuilder();"
+      "b.append(\"x: \");b.appendAll([1,2,3],\" \");b.append(\";\");"
+      "print b.build();" },
+};
+
+INTERPRET(StringBuilderAppendAll, stringBuilderAppendAll, 6);
+
+InterpretCase stringBuilderBuild[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
+      "StringBuilder().build(0);" },
+  { INTERPRET_OK, "ab\nabc\n",
+      "var b=StringBuilder();b.append(\"ab\");print b.build();"
+      "b.append(\"c\");print b.build();" },
+};
+
+INTERPRET(StringBuilderBuild, stringBuilderBuild, 2);
+
+InterpretCase stringBuilderSize[] = {
+  { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
+      "StringBuilder().size(0);" },
+  { INTERPRET_OK, "0\n3\n",
+      "var b=StringBuilder();print b.size();"
+      "b.append(\"abc\");print b.size();" },
+};
+
+INTERPRET(StringBuilderSize, stringBuilderSize, 2);
+
 UTEST_STATE();
 
 int main(int argc, const char* argv[]) {
@@ -0,0 +1,59 @@
+#include "vm.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "ubench.h"
+
+static void runList(
+    struct ubench_run_state_s* ubench_run_state, const char* src) {
+  VM vm;
+  InterpretResult ires = INTERPRET_OK;
+  initVM(&vm, stdout, stderr);
+  UBENCH_DO_BENCHMARK() {
+    ires = interpret(&vm, src);
+  }
+  assert(ires == INTERPRET_OK);
+  (void)ires;
+  freeVM(&vm);
+}
+
+// A breadth-first style queue that grows to 10000 entries and drains.
+UBENCH_EX(List, QueueRemoveFront) {
+  runList(ubench_run_state,
+      "var q=[];for(var i in range(10000))q.push(i);"
+      "while(q.size()>0)q.remove(0);");
+}
+
+UBENCH_EX(List, DequePushPopFront) {
+  runList(ubench_run_state,
+      "var q=[];for(var i in range(10000))q.pushFront(i);"
+      "while(q.size()>0)q.popFront();");
+}
+
+UBENCH_EX(List, BuildPush) {
+  runList(ubench_run_state,
+      "var l=[];for(var i in range(100000))l.push(0);"
+      "var c=[];for(var x in l)c.push(x);");
+}
+
+UBENCH_EX(List, BuildBulk) {
+  runList(ubench_run_state,
+      "for(var i in range(20)){var l=List(100000,0);l.reverse();"
+      "var c=l.slice(0,-1);c.extend(l);}");
+}
+
+// Rebuild 16-element literals, all constant and with a variable.
+UBENCH_EX(List, LiteralConstant) {
+  runList(ubench_run_state,
+      "for(var i in range(50000)){"
+      "var l=[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16];}");
+}
+
+UBENCH_EX(List, LiteralVariable) {
+  runList(ubench_run_state,
+      "for(var i in range(50000)){"
+      "var l=[i,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16];}");
+}
+
+UBENCH_MAIN();
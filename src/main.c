@@ -1,3 +1,4 @@
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,6 +11,7 @@
 #include "debug.h"
 #include "membuf.h"
 #include "memory.h"
+#include "optimizer.h"
 #include "vm.h"
 
 #define STR(x) #x
@@ -154,14 +156,35 @@ static void printHelp(FILE* fout) {
       "Usage: clox [options] [path]\n"
       "\n"
       "   -D, --dump\t\t(debug) Dump disassembled script\n"
+      "   -I, --dump-ir\t(debug) Dump IR after each optimization pass\n"
       "   -T, --trace\t\t(debug) Trace script execution\n"
       "   -L, --log-gc\t\t(debug) Log garbage collector\n"
       "   -S, --stress-gc\t(debug) Always collect garbage\n"
+      "   -O<n>\t\tSet optimization level (0 = off, default 1, max 2)\n"
       "   -h, -?, --help\tShow help (this message) and exit\n"
       "   -v, --version\tShow version information and exit\n",
       fout);
 }
 
+// Set optimizeLevel from the digits after -O, or to 1 if there are
+// none. Return false if they aren't a level any pass runs at.
+static bool parseOptimizeLevel(const char* digits) {
+  if (!*digits) {
+    optimizeLevel = 1;
+    return true;
+  }
+  if (!isdigit((unsigned char)*digits)) {
+    return false;
+  }
+  char* end;
+  long level = strtol(digits, &end, 10);
+  if (*end || level > MAX_OPTIMIZE_LEVEL) {
+    return false;
+  }
+  optimizeLevel = (int)level;
+  return true;
+}
+
 int main(int argc, const char* argv[]) {
   const char* argv0 = argv[0];
   const char* script = NULL;
@@ -179,6 +202,8 @@ int main(int argc, const char* argv[]) {
       return 0;
     } else if (!strcmp(argv[1], "--dump")) {
       debugPrintCode = true;
+    } else if (!strcmp(argv[1], "--dump-ir")) {
+      debugPrintIr = true;
     } else if (!strcmp(argv[1], "--trace")) {
       debugTraceExecution = true;
     } else if (!strcmp(argv[1], "--log-gc")) {
@@ -200,6 +225,16 @@ int main(int argc, const char* argv[]) {
           case '?':
           case 'h': printHelp(stdout); return 0;
           case 'D': debugPrintCode = true; break;
+          case 'I': debugPrintIr = true; break;
+          case 'O':
+            // The level takes up the rest of the argument.
+            if (!parseOptimizeLevel(a + 1)) {
+              fprintf(stderr, "Unknown option: '%s'\n", argv[1]);
+              printHelp(stderr);
+              return 1;
+            }
+            a += strlen(a) - 1;
+            break;
           case 'T': debugTraceExecution = true; break;
           case 'L': debugLogGC = true; break;
           case 'S': debugStressGC = true; break;
@@ -129,14 +129,17 @@ static void blackenObject(GC* gc, Obj* object) {
     }
     case OBJ_MAP: {
       ObjMap* map = (ObjMap*)object;
-      markTable(gc, &map->table);
+      markDict(gc, &map->dict);
       break;
     }
     case OBJ_UPVALUE:
       markValue(gc, ((ObjUpvalue*)object)->closed);
       break;
+    case OBJ_FLOAT_ARRAY:
     case OBJ_NATIVE:
-    case OBJ_STRING: break;
+    case OBJ_RANGE:
+    case OBJ_STRING:
+    case OBJ_STRING_BUILDER: break;
   }
 }
 
@@ -162,6 +165,12 @@ static void freeObject(GC* gc, Obj* object) {
       FREE(gc, ObjClosure, object);
       break;
     }
+    case OBJ_FLOAT_ARRAY: {
+      ObjFloatArray* array = (ObjFloatArray*)object;
+      FREE_ARRAY(gc, double, array->values, array->count);
+      FREE(gc, ObjFloatArray, object);
+      break;
+    }
     case OBJ_FUNCTION: {
       ObjFunction* function = (ObjFunction*)object;
       freeChunk(gc, &function->chunk);
@@ -182,16 +191,23 @@ static void freeObject(GC* gc, Obj* object) {
     }
     case OBJ_MAP: {
       ObjMap* map = (ObjMap*)object;
-      freeTable(gc, &map->table);
+      freeDict(gc, &map->dict);
       FREE(gc, ObjMap, object);
       break;
     }
     case OBJ_NATIVE: FREE(gc, ObjNative, object); break;
+    case OBJ_RANGE: FREE(gc, ObjRange, object); break;
     case OBJ_STRING: {
       ObjString* string = (ObjString*)object;
       reallocate(gc, object, sizeof(ObjString) + string->length + 1, 0);
       break;
     }
+    case OBJ_STRING_BUILDER: {
+      ObjStringBuilder* builder = (ObjStringBuilder*)object;
+      FREE_ARRAY(gc, char, builder->chars, builder->capacity);
+      FREE(gc, ObjStringBuilder, object);
+      break;
+    }
     case OBJ_UPVALUE: FREE(gc, ObjUpvalue, object); break;
   }
 }
@@ -0,0 +1,296 @@
+#include "number.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Numbers are written like printf's "%g" format: six significant digits
+// with trailing zeros trimmed, and an exponent for big or small numbers.
+#define PRECISION 6
+
+// Powers of ten that are exactly representable as doubles.
+static const double exactPowersOf10[] = {
+  1e0,
+  1e1,
+  1e2,
+  1e3,
+  1e4,
+  1e5,
+  1e6,
+  1e7,
+  1e8,
+  1e9,
+  1e10,
+  1e11,
+  1e12,
+  1e13,
+  1e14,
+  1e15,
+  1e16,
+  1e17,
+  1e18,
+  1e19,
+  1e20,
+  1e21,
+  1e22,
+};
+
+static const uint64_t intPowersOf10[] = {
+  1u,
+  10u,
+  100u,
+  1000u,
+  10000u,
+  100000u,
+  1000000u,
+  10000000u,
+  100000000u,
+  1000000000u,
+  10000000000u,
+  100000000000u,
+  1000000000000u,
+  10000000000000u,
+  100000000000000u,
+  1000000000000000u,
+};
+
+static int copyLiteral(char* buf, const char* literal) {
+  size_t length = strlen(literal);
+  memcpy(buf, literal, length + 1);
+  return (int)length;
+}
+
+// Round a positive whole number below 1e15 to PRECISION digits.
+static void roundWhole(uint64_t whole, uint32_t* digits, int* exponent) {
+  int length = 1;
+  while (whole >= intPowersOf10[length]) {
+    length++;
+  }
+  *exponent = length - 1;
+
+  if (length <= PRECISION) {
+    *digits = (uint32_t)(whole * intPowersOf10[PRECISION - length]);
+    return;
+  }
+
+  uint64_t divisor = intPowersOf10[length - PRECISION];
+  uint64_t quotient = whole / divisor;
+  uint64_t remainder = whole % divisor;
+  // Exact halves round to even, like printf does.
+  if (remainder > divisor / 2 ||
+      (remainder == divisor / 2 && (quotient & 1))) {
+    quotient++;
+  }
+  if (quotient == intPowersOf10[PRECISION]) {
+    quotient /= 10;
+    (*exponent)++;
+  }
+  *digits = (uint32_t)quotient;
+}
+
+// Round a positive finite number to PRECISION significant digits, stored
+// as a whole number in *digits, with the power of ten of the leading
+// digit in *exponent.  Returns false if that can't be done quickly and
+// exactly, e.g. the number is extremely big or small, or too close to a
+// rounding boundary to trust a single inexact multiply.
+static bool roundDigits(double num, uint32_t* digits, int* exponent) {
+  if (num < 1e15 && num == floor(num)) {
+    roundWhole((uint64_t)num, digits, exponent);
+    return true;
+  }
+
+  int exp10 = (int)floor(log10(num));
+  double scaled;
+  for (;;) {
+    int shift = PRECISION - 1 - exp10;
+    if (shift > 22 || shift < -22) {
+      return false;
+    }
+    scaled = shift >= 0 ? num * exactPowersOf10[shift]
+                        : num / exactPowersOf10[-shift];
+    if (scaled < exactPowersOf10[PRECISION - 1]) {
+      exp10--;
+    } else if (scaled >= exactPowersOf10[PRECISION]) {
+      exp10++;
+    } else {
+      break;
+    }
+  }
+
+  // Scaling rounds once, so the error is far below 1e-9 at this size.
+  double whole = floor(scaled);
+  double fraction = scaled - whole;
+  if (fabs(fraction - 0.5) < 1e-9) {
+    return false;
+  }
+
+  uint32_t rounded = (uint32_t)whole + (fraction > 0.5);
+  if (rounded == intPowersOf10[PRECISION]) {
+    rounded /= 10;
+    exp10++;
+  }
+  *digits = rounded;
+  *exponent = exp10;
+  return true;
+}
+
+// Write num into buf (at least NUMBER_BUF_SIZE chars) the same way that
+// printf's "%g" would, without needing a FILE stream, and return its
+// length.
+int formatNumber(char* buf, double num) {
+  if (isnan(num)) {
+    return copyLiteral(buf, signbit(num) ? "-nan" : "nan");
+  }
+  if (isinf(num)) {
+    return copyLiteral(buf, num < 0 ? "-inf" : "inf");
+  }
+
+  char* out = buf;
+  if (signbit(num)) {
+    *out++ = '-';
+  }
+  double magnitude = fabs(num);
+  if (magnitude == 0.0) {
+    *out++ = '0';
+    *out = '\0';
+    return (int)(out - buf);
+  }
+
+  uint32_t digits;
+  int exponent;
+  if (!roundDigits(magnitude, &digits, &exponent)) {
+    return snprintf(buf, NUMBER_BUF_SIZE, "%g", num);
+  }
+
+  char d[PRECISION];
+  for (int i = PRECISION - 1; i >= 0; --i) {
+    d[i] = (char)('0' + digits % 10);
+    digits /= 10;
+  }
+  int last = PRECISION - 1;
+  while (last > 0 && d[last] == '0') {
+    last--;
+  }
+
+  if (exponent < -4 || exponent >= PRECISION) {
+    *out++ = d[0];
+    if (last > 0) {
+      *out++ = '.';
+      memcpy(out, d + 1, last);
+      out += last;
+    }
+    *out++ = 'e';
+    *out++ = exponent < 0 ? '-' : '+';
+    int e = abs(exponent);
+    if (e >= 100) {
+      *out++ = (char)('0' + e / 100);
+    }
+    *out++ = (char)('0' + e / 10 % 10);
+    *out++ = (char)('0' + e % 10);
+  } else if (exponent >= 0) {
+    memcpy(out, d, exponent + 1);
+    out += exponent + 1;
+    if (last > exponent) {
+      *out++ = '.';
+      memcpy(out, d + exponent + 1, last - exponent);
+      out += last - exponent;
+    }
+  } else {
+    *out++ = '0';
+    *out++ = '.';
+    for (int i = -1; i > exponent; --i) {
+      *out++ = '0';
+    }
+    memcpy(out, d, last + 1);
+    out += last + 1;
+  }
+
+  *out = '\0';
+  return (int)(out - buf);
+}
+
+// Read a number from chars like strtod(), storing the end of the number
+// in *after if it isn't NULL.  Plain decimal numbers whose digits and
+// exponent fit exactly into doubles are converted directly; everything
+// else (hex, "inf", "nan", very long or precise numbers) uses strtod().
+double parseNumber(const char* chars, char** after) {
+  const char* p = chars;
+  while (isspace((unsigned char)*p)) {
+    ++p;
+  }
+  bool negative = *p == '-';
+  if (*p == '-' || *p == '+') {
+    ++p;
+  }
+  if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+    return strtod(chars, after);
+  }
+
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int significant = 0;
+  int exp10 = 0;
+  while (isdigit((unsigned char)*p)) {
+    if (mantissa != 0 || *p != '0') {
+      significant++;
+    }
+    mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+    digits++;
+    ++p;
+  }
+  if (*p == '.') {
+    ++p;
+    while (isdigit((unsigned char)*p)) {
+      if (mantissa != 0 || *p != '0') {
+        significant++;
+      }
+      mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+      exp10--;
+      digits++;
+      ++p;
+    }
+  }
+  if (digits == 0 || significant > 19) {
+    return strtod(chars, after);
+  }
+
+  if (*p == 'e' || *p == 'E') {
+    const char* e = p + 1;
+    bool negativeExp = *e == '-';
+    if (*e == '-' || *e == '+') {
+      ++e;
+    }
+    if (isdigit((unsigned char)*e)) {
+      int exponent = 0;
+      while (isdigit((unsigned char)*e)) {
+        if (exponent < 100000) {
+          exponent = exponent * 10 + (*e - '0');
+        }
+        ++e;
+      }
+      exp10 += negativeExp ? -exponent : exponent;
+      p = e;
+    }
+  }
+
+  // Clinger's fast path: both operands are exact, so one correctly
+  // rounded multiply or divide gives the correctly rounded result.
+  double result;
+  if (mantissa == 0) {
+    result = 0.0;
+  } else if (mantissa <= (UINT64_C(1) << 53) && exp10 >= -22 &&
+             exp10 <= 22) {
+    result = (double)mantissa;
+    result = exp10 < 0 ? result / exactPowersOf10[-exp10]
+                       : result * exactPowersOf10[exp10];
+  } else {
+    return strtod(chars, after);
+  }
+
+  if (after != NULL) {
+    *after = (char*)p;
+  }
+  return negative ? -result : result;
+}
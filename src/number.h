@@ -0,0 +1,13 @@
+#pragma once
+#ifndef clox_number_h
+#define clox_number_h
+
+#include "common.h"
+
+// Enough room for any number written by formatNumber(), plus a null.
+#define NUMBER_BUF_SIZE 32
+
+int formatNumber(char* buf, double num);
+double parseNumber(const char* chars, char** after);
+
+#endif
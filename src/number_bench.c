@@ -0,0 +1,76 @@
+#include "number.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ubench.h"
+
+#define COUNT 100000
+
+// Fields like those found in typical CSV data.
+static char fields[COUNT][24];
+
+static void fillFields(void) {
+  static bool filled = false;
+  if (filled) {
+    return;
+  }
+  uint32_t seed = 12345;
+  for (int i = 0; i < COUNT; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    uint32_t r = seed >> 8;
+    switch (i % 4) {
+      case 0:
+        snprintf(fields[i], sizeof(fields[i]), "%u", r % 100000);
+        break;
+      case 1:
+        snprintf(fields[i], sizeof(fields[i]), "%u.%02u", r % 10000,
+            r % 100);
+        break;
+      case 2:
+        snprintf(fields[i], sizeof(fields[i]), "-%u.%06u", r % 1000,
+            r % 1000000);
+        break;
+      case 3:
+        snprintf(fields[i], sizeof(fields[i]), "%.6e", r / 7.0);
+        break;
+    }
+  }
+  filled = true;
+}
+
+UBENCH_EX(Number, ParseNumber) {
+  fillFields();
+  UBENCH_DO_BENCHMARK() {
+    double sum = 0;
+    for (int i = 0; i < COUNT; ++i) {
+      sum += parseNumber(fields[i], NULL);
+    }
+    UBENCH_DO_NOTHING(&sum);
+  }
+}
+
+UBENCH_EX(Number, Strtod) {
+  fillFields();
+  UBENCH_DO_BENCHMARK() {
+    double sum = 0;
+    for (int i = 0; i < COUNT; ++i) {
+      sum += strtod(fields[i], NULL);
+    }
+    UBENCH_DO_NOTHING(&sum);
+  }
+}
+
+UBENCH_EX(Number, FormatNumber) {
+  fillFields();
+  UBENCH_DO_BENCHMARK() {
+    char buf[NUMBER_BUF_SIZE];
+    int length = 0;
+    for (int i = 0; i < COUNT; ++i) {
+      length += formatNumber(buf, i * 1.25 - 333.3);
+    }
+    UBENCH_DO_NOTHING(&length);
+  }
+}
+
+UBENCH_MAIN();
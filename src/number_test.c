@@ -0,0 +1,122 @@
+#include "number.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utest.h"
+
+static void expectSameAsPrintf(int* utest_result, double num) {
+  char expected[64];
+  char actual[NUMBER_BUF_SIZE];
+  snprintf(expected, sizeof(expected), "%g", num);
+  int length = formatNumber(actual, num);
+  EXPECT_STREQ(expected, actual);
+  EXPECT_EQ((int)strlen(expected), length);
+}
+
+UTEST(Number, Specials) {
+  expectSameAsPrintf(utest_result, 0.0);
+  expectSameAsPrintf(utest_result, -0.0);
+  expectSameAsPrintf(utest_result, INFINITY);
+  expectSameAsPrintf(utest_result, -INFINITY);
+  expectSameAsPrintf(utest_result, NAN);
+  expectSameAsPrintf(utest_result, -NAN);
+}
+
+UTEST(Number, Integers) {
+  for (int i = -1000; i <= 1000; ++i) {
+    expectSameAsPrintf(utest_result, i);
+  }
+  const double nums[] = { 999999, 1000000, 1234567, 1234565, 1234575,
+    9999995, 9999994, 9999996, 123456789012345, 999999999999999,
+    1e15, 1e16, 4503599627370497.0, 9007199254740993.0, 1e22, 1e23,
+    1.7976931348623157e308 };
+  for (size_t i = 0; i < ARRAY_SIZE(nums); ++i) {
+    expectSameAsPrintf(utest_result, nums[i]);
+    expectSameAsPrintf(utest_result, -nums[i]);
+  }
+}
+
+UTEST(Number, Fractions) {
+  const double nums[] = { 0.5, 1.5, 2.5, 0.1, 0.2, 0.3, 1.0 / 3,
+    2.0 / 3, 3.14159265358979, 0.0001, 0.00001, 0.000123456,
+    0.0001234565, 0.1234565, 999999.5, 999998.5, 99999.95, 12.5,
+    123.456, 1e-300, 5e-324, 2.2250738585072014e-308 };
+  for (size_t i = 0; i < ARRAY_SIZE(nums); ++i) {
+    expectSameAsPrintf(utest_result, nums[i]);
+    expectSameAsPrintf(utest_result, -nums[i]);
+  }
+}
+
+UTEST(Number, Sweep) {
+  // Walk a wide range of magnitudes with awkward mantissas.
+  double num = 1e-30;
+  while (num < 1e30) {
+    expectSameAsPrintf(utest_result, num);
+    expectSameAsPrintf(utest_result, num * 1.0000001);
+    expectSameAsPrintf(utest_result, num * 0.9999999);
+    num *= 1.7;
+  }
+  for (int i = 0; i < 20000; ++i) {
+    expectSameAsPrintf(utest_result, i / 64.0);
+    expectSameAsPrintf(utest_result, i * 0.001);
+  }
+}
+
+static void expectSameAsStrtod(int* utest_result, const char* chars) {
+  char* expectedAfter;
+  char* actualAfter;
+  double expected = strtod(chars, &expectedAfter);
+  double actual = parseNumber(chars, &actualAfter);
+  EXPECT_EQ(memcmp(&expected, &actual, sizeof(double)), 0);
+  EXPECT_EQ(expectedAfter - chars, actualAfter - chars);
+}
+
+UTEST(Number, ParseSimple) {
+  const char* strs[] = { "0", "-0", "+0", "1", "-1", "123", "1.5",
+    "-2.25", ".5", "5.", "0.1", "0.2", "0.3", "3.14159265358979",
+    "  42", "\t\n-7", "1e10", "1E10", "1e-10", "2.5e+3", "1e22",
+    "1e-22", "9007199254740992", "9007199254740993", "0.000001",
+    "123456789012345678", "000000000000000000000001", "1.0000" };
+  for (size_t i = 0; i < ARRAY_SIZE(strs); ++i) {
+    expectSameAsStrtod(utest_result, strs[i]);
+  }
+}
+
+UTEST(Number, ParseSlowPath) {
+  const char* strs[] = { "1e23", "1e-23", "1e308", "1e309", "1e-400",
+    "2.2250738585072014e-308", "4.9e-324", "12345678901234567890123",
+    "0.12345678901234567890123", "9007199254740993e5", "0x1f",
+    "-0X10", "inf", "-Infinity", "nan", "1e99999999999" };
+  for (size_t i = 0; i < ARRAY_SIZE(strs); ++i) {
+    expectSameAsStrtod(utest_result, strs[i]);
+  }
+}
+
+UTEST(Number, ParsePartial) {
+  const char* strs[] = { "", " ", "-", "+", ".", "-.", "e5", "abc",
+    "12abc", "1.5.5", "1e", "1e+", "1e-x", "3 4", "7,8" };
+  for (size_t i = 0; i < ARRAY_SIZE(strs); ++i) {
+    expectSameAsStrtod(utest_result, strs[i]);
+  }
+}
+
+UTEST(Number, ParseRoundTrip) {
+  char buf[64];
+  double num = 1e-25;
+  while (num < 1e25) {
+    for (int precision = 1; precision <= 17; ++precision) {
+      snprintf(buf, sizeof(buf), "%.*g", precision, num);
+      expectSameAsStrtod(utest_result, buf);
+    }
+    num *= 1.37;
+  }
+  for (int i = 0; i < 20000; ++i) {
+    snprintf(buf, sizeof(buf), "%d.%03d", i, i % 1000);
+    expectSameAsStrtod(utest_result, buf);
+  }
+}
+
+UTEST_MAIN();
@@ -60,11 +60,27 @@ ObjClosure* newClosure(GC* gc, ObjFunction* function) {
   return closure;
 }
 
+// The values start zeroed.
+ObjFloatArray* newFloatArray(GC* gc, int count) {
+  double* values = ALLOCATE(gc, double, count);
+  for (int i = 0; i < count; i++) {
+    values[i] = 0.0;
+  }
+
+  ObjFloatArray* array =
+      ALLOCATE_OBJ(gc, ObjFloatArray, OBJ_FLOAT_ARRAY);
+  array->count = count;
+  array->values = values;
+  return array;
+}
+
 ObjFunction* newFunction(GC* gc) {
   ObjFunction* function = ALLOCATE_OBJ(gc, ObjFunction, OBJ_FUNCTION);
   function->arity = 0;
   function->upvalueCount = 0;
   function->name = NULL;
+  function->inlineKind = INLINE_NONE;
+  function->inlineValue = NIL_VAL;
   initChunk(&function->chunk);
   return function;
 }
@@ -84,7 +100,7 @@ ObjList* newList(GC* gc) {
 
 ObjMap* newMap(GC* gc) {
   ObjMap* map = ALLOCATE_OBJ(gc, ObjMap, OBJ_MAP);
-  initTable(&map->table, 0.75);
+  initDict(&map->dict);
   return map;
 }
 
@@ -94,6 +110,14 @@ ObjNative* newNative(GC* gc, NativeFn function) {
   return native;
 }
 
+ObjRange* newRange(GC* gc, double start, double end, double step) {
+  ObjRange* range = ALLOCATE_OBJ(gc, ObjRange, OBJ_RANGE);
+  range->start = start;
+  range->end = end;
+  range->step = step;
+  return range;
+}
+
 static ObjString* allocateString(GC* gc, int length, uint32_t hash) {
   ObjString* string = (ObjString*)allocateObject(
       gc, sizeof(ObjString) + length + 1, OBJ_STRING);
@@ -127,11 +151,20 @@ ObjString* concatStrings(GC* gc, Table* strings, const char* a,
   }
 
   int length = aLen + bLen;
+  int count = strings->count;
   ObjString* string = allocateString(gc, length, hash);
   memcpy(string->chars, a, aLen);
   memcpy(string->chars + aLen, b, bLen);
   string->chars[length] = '\0';
 
+  if (strings->count != count) {
+    // The GC removed dead strings while allocating, shifting entries
+    // back, so the entry found above may no longer be the right one.
+    pushTemp(gc, OBJ_VAL(string));
+    entry = tableJoinedStringsEntry(
+        gc, strings, string->chars, length, "", 0, hash);
+    popTemp(gc);
+  }
   tableSetEntry(strings, entry, string, NIL_VAL);
   return string;
 }
@@ -142,6 +175,36 @@ ObjString* copyString(
   return concatStrings(gc, strings, chars, length, hash, "", 0);
 }
 
+ObjStringBuilder* newStringBuilder(GC* gc) {
+  ObjStringBuilder* builder =
+      ALLOCATE_OBJ(gc, ObjStringBuilder, OBJ_STRING_BUILDER);
+  builder->length = 0;
+  builder->capacity = 0;
+  builder->chars = NULL;
+  return builder;
+}
+
+// The builder must be reachable by the GC, since growing it allocates.
+void appendStringBuilder(
+    GC* gc, ObjStringBuilder* builder, const char* chars, int length) {
+  assert(length >= 0); // GCOV_EXCL_LINE
+  if (length == 0) {
+    return;
+  }
+  if (builder->capacity - builder->length < length) {
+    int oldCapacity = builder->capacity;
+    int newCapacity = oldCapacity;
+    while (newCapacity - builder->length < length) {
+      newCapacity = GROW_CAPACITY(newCapacity);
+    }
+    builder->chars =
+        GROW_ARRAY(gc, char, builder->chars, oldCapacity, newCapacity);
+    builder->capacity = newCapacity;
+  }
+  memcpy(builder->chars + builder->length, chars, length);
+  builder->length += length;
+}
+
 ObjUpvalue* newUpvalue(GC* gc, Value* slot) {
   ObjUpvalue* upvalue = ALLOCATE_OBJ(gc, ObjUpvalue, OBJ_UPVALUE);
   upvalue->closed = NIL_VAL;
@@ -170,6 +233,7 @@ void printObject(FILE* fout, Value value) {
     case OBJ_CLOSURE:
       printFunction(fout, AS_CLOSURE(value)->function);
       break;
+    case OBJ_FLOAT_ARRAY: fprintf(fout, "<float64 array>"); break;
     case OBJ_FUNCTION: printFunction(fout, AS_FUNCTION(value)); break;
     case OBJ_INSTANCE:
       fprintf(
@@ -192,9 +256,9 @@ void printObject(FILE* fout, Value value) {
       ObjMap* map = AS_MAP(value);
       fputc('{', fout);
       bool first = true;
-      for (int i = 0; i < map->table.capacity; ++i) {
-        Entry* entry = &map->table.entries[i];
-        if (entry->key == NULL) {
+      for (int i = 0; i < map->dict.entryCount; ++i) {
+        DictEntry* entry = &map->dict.entries[i];
+        if (IS_EMPTY(entry->key)) {
           continue;
         }
         if (first) {
@@ -202,7 +266,7 @@ void printObject(FILE* fout, Value value) {
         } else {
           fputs(", ", fout);
         }
-        fprintf(fout, "%.*s", entry->key->length, entry->key->chars);
+        printValueShallow(fout, entry->key);
         fputs(": ", fout);
         printValueShallow(fout, entry->value);
       }
@@ -210,7 +274,9 @@ void printObject(FILE* fout, Value value) {
       break;
     }
     case OBJ_NATIVE: fprintf(fout, "<native fn>"); break;
+    case OBJ_RANGE: fprintf(fout, "<range>"); break;
     case OBJ_STRING: fprintf(fout, "%s", AS_CSTRING(value)); break;
+    case OBJ_STRING_BUILDER: fprintf(fout, "<string builder>"); break;
     case OBJ_UPVALUE: fprintf(fout, "upvalue"); break;
   }
 }
@@ -6,6 +6,7 @@
 
 #include "chunk.h"
 #include "common.h"
+#include "dict.h"
 #include "gc.h"
 #include "table.h"
 #include "value.h"
@@ -16,33 +17,42 @@
 #define IS_BOUND_METHOD(value) isObjType(value, OBJ_BOUND_METHOD)
 #define IS_CLASS(value)        isObjType(value, OBJ_CLASS)
 #define IS_CLOSURE(value)      isObjType(value, OBJ_CLOSURE)
+#define IS_FLOAT_ARRAY(value)  isObjType(value, OBJ_FLOAT_ARRAY)
 #define IS_FUNCTION(value)     isObjType(value, OBJ_FUNCTION)
 #define IS_INSTANCE(value)     isObjType(value, OBJ_INSTANCE)
 #define IS_LIST(value)         isObjType(value, OBJ_LIST)
 #define IS_MAP(value)          isObjType(value, OBJ_MAP)
+#define IS_RANGE(value)        isObjType(value, OBJ_RANGE)
 #define IS_STRING(value)       isObjType(value, OBJ_STRING)
+#define IS_STRING_BUILDER(value) isObjType(value, OBJ_STRING_BUILDER)
 
 #define AS_BOUND_METHOD(value) ((ObjBoundMethod*)AS_OBJ(value))
 #define AS_CLASS(value)        ((ObjClass*)AS_OBJ(value))
 #define AS_CLOSURE(value)      ((ObjClosure*)AS_OBJ(value))
+#define AS_FLOAT_ARRAY(value)  ((ObjFloatArray*)AS_OBJ(value))
 #define AS_FUNCTION(value)     ((ObjFunction*)AS_OBJ(value))
 #define AS_INSTANCE(value)     ((ObjInstance*)AS_OBJ(value))
 #define AS_LIST(value)         ((ObjList*)AS_OBJ(value))
 #define AS_MAP(value)          ((ObjMap*)AS_OBJ(value))
+#define AS_RANGE(value)        ((ObjRange*)AS_OBJ(value))
 #define AS_STRING(value)       ((ObjString*)AS_OBJ(value))
 #define AS_CSTRING(value)      (((ObjString*)AS_OBJ(value))->chars)
+#define AS_STRING_BUILDER(value) ((ObjStringBuilder*)AS_OBJ(value))
 // clang-format on
 
 typedef enum {
   OBJ_BOUND_METHOD,
   OBJ_CLASS,
   OBJ_CLOSURE,
+  OBJ_FLOAT_ARRAY,
   OBJ_FUNCTION,
   OBJ_INSTANCE,
   OBJ_LIST,
   OBJ_MAP,
   OBJ_NATIVE,
+  OBJ_RANGE,
   OBJ_STRING,
+  OBJ_STRING_BUILDER,
   OBJ_UPVALUE,
 } ObjType;
 
@@ -52,12 +62,21 @@ struct Obj {
   struct Obj* next;
 };
 
+// How a call to a function can be done without running its code.
+typedef enum {
+  INLINE_NONE,
+  INLINE_CONSTANT, // Returns inlineValue.
+  INLINE_GETTER,   // Returns the field of this named by inlineValue.
+} InlineKind;
+
 typedef struct {
   Obj obj;
   int arity;
   int upvalueCount;
   Chunk chunk;
   ObjString* name;
+  InlineKind inlineKind;
+  Value inlineValue; // Kept alive by the chunk's constants.
 } ObjFunction;
 
 struct ObjString {
@@ -106,20 +125,47 @@ typedef struct {
 
 typedef struct {
   Obj obj;
-  Table table;
+  Dict dict;
 } ObjMap;
 
+// A fixed-size array of unboxed doubles.
+typedef struct {
+  Obj obj;
+  int count;
+  double* values;
+} ObjFloatArray;
+
+// Numbers from start up to but not including end, stepping by step.
+typedef struct {
+  Obj obj;
+  double start;
+  double end;
+  double step;
+} ObjRange;
+
+typedef struct {
+  Obj obj;
+  int length;
+  int capacity;
+  char* chars;
+} ObjStringBuilder;
+
 ObjBoundMethod* newBoundMethod(GC* gc, Value receiver, Obj* method);
 ObjClass* newClass(GC* gc, ObjString* name);
 ObjClosure* newClosure(GC* gc, ObjFunction* function);
+ObjFloatArray* newFloatArray(GC* gc, int count);
 ObjFunction* newFunction(GC* gc);
 ObjInstance* newInstance(GC* gc, ObjClass* klass);
 ObjList* newList(GC* gc);
 ObjMap* newMap(GC* gc);
+ObjRange* newRange(GC* gc, double start, double end, double step);
 ObjString* concatStrings(GC* gc, Table* strings, const char* a,
     int aLen, uint32_t aHash, const char* b, int bLen);
 ObjString* copyString(
     GC* gc, Table* strings, const char* chars, int length);
+ObjStringBuilder* newStringBuilder(GC* gc);
+void appendStringBuilder(
+    GC* gc, ObjStringBuilder* builder, const char* chars, int length);
 ObjUpvalue* newUpvalue(GC* gc, Value* slot);
 void printObject(FILE* fout, Value value);
 
@@ -0,0 +1,632 @@
+#include "optimizer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug.h"
+#include "memory.h"
+#include "object.h"
+
+int optimizeLevel = 1;
+bool debugPrintIr = false;
+
+// The IR is the code of a chunk decoded into instructions. Jumps point
+// at instruction indices instead of byte offsets, so passes can remove
+// and rewrite instructions without patching every jump around them.
+typedef struct {
+  int start;  // Offset of the opcode in the chunk's code.
+  int length; // Bytes in the opcode and its operands; 0 if removed.
+  int line;
+  int target; // Index of the instruction a jump goes to, or -1.
+} Instr;
+
+typedef struct {
+  GC* gc;
+  Chunk* chunk;
+  int count;
+  int capacity;
+  Instr* instrs;
+} Ir;
+
+static int operandLength(Chunk* chunk, int offset) {
+  switch ((OpCode)chunk->code[offset]) {
+    case OP_NIL:
+    case OP_TRUE:
+    case OP_FALSE:
+    case OP_POP:
+    case OP_DUP:
+    case OP_GET_INDEX:
+    case OP_SET_INDEX:
+    case OP_GET_INDEX_KEEP:
+    case OP_ADD_INDEX:
+    case OP_SUBTRACT_INDEX:
+    case OP_MULTIPLY_INDEX:
+    case OP_DIVIDE_INDEX:
+    case OP_MODULO_INDEX:
+    case OP_EQUAL:
+    case OP_NOT_EQUAL:
+    case OP_GREATER:
+    case OP_GREATER_NN:
+    case OP_NOT_GREATER:
+    case OP_LESS:
+    case OP_LESS_NN:
+    case OP_NOT_LESS:
+    case OP_ADD:
+    case OP_ADD_NN:
+    case OP_SUBTRACT:
+    case OP_SUBTRACT_NN:
+    case OP_MULTIPLY:
+    case OP_MULTIPLY_NN:
+    case OP_DIVIDE:
+    case OP_DIVIDE_NN:
+    case OP_MODULO:
+    case OP_NOT:
+    case OP_NEGATE:
+    case OP_PRINT:
+    case OP_CLOSE_UPVALUE:
+    case OP_ITER_INIT:
+    case OP_RETURN:
+    case OP_INHERIT:
+    case MAX_OPCODES: return 0;
+    case OP_GET_LOCAL:
+    case OP_SET_LOCAL:
+    case OP_SET_LOCAL_POP:
+    case OP_GET_UPVALUE:
+    case OP_SET_UPVALUE:
+    case OP_CALL:
+    case OP_LIST_BUILD:
+    case OP_LIST_DATA:
+    case OP_MAP_BUILD:
+    case OP_MAP_DATA: return 1;
+    case OP_CONSTANT:
+    case OP_GET_GLOBAL:
+    case OP_GET_GLOBAL_I:
+    case OP_DEFINE_GLOBAL:
+    case OP_DEFINE_GLOBAL_I:
+    case OP_SET_GLOBAL:
+    case OP_SET_GLOBAL_I:
+    case OP_SET_GLOBAL_I_POP:
+    case OP_GET_PROPERTY:
+    case OP_SET_PROPERTY:
+    case OP_GET_PROPERTY_KEEP:
+    case OP_ADD_PROPERTY:
+    case OP_SUBTRACT_PROPERTY:
+    case OP_MULTIPLY_PROPERTY:
+    case OP_DIVIDE_PROPERTY:
+    case OP_MODULO_PROPERTY:
+    case OP_GET_SUPER:
+    case OP_LESS_C:
+    case OP_LESS_C_NN:
+    case OP_NOT_LESS_C:
+    case OP_ADD_C:
+    case OP_ADD_C_NN:
+    case OP_SUBTRACT_C:
+    case OP_SUBTRACT_C_NN:
+    case OP_JUMP:
+    case OP_JUMP_IF_FALSE:
+    case OP_PJMP_IF_FALSE:
+    case OP_LOOP:
+    case OP_LIST_TEMPLATE:
+    case OP_MAP_TEMPLATE:
+    case OP_CLASS:
+    case OP_METHOD: return 2;
+    case OP_INC_LOCAL:
+    case OP_HOIST_PROPERTY:
+    case OP_GET_HOISTED:
+    case OP_INVOKE:
+    case OP_SUPER_INVOKE: return 3;
+    case OP_JUMP_IF_LESS_LL:
+    case OP_JUMP_IF_NOT_LESS_LL:
+    case OP_JUMP_IF_EQUAL_LL:
+    case OP_JUMP_IF_NOT_EQUAL_LL:
+    case OP_ITER_NEXT: return 4;
+    case OP_JUMP_IF_LESS_LC:
+    case OP_JUMP_IF_NOT_LESS_LC:
+    case OP_JUMP_IF_GREATER_LC:
+    case OP_JUMP_IF_NOT_GREATER_LC:
+    case OP_JUMP_IF_EQUAL_LC:
+    case OP_JUMP_IF_NOT_EQUAL_LC: return 5;
+    case OP_CLOSURE: {
+      uint16_t constant = (uint16_t)(chunk->code[offset + 1] << 8);
+      constant |= chunk->code[offset + 2];
+      ObjFunction* function =
+          AS_FUNCTION(chunk->constants.values[constant]);
+      return 2 + function->upvalueCount * 2;
+    }
+  }
+  return 0; // GCOV_EXCL_LINE: Unreachable.
+}
+
+// Return the name of the jump op, or NULL if it's not a jump.
+static const char* jumpName(uint8_t op) {
+  switch (op) {
+    case OP_JUMP: return "OP_JUMP";
+    case OP_JUMP_IF_FALSE: return "OP_JUMP_IF_FALSE";
+    case OP_PJMP_IF_FALSE: return "OP_PJMP_IF_FALSE";
+    case OP_JUMP_IF_LESS_LC: return "OP_JUMP_IF_LESS_LC";
+    case OP_JUMP_IF_NOT_LESS_LC: return "OP_JUMP_IF_NOT_LESS_LC";
+    case OP_JUMP_IF_GREATER_LC: return "OP_JUMP_IF_GREATER_LC";
+    case OP_JUMP_IF_NOT_GREATER_LC: return "OP_JUMP_IF_NOT_GREATER_LC";
+    case OP_JUMP_IF_EQUAL_LC: return "OP_JUMP_IF_EQUAL_LC";
+    case OP_JUMP_IF_NOT_EQUAL_LC: return "OP_JUMP_IF_NOT_EQUAL_LC";
+    case OP_JUMP_IF_LESS_LL: return "OP_JUMP_IF_LESS_LL";
+    case OP_JUMP_IF_NOT_LESS_LL: return "OP_JUMP_IF_NOT_LESS_LL";
+    case OP_JUMP_IF_EQUAL_LL: return "OP_JUMP_IF_EQUAL_LL";
+    case OP_JUMP_IF_NOT_EQUAL_LL: return "OP_JUMP_IF_NOT_EQUAL_LL";
+    case OP_LOOP: return "OP_LOOP";
+    case OP_GET_HOISTED: return "OP_GET_HOISTED";
+    case OP_ITER_NEXT: return "OP_ITER_NEXT";
+    default: return NULL;
+  }
+}
+
+// Return the offset a jump at offset goes to, or -1 if it's not a jump.
+// Every jump keeps its distance in its last two operand bytes.
+static int jumpTarget(Chunk* chunk, int offset, int length) {
+  uint8_t op = chunk->code[offset];
+  if (jumpName(op) == NULL) {
+    return -1;
+  }
+  int end = offset + length;
+  int distance = (chunk->code[end - 2] << 8) | chunk->code[end - 1];
+  return op == OP_LOOP ? end - distance : end + distance;
+}
+
+static void initIr(Ir* ir, GC* gc, Chunk* chunk) {
+  ir->gc = gc;
+  ir->chunk = chunk;
+  ir->count = 0;
+  ir->capacity = 0;
+  ir->instrs = NULL;
+
+  int* indices = ALLOCATE(gc, int, chunk->count + 1);
+  for (int offset = 0; offset < chunk->count;) {
+    indices[offset] = ir->capacity++;
+    offset += 1 + operandLength(chunk, offset);
+  }
+  indices[chunk->count] = ir->capacity;
+
+  ir->instrs = ALLOCATE(gc, Instr, ir->capacity);
+  for (int offset = 0; offset < chunk->count;) {
+    Instr* instr = &ir->instrs[ir->count++];
+    instr->start = offset;
+    instr->length = 1 + operandLength(chunk, offset);
+    instr->line = getLine(chunk, offset);
+    int target = jumpTarget(chunk, offset, instr->length);
+    instr->target = target >= 0 ? indices[target] : -1;
+    offset += instr->length;
+  }
+  FREE_ARRAY(gc, int, indices, chunk->count + 1);
+}
+
+static void freeIr(Ir* ir) {
+  FREE_ARRAY(ir->gc, Instr, ir->instrs, ir->capacity);
+}
+
+static uint8_t opAt(Ir* ir, int index) {
+  return ir->chunk->code[ir->instrs[index].start];
+}
+
+static bool isUnconditional(uint8_t op) {
+  return op == OP_JUMP || op == OP_LOOP;
+}
+
+// Drop removed instructions, moving jumps that went to them onto the
+// instructions that followed them.
+static void compactIr(Ir* ir) {
+  int* indices = ALLOCATE(ir->gc, int, ir->count + 1);
+  int live = 0;
+  for (int i = 0; i < ir->count; ++i) {
+    indices[i] = live;
+    live += ir->instrs[i].length > 0;
+  }
+  indices[ir->count] = live;
+
+  int j = 0;
+  for (int i = 0; i < ir->count; ++i) {
+    Instr instr = ir->instrs[i];
+    if (instr.length > 0) {
+      if (instr.target >= 0) {
+        instr.target = indices[instr.target];
+      }
+      ir->instrs[j++] = instr;
+    }
+  }
+  FREE_ARRAY(ir->gc, int, indices, ir->count + 1);
+  ir->count = live;
+}
+
+// Replace the code of the chunk with the code of the IR.
+static void encodeIr(Ir* ir) {
+  GC* gc = ir->gc;
+  Chunk* chunk = ir->chunk;
+  int* offsets = ALLOCATE(gc, int, ir->count + 1);
+  int size = 0;
+  for (int i = 0; i < ir->count; ++i) {
+    offsets[i] = size;
+    size += ir->instrs[i].length;
+  }
+  offsets[ir->count] = size;
+
+  uint8_t* code = ALLOCATE(gc, uint8_t, size);
+  for (int i = 0; i < ir->count; ++i) {
+    Instr* instr = &ir->instrs[i];
+    uint8_t* bytes = &code[offsets[i]];
+    memcpy(bytes, &chunk->code[instr->start], (size_t)instr->length);
+
+    if (instr->target >= 0) {
+      int from = offsets[i] + instr->length;
+      int to = offsets[instr->target];
+      if (isUnconditional(bytes[0])) {
+        bytes[0] = to >= from ? OP_JUMP : OP_LOOP;
+      }
+      int distance = to >= from ? to - from : from - to;
+      bytes[instr->length - 2] = (distance >> 8) & 0xff;
+      bytes[instr->length - 1] = distance & 0xff;
+    }
+  }
+
+  // Lines only ever merge, so the new table fits in the old one.
+  chunk->lineCount = 0;
+  for (int i = 0; i < ir->count; ++i) {
+    addLine(gc, chunk, offsets[i], ir->instrs[i].line);
+  }
+  FREE_ARRAY(gc, int, offsets, ir->count + 1);
+
+  FREE_ARRAY(gc, uint8_t, chunk->code, chunk->capacity);
+  chunk->code = code;
+  chunk->count = size;
+  chunk->capacity = size;
+}
+
+// Remove instructions that no path from the start of the chunk reaches,
+// such as the implicit return after an explicit one.
+static bool removeUnreachable(Ir* ir) {
+  bool* reached = ALLOCATE(ir->gc, bool, ir->count);
+  int* work = ALLOCATE(ir->gc, int, ir->count);
+  int workCount = 0;
+  memset(reached, 0, sizeof(bool) * (size_t)ir->count);
+  reached[0] = true;
+  work[workCount++] = 0;
+
+  while (workCount > 0) {
+    int i = work[--workCount];
+    uint8_t op = opAt(ir, i);
+    int next[2] = { ir->instrs[i].target, -1 };
+    if (!isUnconditional(op) && op != OP_RETURN) {
+      next[1] = i + 1;
+    }
+    for (int k = 0; k < 2; ++k) {
+      if (next[k] >= 0 && next[k] < ir->count && !reached[next[k]]) {
+        reached[next[k]] = true;
+        work[workCount++] = next[k];
+      }
+    }
+  }
+
+  bool changed = false;
+  for (int i = 0; i < ir->count; ++i) {
+    if (!reached[i]) {
+      ir->instrs[i].length = 0;
+      changed = true;
+    }
+  }
+  FREE_ARRAY(ir->gc, bool, reached, ir->count);
+  FREE_ARRAY(ir->gc, int, work, ir->count);
+  return changed;
+}
+
+// Follow the jump at index through jumps that must go the same way as
+// it once it's taken.
+static int threadedTarget(Ir* ir, int index) {
+  Instr* instr = &ir->instrs[index];
+  uint8_t op = opAt(ir, index);
+  int target = instr->target;
+  for (int hops = 0; hops < ir->count && target < ir->count; ++hops) {
+    Instr* next = &ir->instrs[target];
+    uint8_t nextOp = opAt(ir, target);
+    // A value that made OP_JUMP_IF_FALSE jump is still on the stack.
+    if (next->target < 0 ||
+        !(isUnconditional(nextOp) ||
+            (op == OP_JUMP_IF_FALSE && nextOp == OP_JUMP_IF_FALSE))) {
+      break;
+    }
+    // Only unconditional jumps can go backwards.
+    if (!isUnconditional(op) && next->target <= index) {
+      break;
+    }
+    // The distance must still fit; offsets only shrink after this.
+    int from = instr->start + instr->length;
+    int to = ir->instrs[next->target].start;
+    if (abs(to - from) > UINT16_MAX) {
+      break;
+    }
+    target = next->target;
+  }
+  return target;
+}
+
+// Send jumps that land on jumps straight to the final destination, and
+// remove jumps to the very next instruction.
+static bool threadJumps(Ir* ir) {
+  bool changed = false;
+  for (int i = 0; i < ir->count; ++i) {
+    Instr* instr = &ir->instrs[i];
+    if (instr->target < 0) {
+      continue;
+    }
+    int target = threadedTarget(ir, i);
+    if (target != instr->target) {
+      instr->target = target;
+      changed = true;
+    }
+    if (target != i + 1) {
+      continue;
+    }
+
+    uint8_t op = opAt(ir, i);
+    if (isUnconditional(op) || op == OP_JUMP_IF_FALSE) {
+      instr->length = 0;
+      changed = true;
+    } else if (op == OP_PJMP_IF_FALSE) {
+      ir->chunk->code[instr->start] = OP_POP;
+      instr->length = 1;
+      instr->target = -1;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+// Return an array of which instructions jumps go to; free it with
+// FREE_ARRAY(gc, bool, targets, ir->count).
+static bool* jumpTargets(Ir* ir) {
+  bool* targets = ALLOCATE(ir->gc, bool, ir->count);
+  memset(targets, 0, sizeof(bool) * (size_t)ir->count);
+  for (int i = 0; i < ir->count; ++i) {
+    int target = ir->instrs[i].target;
+    if (target >= 0 && target < ir->count) {
+      targets[target] = true;
+    }
+  }
+  return targets;
+}
+
+// True if op only pushes a value, without side effects or errors.
+static bool pushesOnly(uint8_t op) {
+  switch (op) {
+    case OP_CONSTANT:
+    case OP_NIL:
+    case OP_TRUE:
+    case OP_FALSE:
+    case OP_GET_LOCAL:
+    case OP_GET_UPVALUE: return true;
+    default: return false;
+  }
+}
+
+// Return the op that does the work of op followed by next with op's
+// operands, or op itself if there's none.
+static uint8_t fusedOp(uint8_t op, uint8_t next) {
+  if (next == OP_NOT) {
+    switch (op) {
+      case OP_EQUAL: return OP_NOT_EQUAL;
+      case OP_GREATER: return OP_NOT_GREATER;
+      case OP_LESS: return OP_NOT_LESS;
+      case OP_LESS_C: return OP_NOT_LESS_C;
+    }
+  } else if (next == OP_POP) {
+    switch (op) {
+      case OP_SET_LOCAL: return OP_SET_LOCAL_POP;
+      case OP_SET_GLOBAL_I: return OP_SET_GLOBAL_I_POP;
+    }
+  }
+  return op;
+}
+
+// Rewrite pairs of instructions no jump lands between: fuse them into
+// one instruction, or remove both if the second pops what the first
+// pushes.
+static bool peephole(Ir* ir) {
+  bool* targets = jumpTargets(ir);
+  bool changed = false;
+  for (int i = 0; i + 1 < ir->count; ++i) {
+    if (targets[i + 1]) {
+      continue;
+    }
+    Instr* instr = &ir->instrs[i];
+    Instr* next = &ir->instrs[i + 1];
+    uint8_t* op = &ir->chunk->code[instr->start];
+    uint8_t nextOp = opAt(ir, i + 1);
+
+    if (nextOp == OP_POP && pushesOnly(*op)) {
+      instr->length = 0;
+      next->length = 0;
+    } else if (fusedOp(*op, nextOp) != *op) {
+      *op = fusedOp(*op, nextOp);
+      next->length = 0;
+    } else {
+      continue;
+    }
+    changed = true;
+    i++;
+  }
+  FREE_ARRAY(ir->gc, bool, targets, ir->count);
+  return changed;
+}
+
+// If op stores a variable, set *load to the op that loads it and *keep
+// to the form of op that leaves the value on the stack.
+static bool storeOp(uint8_t op, uint8_t* load, uint8_t* keep) {
+  switch (op) {
+    case OP_SET_LOCAL:
+    case OP_SET_LOCAL_POP:
+      *load = OP_GET_LOCAL;
+      *keep = OP_SET_LOCAL;
+      return true;
+    case OP_SET_GLOBAL_I:
+    case OP_SET_GLOBAL_I_POP:
+      *load = OP_GET_GLOBAL_I;
+      *keep = OP_SET_GLOBAL_I;
+      return true;
+    case OP_SET_UPVALUE:
+      *load = OP_GET_UPVALUE;
+      *keep = OP_SET_UPVALUE;
+      return true;
+    default: return false;
+  }
+}
+
+// True if the instructions at indices a and b have the same operands.
+static bool sameOperands(Ir* ir, int a, int b) {
+  Instr* x = &ir->instrs[a];
+  Instr* y = &ir->instrs[b];
+  const uint8_t* code = ir->chunk->code;
+  return x->length == y->length &&
+      !memcmp(&code[x->start + 1], &code[y->start + 1],
+          (size_t)x->length - 1);
+}
+
+// Replace a store of a variable that pops its value, followed by a load
+// of the same variable, with a store that leaves the value in place.
+static bool forwardStores(Ir* ir) {
+  bool* targets = jumpTargets(ir);
+  bool changed = false;
+  for (int i = 0; i + 1 < ir->count; ++i) {
+    uint8_t* op = &ir->chunk->code[ir->instrs[i].start];
+    uint8_t load;
+    uint8_t keep;
+    if (!storeOp(*op, &load, &keep)) {
+      continue;
+    }
+    // The pop is either part of the store or the next instruction.
+    int get = i + 1;
+    if (*op == keep) {
+      if (targets[get] || opAt(ir, get) != OP_POP ||
+          get + 1 >= ir->count) {
+        continue;
+      }
+      get++;
+    }
+    if (targets[get] || opAt(ir, get) != load ||
+        !sameOperands(ir, i, get)) {
+      continue;
+    }
+
+    *op = keep;
+    for (int k = i + 1; k <= get; ++k) {
+      ir->instrs[k].length = 0;
+    }
+    changed = true;
+    i = get;
+  }
+  FREE_ARRAY(ir->gc, bool, targets, ir->count);
+  return changed;
+}
+
+// True if the instruction at index loads the value that the one before
+// it left on the stack: the same constant or variable, or the variable
+// it just stored.
+static bool reloads(Ir* ir, int index) {
+  uint8_t op = opAt(ir, index);
+  uint8_t prev = opAt(ir, index - 1);
+  if (!sameOperands(ir, index - 1, index)) {
+    return false;
+  }
+  if (op == prev) {
+    return op == OP_CONSTANT || op == OP_GET_LOCAL ||
+        op == OP_GET_UPVALUE;
+  }
+  uint8_t load;
+  uint8_t keep;
+  return storeOp(prev, &load, &keep) && prev == keep && op == load;
+}
+
+// Replace loads of the value already on top of the stack with OP_DUP,
+// which needs no operands.
+static bool dupLoads(Ir* ir) {
+  bool* targets = jumpTargets(ir);
+  bool changed = false;
+  // Go backwards, so each load is compared with one not yet replaced.
+  for (int i = ir->count - 1; i > 0; --i) {
+    if (!targets[i] && reloads(ir, i)) {
+      ir->chunk->code[ir->instrs[i].start] = OP_DUP;
+      ir->instrs[i].length = 1;
+      changed = true;
+    }
+  }
+  FREE_ARRAY(ir->gc, bool, targets, ir->count);
+  return changed;
+}
+
+typedef struct {
+  const char* name;
+  int level;
+  bool (*run)(Ir* ir);
+} Pass;
+
+static const Pass passes[] = {
+  { "unreachable", 1, removeUnreachable },
+  { "jumps", 1, threadJumps },
+  { "peephole", 1, peephole },
+  { "forward", 2, forwardStores },
+  { "dup", 2, dupLoads },
+};
+
+// GCOV_EXCL_START
+static void printIr(FILE* ferr, Ir* ir, const char* name,
+    const char* pass) {
+  fprintf(ferr, "== %s: %s ==\n", name, pass);
+  for (int i = 0; i < ir->count; ++i) {
+    Instr* instr = &ir->instrs[i];
+    fprintf(ferr, "%4d ", i);
+    if (i > 0 && instr->line == ir->instrs[i - 1].line) {
+      fprintf(ferr, "   | ");
+    } else {
+      fprintf(ferr, "%4d ", instr->line);
+    }
+    if (instr->target >= 0) {
+      fprintf(ferr, "%-16s      -> %d\n", jumpName(opAt(ir, i)),
+          instr->target);
+    } else {
+      disassembleOperation(ferr, ir->chunk, instr->start);
+    }
+  }
+}
+// GCOV_EXCL_STOP
+
+void optimizeChunk(FILE* ferr, GC* gc, Chunk* chunk, const char* name) {
+  if (optimizeLevel <= 0 || chunk->count == 0) {
+    return;
+  }
+
+  Ir ir;
+  initIr(&ir, gc, chunk);
+  // GCOV_EXCL_START
+  if (debugPrintIr) {
+    printIr(ferr, &ir, name, "input");
+  }
+  // GCOV_EXCL_STOP
+
+  // Passes can open up work for each other, so repeat them until none
+  // of them changes anything.
+  bool changed;
+  do {
+    changed = false;
+    for (size_t i = 0; i < ARRAY_SIZE(passes); ++i) {
+      if (passes[i].level > optimizeLevel || !passes[i].run(&ir)) {
+        continue;
+      }
+      compactIr(&ir);
+      changed = true;
+      // GCOV_EXCL_START
+      if (debugPrintIr) {
+        printIr(ferr, &ir, name, passes[i].name);
+      }
+      // GCOV_EXCL_STOP
+    }
+  } while (changed);
+
+  encodeIr(&ir);
+  freeIr(&ir);
+}
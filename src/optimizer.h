@@ -0,0 +1,20 @@
+#pragma once
+#ifndef clox_optimizer_h
+#define clox_optimizer_h
+
+#include <stdio.h>
+
+#include "chunk.h"
+
+// Rewrite the code of a chunk the compiler has finished emitting.
+// The chunk's constants are left alone.
+void optimizeChunk(FILE* ferr, GC* gc, Chunk* chunk, const char* name);
+
+// The highest level any pass runs at.
+#define MAX_OPTIMIZE_LEVEL 2
+
+// 0 leaves the emitted code as is; passes run at or below this level.
+extern int optimizeLevel;
+extern bool debugPrintIr;
+
+#endif
@@ -0,0 +1,240 @@
+#include "optimizer.h"
+
+#include <stdio.h>
+
+#include "utest.h"
+
+#include "chunk.h"
+#include "gc.h"
+#include "memory.h"
+
+#define ufx utest_fixture
+
+struct Optimize {
+  GC gc;
+  Chunk chunk;
+};
+
+UTEST_F_SETUP(Optimize) {
+  initGC(&ufx->gc);
+  initChunk(&ufx->chunk);
+  optimizeLevel = 1;
+  ASSERT_TRUE(1);
+}
+
+UTEST_F_TEARDOWN(Optimize) {
+  freeChunk(&ufx->gc, &ufx->chunk);
+  freeGC(&ufx->gc);
+  optimizeLevel = 1;
+  ASSERT_TRUE(1);
+}
+
+static void writeOps(
+    GC* gc, Chunk* chunk, const uint8_t* code, int count, int line) {
+  for (int i = 0; i < count; ++i) {
+    writeChunk(gc, chunk, code[i], line);
+  }
+}
+
+#define WRITE(line, ...) \
+  do { \
+    const uint8_t code[] = { __VA_ARGS__ }; \
+    writeOps(&ufx->gc, &ufx->chunk, code, ARRAY_SIZE(code), line); \
+  } while (0)
+
+#define EXPECT_CODE(...) \
+  do { \
+    const uint8_t code[] = { __VA_ARGS__ }; \
+    ASSERT_EQ((int)ARRAY_SIZE(code), ufx->chunk.count); \
+    for (int i = 0; i < ufx->chunk.count; ++i) { \
+      EXPECT_EQ(code[i], ufx->chunk.code[i]); \
+    } \
+  } while (0)
+
+UTEST_F(Optimize, Unreachable) {
+  WRITE(1, OP_NIL, OP_RETURN);
+  WRITE(2, OP_NIL, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_RETURN);
+}
+
+UTEST_F(Optimize, UnreachableLoop) {
+  WRITE(1, OP_NIL, OP_PRINT, OP_LOOP, 0, 5);
+  WRITE(2, OP_NIL, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_PRINT, OP_LOOP, 0, 5);
+}
+
+UTEST_F(Optimize, JumpToNext) {
+  WRITE(1, OP_TRUE, OP_JUMP_IF_FALSE, 0, 0, OP_JUMP, 0, 0);
+  WRITE(2, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_TRUE, OP_RETURN);
+}
+
+UTEST_F(Optimize, PopJumpToNext) {
+  WRITE(1, OP_TRUE, OP_NOT, OP_PJMP_IF_FALSE, 0, 0, OP_NIL, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_TRUE, OP_NOT, OP_POP, OP_NIL, OP_RETURN);
+}
+
+UTEST_F(Optimize, ThreadJumps) {
+  // A conditional jump to a jump goes straight to the jump's target.
+  WRITE(1, OP_TRUE, OP_PJMP_IF_FALSE, 0, 4);
+  WRITE(2, OP_NIL, OP_PRINT, OP_NIL, OP_RETURN);
+  WRITE(3, OP_JUMP, 0, 2);
+  WRITE(4, OP_NIL, OP_RETURN, OP_FALSE, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_TRUE, OP_PJMP_IF_FALSE, 0, 4, OP_NIL, OP_PRINT,
+      OP_NIL, OP_RETURN, OP_FALSE, OP_RETURN);
+}
+
+UTEST_F(Optimize, ThreadCompareJumps) {
+  // Jumps that compare locals in place are threaded like the others.
+  WRITE(1, OP_NIL, OP_JUMP_IF_NOT_LESS_LC, 0, 0, 0, 0, 9);
+  WRITE(2, OP_JUMP_IF_EQUAL_LL, 0, 0, 0, 4);
+  WRITE(3, OP_NIL, OP_PRINT, OP_NIL, OP_RETURN);
+  WRITE(4, OP_JUMP, 0, 2, OP_NIL, OP_RETURN, OP_FALSE, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_JUMP_IF_NOT_LESS_LC, 0, 0, 0, 0, 9,
+      OP_JUMP_IF_EQUAL_LL, 0, 0, 0, 4, OP_NIL, OP_PRINT, OP_NIL,
+      OP_RETURN, OP_FALSE, OP_RETURN);
+}
+
+UTEST_F(Optimize, ThreadConditionalJumps) {
+  // Like "a and b and c": the value that made the first jump go is
+  // still on the stack and makes the second go too.
+  WRITE(1, OP_FALSE, OP_JUMP_IF_FALSE, 0, 2, OP_POP, OP_FALSE);
+  WRITE(2, OP_JUMP_IF_FALSE, 0, 2, OP_POP, OP_TRUE);
+  WRITE(3, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_FALSE, OP_JUMP_IF_FALSE, 0, 7, OP_POP, OP_FALSE,
+      OP_JUMP_IF_FALSE, 0, 2, OP_POP, OP_TRUE, OP_RETURN);
+}
+
+UTEST_F(Optimize, ThreadIntoLoop) {
+  // A forward jump to a loop becomes a loop itself.
+  WRITE(1, OP_NIL, OP_PRINT, OP_TRUE, OP_PJMP_IF_FALSE, 0, 3);
+  WRITE(2, OP_JUMP, 0, 2, OP_NIL, OP_RETURN);
+  WRITE(3, OP_LOOP, 0, 14);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_PRINT, OP_TRUE, OP_PJMP_IF_FALSE, 0, 3,
+      OP_LOOP, 0, 9, OP_NIL, OP_RETURN);
+}
+
+UTEST_F(Optimize, GetHoistedJumps) {
+  // The jump over the read that fills the cache moves with the code.
+  WRITE(1, OP_NIL, OP_GET_HOISTED, 1, 0, 8, OP_NIL, OP_POP);
+  WRITE(2, OP_GET_LOCAL, 0, OP_HOIST_PROPERTY, 0, 0, 1, OP_PRINT);
+  WRITE(3, OP_NIL, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_GET_HOISTED, 1, 0, 6, OP_GET_LOCAL, 0,
+      OP_HOIST_PROPERTY, 0, 0, 1, OP_PRINT, OP_NIL, OP_RETURN);
+}
+
+UTEST_F(Optimize, Lines) {
+  WRITE(1, OP_JUMP, 0, 2);
+  WRITE(2, OP_NIL, OP_RETURN);
+  WRITE(3, OP_NIL, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_RETURN);
+  EXPECT_EQ(3, getLine(&ufx->chunk, 0));
+  EXPECT_EQ(3, getLine(&ufx->chunk, 1));
+}
+
+UTEST_F(Optimize, FuseNot) {
+  WRITE(1, OP_NIL, OP_NIL, OP_EQUAL, OP_NOT, OP_PRINT);
+  WRITE(2, OP_NIL, OP_NIL, OP_GREATER, OP_NOT, OP_PRINT);
+  WRITE(3, OP_NIL, OP_NIL, OP_LESS, OP_NOT, OP_PRINT);
+  WRITE(4, OP_NIL, OP_LESS_C, 0, 0, OP_NOT, OP_PRINT);
+  WRITE(5, OP_NIL, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_NIL, OP_NOT_EQUAL, OP_PRINT, OP_NIL, OP_NIL,
+      OP_NOT_GREATER, OP_PRINT, OP_NIL, OP_NIL, OP_NOT_LESS, OP_PRINT,
+      OP_NIL, OP_NOT_LESS_C, 0, 0, OP_PRINT, OP_NIL, OP_RETURN);
+}
+
+UTEST_F(Optimize, FusePop) {
+  WRITE(1, OP_NIL, OP_NIL, OP_SET_LOCAL, 1, OP_POP);
+  WRITE(2, OP_NIL, OP_SET_GLOBAL_I, 0, 0, OP_POP, OP_NIL, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_NIL, OP_SET_LOCAL_POP, 1, OP_NIL,
+      OP_SET_GLOBAL_I_POP, 0, 0, OP_NIL, OP_RETURN);
+  // The fused op takes the line of the first op.
+  EXPECT_EQ(1, getLine(&ufx->chunk, 3));
+}
+
+UTEST_F(Optimize, PushPop) {
+  WRITE(1, OP_NIL, OP_CONSTANT, 0, 0, OP_POP, OP_GET_LOCAL, 1, OP_POP);
+  WRITE(2, OP_GET_UPVALUE, 0, OP_POP);
+  // Getting an undefined global fails, so it stays.
+  WRITE(3, OP_GET_GLOBAL_I, 0, 0, OP_POP, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_GET_GLOBAL_I, 0, 0, OP_POP, OP_RETURN);
+}
+
+UTEST_F(Optimize, NoPeepholeAtJumpTarget) {
+  // Code that jumps to the OP_NOT expects it to negate another value.
+  WRITE(1, OP_NIL, OP_FALSE, OP_JUMP_IF_FALSE, 0, 1, OP_LESS);
+  WRITE(2, OP_NOT, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_FALSE, OP_JUMP_IF_FALSE, 0, 1, OP_LESS,
+      OP_NOT, OP_RETURN);
+}
+
+UTEST_F(Optimize, ForwardStores) {
+  optimizeLevel = 2;
+  WRITE(1, OP_NIL, OP_SET_LOCAL, 1, OP_POP, OP_GET_LOCAL, 1, OP_PRINT);
+  WRITE(2, OP_NIL, OP_SET_GLOBAL_I, 0, 0, OP_POP);
+  WRITE(2, OP_GET_GLOBAL_I, 0, 0, OP_PRINT);
+  // A different variable is loaded, so the store keeps its pop.
+  WRITE(3, OP_NIL, OP_SET_LOCAL, 1, OP_POP, OP_GET_LOCAL, 2, OP_PRINT);
+  WRITE(4, OP_NIL, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_SET_LOCAL, 1, OP_PRINT,
+      OP_NIL, OP_SET_GLOBAL_I, 0, 0, OP_PRINT,
+      OP_NIL, OP_SET_LOCAL_POP, 1, OP_GET_LOCAL, 2, OP_PRINT,
+      OP_NIL, OP_RETURN);
+}
+
+UTEST_F(Optimize, DupLoads) {
+  optimizeLevel = 2;
+  WRITE(1, OP_GET_LOCAL, 1, OP_GET_LOCAL, 1, OP_MULTIPLY);
+  WRITE(2, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 0, OP_ADD);
+  WRITE(3, OP_SET_UPVALUE, 0, OP_GET_UPVALUE, 0, OP_ADD);
+  // Getting a global can fail, so both loads stay.
+  WRITE(4, OP_GET_GLOBAL_I, 0, 0, OP_GET_GLOBAL_I, 0, 0, OP_ADD);
+  WRITE(5, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_GET_LOCAL, 1, OP_DUP, OP_MULTIPLY,
+      OP_CONSTANT, 0, 0, OP_DUP, OP_ADD,
+      OP_SET_UPVALUE, 0, OP_DUP, OP_ADD,
+      OP_GET_GLOBAL_I, 0, 0, OP_GET_GLOBAL_I, 0, 0, OP_ADD,
+      OP_RETURN);
+}
+
+UTEST_F(Optimize, NoDupAtJumpTarget) {
+  optimizeLevel = 2;
+  // The loop reaches the second load without running the first.
+  WRITE(1, OP_GET_LOCAL, 1, OP_GET_LOCAL, 1, OP_PRINT, OP_LOOP, 0, 6);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_GET_LOCAL, 1, OP_GET_LOCAL, 1, OP_PRINT,
+      OP_LOOP, 0, 6);
+}
+
+UTEST_F(Optimize, LevelOneKeepsLoads) {
+  WRITE(1, OP_NIL, OP_SET_LOCAL, 1, OP_POP, OP_GET_LOCAL, 1);
+  WRITE(1, OP_GET_LOCAL, 1, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_SET_LOCAL_POP, 1, OP_GET_LOCAL, 1,
+      OP_GET_LOCAL, 1, OP_RETURN);
+}
+
+UTEST_F(Optimize, LevelZero) {
+  optimizeLevel = 0;
+  WRITE(1, OP_NIL, OP_RETURN, OP_NIL, OP_RETURN);
+  optimizeChunk(stderr, &ufx->gc, &ufx->chunk, "test");
+  EXPECT_CODE(OP_NIL, OP_RETURN, OP_NIL, OP_RETURN);
+}
+
+UTEST_MAIN();
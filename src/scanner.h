@@ -30,6 +30,11 @@ typedef enum {
   TOKEN_GREATER_EQUAL,
   TOKEN_LESS,
   TOKEN_LESS_EQUAL,
+  TOKEN_MINUS_EQUAL,
+  TOKEN_PERCENT_EQUAL,
+  TOKEN_PLUS_EQUAL,
+  TOKEN_SLASH_EQUAL,
+  TOKEN_STAR_EQUAL,
   // Literals.
   TOKEN_IDENTIFIER,
   TOKEN_STRING,
@@ -124,9 +124,15 @@ StringToTokenTypes oneOrTwo[] = {
   { ">", (TokenType[]){ TOKEN_GREATER, TOKEN_EOF } },
   { ">>", (TokenType[]){ TOKEN_GREATER, TOKEN_GREATER, TOKEN_EOF } },
   { ">=", (TokenType[]){ TOKEN_GREATER_EQUAL, TOKEN_EOF } },
+  { "-=", (TokenType[]){ TOKEN_MINUS_EQUAL, TOKEN_EOF } },
+  { "%=", (TokenType[]){ TOKEN_PERCENT_EQUAL, TOKEN_EOF } },
+  { "+=", (TokenType[]){ TOKEN_PLUS_EQUAL, TOKEN_EOF } },
+  { "+==", (TokenType[]){ TOKEN_PLUS_EQUAL, TOKEN_EQUAL, TOKEN_EOF } },
+  { "/=", (TokenType[]){ TOKEN_SLASH_EQUAL, TOKEN_EOF } },
+  { "*=", (TokenType[]){ TOKEN_STAR_EQUAL, TOKEN_EOF } },
 };
 
-SCAN_TOKEN_TYPES(OneOrTwo, oneOrTwo, 11);
+SCAN_TOKEN_TYPES(OneOrTwo, oneOrTwo, 17);
 
 StringToTokenTypes whitespace[] = {
   { "   ", (TokenType[]){ TOKEN_EOF } },
@@ -0,0 +1,42 @@
+#include "vm.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "ubench.h"
+
+#define MAKE_LIST \
+  "var a=[];for(var i in range(10000))a.push((i*7919)%10007);"
+
+static void runSort(
+    struct ubench_run_state_s* ubench_run_state, const char* src) {
+  VM vm;
+  InterpretResult ires = INTERPRET_OK;
+  initVM(&vm, stdout, stderr);
+  UBENCH_DO_BENCHMARK() {
+    ires = interpret(&vm, src);
+  }
+  assert(ires == INTERPRET_OK);
+  (void)ires;
+  freeVM(&vm);
+}
+
+UBENCH_EX(Sort, LoxQuicksort) {
+  runSort(ubench_run_state,
+      MAKE_LIST "fun qs(a,lo,hi){if(lo>=hi)return;"
+      "var p=a[floor((lo+hi)/2)];"
+      "var i=lo;var j=hi;while(i<=j){while(a[i]<p)i=i+1;"
+      "while(a[j]>p)j=j-1;if(i<=j){var t=a[i];a[i]=a[j];a[j]=t;"
+      "i=i+1;j=j-1;}}qs(a,lo,j);qs(a,i,hi);}"
+      "qs(a,0,a.size()-1);");
+}
+
+UBENCH_EX(Sort, Native) {
+  runSort(ubench_run_state, MAKE_LIST "a.sort();");
+}
+
+UBENCH_EX(Sort, NativeComparator) {
+  runSort(ubench_run_state, MAKE_LIST "a.sort(fun(x,y){return x-y;});");
+}
+
+UBENCH_MAIN();
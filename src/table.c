@@ -4,49 +4,123 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "memory.h"
 #include "object.h"
 #include "value.h"
 
+#define CTRL_EMPTY ((uint8_t)0x80)
+
+// Tags use the top hash bits; the bottom ones pick the home entry.
+#define HASH_TAG(hash) ((uint8_t)((hash) >> 25))
+
+#ifdef __SSE2__
+
+static inline uint32_t groupMatch(const uint8_t* group, uint8_t byte) {
+  __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+  __m128i match = _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte));
+  return (uint32_t)_mm_movemask_epi8(match);
+}
+
+// Tags never have their high bit set, unlike CTRL_EMPTY.
+static inline uint32_t groupMatchEmpty(const uint8_t* group) {
+  __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+  return (uint32_t)_mm_movemask_epi8(ctrl);
+}
+
+#else
+
+static inline uint32_t groupMatch(const uint8_t* group, uint8_t byte) {
+  uint32_t bits = 0;
+  for (int i = 0; i < TABLE_GROUP_WIDTH; ++i) {
+    bits |= (uint32_t)(group[i] == byte) << i;
+  }
+  return bits;
+}
+
+static inline uint32_t groupMatchEmpty(const uint8_t* group) {
+  uint32_t bits = 0;
+  for (int i = 0; i < TABLE_GROUP_WIDTH; ++i) {
+    bits |= (uint32_t)(group[i] >> 7) << i;
+  }
+  return bits;
+}
+
+#endif
+
+static inline int lowestBit(uint32_t bits) {
+  return __builtin_ctz(bits);
+}
+
 void initTable(Table* table, double maxLoad) {
   table->count = 0;
   table->capacity = 0;
   table->entries = NULL;
+  table->ctrl = NULL;
   assert(maxLoad > 0.0 && maxLoad <= 1.0); // GCOV_EXCL_LINE
   table->maxLoad = maxLoad;
 }
 
 void freeTable(GC* gc, Table* table) {
   FREE_ARRAY(gc, Entry, table->entries, table->capacity);
+  if (table->ctrl != NULL) {
+    FREE_ARRAY(gc, uint8_t, table->ctrl,
+        table->capacity + TABLE_GROUP_WIDTH);
+  }
   initTable(table, table->maxLoad);
 }
 
-static Entry* findEntry(Entry* entries, int capacity, ObjString* key) {
-  uint32_t index = key->hash & (capacity - 1);
-  Entry* tombstone = NULL;
+// Set the control byte of an entry, along with its copies at the end.
+static void setCtrl(uint8_t* ctrl, int capacity, int index, uint8_t c) {
+  for (int i = index; i < capacity + TABLE_GROUP_WIDTH; i += capacity) {
+    ctrl[i] = c;
+  }
+}
+
+// Probe a group of control bytes at a time from the home entry of the
+// key, checking entries whose tags match.  Returns the index of the key
+// if it's present, otherwise the first empty entry after its home, or
+// -1 if there are none at all.
+//
+// Deletion shifts entries back (see tableDelete()), so there is never a
+// gap between an entry and its home, and an empty entry ends the probe.
+static int findIndex(
+    Entry* entries, uint8_t* ctrl, int capacity, ObjString* key) {
+  uint32_t mask = (uint32_t)capacity - 1;
+  uint32_t pos = key->hash & mask;
+  uint8_t tag = HASH_TAG(key->hash);
 
-  for (int i = 0; i < capacity; i++) {
-    Entry* entry = &entries[index];
-    if (entry->key == NULL) {
-      if (IS_NIL(entry->value)) {
-        // Empty entry.
-        return tombstone != NULL ? tombstone : entry;
-      } else {
-        // We found a tombstone.
-        if (tombstone == NULL) {
-          tombstone = entry;
-        }
+  for (int probed = 0; probed < capacity;
+       probed += TABLE_GROUP_WIDTH) {
+    const uint8_t* group = ctrl + pos;
+    uint32_t matches = groupMatch(group, tag);
+    while (matches) {
+      uint32_t index = (pos + lowestBit(matches)) & mask;
+      if (entries[index].key == key) {
+        return (int)index;
       }
-    } else if (entry->key == key) {
-      // We found the key.
-      return entry;
+      matches &= matches - 1;
     }
 
-    index = (index + 1) & (capacity - 1);
+    uint32_t empty = groupMatchEmpty(group);
+    if (empty) {
+      return (int)((pos + lowestBit(empty)) & mask);
+    }
+
+    pos = (pos + TABLE_GROUP_WIDTH) & mask;
   }
 
+  return -1;
+}
+
+static Entry* findEntry(Table* table, ObjString* key) {
+  int index =
+      findIndex(table->entries, table->ctrl, table->capacity, key);
   // NOTE: This may be null if the table is filled to capacity.
-  return tombstone;
+  return index >= 0 ? &table->entries[index] : NULL;
 }
 
 bool tableGet(Table* table, ObjString* key, Value* value) {
@@ -54,7 +128,7 @@ bool tableGet(Table* table, ObjString* key, Value* value) {
     return false;
   }
 
-  Entry* entry = findEntry(table->entries, table->capacity, key);
+  Entry* entry = findEntry(table, key);
   if (entry == NULL || entry->key == NULL) {
     return false;
   }
@@ -63,30 +137,49 @@ bool tableGet(Table* table, ObjString* key, Value* value) {
   return true;
 }
 
+// Return a pointer to the value of key, or NULL if it has none. It
+// stays valid until the table is next changed.
+Value* tableFind(Table* table, ObjString* key) {
+  if (table->count == 0) {
+    return NULL;
+  }
+
+  Entry* entry = findEntry(table, key);
+  if (entry == NULL || entry->key == NULL) {
+    return NULL;
+  }
+  return &entry->value;
+}
+
 static void adjustCapacity(GC* gc, Table* table, int capacity) {
   Entry* entries = ALLOCATE(gc, Entry, capacity);
   for (int i = 0; i < capacity; i++) {
     entries[i].key = NULL;
     entries[i].value = NIL_VAL;
   }
+  uint8_t* ctrl = ALLOCATE(gc, uint8_t, capacity + TABLE_GROUP_WIDTH);
+  memset(ctrl, CTRL_EMPTY, capacity + TABLE_GROUP_WIDTH);
 
-  table->count = 0;
+  int count = 0;
   for (int i = 0; i < table->capacity; i++) {
     Entry* entry = &table->entries[i];
     if (entry->key == NULL) {
       continue;
     }
 
-    Entry* dest = findEntry(entries, capacity, entry->key);
-    assert(dest != NULL); // GCOV_EXCL_LINE
-    dest->key = entry->key;
-    dest->value = entry->value;
-    table->count++;
+    int dest = findIndex(entries, ctrl, capacity, entry->key);
+    assert(dest >= 0); // GCOV_EXCL_LINE
+    entries[dest].key = entry->key;
+    entries[dest].value = entry->value;
+    setCtrl(ctrl, capacity, dest, HASH_TAG(entry->key->hash));
+    count++;
   }
 
-  FREE_ARRAY(gc, Entry, table->entries, table->capacity);
+  freeTable(gc, table);
   table->entries = entries;
+  table->ctrl = ctrl;
   table->capacity = capacity;
+  table->count = count;
 }
 
 bool tableSetEntry(
@@ -95,7 +188,9 @@ bool tableSetEntry(
   assert(entry < table->entries + table->capacity); // GCOV_EXCL_LINE
 
   bool isNewKey = entry->key == NULL;
-  if (isNewKey && IS_NIL(entry->value)) {
+  if (isNewKey) {
+    int index = (int)(entry - table->entries);
+    setCtrl(table->ctrl, table->capacity, index, HASH_TAG(key->hash));
     table->count++;
   }
 
@@ -109,24 +204,51 @@ bool tableSet(GC* gc, Table* table, ObjString* key, Value value) {
     int capacity = GROW_CAPACITY(table->capacity);
     adjustCapacity(gc, table, capacity);
   }
-  Entry* entry = findEntry(table->entries, table->capacity, key);
+  Entry* entry = findEntry(table, key);
   return tableSetEntry(table, entry, key, value);
 }
 
+// Empty the entry at index, then move back later entries of the same
+// cluster that can no longer be reached from their home entries, so
+// probe sequences never have gaps (Knuth's Algorithm R).
+static void deleteIndex(Table* table, int index) {
+  uint32_t mask = (uint32_t)table->capacity - 1;
+  uint32_t hole = (uint32_t)index;
+  uint32_t next = (hole + 1) & mask;
+  setCtrl(table->ctrl, table->capacity, (int)hole, CTRL_EMPTY);
+
+  while (table->ctrl[next] != CTRL_EMPTY) {
+    uint32_t home = table->entries[next].key->hash & mask;
+    // Leave the entry be if its home lies cyclically in (hole, next].
+    bool reachable = hole <= next ? (hole < home && home <= next)
+                                  : (hole < home || home <= next);
+    if (!reachable) {
+      table->entries[hole] = table->entries[next];
+      setCtrl(
+          table->ctrl, table->capacity, (int)hole, table->ctrl[next]);
+      setCtrl(table->ctrl, table->capacity, (int)next, CTRL_EMPTY);
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+
+  table->entries[hole].key = NULL;
+  table->entries[hole].value = NIL_VAL;
+  table->count--;
+}
+
 bool tableDelete(Table* table, ObjString* key) {
   if (table->count == 0) {
     return false;
   }
 
   // Find the entry.
-  Entry* entry = findEntry(table->entries, table->capacity, key);
-  if (entry->key == NULL) {
+  Entry* entry = findEntry(table, key);
+  if (entry == NULL || entry->key == NULL) {
     return false;
   }
 
-  // Place a tombstone in the entry.
-  entry->key = NULL;
-  entry->value = BOOL_VAL(true);
+  deleteIndex(table, (int)(entry - table->entries));
   return true;
 }
 
@@ -147,21 +269,17 @@ Entry* tableJoinedStringsEntry(GC* gc, Table* table, const char* a,
   }
 
   int length = aLen + bLen;
-  uint32_t index = hash & (table->capacity - 1);
-  Entry* tombstone = NULL;
+  uint32_t mask = (uint32_t)table->capacity - 1;
+  uint32_t pos = hash & mask;
+  uint8_t tag = HASH_TAG(hash);
 
-  for (int i = 0; i < table->capacity; i++) {
-    Entry* entry = &table->entries[index];
-    if (entry->key == NULL) {
-      if (IS_NIL(entry->value)) {
-        // Return an unused entry.
-        return tombstone != NULL ? tombstone : entry;
-      } else {
-        if (tombstone == NULL) {
-          tombstone = entry;
-        }
-      }
-    } else {
+  for (int probed = 0; probed < table->capacity;
+       probed += TABLE_GROUP_WIDTH) {
+    const uint8_t* group = table->ctrl + pos;
+    uint32_t matches = groupMatch(group, tag);
+    while (matches) {
+      Entry* entry =
+          &table->entries[(pos + lowestBit(matches)) & mask];
       ObjString* key = entry->key;
       if (key->hash == hash && key->length == length) {
         const char* keyChars = key->chars;
@@ -171,20 +289,31 @@ Entry* tableJoinedStringsEntry(GC* gc, Table* table, const char* a,
           return entry;
         }
       }
+      matches &= matches - 1;
+    }
+
+    uint32_t empty = groupMatchEmpty(group);
+    if (empty) {
+      // Return an unused entry.
+      return &table->entries[(pos + lowestBit(empty)) & mask];
     }
 
-    index = (index + 1) & (table->capacity - 1);
+    pos = (pos + TABLE_GROUP_WIDTH) & mask;
   }
 
-  assert(tombstone != NULL); // GCOV_EXCL_LINE
-  return tombstone;
+  assert(false); // GCOV_EXCL_LINE: Table grows before it's full.
+  return NULL; // GCOV_EXCL_LINE
 }
 
 void tableRemoveWhite(Table* table) {
-  for (int i = 0; i < table->capacity; i++) {
+  int i = 0;
+  while (i < table->capacity) {
     Entry* entry = &table->entries[i];
     if (entry->key != NULL && !entry->key->obj.isMarked) {
-      tableDelete(table, entry->key);
+      // Check this index again, since a later entry may shift into it.
+      deleteIndex(table, i);
+    } else {
+      i++;
     }
   }
 }
@@ -12,16 +12,24 @@ typedef struct {
   Value value;
 } Entry;
 
+// Each entry has a control byte in ctrl: empty or a 7-bit tag from its
+// key's hash.  ctrl has TABLE_GROUP_WIDTH extra bytes at the end that
+// repeat the start, so a group starting at any entry can be loaded
+// without wrapping around.
+#define TABLE_GROUP_WIDTH 16
+
 typedef struct {
   int count;
   int capacity;
   Entry* entries;
+  uint8_t* ctrl;
   double maxLoad;
 } Table;
 
 void initTable(Table* table, double maxLoad);
 void freeTable(GC* gc, Table* table);
 bool tableGet(Table* table, ObjString* key, Value* value);
+Value* tableFind(Table* table, ObjString* key);
 bool tableSetEntry(
     Table* table, Entry* entry, ObjString* key, Value value);
 bool tableSet(GC* gc, Table* table, ObjString* key, Value value);
@@ -69,4 +69,113 @@ UBENCH_EX_F(Table, SetGetDelete) {
 #undef COUNT
 }
 
+// Make count three-letter strings starting from the given index.
+static void makeKeys(
+    GC* gc, Table* strings, ObjString** oStrs, int start, int count) {
+  char baseStr[] = "aaa";
+  for (int i = 0; i < count; ++i) {
+    int n = start + i;
+    baseStr[0] = 'a' + n / (26 * 26);
+    baseStr[1] = 'a' + (n % (26 * 26)) / 26;
+    baseStr[2] = 'a' + n % 26;
+    oStrs[i] = copyString(gc, strings, baseStr, 3);
+    pushTemp(gc, OBJ_VAL(oStrs[i]));
+  }
+}
+
+static void popKeys(GC* gc, int count) {
+  for (int i = 0; i < count; ++i) {
+    popTemp(gc);
+  }
+}
+
+// A table of 4096 entries holds up to 3072 keys at the 0.75 load limit.
+#define HALF_LOAD 2049
+#define HIGH_LOAD 3072
+#define MISSES 3072
+
+static_assert(HIGH_LOAD + MISSES <= 26 * 26 * 26, "Table keys");
+
+static ObjString* hitKeys[HIGH_LOAD];
+static ObjString* missKeys[MISSES];
+
+// Fill the table with count keys, and make keys that aren't in it.
+static void fillTable(struct Table* fx, int count) {
+  makeKeys(&fx->gc, &fx->strings, hitKeys, 0, count);
+  makeKeys(&fx->gc, &fx->strings, missKeys, HIGH_LOAD, MISSES);
+  for (int i = 0; i < count; ++i) {
+    tableSet(&fx->gc, &fx->t, hitKeys[i], NUMBER_VAL(i));
+  }
+}
+
+static void getAll(Table* t, ObjString** keys, int count) {
+  for (int i = 0; i < count; ++i) {
+    Value v;
+    tableGet(t, keys[i], &v);
+    UBENCH_DO_NOTHING(&v);
+  }
+}
+
+UBENCH_EX_F(Table, GetHit) {
+  fillTable(ufx, HALF_LOAD);
+  UBENCH_DO_BENCHMARK() {
+    getAll(&ufx->t, hitKeys, HALF_LOAD);
+  }
+  popKeys(&ufx->gc, HALF_LOAD + MISSES);
+}
+
+UBENCH_EX_F(Table, GetMiss) {
+  fillTable(ufx, HALF_LOAD);
+  UBENCH_DO_BENCHMARK() {
+    getAll(&ufx->t, missKeys, MISSES);
+  }
+  popKeys(&ufx->gc, HALF_LOAD + MISSES);
+}
+
+UBENCH_EX_F(Table, HighLoadGetHit) {
+  fillTable(ufx, HIGH_LOAD);
+  UBENCH_DO_BENCHMARK() {
+    getAll(&ufx->t, hitKeys, HIGH_LOAD);
+  }
+  popKeys(&ufx->gc, HIGH_LOAD + MISSES);
+}
+
+UBENCH_EX_F(Table, HighLoadGetMiss) {
+  fillTable(ufx, HIGH_LOAD);
+  UBENCH_DO_BENCHMARK() {
+    getAll(&ufx->t, missKeys, MISSES);
+  }
+  popKeys(&ufx->gc, HIGH_LOAD + MISSES);
+}
+
+UBENCH_EX_F(Table, Churn) {
+  // Slide a window of live keys through a pool of them, so every key is
+  // eventually deleted and set again, checking for a missing key too.
+#define POOL (HIGH_LOAD + MISSES)
+#define STEPS 1024
+  static ObjString* pool[POOL];
+  makeKeys(&ufx->gc, &ufx->strings, pool, 0, POOL);
+  for (int i = 0; i < HALF_LOAD; ++i) {
+    tableSet(&ufx->gc, &ufx->t, pool[i], NUMBER_VAL(i));
+  }
+
+  int head = 0;
+  UBENCH_DO_BENCHMARK() {
+    for (int i = 0; i < STEPS; ++i) {
+      tableDelete(&ufx->t, pool[head]);
+      int tail = (head + HALF_LOAD) % POOL;
+      tableSet(&ufx->gc, &ufx->t, pool[tail], NUMBER_VAL(i));
+      head = (head + 1) % POOL;
+
+      Value v;
+      tableGet(&ufx->t, pool[(tail + POOL / 2) % POOL], &v);
+      UBENCH_DO_NOTHING(&v);
+    }
+  }
+
+  popKeys(&ufx->gc, POOL);
+#undef STEPS
+#undef POOL
+}
+
 UBENCH_MAIN();
@@ -1,5 +1,8 @@
 #include "table.h"
 
+#include <stdio.h>
+#include <string.h>
+
 #include "utest.h"
 
 #include "gc.h"
@@ -68,6 +71,32 @@ UTEST_F(Table, GetSetDelete) {
   popTemp(&ufx->gc);
 }
 
+UTEST_F(Table, Find) {
+  ObjString* foo = copyString(&ufx->gc, &ufx->strings, "foo", 3);
+  pushTemp(&ufx->gc, OBJ_VAL(foo));
+  ObjString* bar = copyString(&ufx->gc, &ufx->strings, "bar", 3);
+  pushTemp(&ufx->gc, OBJ_VAL(bar));
+
+  EXPECT_TRUE(tableFind(&ufx->t, foo) == NULL);
+  EXPECT_TRUE(tableSet(&ufx->gc, &ufx->t, foo, NUMBER_VAL(1.0)));
+  EXPECT_TRUE(tableFind(&ufx->t, bar) == NULL);
+
+  // Values can be changed through the pointer.
+  Value* found = tableFind(&ufx->t, foo);
+  ASSERT_TRUE(found != NULL);
+  EXPECT_VALEQ(NUMBER_VAL(1.0), *found);
+  *found = NUMBER_VAL(2.0);
+  Value v;
+  EXPECT_TRUE(tableGet(&ufx->t, foo, &v));
+  EXPECT_VALEQ(NUMBER_VAL(2.0), v);
+
+  EXPECT_TRUE(tableDelete(&ufx->t, foo));
+  EXPECT_TRUE(tableFind(&ufx->t, foo) == NULL);
+
+  popTemp(&ufx->gc);
+  popTemp(&ufx->gc);
+}
+
 UTEST_F(Table, AddAll) {
   Table t2;
   initTable(&t2, 1.0);
@@ -121,6 +150,141 @@ UTEST_F(Table, SetGetLots) {
   }
 }
 
+UTEST_F(Table, SetGetDeleteMany) {
+  // Enough keys to need several control byte groups per probe.
+  ObjString* oStrs[26 * 26];
+  char str[] = "aa";
+
+  for (size_t i = 0; i < ARRAY_SIZE(oStrs); ++i) {
+    str[0] = 'a' + i / 26;
+    str[1] = 'a' + i % 26;
+    oStrs[i] = copyString(&ufx->gc, &ufx->strings, str, 2);
+    pushTemp(&ufx->gc, OBJ_VAL(oStrs[i]));
+    EXPECT_TRUE(tableSet(&ufx->gc, &ufx->t, oStrs[i], NUMBER_VAL(i)));
+  }
+
+  // Delete every other key, then check that the rest are still there.
+  for (size_t i = 0; i < ARRAY_SIZE(oStrs); i += 2) {
+    EXPECT_TRUE(tableDelete(&ufx->t, oStrs[i]));
+    EXPECT_FALSE(tableDelete(&ufx->t, oStrs[i]));
+  }
+  for (size_t i = 0; i < ARRAY_SIZE(oStrs); ++i) {
+    Value v;
+    if (i % 2 == 0) {
+      EXPECT_FALSE(tableGet(&ufx->t, oStrs[i], &v));
+    } else {
+      EXPECT_TRUE(tableGet(&ufx->t, oStrs[i], &v));
+      EXPECT_VALEQ(NUMBER_VAL(i), v);
+    }
+  }
+
+  // Put the deleted keys back with new values.
+  for (size_t i = 0; i < ARRAY_SIZE(oStrs); i += 2) {
+    EXPECT_TRUE(tableSet(&ufx->gc, &ufx->t, oStrs[i], NUMBER_VAL(-1)));
+  }
+  for (size_t i = 0; i < ARRAY_SIZE(oStrs); ++i) {
+    Value v;
+    EXPECT_TRUE(tableGet(&ufx->t, oStrs[i], &v));
+    EXPECT_VALEQ(NUMBER_VAL(i % 2 == 0 ? -1.0 : (double)i), v);
+  }
+
+  for (size_t i = 0; i < ARRAY_SIZE(oStrs); ++i) {
+    popTemp(&ufx->gc);
+  }
+}
+
+UTEST_F(Table, Churn) {
+  ObjString* oStrs[26 * 26];
+  bool present[ARRAY_SIZE(oStrs)] = { false };
+  char str[] = "aa";
+
+  for (size_t i = 0; i < ARRAY_SIZE(oStrs); ++i) {
+    str[0] = 'a' + i / 26;
+    str[1] = 'a' + i % 26;
+    oStrs[i] = copyString(&ufx->gc, &ufx->strings, str, 2);
+    pushTemp(&ufx->gc, OBJ_VAL(oStrs[i]));
+  }
+
+  // Randomly set and delete keys, checking them all now and then.
+  uint32_t seed = 1;
+  int count = 0;
+  for (int step = 1; step <= 20000; ++step) {
+    seed = seed * 1103515245u + 12345u;
+    size_t i = (seed >> 8) % ARRAY_SIZE(oStrs);
+    if (present[i]) {
+      EXPECT_TRUE(tableDelete(&ufx->t, oStrs[i]));
+      count--;
+    } else {
+      EXPECT_TRUE(
+          tableSet(&ufx->gc, &ufx->t, oStrs[i], NUMBER_VAL(step)));
+      count++;
+    }
+    present[i] = !present[i];
+
+    if (step % 1000 == 0) {
+      EXPECT_EQ(count, ufx->t.count);
+      for (size_t j = 0; j < ARRAY_SIZE(oStrs); ++j) {
+        Value v;
+        EXPECT_EQ(present[j], tableGet(&ufx->t, oStrs[j], &v));
+      }
+    }
+  }
+
+  for (size_t i = 0; i < ARRAY_SIZE(oStrs); ++i) {
+    popTemp(&ufx->gc);
+  }
+}
+
+// FNV-1a, as used for ObjString hashes.
+static uint32_t hashChars(const char* chars) {
+  uint32_t hash = 2166136261u;
+  for (; *chars; ++chars) {
+    hash ^= (uint8_t)*chars;
+    hash *= 16777619;
+  }
+  return hash;
+}
+
+// Write the next string after *next whose hash has the given home slot.
+static void stringWithHome(
+    char* buf, int* next, uint32_t mask, int home) {
+  do {
+    sprintf(buf, "s%d", (*next)++);
+  } while ((hashChars(buf) & mask) != (uint32_t)home);
+}
+
+UTEST_F(Table, InternDuringCollect) {
+  ufx->gc.fixWeak = (void (*)(void*))tableRemoveWhite;
+  ufx->gc.fixWeakArg = &ufx->strings;
+  char buf[16];
+  int next = 0;
+
+  // Fill slots 1 to 15 of a 32-slot table with live strings.
+  for (int i = 0; i < 15; ++i) {
+    stringWithHome(buf, &next, 31, 1);
+    ObjString* oStr =
+        copyString(&ufx->gc, &ufx->strings, buf, (int)strlen(buf));
+    pushTemp(&ufx->gc, OBJ_VAL(oStr));
+  }
+  // Slot 0 holds a garbage string, which the next allocation frees.
+  stringWithHome(buf, &next, 31, 0);
+  copyString(&ufx->gc, &ufx->strings, buf, (int)strlen(buf));
+  ASSERT_EQ(32, ufx->strings.capacity);
+
+  // This string is probed past slot 0 before its allocation frees it.
+  stringWithHome(buf, &next, 31, 0);
+  ObjString* a =
+      copyString(&ufx->gc, &ufx->strings, buf, (int)strlen(buf));
+  pushTemp(&ufx->gc, OBJ_VAL(a));
+  ObjString* b =
+      copyString(&ufx->gc, &ufx->strings, buf, (int)strlen(buf));
+  EXPECT_EQ(a, b);
+
+  for (int i = 0; i < 16; ++i) {
+    popTemp(&ufx->gc);
+  }
+}
+
 UTEST_F(Table, SetGetCollisions) {
   // Avoid resizing the table.
   ufx->t.maxLoad = 1.0;
@@ -195,8 +359,8 @@ UTEST_F(Table, FullTableGetMissing) {
   EXPECT_TRUE(tableDelete(&ufx->t, a));
   EXPECT_TRUE(tableDelete(&ufx->t, b));
 
-  // Recheck that the table is full.
-  EXPECT_EQ(ufx->t.capacity, ufx->t.count);
+  // Deleting leaves no tombstones behind.
+  EXPECT_EQ(ufx->t.capacity - 2, ufx->t.count);
 
   EXPECT_FALSE(tableGet(&ufx->t, missingOStr, &missingValue));
 
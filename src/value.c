@@ -5,21 +5,78 @@
 #include <string.h>
 
 #include "memory.h"
+#include "number.h"
 #include "object.h"
 
 void initValueArray(ValueArray* array) {
   array->values = NULL;
   array->capacity = 0;
   array->count = 0;
+  array->head = 0;
+}
+
+static Value* arrayBase(ValueArray* array) {
+  return array->head > 0 ? array->values - array->head : array->values;
 }
 
 static void ensureNewSpace(GC* gc, ValueArray* array) {
-  if (array->capacity < array->count + 1) {
-    int oldCapacity = array->capacity;
-    array->capacity = GROW_CAPACITY(oldCapacity);
-    array->values = GROW_ARRAY(
-        gc, Value, array->values, oldCapacity, array->capacity);
+  if (array->capacity >= array->count + 1) {
+    return;
+  }
+  Value* base = arrayBase(array);
+  if (array->head > 0 && array->head >= array->count) {
+    // Most of the room is at the front, as in a queue that pushes at
+    // the back and removes from the front, so slide down into it.
+    memmove(base, array->values, array->count * sizeof(Value));
+    array->values = base;
+    array->capacity += array->head;
+    array->head = 0;
+    return;
+  }
+  int oldCapacity = array->capacity;
+  array->capacity = GROW_CAPACITY(oldCapacity);
+  base = GROW_ARRAY(gc, Value, base, array->head + oldCapacity,
+      array->head + array->capacity);
+  array->values = base + array->head;
+}
+
+static void ensureFrontSpace(GC* gc, ValueArray* array) {
+  if (array->head > 0) {
+    return;
+  }
+  // Leave as many free slots in front as there are values, so pushing
+  // at the front repeatedly takes amortized constant time.
+  int head = array->count < 8 ? 8 : array->count;
+  Value* base = ALLOCATE(gc, Value, head + array->capacity);
+  if (array->count > 0) {
+    memcpy(base + head, array->values, array->count * sizeof(Value));
+  }
+  FREE_ARRAY(gc, Value, array->values, array->capacity);
+  array->values = base + head;
+  array->head = head;
+}
+
+// Make room for at least capacity values from the start of the array.
+void reserveValueArray(GC* gc, ValueArray* array, int capacity) {
+  if (array->capacity >= capacity) {
+    return;
+  }
+  Value* base = arrayBase(array);
+  base = GROW_ARRAY(gc, Value, base, array->head + array->capacity,
+      array->head + capacity);
+  array->values = base + array->head;
+  array->capacity = capacity;
+}
+
+// Make room for count more values, growing geometrically so that
+// repeatedly appending values takes linear time overall.
+void growValueArray(GC* gc, ValueArray* array, int count) {
+  int needed = array->count + count;
+  if (array->capacity >= needed) {
+    return;
   }
+  int capacity = GROW_CAPACITY(array->capacity);
+  reserveValueArray(gc, array, capacity < needed ? needed : capacity);
 }
 
 void writeValueArray(GC* gc, ValueArray* array, Value value) {
@@ -28,11 +85,22 @@ void writeValueArray(GC* gc, ValueArray* array, Value value) {
   array->count++;
 }
 
+// Values are shifted towards whichever end is closer to pos, so
+// inserting and removing at either end takes constant time.
+
 void insertValueArray(GC* gc, ValueArray* array, int pos, Value value) {
-  assert(pos >= 0 && pos < array->count); // GCOV_EXCL_LINE
-  ensureNewSpace(gc, array);
-  memmove(array->values + pos + 1, array->values + pos,
-      (array->count - pos) * sizeof(Value));
+  assert(pos >= 0 && pos <= array->count); // GCOV_EXCL_LINE
+  if (pos < array->count / 2) {
+    ensureFrontSpace(gc, array);
+    array->values--;
+    array->head--;
+    array->capacity++;
+    memmove(array->values, array->values + 1, pos * sizeof(Value));
+  } else {
+    ensureNewSpace(gc, array);
+    memmove(array->values + pos + 1, array->values + pos,
+        (array->count - pos) * sizeof(Value));
+  }
   array->values[pos] = value;
   array->count++;
 }
@@ -40,8 +108,15 @@ void insertValueArray(GC* gc, ValueArray* array, int pos, Value value) {
 Value removeValueArray(ValueArray* array, int pos) {
   assert(pos >= 0 && pos < array->count); // GCOV_EXCL_LINE
   Value value = array->values[pos];
-  memmove(array->values + pos, array->values + pos + 1,
-      (array->count - pos - 1) * sizeof(Value));
+  if (pos < array->count / 2) {
+    memmove(array->values + 1, array->values, pos * sizeof(Value));
+    array->values++;
+    array->head++;
+    array->capacity--;
+  } else {
+    memmove(array->values + pos, array->values + pos + 1,
+        (array->count - pos - 1) * sizeof(Value));
+  }
   array->count--;
   return value;
 }
@@ -56,10 +131,16 @@ int findInValueArray(ValueArray* array, Value value) {
 }
 
 void freeValueArray(GC* gc, ValueArray* array) {
-  FREE_ARRAY(gc, Value, array->values, array->capacity);
+  FREE_ARRAY(
+      gc, Value, arrayBase(array), array->head + array->capacity);
   initValueArray(array);
 }
 
+static void printNumber(FILE* fout, double num) {
+  char buf[NUMBER_BUF_SIZE];
+  fwrite(buf, 1, formatNumber(buf, num), fout);
+}
+
 void printValue(FILE* fout, Value value) {
 #if NAN_BOXING == 1
   if (IS_BOOL(value)) {
@@ -67,7 +148,7 @@ void printValue(FILE* fout, Value value) {
   } else if (IS_NIL(value)) {
     fprintf(fout, "nil");
   } else if (IS_NUMBER(value)) {
-    fprintf(fout, "%g", AS_NUMBER(value));
+    printNumber(fout, AS_NUMBER(value));
   } else if (IS_OBJ(value)) {
     printObject(fout, value);
   }
@@ -76,8 +157,9 @@ void printValue(FILE* fout, Value value) {
     case VAL_BOOL:
       fprintf(fout, AS_BOOL(value) ? "true" : "false");
       break;
+    case VAL_EMPTY: break; // GCOV_EXCL_LINE: Never visible.
     case VAL_NIL: fprintf(fout, "nil"); break;
-    case VAL_NUMBER: fprintf(fout, "%g", AS_NUMBER(value)); break;
+    case VAL_NUMBER: printNumber(fout, AS_NUMBER(value)); break;
     case VAL_OBJ: printObject(fout, value); break;
   }
 #endif
@@ -105,6 +187,7 @@ bool valuesEqual(Value a, Value b) {
   }
   switch (a.type) {
     case VAL_BOOL: return AS_BOOL(a) == AS_BOOL(b);
+    case VAL_EMPTY:
     case VAL_NIL: return true;
     case VAL_NUMBER: return AS_NUMBER(a) == AS_NUMBER(b);
     case VAL_OBJ: return AS_OBJ(a) == AS_OBJ(b);
@@ -17,6 +17,7 @@ typedef struct ObjString ObjString;
 #define QNAN     ((uint64_t)0x7ffc000000000000)
 #define SIGN_BIT ((uint64_t)0x8000000000000000)
 
+#define TAG_EMPTY 0 // 00.
 #define TAG_NIL   1 // 01.
 #define TAG_FALSE 2 // 10.
 #define TAG_TRUE  3 // 11.
@@ -24,6 +25,7 @@ typedef struct ObjString ObjString;
 typedef uint64_t Value;
 
 #define IS_BOOL(value)      (((value) | 1) == TRUE_VAL)
+#define IS_EMPTY(value)     ((value) == EMPTY_VAL)
 #define IS_NIL(value)       ((value) == NIL_VAL)
 #define IS_NUMBER(value)    (((value) & QNAN) != QNAN)
 #define IS_OBJ(value) \
@@ -35,6 +37,7 @@ typedef uint64_t Value;
   ((Obj*)(uintptr_t)((value) & ~(SIGN_BIT | QNAN)))
 
 #define BOOL_VAL(b)     (FALSE_VAL | !!(b))
+#define EMPTY_VAL       ((Value)(uint64_t)(QNAN | TAG_EMPTY))
 #define FALSE_VAL       ((Value)(uint64_t)(QNAN | TAG_FALSE))
 #define TRUE_VAL        ((Value)(uint64_t)(QNAN | TAG_TRUE))
 #define NIL_VAL         ((Value)(uint64_t)(QNAN | TAG_NIL))
@@ -59,6 +62,7 @@ static inline Value numToValue(double num) {
 
 typedef enum {
   VAL_BOOL,
+  VAL_EMPTY,
   VAL_NIL,
   VAL_NUMBER,
   VAL_OBJ,
@@ -75,6 +79,7 @@ typedef struct {
 
 // clang-format off
 #define IS_BOOL(value)    ((value).type == VAL_BOOL)
+#define IS_EMPTY(value)   ((value).type == VAL_EMPTY)
 #define IS_NIL(value)     ((value).type == VAL_NIL)
 #define IS_NUMBER(value)  ((value).type == VAL_NUMBER)
 #define IS_OBJ(value)     ((value).type == VAL_OBJ)
@@ -84,24 +89,35 @@ typedef struct {
 #define AS_OBJ(value)     ((value).as.obj)
 
 #define BOOL_VAL(value)   (Value)BOOL_LIT(value)
+#define EMPTY_VAL         (Value)EMPTY_LIT
 #define NIL_VAL           (Value)NIL_LIT
 #define NUMBER_VAL(value) (Value)NUMBER_LIT(value)
 #define OBJ_VAL(object)   (Value){ VAL_OBJ, { .obj = (Obj*)object } }
 
 #define BOOL_LIT(lit)     { VAL_BOOL, { .boolean = lit } }
+#define EMPTY_LIT         { VAL_EMPTY, { .number = 0 } }
 #define NIL_LIT           { VAL_NIL, { .number = 0 } }
 #define NUMBER_LIT(lit)   { VAL_NUMBER, { .number = lit } }
 // clang-format on
 
 #endif
 
+// EMPTY_VAL marks unused entries in hash tables keyed by values; it's
+// never visible to scripts.
+
+// Values are contiguous from values, so they can be indexed directly,
+// but removing from the front leaves unused slots before them (head)
+// that inserting at the front can reuse.
 typedef struct {
-  int capacity;
+  int capacity; // Slots from values onwards.
   int count;
+  int head;
   Value* values;
 } ValueArray;
 
 void initValueArray(ValueArray* array);
+void reserveValueArray(GC* gc, ValueArray* array, int capacity);
+void growValueArray(GC* gc, ValueArray* array, int count);
 void writeValueArray(GC* gc, ValueArray* array, Value value);
 void insertValueArray(GC* gc, ValueArray* array, int pos, Value value);
 Value removeValueArray(ValueArray* array, int pos);
@@ -111,6 +127,10 @@ void printValue(FILE* fout, Value value);
 void printValueShallow(FILE* fout, Value value);
 bool valuesEqual(Value a, Value b);
 
+static inline bool isFalsey(Value value) {
+  return IS_NIL(value) || (IS_BOOL(value) && !AS_BOOL(value));
+}
+
 #define EXPECT_VALEQ(x, y) \
   UTEST_SURPRESS_WARNING_BEGIN do { \
     if (!valuesEqual(x, y)) { \
@@ -1,5 +1,7 @@
 #include "value.h"
 
+#include <string.h>
+
 #include "utest.h"
 
 #include "gc.h"
@@ -96,6 +98,83 @@ UTEST_F(ValueArray, InsertRemove) {
   EXPECT_EQ(0, ufx->va.count);
 }
 
+UTEST_F(ValueArray, InsertRemoveBothEnds) {
+  // Mirror a deque of ints in a plain array to check every position.
+  int expected[200];
+  int count = 0;
+  for (int i = 0; i < 100; ++i) {
+    insertValueArray(&ufx->gc, &ufx->va, 0, NUMBER_VAL(-i));
+    writeValueArray(&ufx->gc, &ufx->va, NUMBER_VAL(i));
+  }
+  for (int i = 99; i >= 0; --i) {
+    expected[count++] = -i;
+  }
+  for (int i = 0; i < 100; ++i) {
+    expected[count++] = i;
+  }
+  ASSERT_EQ(count, ufx->va.count);
+
+  // Remove near the front and back, then insert near the front.
+  removeValueArray(&ufx->va, 3);
+  memmove(&expected[3], &expected[4], (count - 4) * sizeof(int));
+  count--;
+  removeValueArray(&ufx->va, count - 2);
+  expected[count - 2] = expected[count - 1];
+  count--;
+  insertValueArray(&ufx->gc, &ufx->va, 5, NUMBER_VAL(1000));
+  memmove(&expected[6], &expected[5], (count - 5) * sizeof(int));
+  expected[5] = 1000;
+  count++;
+
+  ASSERT_EQ(count, ufx->va.count);
+  for (int i = 0; i < count; ++i) {
+    EXPECT_VALEQ(NUMBER_VAL(expected[i]), ufx->va.values[i]);
+  }
+}
+
+UTEST_F(ValueArray, QueueReusesSpace) {
+  for (int i = 0; i < 8; ++i) {
+    writeValueArray(&ufx->gc, &ufx->va, NUMBER_VAL(i));
+  }
+
+  // Pushing at the back and removing from the front slides values down
+  // into the freed space instead of growing without bound.
+  for (int i = 8; i < 10000; ++i) {
+    writeValueArray(&ufx->gc, &ufx->va, NUMBER_VAL(i));
+    Value v = removeValueArray(&ufx->va, 0);
+    EXPECT_VALEQ(NUMBER_VAL(i - 8), v);
+  }
+  EXPECT_EQ(8, ufx->va.count);
+  EXPECT_LE(ufx->va.head + ufx->va.capacity, 16);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_VALEQ(NUMBER_VAL(9992 + i), ufx->va.values[i]);
+  }
+}
+
+UTEST_F(ValueArray, Reserve) {
+  reserveValueArray(&ufx->gc, &ufx->va, 100);
+  EXPECT_EQ(0, ufx->va.count);
+  EXPECT_EQ(100, ufx->va.capacity);
+  Value* values = ufx->va.values;
+  for (int i = 0; i < 100; ++i) {
+    writeValueArray(&ufx->gc, &ufx->va, NUMBER_VAL(i));
+  }
+  EXPECT_EQ(values, ufx->va.values);
+
+  // Reserving less than the capacity does nothing.
+  reserveValueArray(&ufx->gc, &ufx->va, 10);
+  EXPECT_EQ(100, ufx->va.capacity);
+
+  // Reserving keeps values and room at the front.
+  removeValueArray(&ufx->va, 0);
+  reserveValueArray(&ufx->gc, &ufx->va, 200);
+  EXPECT_EQ(1, ufx->va.head);
+  EXPECT_EQ(200, ufx->va.capacity);
+  for (int i = 0; i < 99; ++i) {
+    EXPECT_VALEQ(NUMBER_VAL(i + 1), ufx->va.values[i]);
+  }
+}
+
 UTEST_F(ValueArray, FindInValueArray) {
   writeValueArray(&ufx->gc, &ufx->va, NUMBER_VAL(1.0));
   writeValueArray(&ufx->gc, &ufx->va, NUMBER_VAL(2.0));
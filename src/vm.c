@@ -13,8 +13,10 @@
 #include "common.h"
 #include "compiler.h"
 #include "debug.h"
+#include "f64.h"
 #include "membuf.h"
 #include "memory.h"
+#include "number.h"
 #include "obj_native.h"
 #include "object.h"
 
@@ -24,6 +26,8 @@
 
 bool debugTraceExecution = false;
 
+static bool callFromNative(VM* vm, Value callee, int argCount);
+
 static void resetStack(VM* vm) {
   vm->stackTop = vm->stack;
   vm->frameCount = 0;
@@ -40,9 +44,9 @@ static void runtimeError(VM* vm, const char* format, ...) {
   for (int i = vm->frameCount - 1; i >= 0; i--) {
     CallFrame* frame = &vm->frames[i];
     ObjFunction* function = frame->function;
-    size_t instruction = frame->ip - function->chunk.code - 1;
-    fprintf(
-        vm->ferr, "[line %d] in ", function->chunk.lines[instruction]);
+    int instruction = (int)(frame->ip - function->chunk.code - 1);
+    fprintf(vm->ferr, "[line %d] in ",
+        getLine(&function->chunk, instruction));
     if (function->name == NULL) {
       fprintf(vm->ferr, "script\n");
     } else {
@@ -53,6 +57,21 @@ static void runtimeError(VM* vm, const char* format, ...) {
   resetStack(vm);
 }
 
+// Report a global that was used before being defined. The compiler
+// reserves its slot, and the name is found by a linear search, which
+// is fine since it's only needed for the error.
+static void undefinedGlobal(VM* vm, uint16_t slot) {
+  const char* name = "?";
+  for (int i = 0; i < vm->globals.capacity; i++) {
+    Entry* entry = &vm->globals.entries[i];
+    if (entry->key != NULL && AS_NUMBER(entry->value) == slot) {
+      name = entry->key->chars;
+      break;
+    }
+  }
+  runtimeError(vm, "Undefined variable '%s'.", name);
+}
+
 static bool checkArity(VM* vm, int expected, int actual) {
   if (expected != actual) {
     runtimeError(
@@ -84,12 +103,68 @@ static bool checkIndexBounds(
   return true;
 }
 
+// Check that sizeValue is a whole number that fits in an int.
+static bool checkSize(VM* vm, Value sizeValue, int* size) {
+  if (!IS_NUMBER(sizeValue)) {
+    runtimeError(vm, "Size must be a number.");
+    return false;
+  }
+  double num = AS_NUMBER(sizeValue);
+  if (!(num >= 0.0 && num <= (double)INT_MAX) ||
+      (double)(int)num != num) {
+    runtimeError(vm,
+        "Size (%g) must be a whole number between 0 and %d.", num,
+        INT_MAX);
+    return false;
+  }
+  *size = (int)num;
+  return true;
+}
+
+static bool substrIndex(
+    VM* vm, Value input, const char* type, int length, int* index) {
+  if (!IS_NUMBER(input)) {
+    runtimeError(vm, "%s must be a number.", type);
+    return false;
+  }
+  double num = AS_NUMBER(input);
+  if (num <= (double)INT_MIN) {
+    *index = INT_MIN;
+  } else if (num >= (double)INT_MAX) {
+    *index = INT_MAX;
+  } else {
+    if ((double)(int)num != num) {
+      runtimeError(vm, "%s (%g) must be a whole number.", type, num);
+      return false;
+    }
+    *index = num;
+  }
+  if (*index < 0) {
+    *index += length + 1;
+  }
+  if (*index < 0) {
+    *index = 0;
+  } else if (*index > length) {
+    *index = length;
+  }
+  return true;
+}
+
 static bool checkStringIndex(
     VM* vm, ObjString* string, Value indexValue) {
   return checkIndexBounds(
       vm, "String index", string->length, indexValue);
 }
 
+static void undefinedKeyError(VM* vm, Value key) {
+  MemBuf out;
+  initMemBuf(&out);
+  printValueShallow(out.fptr, key);
+  fflush(out.fptr);
+  runtimeError(vm, "Undefined key '%s'.", out.buf);
+  freeMemBuf(&out);
+}
+
 static bool argcNative(VM* vm, int argCount, Value* args) {
   (void)args;
   if (!checkArity(vm, 0, argCount)) {
@@ -201,6 +276,29 @@ static bool floorNative(VM* vm, int argCount, Value* args) {
   return true;
 }
 
+static bool rangeNative(VM* vm, int argCount, Value* args) {
+  if (argCount < 1 || argCount > 3) {
+    runtimeError(
+        vm, "Expected 1 to 3 arguments but got %d.", argCount);
+    return false;
+  }
+  for (int i = 0; i < argCount; ++i) {
+    if (!IS_NUMBER(args[i])) {
+      runtimeError(vm, "Arguments must be numbers.");
+      return false;
+    }
+  }
+  double start = argCount > 1 ? AS_NUMBER(args[0]) : 0.0;
+  double end = AS_NUMBER(args[argCount > 1 ? 1 : 0]);
+  double step = argCount > 2 ? AS_NUMBER(args[2]) : 1.0;
+  if (step == 0.0 || isnan(step)) {
+    runtimeError(vm, "Step must be a non-zero number.");
+    return false;
+  }
+  push(vm, OBJ_VAL(newRange(&vm->gc, start, end, step)));
+  return true;
+}
+
 static bool roundNative(VM* vm, int argCount, Value* args) {
   if (!checkArity(vm, 1, argCount)) {
     return false;
@@ -217,9 +315,27 @@ static bool strNative(VM* vm, int argCount, Value* args) {
   if (!checkArity(vm, 1, argCount)) {
     return false;
   }
+  Value arg = args[0];
+  if (IS_STRING(arg)) {
+    push(vm, arg);
+    return true;
+  }
+  if (IS_NUMBER(arg)) {
+    char buf[NUMBER_BUF_SIZE];
+    int length = formatNumber(buf, AS_NUMBER(arg));
+    push(vm, OBJ_VAL(copyString(&vm->gc, &vm->strings, buf, length)));
+    return true;
+  }
+  if (IS_BOOL(arg) || IS_NIL(arg)) {
+    const char* chars =
+        IS_NIL(arg) ? "nil" : AS_BOOL(arg) ? "true" : "false";
+    push(vm,
+        OBJ_VAL(copyString(&vm->gc, &vm->strings, chars, strlen(chars))));
+    return true;
+  }
   MemBuf out;
   initMemBuf(&out);
-  printValue(out.fptr, args[0]);
+  printValue(out.fptr, arg);
   fflush(out.fptr);
   push(vm,
       OBJ_VAL(copyString(&vm->gc, &vm->strings, out.buf, out.size)));
@@ -238,11 +354,14 @@ static bool typeNative(VM* vm, int argCount, Value* args) {
       case OBJ_CLOSURE:
       case OBJ_FUNCTION: t = "function"; break;
       case OBJ_CLASS: t = "class"; break;
+      case OBJ_FLOAT_ARRAY: t = "float64 array"; break;
       case OBJ_INSTANCE: t = "instance"; break;
       case OBJ_LIST: t = "list"; break;
       case OBJ_MAP: t = "map"; break;
       case OBJ_NATIVE: t = "native function"; break;
+      case OBJ_RANGE: t = "range"; break;
       case OBJ_STRING: t = "string"; break;
+      case OBJ_STRING_BUILDER: t = "string builder"; break;
       case OBJ_UPVALUE: t = "upvalue"; break;
     }
   } else if (IS_BOOL(args[0])) {
@@ -297,9 +416,11 @@ static void vmMarkRoots(GC* gc, void* arg) {
   }
 
   markObject(gc, (Obj*)vm->initString);
+  markObject(gc, (Obj*)vm->float64ArrayClass);
   markObject(gc, (Obj*)vm->listClass);
   markObject(gc, (Obj*)vm->mapClass);
   markObject(gc, (Obj*)vm->stringClass);
+  markObject(gc, (Obj*)vm->stringBuilderClass);
 }
 
 static void defineNativeMethod(
@@ -317,12 +438,271 @@ static void defineNativeMethod(
   popTemp(&vm->gc); // native
 }
 
+static bool float64ArrayNative(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  if (IS_LIST(args[0])) {
+    ObjList* list = AS_LIST(args[0]);
+    for (int i = 0; i < list->elements.count; ++i) {
+      if (!IS_NUMBER(list->elements.values[i])) {
+        runtimeError(vm, "List elements must be numbers.");
+        return false;
+      }
+    }
+    ObjFloatArray* array = newFloatArray(&vm->gc, list->elements.count);
+    for (int i = 0; i < list->elements.count; ++i) {
+      array->values[i] = AS_NUMBER(list->elements.values[i]);
+    }
+    push(vm, OBJ_VAL(array));
+    return true;
+  }
+  if (!IS_NUMBER(args[0])) {
+    runtimeError(vm, "Argument must be a size or a list.");
+    return false;
+  }
+  int size;
+  if (!checkSize(vm, args[0], &size)) {
+    return false;
+  }
+  push(vm, OBJ_VAL(newFloatArray(&vm->gc, size)));
+  return true;
+}
+
+// Check that the argument is a Float64Array the same size as array.
+static bool checkSameSize(
+    VM* vm, ObjFloatArray* array, Value other, const char* name) {
+  if (!IS_FLOAT_ARRAY(other)) {
+    runtimeError(vm, "Argument must be a %s.", name);
+    return false;
+  }
+  if (AS_FLOAT_ARRAY(other)->count != array->count) {
+    runtimeError(vm, "Float64Array sizes must match (%d and %d).",
+        array->count, AS_FLOAT_ARRAY(other)->count);
+    return false;
+  }
+  return true;
+}
+
+static bool float64ArrayAdd(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  ObjFloatArray* array = AS_FLOAT_ARRAY(args[-1]);
+  if (IS_NUMBER(args[0])) {
+    f64AddScalar(array->values, array->count, AS_NUMBER(args[0]));
+  } else if (checkSameSize(
+                 vm, array, args[0], "number or Float64Array")) {
+    f64Add(array->values, AS_FLOAT_ARRAY(args[0])->values,
+        array->count);
+  } else {
+    return false;
+  }
+  push(vm, args[-1]);
+  return true;
+}
+
+static bool float64ArrayDot(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  ObjFloatArray* array = AS_FLOAT_ARRAY(args[-1]);
+  if (!checkSameSize(vm, array, args[0], "Float64Array")) {
+    return false;
+  }
+  push(vm,
+      NUMBER_VAL(f64Dot(array->values, AS_FLOAT_ARRAY(args[0])->values,
+          array->count)));
+  return true;
+}
+
+static bool float64ArrayMap(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  ObjFloatArray* array = AS_FLOAT_ARRAY(args[-1]);
+  for (int i = 0; i < array->count; ++i) {
+    push(vm, args[0]);
+    push(vm, NUMBER_VAL(array->values[i]));
+    if (!callFromNative(vm, args[0], 1)) {
+      return false;
+    }
+    Value result = pop(vm);
+    if (!IS_NUMBER(result)) {
+      runtimeError(vm, "Map function must return a number.");
+      return false;
+    }
+    array->values[i] = AS_NUMBER(result);
+  }
+  push(vm, args[-1]);
+  return true;
+}
+
+static bool float64ArrayMax(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 0, argCount)) {
+    return false;
+  }
+  ObjFloatArray* array = AS_FLOAT_ARRAY(args[-1]);
+  if (array->count == 0) {
+    runtimeError(vm, "Can't take the max of an empty Float64Array.");
+    return false;
+  }
+  push(vm, NUMBER_VAL(f64Max(array->values, array->count)));
+  return true;
+}
+
+static bool float64ArrayMin(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 0, argCount)) {
+    return false;
+  }
+  ObjFloatArray* array = AS_FLOAT_ARRAY(args[-1]);
+  if (array->count == 0) {
+    runtimeError(vm, "Can't take the min of an empty Float64Array.");
+    return false;
+  }
+  push(vm, NUMBER_VAL(f64Min(array->values, array->count)));
+  return true;
+}
+
+static bool float64ArrayScale(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  if (!IS_NUMBER(args[0])) {
+    runtimeError(vm, "Argument must be a number.");
+    return false;
+  }
+  ObjFloatArray* array = AS_FLOAT_ARRAY(args[-1]);
+  f64Scale(array->values, array->count, AS_NUMBER(args[0]));
+  push(vm, args[-1]);
+  return true;
+}
+
+static bool float64ArraySize(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 0, argCount)) {
+    return false;
+  }
+  push(vm, NUMBER_VAL((double)AS_FLOAT_ARRAY(args[-1])->count));
+  return true;
+}
+
+static bool float64ArraySum(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 0, argCount)) {
+    return false;
+  }
+  ObjFloatArray* array = AS_FLOAT_ARRAY(args[-1]);
+  push(vm, NUMBER_VAL(f64Sum(array->values, array->count)));
+  return true;
+}
+
+static bool float64ArrayToList(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 0, argCount)) {
+    return false;
+  }
+  ObjFloatArray* array = AS_FLOAT_ARRAY(args[-1]);
+  ObjList* list = newList(&vm->gc);
+  push(vm, OBJ_VAL(list));
+  reserveValueArray(&vm->gc, &list->elements, array->count);
+  for (int i = 0; i < array->count; ++i) {
+    writeValueArray(
+        &vm->gc, &list->elements, NUMBER_VAL(array->values[i]));
+  }
+  return true;
+}
+
+static void initFloat64ArrayClass(VM* vm) {
+  const char arrayStr[] = "(Float64Array)";
+  ObjString* arrayClassName = copyString(
+      &vm->gc, &vm->strings, arrayStr, sizeof(arrayStr) - 1);
+  pushTemp(&vm->gc, OBJ_VAL(arrayClassName));
+  vm->float64ArrayClass = newClass(&vm->gc, arrayClassName);
+  popTemp(&vm->gc);
+
+  defineNativeMethod(vm, vm->float64ArrayClass, "add", float64ArrayAdd);
+  defineNativeMethod(vm, vm->float64ArrayClass, "dot", float64ArrayDot);
+  defineNativeMethod(vm, vm->float64ArrayClass, "map", float64ArrayMap);
+  defineNativeMethod(vm, vm->float64ArrayClass, "max", float64ArrayMax);
+  defineNativeMethod(vm, vm->float64ArrayClass, "min", float64ArrayMin);
+  defineNativeMethod(
+      vm, vm->float64ArrayClass, "scale", float64ArrayScale);
+  defineNativeMethod(
+      vm, vm->float64ArrayClass, "size", float64ArraySize);
+  defineNativeMethod(vm, vm->float64ArrayClass, "sum", float64ArraySum);
+  defineNativeMethod(
+      vm, vm->float64ArrayClass, "toList", float64ArrayToList);
+}
+
+static bool listNative(VM* vm, int argCount, Value* args) {
+  if (argCount < 1 || argCount > 2) {
+    runtimeError(
+        vm, "Expected 1 to 2 arguments but got %d.", argCount);
+    return false;
+  }
+  int size;
+  if (!checkSize(vm, args[0], &size)) {
+    return false;
+  }
+  Value fill = argCount == 2 ? args[1] : NIL_VAL;
+  ObjList* list = newList(&vm->gc);
+  push(vm, OBJ_VAL(list));
+  reserveValueArray(&vm->gc, &list->elements, size);
+  for (int i = 0; i < size; ++i) {
+    list->elements.values[i] = fill;
+  }
+  list->elements.count = size;
+  return true;
+}
+
 static bool checkListIndex(VM* vm, Value listValue, Value indexValue) {
   ObjList* list = AS_LIST(listValue);
   return checkIndexBounds(
       vm, "List index", list->elements.count, indexValue);
 }
 
+static bool listExtend(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  if (!IS_LIST(args[0])) {
+    runtimeError(vm, "Argument must be a list.");
+    return false;
+  }
+  ValueArray* elements = &AS_LIST(args[-1])->elements;
+  ValueArray* other = &AS_LIST(args[0])->elements;
+  int count = other->count;
+  growValueArray(&vm->gc, elements, count);
+  // Read other->values only now, in case other is the same list.
+  if (count > 0) {
+    memcpy(&elements->values[elements->count], other->values,
+        sizeof(Value) * (size_t)count);
+  }
+  elements->count += count;
+  push(vm, NIL_VAL);
+  return true;
+}
+
+static bool listFill(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  ValueArray* elements = &AS_LIST(args[-1])->elements;
+  for (int i = 0; i < elements->count; ++i) {
+    elements->values[i] = args[0];
+  }
+  push(vm, NIL_VAL);
+  return true;
+}
+
+static bool listIndexOf(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  ObjList* list = AS_LIST(args[-1]);
+  int index = findInValueArray(&list->elements, args[0]);
+  push(vm, NUMBER_VAL((double)index));
+  return true;
+}
+
 static bool listInsert(VM* vm, int argCount, Value* args) {
   if (!checkArity(vm, 2, argCount)) {
     return false;
@@ -350,6 +730,19 @@ static bool listPop(VM* vm, int argCount, Value* args) {
   return true;
 }
 
+static bool listPopFront(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 0, argCount)) {
+    return false;
+  }
+  ObjList* list = AS_LIST(args[-1]);
+  if (list->elements.count == 0) {
+    runtimeError(vm, "Can't pop from an empty list.");
+    return false;
+  }
+  push(vm, removeValueArray(&list->elements, 0));
+  return true;
+}
+
 static bool listPush(VM* vm, int argCount, Value* args) {
   if (!checkArity(vm, 1, argCount)) {
     return false;
@@ -360,6 +753,29 @@ static bool listPush(VM* vm, int argCount, Value* args) {
   return true;
 }
 
+static bool listPushFront(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  ObjList* list = AS_LIST(args[-1]);
+  insertValueArray(&vm->gc, &list->elements, 0, args[0]);
+  push(vm, NIL_VAL);
+  return true;
+}
+
+static bool listReserve(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  int capacity;
+  if (!checkSize(vm, args[0], &capacity)) {
+    return false;
+  }
+  reserveValueArray(&vm->gc, &AS_LIST(args[-1])->elements, capacity);
+  push(vm, NIL_VAL);
+  return true;
+}
+
 static bool listRemove(VM* vm, int argCount, Value* args) {
   if (!checkArity(vm, 1, argCount)) {
     return false;
@@ -382,6 +798,224 @@ static bool listSize(VM* vm, int argCount, Value* args) {
   return true;
 }
 
+static bool listReverse(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 0, argCount)) {
+    return false;
+  }
+  ValueArray* elements = &AS_LIST(args[-1])->elements;
+  for (int i = 0, j = elements->count - 1; i < j; ++i, --j) {
+    Value value = elements->values[i];
+    elements->values[i] = elements->values[j];
+    elements->values[j] = value;
+  }
+  push(vm, NIL_VAL);
+  return true;
+}
+
+static bool listSlice(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 2, argCount)) {
+    return false;
+  }
+  ObjList* list = AS_LIST(args[-1]);
+  int start;
+  int end;
+  if (!substrIndex(
+          vm, args[0], "Start", list->elements.count, &start)) {
+    return false;
+  }
+  if (!substrIndex(vm, args[1], "End", list->elements.count, &end)) {
+    return false;
+  }
+  ObjList* slice = newList(&vm->gc);
+  push(vm, OBJ_VAL(slice));
+  if (start < end) {
+    reserveValueArray(&vm->gc, &slice->elements, end - start);
+    memcpy(slice->elements.values, &list->elements.values[start],
+        sizeof(Value) * (size_t)(end - start));
+    slice->elements.count = end - start;
+  }
+  return true;
+}
+
+// Set *less to whether a sorts before b, returning false on error.
+typedef bool (*LessFn)(VM* vm, Value cmp, Value a, Value b, bool* less);
+
+static bool lessNumbers(
+    VM* vm, Value cmp, Value a, Value b, bool* less) {
+  (void)vm;
+  (void)cmp;
+  *less = AS_NUMBER(a) < AS_NUMBER(b);
+  return true;
+}
+
+static bool lessStrings(
+    VM* vm, Value cmp, Value a, Value b, bool* less) {
+  (void)vm;
+  (void)cmp;
+  ObjString* x = AS_STRING(a);
+  ObjString* y = AS_STRING(b);
+  int length = x->length < y->length ? x->length : y->length;
+  int c = memcmp(x->chars, y->chars, length);
+  *less = c < 0 || (c == 0 && x->length < y->length);
+  return true;
+}
+
+static bool lessCall(VM* vm, Value cmp, Value a, Value b, bool* less) {
+  push(vm, cmp);
+  push(vm, a);
+  push(vm, b);
+  if (!callFromNative(vm, cmp, 2)) {
+    return false;
+  }
+  Value result = pop(vm);
+  if (!IS_NUMBER(result)) {
+    runtimeError(vm, "Comparator must return a number.");
+    return false;
+  }
+  *less = AS_NUMBER(result) < 0;
+  return true;
+}
+
+#define SORT_RUN 32
+
+// Stable binary insertion sort of values[lo..hi).
+static bool insertionSort(
+    VM* vm, Value cmp, LessFn less, Value* values, int lo, int hi) {
+  for (int i = lo + 1; i < hi; ++i) {
+    Value value = values[i];
+    bool lt;
+    if (!less(vm, cmp, value, values[i - 1], &lt)) {
+      return false;
+    }
+    if (!lt) {
+      continue; // Already in place, as in sorted input.
+    }
+    int left = lo;
+    int right = i - 1;
+    while (left < right) {
+      int mid = left + (right - left) / 2;
+      if (!less(vm, cmp, value, values[mid], &lt)) {
+        return false;
+      }
+      if (lt) {
+        right = mid;
+      } else {
+        left = mid + 1;
+      }
+    }
+    memmove(&values[left + 1], &values[left],
+        sizeof(Value) * (size_t)(i - left));
+    values[left] = value;
+  }
+  return true;
+}
+
+// Merge the sorted runs values[lo..mid) and values[mid..hi) stably.
+static bool mergeRuns(VM* vm, Value cmp, LessFn less, Value* values,
+    Value* scratch, int lo, int mid, int hi) {
+  bool lt;
+  if (!less(vm, cmp, values[mid], values[mid - 1], &lt)) {
+    return false;
+  }
+  if (!lt) {
+    return true; // Already in order, as in sorted input.
+  }
+  memcpy(&scratch[lo], &values[lo], sizeof(Value) * (size_t)(mid - lo));
+  int i = lo;
+  int j = mid;
+  int k = lo;
+  while (i < mid && j < hi) {
+    if (!less(vm, cmp, values[j], scratch[i], &lt)) {
+      return false;
+    }
+    values[k++] = lt ? values[j++] : scratch[i++];
+  }
+  while (i < mid) {
+    values[k++] = scratch[i++];
+  }
+  return true;
+}
+
+// Bottom-up merge sort over insertion-sorted runs, which is stable and
+// takes close to linear time on input that is mostly sorted already.
+// Every value must be in either values or scratch at all times, so
+// both can be kept reachable while a comparator runs.
+static bool sortValues(VM* vm, Value cmp, LessFn less, Value* values,
+    Value* scratch, int count) {
+  for (int lo = 0; lo < count; lo += SORT_RUN) {
+    int hi = lo + SORT_RUN < count ? lo + SORT_RUN : count;
+    if (!insertionSort(vm, cmp, less, values, lo, hi)) {
+      return false;
+    }
+  }
+  for (int width = SORT_RUN; width < count; width *= 2) {
+    for (int lo = 0; lo < count - width; lo += 2 * width) {
+      int mid = lo + width;
+      int hi = mid + width < count ? mid + width : count;
+      if (!mergeRuns(vm, cmp, less, values, scratch, lo, mid, hi)) {
+        return false;
+      }
+    }
+    if (width > INT_MAX / 2) {
+      break;
+    }
+  }
+  return true;
+}
+
+#undef SORT_RUN
+
+static bool listSort(VM* vm, int argCount, Value* args) {
+  if (argCount > 1) {
+    runtimeError(
+        vm, "Expected 0 to 1 arguments but got %d.", argCount);
+    return false;
+  }
+  ObjList* list = AS_LIST(args[-1]);
+  int count = list->elements.count;
+  Value cmp = NIL_VAL;
+  LessFn less = lessCall;
+  if (argCount == 1) {
+    cmp = args[0];
+  } else if (count > 0) {
+    // Compare numbers and strings directly without calling into Lox.
+    bool numbers = IS_NUMBER(list->elements.values[0]);
+    less = numbers ? lessNumbers : lessStrings;
+    for (int i = 0; i < count; ++i) {
+      Value value = list->elements.values[i];
+      if (numbers ? !IS_NUMBER(value) : !IS_STRING(value)) {
+        runtimeError(vm,
+            "List elements must be all numbers or all strings "
+            "to sort without a comparator.");
+        return false;
+      }
+    }
+  }
+
+  // A comparator can change the list or collect garbage, so sort a
+  // copy that stays on the stack and swap it in at the end.
+  ObjList* sorted = newList(&vm->gc);
+  push(vm, OBJ_VAL(sorted));
+  ObjList* scratch = newList(&vm->gc);
+  push(vm, OBJ_VAL(scratch));
+  for (int i = 0; i < count; ++i) {
+    writeValueArray(
+        &vm->gc, &sorted->elements, list->elements.values[i]);
+    writeValueArray(&vm->gc, &scratch->elements, NIL_VAL);
+  }
+  if (!sortValues(vm, cmp, less, sorted->elements.values,
+          scratch->elements.values, count)) {
+    return false;
+  }
+  ValueArray elements = list->elements;
+  list->elements = sorted->elements;
+  sorted->elements = elements;
+  pop(vm); // Scratch.
+  pop(vm); // Sorted.
+  push(vm, NIL_VAL);
+  return true;
+}
+
 static void initListClass(VM* vm) {
   const char listStr[] = "(List)";
   ObjString* listClassName =
@@ -390,23 +1024,27 @@ static void initListClass(VM* vm) {
   vm->listClass = newClass(&vm->gc, listClassName);
   popTemp(&vm->gc);
 
+  defineNativeMethod(vm, vm->listClass, "extend", listExtend);
+  defineNativeMethod(vm, vm->listClass, "fill", listFill);
+  defineNativeMethod(vm, vm->listClass, "indexOf", listIndexOf);
   defineNativeMethod(vm, vm->listClass, "insert", listInsert);
   defineNativeMethod(vm, vm->listClass, "push", listPush);
+  defineNativeMethod(vm, vm->listClass, "pushFront", listPushFront);
   defineNativeMethod(vm, vm->listClass, "pop", listPop);
+  defineNativeMethod(vm, vm->listClass, "popFront", listPopFront);
   defineNativeMethod(vm, vm->listClass, "size", listSize);
+  defineNativeMethod(vm, vm->listClass, "sort", listSort);
   defineNativeMethod(vm, vm->listClass, "remove", listRemove);
+  defineNativeMethod(vm, vm->listClass, "reserve", listReserve);
+  defineNativeMethod(vm, vm->listClass, "reverse", listReverse);
+  defineNativeMethod(vm, vm->listClass, "slice", listSlice);
 }
 
 static bool mapCount(VM* vm, int argCount, Value* args) {
   if (!checkArity(vm, 0, argCount)) {
     return false;
   }
-  ObjMap* map = AS_MAP(args[-1]);
-  int count = 0;
-  for (int i = 0; i < map->table.capacity; ++i) {
-    count += !!(map->table.entries[i].key);
-  }
-  push(vm, NUMBER_VAL((double)count));
+  push(vm, NUMBER_VAL((double)AS_MAP(args[-1])->dict.count));
   return true;
 }
 
@@ -414,14 +1052,9 @@ static bool mapHas(VM* vm, int argCount, Value* args) {
   if (!checkArity(vm, 1, argCount)) {
     return false;
   }
-  if (!IS_STRING(args[0])) {
-    runtimeError(vm, "Maps can only be indexed by string.");
-    return false;
-  }
   ObjMap* map = AS_MAP(args[-1]);
-  ObjString* key = AS_STRING(args[0]);
   Value value;
-  push(vm, BOOL_VAL(tableGet(&map->table, key, &value)));
+  push(vm, BOOL_VAL(dictGet(&map->dict, args[0], &value)));
   return true;
 }
 
@@ -432,12 +1065,12 @@ static bool mapKeys(VM* vm, int argCount, Value* args) {
   ObjMap* map = AS_MAP(args[-1]);
   ObjList* keys = newList(&vm->gc);
   push(vm, OBJ_VAL(keys));
-  for (int i = 0; i < map->table.capacity; ++i) {
-    Entry* entry = &map->table.entries[i];
-    if (entry->key == NULL) {
+  for (int i = 0; i < map->dict.entryCount; ++i) {
+    DictEntry* entry = &map->dict.entries[i];
+    if (IS_EMPTY(entry->key)) {
       continue;
     }
-    writeValueArray(&vm->gc, &keys->elements, OBJ_VAL(entry->key));
+    writeValueArray(&vm->gc, &keys->elements, entry->key);
   }
   return true;
 }
@@ -446,13 +1079,8 @@ static bool mapRemove(VM* vm, int argCount, Value* args) {
   if (!checkArity(vm, 1, argCount)) {
     return false;
   }
-  if (!IS_STRING(args[0])) {
-    runtimeError(vm, "Maps can only be indexed by string.");
-    return false;
-  }
   ObjMap* map = AS_MAP(args[-1]);
-  ObjString* key = AS_STRING(args[0]);
-  push(vm, BOOL_VAL(tableDelete(&map->table, key)));
+  push(vm, BOOL_VAL(dictDelete(&map->dict, args[0])));
   return true;
 }
 
@@ -476,7 +1104,7 @@ static bool stringParseNum(VM* vm, int argCount, Value* args) {
   }
   ObjString* string = AS_STRING(args[-1]);
   char* after;
-  double result = strtod(string->chars, &after);
+  double result = parseNumber(string->chars, &after);
   while (after < string->chars + string->length) {
     if (!isspace(*after)) {
       break;
@@ -500,35 +1128,6 @@ static bool stringSize(VM* vm, int argCount, Value* args) {
   return true;
 }
 
-static bool substrIndex(
-    VM* vm, Value input, const char* type, int length, int* index) {
-  if (!IS_NUMBER(input)) {
-    runtimeError(vm, "%s must be a number.", type);
-    return false;
-  }
-  double num = AS_NUMBER(input);
-  if (num <= (double)INT_MIN) {
-    *index = INT_MIN;
-  } else if (num >= (double)INT_MAX) {
-    *index = INT_MAX;
-  } else {
-    if ((double)(int)num != num) {
-      runtimeError(vm, "%s (%g) must be a whole number.", type, num);
-      return false;
-    }
-    *index = num;
-  }
-  if (*index < 0) {
-    *index += length + 1;
-  }
-  if (*index < 0) {
-    *index = 0;
-  } else if (*index > length) {
-    *index = length;
-  }
-  return true;
-}
-
 static bool stringSubstr(VM* vm, int argCount, Value* args) {
   if (!checkArity(vm, 2, argCount)) {
     return false;
@@ -548,21 +1147,127 @@ static bool stringSubstr(VM* vm, int argCount, Value* args) {
     chars = string->chars + start;
     length = end - start;
   }
-  push(vm, OBJ_VAL(copyString(&vm->gc, &vm->strings, chars, length)));
+  push(vm, OBJ_VAL(copyString(&vm->gc, &vm->strings, chars, length)));
+  return true;
+}
+
+static void initStringClass(VM* vm) {
+  const char stringStr[] = "(String)";
+  ObjString* stringClassName = copyString(
+      &vm->gc, &vm->strings, stringStr, sizeof(stringStr) - 1);
+  pushTemp(&vm->gc, OBJ_VAL(stringClassName));
+  vm->stringClass = newClass(&vm->gc, stringClassName);
+  popTemp(&vm->gc);
+
+  defineNativeMethod(vm, vm->stringClass, "parsenum", stringParseNum);
+  defineNativeMethod(vm, vm->stringClass, "size", stringSize);
+  defineNativeMethod(vm, vm->stringClass, "substr", stringSubstr);
+}
+
+static bool stringBuilderNative(VM* vm, int argCount, Value* args) {
+  (void)args;
+  if (!checkArity(vm, 0, argCount)) {
+    return false;
+  }
+  push(vm, OBJ_VAL(newStringBuilder(&vm->gc)));
+  return true;
+}
+
+static void appendValue(
+    VM* vm, ObjStringBuilder* builder, Value value) {
+  if (IS_STRING(value)) {
+    ObjString* string = AS_STRING(value);
+    appendStringBuilder(
+        &vm->gc, builder, string->chars, string->length);
+  } else if (IS_NUMBER(value)) {
+    char buf[NUMBER_BUF_SIZE];
+    int length = formatNumber(buf, AS_NUMBER(value));
+    appendStringBuilder(&vm->gc, builder, buf, length);
+  } else if (IS_BOOL(value) || IS_NIL(value)) {
+    const char* chars =
+        IS_NIL(value) ? "nil" : AS_BOOL(value) ? "true" : "false";
+    appendStringBuilder(&vm->gc, builder, chars, (int)strlen(chars));
+  } else {
+    MemBuf out;
+    initMemBuf(&out);
+    printValue(out.fptr, value);
+    fflush(out.fptr);
+    appendStringBuilder(&vm->gc, builder, out.buf, (int)out.size);
+    freeMemBuf(&out);
+  }
+}
+
+static bool stringBuilderAppend(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 1, argCount)) {
+    return false;
+  }
+  appendValue(vm, AS_STRING_BUILDER(args[-1]), args[0]);
+  push(vm, NIL_VAL);
+  return true;
+}
+
+static bool stringBuilderAppendAll(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 2, argCount)) {
+    return false;
+  }
+  if (!IS_LIST(args[0])) {
+    runtimeError(vm, "First argument must be a list.");
+    return false;
+  }
+  if (!IS_STRING(args[1])) {
+    runtimeError(vm, "Second argument must be a string.");
+    return false;
+  }
+  ObjStringBuilder* builder = AS_STRING_BUILDER(args[-1]);
+  ObjList* list = AS_LIST(args[0]);
+  ObjString* sep = AS_STRING(args[1]);
+  for (int i = 0; i < list->elements.count; ++i) {
+    if (i > 0) {
+      appendStringBuilder(&vm->gc, builder, sep->chars, sep->length);
+    }
+    appendValue(vm, builder, list->elements.values[i]);
+  }
+  push(vm, NIL_VAL);
+  return true;
+}
+
+static bool stringBuilderBuild(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 0, argCount)) {
+    return false;
+  }
+  ObjStringBuilder* builder = AS_STRING_BUILDER(args[-1]);
+  const char* chars = builder->chars ? builder->chars : "";
+  ObjString* string =
+      copyString(&vm->gc, &vm->strings, chars, builder->length);
+  push(vm, OBJ_VAL(string));
+  return true;
+}
+
+static bool stringBuilderSize(VM* vm, int argCount, Value* args) {
+  if (!checkArity(vm, 0, argCount)) {
+    return false;
+  }
+  ObjStringBuilder* builder = AS_STRING_BUILDER(args[-1]);
+  push(vm, NUMBER_VAL((double)builder->length));
   return true;
 }
 
-static void initStringClass(VM* vm) {
-  const char stringStr[] = "(String)";
-  ObjString* stringClassName = copyString(
-      &vm->gc, &vm->strings, stringStr, sizeof(stringStr) - 1);
-  pushTemp(&vm->gc, OBJ_VAL(stringClassName));
-  vm->stringClass = newClass(&vm->gc, stringClassName);
+static void initStringBuilderClass(VM* vm) {
+  const char builderStr[] = "(StringBuilder)";
+  ObjString* builderClassName = copyString(
+      &vm->gc, &vm->strings, builderStr, sizeof(builderStr) - 1);
+  pushTemp(&vm->gc, OBJ_VAL(builderClassName));
+  vm->stringBuilderClass = newClass(&vm->gc, builderClassName);
   popTemp(&vm->gc);
 
-  defineNativeMethod(vm, vm->stringClass, "parsenum", stringParseNum);
-  defineNativeMethod(vm, vm->stringClass, "size", stringSize);
-  defineNativeMethod(vm, vm->stringClass, "substr", stringSubstr);
+  defineNativeMethod(
+      vm, vm->stringBuilderClass, "append", stringBuilderAppend);
+  defineNativeMethod(
+      vm, vm->stringBuilderClass, "appendAll", stringBuilderAppendAll);
+  defineNativeMethod(
+      vm, vm->stringBuilderClass, "build", stringBuilderBuild);
+  defineNativeMethod(
+      vm, vm->stringBuilderClass, "size", stringBuilderSize);
 }
 
 void initVM(VM* vm, FILE* fout, FILE* ferr) {
@@ -581,14 +1286,19 @@ void initVM(VM* vm, FILE* fout, FILE* ferr) {
   initTable(&vm->strings, 0.75);
 
   vm->initString = NULL;
+  vm->reboundNatives = 0;
+  vm->float64ArrayClass = NULL;
   vm->listClass = NULL;
   vm->mapClass = NULL;
   vm->stringClass = NULL;
+  vm->stringBuilderClass = NULL;
 
   vm->initString = copyString(&vm->gc, &vm->strings, "init", 4);
+  initFloat64ArrayClass(vm);
   initListClass(vm);
   initMapClass(vm);
   initStringClass(vm);
+  initStringBuilderClass(vm);
 
   defineNative(vm, "argc", argcNative);
   defineNative(vm, "argv", argvNative);
@@ -597,9 +1307,13 @@ void initVM(VM* vm, FILE* fout, FILE* ferr) {
   defineNative(vm, "clock", clockNative);
   defineNative(vm, "eprint", eprintNative);
   defineNative(vm, "exit", exitNative);
+  defineNative(vm, "Float64Array", float64ArrayNative);
   defineNative(vm, "floor", floorNative);
+  defineNative(vm, "List", listNative);
+  defineNative(vm, "range", rangeNative);
   defineNative(vm, "round", roundNative);
   defineNative(vm, "str", strNative);
+  defineNative(vm, "StringBuilder", stringBuilderNative);
   defineNative(vm, "type", typeNative);
 }
 
@@ -640,6 +1354,23 @@ static Value peek(VM* vm, int distance) {
   return vm->stackTop[-1 - distance];
 }
 
+// Do a call to function without running its code if it allows that,
+// and return true, or return false if its code needs to run.
+static bool callInline(VM* vm, ObjFunction* function, int argCount) {
+  Value* slots = vm->stackTop - argCount - 1;
+  if (function->inlineKind == INLINE_GETTER) {
+    if (!IS_INSTANCE(slots[0]) ||
+        !tableGet(&AS_INSTANCE(slots[0])->fields,
+            AS_STRING(function->inlineValue), &slots[0])) {
+      return false;
+    }
+  } else {
+    slots[0] = function->inlineValue;
+  }
+  vm->stackTop = slots + 1;
+  return true;
+}
+
 static bool call(VM* vm, Obj* callable, int argCount) {
   ObjClosure* closure;
   ObjFunction* function;
@@ -656,6 +1387,10 @@ static bool call(VM* vm, Obj* callable, int argCount) {
   if (!checkArity(vm, function->arity, argCount)) {
     return false;
   }
+  if (function->inlineKind != INLINE_NONE &&
+      callInline(vm, function, argCount)) {
+    return true;
+  }
 
   // GCOV_EXCL_START
   if (vm->frameCount == FRAMES_MAX) {
@@ -727,10 +1462,14 @@ static bool invoke(VM* vm, ObjString* name, int argCount) {
 
   if (IS_LIST(receiver)) {
     klass = vm->listClass;
+  } else if (IS_FLOAT_ARRAY(receiver)) {
+    klass = vm->float64ArrayClass;
   } else if (IS_MAP(receiver)) {
     klass = vm->mapClass;
   } else if (IS_STRING(receiver)) {
     klass = vm->stringClass;
+  } else if (IS_STRING_BUILDER(receiver)) {
+    klass = vm->stringBuilderClass;
   } else if (IS_INSTANCE(receiver)) {
     ObjInstance* instance = AS_INSTANCE(receiver);
     Value value;
@@ -762,6 +1501,42 @@ static bool bindMethod(VM* vm, ObjClass* klass, ObjString* name) {
   return true;
 }
 
+// Replace the value on top of the stack with its property name. If the
+// property is a field and cache isn't NULL, store its value there too.
+static bool getProperty(VM* vm, ObjString* name, Value* cache) {
+  Value receiver = peek(vm, 0);
+  ObjClass* klass;
+
+  if (IS_LIST(receiver)) {
+    klass = vm->listClass;
+  } else if (IS_FLOAT_ARRAY(receiver)) {
+    klass = vm->float64ArrayClass;
+  } else if (IS_MAP(receiver)) {
+    klass = vm->mapClass;
+  } else if (IS_STRING(receiver)) {
+    klass = vm->stringClass;
+  } else if (IS_STRING_BUILDER(receiver)) {
+    klass = vm->stringBuilderClass;
+  } else if (IS_INSTANCE(receiver)) {
+    ObjInstance* instance = AS_INSTANCE(receiver);
+    Value value;
+    if (tableGet(&instance->fields, name, &value)) {
+      if (cache != NULL) {
+        *cache = value;
+      }
+      pop(vm); // Instance.
+      push(vm, value);
+      return true;
+    }
+    klass = instance->klass;
+  } else {
+    runtimeError(vm, "Only lists and instances have properties.");
+    return false;
+  }
+
+  return bindMethod(vm, klass, name);
+}
+
 static ObjUpvalue* captureUpvalue(VM* vm, Value* local) {
   ObjUpvalue* prevUpvalue = NULL;
   ObjUpvalue* upvalue = vm->openUpvalues;
@@ -803,10 +1578,6 @@ static void defineMethod(VM* vm, ObjString* name) {
   pop(vm);
 }
 
-static bool isFalsey(Value value) {
-  return IS_NIL(value) || (IS_BOOL(value) && !AS_BOOL(value));
-}
-
 static void concatenate(
     VM* vm, Value aValue, Value bValue, bool popTwice) {
   ObjString* b = AS_STRING(bValue);
@@ -820,6 +1591,159 @@ static void concatenate(
   push(vm, OBJ_VAL(result));
 }
 
+// Set the element of a list, Float64Array or map, or the field of an
+// instance, taking the target, key and value off the stack and pushing
+// the value. Return false after a runtime error.
+static bool setIndex(VM* vm) {
+  if (IS_LIST(peek(vm, 2))) {
+    if (!checkListIndex(vm, peek(vm, 2), peek(vm, 1))) {
+      return false;
+    }
+    Value value = pop(vm);
+    int index = (int)AS_NUMBER(pop(vm));
+    ObjList* list = AS_LIST(pop(vm));
+    list->elements.values[index] = value;
+    push(vm, value);
+    return true;
+  } else if (IS_FLOAT_ARRAY(peek(vm, 2))) {
+    ObjFloatArray* array = AS_FLOAT_ARRAY(peek(vm, 2));
+    if (!checkIndexBounds(
+            vm, "Float64Array index", array->count, peek(vm, 1))) {
+      return false;
+    }
+    if (!IS_NUMBER(peek(vm, 0))) {
+      runtimeError(vm, "Float64Array elements must be numbers.");
+      return false;
+    }
+    Value value = pop(vm);
+    int index = (int)AS_NUMBER(pop(vm));
+    pop(vm); // Array.
+    array->values[index] = AS_NUMBER(value);
+    push(vm, value);
+    return true;
+  } else if (IS_MAP(peek(vm, 2))) {
+    ObjMap* map = AS_MAP(peek(vm, 2));
+    dictSet(&vm->gc, &map->dict, peek(vm, 1), peek(vm, 0));
+    Value value = pop(vm);
+    pop(vm); // Key.
+    pop(vm); // Map.
+    push(vm, value);
+    return true;
+  } else if (IS_INSTANCE(peek(vm, 2))) {
+    if (!IS_STRING(peek(vm, 1))) {
+      runtimeError(vm, "Instances can only be indexed by string.");
+      return false;
+    }
+    ObjString* name = AS_STRING(peek(vm, 1));
+    ObjInstance* instance = AS_INSTANCE(peek(vm, 2));
+    tableSet(&vm->gc, &instance->fields, name, peek(vm, 0));
+    Value value = pop(vm);
+    pop(vm); // Name.
+    pop(vm); // Instance.
+    push(vm, value);
+    return true;
+  } else {
+    runtimeError(
+        vm, "Can only set index of lists, maps and instances.");
+  }
+  return false;
+}
+
+// Combine a and b the way the compound assignment op does, storing the
+// result in *result. Return false after a runtime error. Concatenating
+// strings allocates, so a and b must be reachable by the GC.
+static bool compoundOp(
+    VM* vm, uint8_t op, Value a, Value b, Value* result) {
+  if ((op == OP_ADD_PROPERTY || op == OP_ADD_INDEX) && IS_STRING(a) &&
+      IS_STRING(b)) {
+    ObjString* aString = AS_STRING(a);
+    ObjString* bString = AS_STRING(b);
+    *result = OBJ_VAL(concatStrings(&vm->gc, &vm->strings,
+        aString->chars, aString->length, aString->hash, bString->chars,
+        bString->length));
+    return true;
+  }
+  if (!IS_NUMBER(a) || !IS_NUMBER(b)) {
+    if (op == OP_ADD_PROPERTY || op == OP_ADD_INDEX) {
+      runtimeError(vm, "Operands must be two numbers or two strings.");
+    } else {
+      runtimeError(vm, "Operands must be numbers.");
+    }
+    return false;
+  }
+
+  double x = AS_NUMBER(a);
+  double y = AS_NUMBER(b);
+  switch (op) {
+    case OP_ADD_PROPERTY:
+    case OP_ADD_INDEX: *result = NUMBER_VAL(x + y); break;
+    case OP_SUBTRACT_PROPERTY:
+    case OP_SUBTRACT_INDEX: *result = NUMBER_VAL(x - y); break;
+    case OP_MULTIPLY_PROPERTY:
+    case OP_MULTIPLY_INDEX: *result = NUMBER_VAL(x * y); break;
+    case OP_DIVIDE_PROPERTY:
+    case OP_DIVIDE_INDEX: *result = NUMBER_VAL(x / y); break;
+    default: *result = NUMBER_VAL(fmod(x, y)); break;
+  }
+  return true;
+}
+
+// Store the element at the cursor of a for-in loop, or the cursor's
+// index/key and element if both is true, into vars, then advance the
+// cursor. Return false once the iterable is exhausted.
+static bool iterNext(
+    Value iterable, Value* cursor, Value* vars, bool both) {
+  Value key = *cursor;
+  Value value;
+
+  if (IS_RANGE(iterable)) {
+    // Ranges may be longer than an int can count.
+    ObjRange* range = AS_RANGE(iterable);
+    double count = AS_NUMBER(*cursor);
+    double num = range->start + count * range->step;
+    if (range->step > 0 ? !(num < range->end) : !(num > range->end)) {
+      return false;
+    }
+    value = NUMBER_VAL(num);
+    *cursor = NUMBER_VAL(count + 1);
+  } else {
+    int index = (int)AS_NUMBER(*cursor);
+    if (IS_LIST(iterable)) {
+      ValueArray* elements = &AS_LIST(iterable)->elements;
+      if (index >= elements->count) {
+        return false;
+      }
+      value = elements->values[index];
+    } else if (IS_MAP(iterable)) {
+      Dict* dict = &AS_MAP(iterable)->dict;
+      while (index < dict->entryCount &&
+             IS_EMPTY(dict->entries[index].key)) {
+        index++;
+      }
+      if (index >= dict->entryCount) {
+        return false;
+      }
+      key = dict->entries[index].key;
+      value = both ? dict->entries[index].value : key;
+    } else {
+      ObjString* string = AS_STRING(iterable);
+      if (index >= string->length) {
+        return false;
+      }
+      value = NUMBER_VAL((double)string->chars[index]);
+    }
+    *cursor = NUMBER_VAL((double)(index + 1));
+  }
+
+  if (both) {
+    vars[0] = key;
+    vars[1] = value;
+  } else {
+    vars[0] = value;
+  }
+  return true;
+}
+
 // GCOV_EXCL_START
 static void trace(VM* vm, CallFrame* frame) {
   fprintf(vm->ferr, "          ");
@@ -834,7 +1758,9 @@ static void trace(VM* vm, CallFrame* frame) {
 }
 // GCOV_EXCL_STOP
 
-static InterpretResult run(VM* vm) {
+// Run until the frame count drops back to baseFrame, or to zero when
+// the script finishes.
+static InterpretResult run(VM* vm, int baseFrame) {
   CallFrame* frame = &vm->frames[vm->frameCount - 1];
 
 #define READ_BYTE() (*frame->ip++)
@@ -846,6 +1772,9 @@ static InterpretResult run(VM* vm) {
   (frame->function->chunk.constants.values[READ_SHORT()])
 
 #define READ_STRING() AS_STRING(READ_CONSTANT())
+// The negated comparisons stand in for a comparison and OP_NOT, so
+// they're true for NaN operands, unlike the opposite comparison.
+#define NOT_BOOL_VAL(b) BOOL_VAL(!(b))
 #define BINARY_OP(valueType, op) \
   do { \
     if (!IS_NUMBER(peek(vm, 0)) || !IS_NUMBER(peek(vm, 1))) { \
@@ -867,6 +1796,44 @@ static InterpretResult run(VM* vm) {
     double a = AS_NUMBER(pop(vm)); \
     push(vm, valueType(a op b)); \
   } while (false)
+// The compiler only emits the _NN ops for operands it knows are
+// numbers, so they skip the checks.
+#define BINARY_OP_NN(valueType, op) \
+  do { \
+    double b = AS_NUMBER(pop(vm)); \
+    double a = AS_NUMBER(pop(vm)); \
+    push(vm, valueType(a op b)); \
+  } while (false)
+#define BINARY_OP_C_NN(valueType, op) \
+  do { \
+    double b = AS_NUMBER(READ_CONSTANT()); \
+    double a = AS_NUMBER(pop(vm)); \
+    push(vm, valueType(a op b)); \
+  } while (false)
+// Compare the local in the next slot with bValue, read next, and jump
+// if the result is jumpIf.
+#define COMPARE_JUMP(bValue, op, jumpIf) \
+  do { \
+    Value a = frame->slots[READ_BYTE()]; \
+    Value b = bValue; \
+    uint16_t offset = READ_SHORT(); \
+    if (!IS_NUMBER(a) || !IS_NUMBER(b)) { \
+      runtimeError(vm, "Operands must be numbers."); \
+      return INTERPRET_RUNTIME_ERROR; \
+    } \
+    if ((AS_NUMBER(a) op AS_NUMBER(b)) == jumpIf) { \
+      frame->ip += offset; \
+    } \
+  } while (false)
+#define EQUAL_JUMP(bValue, jumpIf) \
+  do { \
+    Value a = frame->slots[READ_BYTE()]; \
+    Value b = bValue; \
+    uint16_t offset = READ_SHORT(); \
+    if (valuesEqual(a, b) == jumpIf) { \
+      frame->ip += offset; \
+    } \
+  } while (false)
 
 #if THREADED_CODE == 1
 
@@ -877,30 +1844,62 @@ static InterpretResult run(VM* vm) {
     JUMP_ENTRY(OP_TRUE),
     JUMP_ENTRY(OP_FALSE),
     JUMP_ENTRY(OP_POP),
+    JUMP_ENTRY(OP_DUP),
     JUMP_ENTRY(OP_GET_LOCAL),
     JUMP_ENTRY(OP_SET_LOCAL),
+    JUMP_ENTRY(OP_SET_LOCAL_POP),
+    JUMP_ENTRY(OP_INC_LOCAL),
     JUMP_ENTRY(OP_GET_GLOBAL),
     JUMP_ENTRY(OP_GET_GLOBAL_I),
     JUMP_ENTRY(OP_DEFINE_GLOBAL),
+    JUMP_ENTRY(OP_DEFINE_GLOBAL_I),
     JUMP_ENTRY(OP_SET_GLOBAL),
     JUMP_ENTRY(OP_SET_GLOBAL_I),
+    JUMP_ENTRY(OP_SET_GLOBAL_I_POP),
     JUMP_ENTRY(OP_GET_UPVALUE),
     JUMP_ENTRY(OP_SET_UPVALUE),
     JUMP_ENTRY(OP_GET_PROPERTY),
+    JUMP_ENTRY(OP_HOIST_PROPERTY),
+    JUMP_ENTRY(OP_GET_HOISTED),
     JUMP_ENTRY(OP_SET_PROPERTY),
+    JUMP_ENTRY(OP_GET_PROPERTY_KEEP),
+    JUMP_ENTRY(OP_ADD_PROPERTY),
+    JUMP_ENTRY(OP_SUBTRACT_PROPERTY),
+    JUMP_ENTRY(OP_MULTIPLY_PROPERTY),
+    JUMP_ENTRY(OP_DIVIDE_PROPERTY),
+    JUMP_ENTRY(OP_MODULO_PROPERTY),
     JUMP_ENTRY(OP_GET_INDEX),
     JUMP_ENTRY(OP_SET_INDEX),
+    JUMP_ENTRY(OP_GET_INDEX_KEEP),
+    JUMP_ENTRY(OP_ADD_INDEX),
+    JUMP_ENTRY(OP_SUBTRACT_INDEX),
+    JUMP_ENTRY(OP_MULTIPLY_INDEX),
+    JUMP_ENTRY(OP_DIVIDE_INDEX),
+    JUMP_ENTRY(OP_MODULO_INDEX),
     JUMP_ENTRY(OP_GET_SUPER),
     JUMP_ENTRY(OP_EQUAL),
+    JUMP_ENTRY(OP_NOT_EQUAL),
     JUMP_ENTRY(OP_GREATER),
+    JUMP_ENTRY(OP_GREATER_NN),
+    JUMP_ENTRY(OP_NOT_GREATER),
     JUMP_ENTRY(OP_LESS),
+    JUMP_ENTRY(OP_LESS_NN),
+    JUMP_ENTRY(OP_NOT_LESS),
     JUMP_ENTRY(OP_LESS_C),
+    JUMP_ENTRY(OP_LESS_C_NN),
+    JUMP_ENTRY(OP_NOT_LESS_C),
     JUMP_ENTRY(OP_ADD),
+    JUMP_ENTRY(OP_ADD_NN),
     JUMP_ENTRY(OP_ADD_C),
+    JUMP_ENTRY(OP_ADD_C_NN),
     JUMP_ENTRY(OP_SUBTRACT),
+    JUMP_ENTRY(OP_SUBTRACT_NN),
     JUMP_ENTRY(OP_SUBTRACT_C),
+    JUMP_ENTRY(OP_SUBTRACT_C_NN),
     JUMP_ENTRY(OP_MULTIPLY),
+    JUMP_ENTRY(OP_MULTIPLY_NN),
     JUMP_ENTRY(OP_DIVIDE),
+    JUMP_ENTRY(OP_DIVIDE_NN),
     JUMP_ENTRY(OP_MODULO),
     JUMP_ENTRY(OP_NOT),
     JUMP_ENTRY(OP_NEGATE),
@@ -908,24 +1907,43 @@ static InterpretResult run(VM* vm) {
     JUMP_ENTRY(OP_JUMP),
     JUMP_ENTRY(OP_JUMP_IF_FALSE),
     JUMP_ENTRY(OP_PJMP_IF_FALSE),
+    JUMP_ENTRY(OP_JUMP_IF_LESS_LC),
+    JUMP_ENTRY(OP_JUMP_IF_NOT_LESS_LC),
+    JUMP_ENTRY(OP_JUMP_IF_GREATER_LC),
+    JUMP_ENTRY(OP_JUMP_IF_NOT_GREATER_LC),
+    JUMP_ENTRY(OP_JUMP_IF_EQUAL_LC),
+    JUMP_ENTRY(OP_JUMP_IF_NOT_EQUAL_LC),
+    JUMP_ENTRY(OP_JUMP_IF_LESS_LL),
+    JUMP_ENTRY(OP_JUMP_IF_NOT_LESS_LL),
+    JUMP_ENTRY(OP_JUMP_IF_EQUAL_LL),
+    JUMP_ENTRY(OP_JUMP_IF_NOT_EQUAL_LL),
     JUMP_ENTRY(OP_LOOP),
     JUMP_ENTRY(OP_CALL),
     JUMP_ENTRY(OP_INVOKE),
     JUMP_ENTRY(OP_SUPER_INVOKE),
     JUMP_ENTRY(OP_CLOSURE),
     JUMP_ENTRY(OP_CLOSE_UPVALUE),
-    JUMP_ENTRY(OP_LIST_INIT),
+    JUMP_ENTRY(OP_LIST_BUILD),
     JUMP_ENTRY(OP_LIST_DATA),
-    JUMP_ENTRY(OP_MAP_INIT),
+    JUMP_ENTRY(OP_LIST_TEMPLATE),
+    JUMP_ENTRY(OP_MAP_BUILD),
     JUMP_ENTRY(OP_MAP_DATA),
+    JUMP_ENTRY(OP_MAP_TEMPLATE),
+    JUMP_ENTRY(OP_ITER_INIT),
+    JUMP_ENTRY(OP_ITER_NEXT),
     JUMP_ENTRY(OP_RETURN),
     JUMP_ENTRY(OP_CLASS),
     JUMP_ENTRY(OP_INHERIT),
     JUMP_ENTRY(OP_METHOD),
   };
 #undef JUMP_ENTRY
-  for (size_t i = 0; i < MAX_OPCODES; ++i) {
-    assert(jumps[i] != NULL); // GCOV_EXCL_LINE
+  // Natives call back into run(), so only check the table once.
+  static bool jumpsChecked = false;
+  if (!jumpsChecked) {
+    for (size_t i = 0; i < MAX_OPCODES; ++i) {
+      assert(jumps[i] != NULL); // GCOV_EXCL_LINE
+    }
+    jumpsChecked = true;
   }
 #define FOR(c)
 #define SWITCH(c) NEXT;
@@ -981,6 +1999,10 @@ static InterpretResult run(VM* vm) {
         pop(vm);
         NEXT;
       }
+      CASE(OP_DUP) {
+        push(vm, peek(vm, 0));
+        NEXT;
+      }
       CASE(OP_GET_LOCAL) {
         uint8_t slot = READ_BYTE();
         push(vm, frame->slots[slot]);
@@ -991,22 +2013,38 @@ static InterpretResult run(VM* vm) {
         frame->slots[slot] = peek(vm, 0);
         NEXT;
       }
+      CASE(OP_SET_LOCAL_POP) {
+        uint8_t slot = READ_BYTE();
+        frame->slots[slot] = pop(vm);
+        NEXT;
+      }
+      CASE(OP_INC_LOCAL) {
+        // The compiler only emits this for locals holding numbers.
+        uint8_t slot = READ_BYTE();
+        double step = AS_NUMBER(READ_CONSTANT());
+        frame->slots[slot] =
+            NUMBER_VAL(AS_NUMBER(frame->slots[slot]) + step);
+        NEXT;
+      }
       CASE(OP_GET_GLOBAL) {
         ObjString* name = READ_STRING();
         Value slot;
-        if (!tableGet(&vm->globals, name, &slot)) {
+        if (!tableGet(&vm->globals, name, &slot) ||
+            IS_EMPTY(vm->globalSlots.values[(int)AS_NUMBER(slot)])) {
           runtimeError(vm, "Undefined variable '%s'.", name->chars);
           return INTERPRET_RUNTIME_ERROR;
         }
-        uint16_t slotInt = (uint16_t)AS_NUMBER(slot);
-        frame->ip[-3] = OP_GET_GLOBAL_I;
-        frame->ip[-2] = (uint8_t)(slotInt >> 8);
-        frame->ip[-1] = (uint8_t)(slotInt & 0xff);
-        frame->ip -= 3;
+        push(vm, vm->globalSlots.values[(int)AS_NUMBER(slot)]);
         NEXT;
       }
       CASE(OP_GET_GLOBAL_I) {
-        push(vm, vm->globalSlots.values[READ_SHORT()]);
+        uint16_t slot = READ_SHORT();
+        Value value = vm->globalSlots.values[slot];
+        if (IS_EMPTY(value)) {
+          undefinedGlobal(vm, slot);
+          return INTERPRET_RUNTIME_ERROR;
+        }
+        push(vm, value);
         NEXT;
       }
       CASE(OP_DEFINE_GLOBAL) {
@@ -1022,30 +2060,45 @@ static InterpretResult run(VM* vm) {
           }
           // GCOV_EXCL_STOP
           writeValueArray(&vm->gc, &vm->globalSlots, peek(vm, 0));
-          pop(vm);
           slot = NUMBER_VAL((double)newSlot);
           tableSet(&vm->gc, &vm->globals, name, slot);
         } else {
           vm->globalSlots.values[(int)AS_NUMBER(slot)] = peek(vm, 0);
         }
+        pop(vm);
+        NEXT;
+      }
+      CASE(OP_DEFINE_GLOBAL_I) {
+        vm->globalSlots.values[READ_SHORT()] = pop(vm);
         NEXT;
       }
       CASE(OP_SET_GLOBAL) {
         ObjString* name = READ_STRING();
         Value slot;
-        if (!tableGet(&vm->globals, name, &slot)) {
+        if (!tableGet(&vm->globals, name, &slot) ||
+            IS_EMPTY(vm->globalSlots.values[(int)AS_NUMBER(slot)])) {
           runtimeError(vm, "Undefined variable '%s'.", name->chars);
           return INTERPRET_RUNTIME_ERROR;
         }
-        uint16_t slotInt = (uint16_t)AS_NUMBER(slot);
-        frame->ip[-3] = OP_SET_GLOBAL_I;
-        frame->ip[-2] = (uint8_t)(slotInt >> 8);
-        frame->ip[-1] = (uint8_t)(slotInt & 0xff);
-        frame->ip -= 3;
+        vm->globalSlots.values[(int)AS_NUMBER(slot)] = peek(vm, 0);
         NEXT;
       }
       CASE(OP_SET_GLOBAL_I) {
-        vm->globalSlots.values[READ_SHORT()] = peek(vm, 0);
+        uint16_t slot = READ_SHORT();
+        if (IS_EMPTY(vm->globalSlots.values[slot])) {
+          undefinedGlobal(vm, slot);
+          return INTERPRET_RUNTIME_ERROR;
+        }
+        vm->globalSlots.values[slot] = peek(vm, 0);
+        NEXT;
+      }
+      CASE(OP_SET_GLOBAL_I_POP) {
+        uint16_t slot = READ_SHORT();
+        if (IS_EMPTY(vm->globalSlots.values[slot])) {
+          undefinedGlobal(vm, slot);
+          return INTERPRET_RUNTIME_ERROR;
+        }
+        vm->globalSlots.values[slot] = pop(vm);
         NEXT;
       }
       CASE(OP_GET_UPVALUE) {
@@ -1059,35 +2112,28 @@ static InterpretResult run(VM* vm) {
         NEXT;
       }
       CASE(OP_GET_PROPERTY) {
-        ObjString* name = READ_STRING();
-        Value receiver = peek(vm, 0);
-        ObjClass* klass;
-
-        if (IS_LIST(receiver)) {
-          klass = vm->listClass;
-        } else if (IS_MAP(receiver)) {
-          klass = vm->mapClass;
-        } else if (IS_STRING(receiver)) {
-          klass = vm->stringClass;
-        } else if (IS_INSTANCE(receiver)) {
-          ObjInstance* instance = AS_INSTANCE(peek(vm, 0));
-          Value value;
-          if (tableGet(&instance->fields, name, &value)) {
-            pop(vm); // Instance.
-            push(vm, value);
-            NEXT;
-          }
-          klass = instance->klass;
-        } else {
-          runtimeError(vm, "Only lists and instances have properties.");
+        if (!getProperty(vm, READ_STRING(), NULL)) {
           return INTERPRET_RUNTIME_ERROR;
         }
-
-        if (!bindMethod(vm, klass, name)) {
+        NEXT;
+      }
+      CASE(OP_HOIST_PROPERTY) {
+        ObjString* name = READ_STRING();
+        uint8_t slot = READ_BYTE();
+        if (!getProperty(vm, name, &frame->slots[slot])) {
           return INTERPRET_RUNTIME_ERROR;
         }
         NEXT;
       }
+      CASE(OP_GET_HOISTED) {
+        uint8_t slot = READ_BYTE();
+        uint16_t offset = READ_SHORT();
+        if (!IS_NIL(frame->slots[slot])) {
+          push(vm, frame->slots[slot]);
+          frame->ip += offset;
+        }
+        NEXT;
+      }
       CASE(OP_SET_PROPERTY) {
         if (!IS_INSTANCE(peek(vm, 1))) {
           runtimeError(vm, "Only instances have fields.");
@@ -1102,6 +2148,41 @@ static InterpretResult run(VM* vm) {
         push(vm, value);
         NEXT;
       }
+      CASE(OP_GET_PROPERTY_KEEP) {
+        ObjString* name = READ_STRING();
+        if (!IS_INSTANCE(peek(vm, 0))) {
+          runtimeError(vm, "Only instances have fields.");
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        ObjInstance* instance = AS_INSTANCE(peek(vm, 0));
+        Value value;
+        if (!tableGet(&instance->fields, name, &value)) {
+          runtimeError(vm, "Undefined property '%s'.", name->chars);
+          return INTERPRET_RUNTIME_ERROR;
+        }
+        push(vm, value);
+        NEXT;
+      }
+      CASE(OP_ADD_PROPERTY)
+      CASE(OP_SUBTRACT_PROPERTY)
+      CASE(OP_MULTIPLY_PROPERTY)
+      CASE(OP_DIVIDE_PROPERTY)
+      CASE(OP_MODULO_PROPERTY) {
+        // The instance and field value come from OP_GET_PROPERTY_KEEP.
+        uint8_t op = frame->ip[-1];
+        ObjString* name = READ_STRING();
+        Value result;
+        if (!compoundOp(vm, op, peek(vm, 1), peek(vm, 0), &result)) {
+          return INTERPRET_RUNTIME_ERROR;
+        }
+        vm->stackTop[-1] = result; // Keep it reachable.
+        ObjInstance* instance = AS_INSTANCE(peek(vm, 2));
+        tableSet(&vm->gc, &instance->fields, name, result);
+        vm->stackTop -= 3;
+        push(vm, result);
+        NEXT;
+      }
       CASE(OP_GET_INDEX) {
         if (IS_LIST(peek(vm, 1))) {
           if (!checkListIndex(vm, peek(vm, 1), peek(vm, 0))) {
@@ -1111,21 +2192,26 @@ static InterpretResult run(VM* vm) {
           ObjList* list = AS_LIST(pop(vm));
           push(vm, list->elements.values[index]);
           NEXT;
-        } else if (IS_MAP(peek(vm, 1))) {
-          if (!IS_STRING(peek(vm, 0))) {
-            runtimeError(vm, "Maps can only be indexed by string.");
+        } else if (IS_FLOAT_ARRAY(peek(vm, 1))) {
+          ObjFloatArray* array = AS_FLOAT_ARRAY(peek(vm, 1));
+          if (!checkIndexBounds(vm, "Float64Array index",
+                  array->count, peek(vm, 0))) {
             return INTERPRET_RUNTIME_ERROR;
           }
-          ObjString* key = AS_STRING(peek(vm, 0));
+          int index = (int)AS_NUMBER(pop(vm));
+          pop(vm); // Array.
+          push(vm, NUMBER_VAL(array->values[index]));
+          NEXT;
+        } else if (IS_MAP(peek(vm, 1))) {
           ObjMap* map = AS_MAP(peek(vm, 1));
           Value value;
-          if (tableGet(&map->table, key, &value)) {
+          if (dictGet(&map->dict, peek(vm, 0), &value)) {
             pop(vm); // Key.
             pop(vm); // Map.
             push(vm, value);
             NEXT;
           }
-          runtimeError(vm, "Undefined key '%s'.", key->chars);
+          undefinedKeyError(vm, peek(vm, 0));
         } else if (IS_STRING(peek(vm, 1))) {
           ObjString* string = AS_STRING(peek(vm, 1));
           if (!checkStringIndex(vm, string, peek(vm, 0))) {
@@ -1159,48 +2245,74 @@ static InterpretResult run(VM* vm) {
         return INTERPRET_RUNTIME_ERROR;
       }
       CASE(OP_SET_INDEX) {
-        if (IS_LIST(peek(vm, 2))) {
-          if (!checkListIndex(vm, peek(vm, 2), peek(vm, 1))) {
+        if (!setIndex(vm)) {
+          return INTERPRET_RUNTIME_ERROR;
+        }
+        NEXT;
+      }
+      CASE(OP_GET_INDEX_KEEP) {
+        Value target = peek(vm, 1);
+        Value key = peek(vm, 0);
+        Value* element;
+        if (IS_LIST(target)) {
+          if (!checkListIndex(vm, target, key)) {
             return INTERPRET_RUNTIME_ERROR;
           }
-          Value value = pop(vm);
-          int index = (int)AS_NUMBER(pop(vm));
-          ObjList* list = AS_LIST(pop(vm));
-          list->elements.values[index] = value;
-          push(vm, value);
-          NEXT;
-        } else if (IS_MAP(peek(vm, 2))) {
-          if (!IS_STRING(peek(vm, 1))) {
-            runtimeError(vm, "Maps can only be indexed by string.");
+          ObjList* list = AS_LIST(target);
+          element = &list->elements.values[(int)AS_NUMBER(key)];
+        } else if (IS_FLOAT_ARRAY(target)) {
+          ObjFloatArray* array = AS_FLOAT_ARRAY(target);
+          if (!checkIndexBounds(
+                  vm, "Float64Array index", array->count, key)) {
             return INTERPRET_RUNTIME_ERROR;
           }
-          ObjString* key = AS_STRING(peek(vm, 1));
-          ObjMap* map = AS_MAP(peek(vm, 2));
-          tableSet(&vm->gc, &map->table, key, peek(vm, 0));
-          Value value = pop(vm);
-          pop(vm); // Key.
-          pop(vm); // Map.
-          push(vm, value);
+          push(vm, NUMBER_VAL(array->values[(int)AS_NUMBER(key)]));
           NEXT;
-        } else if (IS_INSTANCE(peek(vm, 2))) {
-          if (!IS_STRING(peek(vm, 1))) {
+        } else if (IS_MAP(target)) {
+          element = dictFind(&AS_MAP(target)->dict, key);
+          if (element == NULL) {
+            undefinedKeyError(vm, key);
+            return INTERPRET_RUNTIME_ERROR;
+          }
+        } else if (IS_INSTANCE(target)) {
+          if (!IS_STRING(key)) {
             runtimeError(
                 vm, "Instances can only be indexed by string.");
             return INTERPRET_RUNTIME_ERROR;
           }
-          ObjString* name = AS_STRING(peek(vm, 1));
-          ObjInstance* instance = AS_INSTANCE(peek(vm, 2));
-          tableSet(&vm->gc, &instance->fields, name, peek(vm, 0));
-          Value value = pop(vm);
-          pop(vm); // Name.
-          pop(vm); // Instance.
-          push(vm, value);
-          NEXT;
+          ObjString* name = AS_STRING(key);
+          element = tableFind(&AS_INSTANCE(target)->fields, name);
+          if (element == NULL) {
+            runtimeError(vm, "Undefined property '%s'.", name->chars);
+            return INTERPRET_RUNTIME_ERROR;
+          }
         } else {
           runtimeError(
               vm, "Can only set index of lists, maps and instances.");
+          return INTERPRET_RUNTIME_ERROR;
         }
-        return INTERPRET_RUNTIME_ERROR;
+        push(vm, *element);
+        NEXT;
+      }
+      CASE(OP_ADD_INDEX)
+      CASE(OP_SUBTRACT_INDEX)
+      CASE(OP_MULTIPLY_INDEX)
+      CASE(OP_DIVIDE_INDEX)
+      CASE(OP_MODULO_INDEX) {
+        // The target, key and element come from OP_GET_INDEX_KEEP. The
+        // right-hand side may have changed the target, so the store is
+        // checked again.
+        uint8_t op = frame->ip[-1];
+        Value result;
+        if (!compoundOp(vm, op, peek(vm, 1), peek(vm, 0), &result)) {
+          return INTERPRET_RUNTIME_ERROR;
+        }
+        vm->stackTop[-2] = result;
+        vm->stackTop--;
+        if (!setIndex(vm)) {
+          return INTERPRET_RUNTIME_ERROR;
+        }
+        NEXT;
       }
       CASE(OP_GET_SUPER) {
         ObjString* name = READ_STRING();
@@ -1217,18 +2329,48 @@ static InterpretResult run(VM* vm) {
         push(vm, BOOL_VAL(valuesEqual(a, b)));
         NEXT;
       }
+      CASE(OP_NOT_EQUAL) {
+        Value b = pop(vm);
+        Value a = pop(vm);
+        push(vm, BOOL_VAL(!valuesEqual(a, b)));
+        NEXT;
+      }
       CASE(OP_GREATER) {
         BINARY_OP(BOOL_VAL, >);
         NEXT;
       }
+      CASE(OP_GREATER_NN) {
+        BINARY_OP_NN(BOOL_VAL, >);
+        NEXT;
+      }
+      CASE(OP_NOT_GREATER) {
+        BINARY_OP(NOT_BOOL_VAL, >);
+        NEXT;
+      }
       CASE(OP_LESS) {
         BINARY_OP(BOOL_VAL, <);
         NEXT;
       }
+      CASE(OP_LESS_NN) {
+        BINARY_OP_NN(BOOL_VAL, <);
+        NEXT;
+      }
+      CASE(OP_NOT_LESS) {
+        BINARY_OP(NOT_BOOL_VAL, <);
+        NEXT;
+      }
       CASE(OP_LESS_C) {
         BINARY_OP_C(BOOL_VAL, <);
         NEXT;
       }
+      CASE(OP_LESS_C_NN) {
+        BINARY_OP_C_NN(BOOL_VAL, <);
+        NEXT;
+      }
+      CASE(OP_NOT_LESS_C) {
+        BINARY_OP_C(NOT_BOOL_VAL, <);
+        NEXT;
+      }
       CASE(OP_ADD) {
         Value bValue = peek(vm, 0);
         Value aValue = peek(vm, 1);
@@ -1247,6 +2389,10 @@ static InterpretResult run(VM* vm) {
         }
         NEXT;
       }
+      CASE(OP_ADD_NN) {
+        BINARY_OP_NN(NUMBER_VAL, +);
+        NEXT;
+      }
       CASE(OP_ADD_C) {
         Value bValue = READ_CONSTANT();
         Value aValue = peek(vm, 0);
@@ -1264,22 +2410,42 @@ static InterpretResult run(VM* vm) {
         }
         NEXT;
       }
+      CASE(OP_ADD_C_NN) {
+        BINARY_OP_C_NN(NUMBER_VAL, +);
+        NEXT;
+      }
       CASE(OP_SUBTRACT) {
         BINARY_OP(NUMBER_VAL, -);
         NEXT;
       }
+      CASE(OP_SUBTRACT_NN) {
+        BINARY_OP_NN(NUMBER_VAL, -);
+        NEXT;
+      }
       CASE(OP_SUBTRACT_C) {
         BINARY_OP_C(NUMBER_VAL, -);
         NEXT;
       }
+      CASE(OP_SUBTRACT_C_NN) {
+        BINARY_OP_C_NN(NUMBER_VAL, -);
+        NEXT;
+      }
       CASE(OP_MULTIPLY) {
         BINARY_OP(NUMBER_VAL, *);
         NEXT;
       }
+      CASE(OP_MULTIPLY_NN) {
+        BINARY_OP_NN(NUMBER_VAL, *);
+        NEXT;
+      }
       CASE(OP_DIVIDE) {
         BINARY_OP(NUMBER_VAL, /);
         NEXT;
       }
+      CASE(OP_DIVIDE_NN) {
+        BINARY_OP_NN(NUMBER_VAL, /);
+        NEXT;
+      }
       CASE(OP_MODULO) {
         if (!IS_NUMBER(peek(vm, 0)) || !IS_NUMBER(peek(vm, 1))) {
           runtimeError(vm, "Operands must be numbers.");
@@ -1304,7 +2470,7 @@ static InterpretResult run(VM* vm) {
       }
       CASE(OP_PRINT) {
         printValue(vm->fout, pop(vm));
-        fprintf(vm->fout, "\n");
+        fputc('\n', vm->fout);
         NEXT;
       }
       CASE(OP_JUMP) {
@@ -1327,6 +2493,46 @@ static InterpretResult run(VM* vm) {
         pop(vm);
         NEXT;
       }
+      CASE(OP_JUMP_IF_LESS_LC) {
+        COMPARE_JUMP(READ_CONSTANT(), <, true);
+        NEXT;
+      }
+      CASE(OP_JUMP_IF_NOT_LESS_LC) {
+        COMPARE_JUMP(READ_CONSTANT(), <, false);
+        NEXT;
+      }
+      CASE(OP_JUMP_IF_GREATER_LC) {
+        COMPARE_JUMP(READ_CONSTANT(), >, true);
+        NEXT;
+      }
+      CASE(OP_JUMP_IF_NOT_GREATER_LC) {
+        COMPARE_JUMP(READ_CONSTANT(), >, false);
+        NEXT;
+      }
+      CASE(OP_JUMP_IF_EQUAL_LC) {
+        EQUAL_JUMP(READ_CONSTANT(), true);
+        NEXT;
+      }
+      CASE(OP_JUMP_IF_NOT_EQUAL_LC) {
+        EQUAL_JUMP(READ_CONSTANT(), false);
+        NEXT;
+      }
+      CASE(OP_JUMP_IF_LESS_LL) {
+        COMPARE_JUMP(frame->slots[READ_BYTE()], <, true);
+        NEXT;
+      }
+      CASE(OP_JUMP_IF_NOT_LESS_LL) {
+        COMPARE_JUMP(frame->slots[READ_BYTE()], <, false);
+        NEXT;
+      }
+      CASE(OP_JUMP_IF_EQUAL_LL) {
+        EQUAL_JUMP(frame->slots[READ_BYTE()], true);
+        NEXT;
+      }
+      CASE(OP_JUMP_IF_NOT_EQUAL_LL) {
+        EQUAL_JUMP(frame->slots[READ_BYTE()], false);
+        NEXT;
+      }
       CASE(OP_LOOP) {
         uint16_t offset = READ_SHORT();
         frame->ip -= offset;
@@ -1380,38 +2586,100 @@ static InterpretResult run(VM* vm) {
         pop(vm);
         NEXT;
       }
-      CASE(OP_LIST_INIT) {
-        push(vm, OBJ_VAL(newList(&vm->gc)));
+      CASE(OP_LIST_BUILD) {
+        int count = READ_BYTE();
+        ObjList* list = newList(&vm->gc);
+        pushTemp(&vm->gc, OBJ_VAL(list));
+        reserveValueArray(&vm->gc, &list->elements, count);
+        popTemp(&vm->gc);
+        vm->stackTop -= count;
+        if (count > 0) {
+          memcpy(list->elements.values, vm->stackTop,
+              sizeof(Value) * (size_t)count);
+        }
+        list->elements.count = count;
+        push(vm, OBJ_VAL(list));
         NEXT;
       }
       CASE(OP_LIST_DATA) {
-        if (!IS_LIST(peek(vm, 1))) {
+        int count = READ_BYTE();
+        if (!IS_LIST(peek(vm, count))) {
           runtimeError(vm, "List data can only be added to a list.");
           return INTERPRET_RUNTIME_ERROR;
         }
-        ObjList* list = AS_LIST(peek(vm, 1));
-        writeValueArray(&vm->gc, &list->elements, peek(vm, 0));
-        pop(vm);
+        ValueArray* elements = &AS_LIST(peek(vm, count))->elements;
+        growValueArray(&vm->gc, elements, count);
+        vm->stackTop -= count;
+        memcpy(&elements->values[elements->count], vm->stackTop,
+            sizeof(Value) * (size_t)count);
+        elements->count += count;
         NEXT;
       }
-      CASE(OP_MAP_INIT) {
-        push(vm, OBJ_VAL(newMap(&vm->gc)));
+      CASE(OP_LIST_TEMPLATE) {
+        ValueArray* template = &AS_LIST(READ_CONSTANT())->elements;
+        ObjList* list = newList(&vm->gc);
+        push(vm, OBJ_VAL(list));
+        reserveValueArray(&vm->gc, &list->elements, template->count);
+        memcpy(list->elements.values, template->values,
+            sizeof(Value) * (size_t)template->count);
+        list->elements.count = template->count;
+        NEXT;
+      }
+      CASE(OP_MAP_BUILD) {
+        int count = READ_BYTE();
+        ObjMap* map = newMap(&vm->gc);
+        pushTemp(&vm->gc, OBJ_VAL(map));
+        dictReserve(&vm->gc, &map->dict, count);
+        popTemp(&vm->gc);
+        Value* pairs = vm->stackTop - count * 2;
+        for (int i = 0; i < count * 2; i += 2) {
+          dictSet(&vm->gc, &map->dict, pairs[i], pairs[i + 1]);
+        }
+        vm->stackTop = pairs;
+        push(vm, OBJ_VAL(map));
         NEXT;
       }
       CASE(OP_MAP_DATA) {
-        if (!IS_MAP(peek(vm, 2))) {
+        int count = READ_BYTE();
+        if (!IS_MAP(peek(vm, count * 2))) {
           runtimeError(vm, "Map data can only be added to a map.");
           return INTERPRET_RUNTIME_ERROR;
         }
-        if (!IS_STRING(peek(vm, 1))) {
-          runtimeError(vm, "Map key must be a string.");
+        Dict* dict = &AS_MAP(peek(vm, count * 2))->dict;
+        dictReserve(&vm->gc, dict, dict->count + count);
+        Value* pairs = vm->stackTop - count * 2;
+        for (int i = 0; i < count * 2; i += 2) {
+          dictSet(&vm->gc, dict, pairs[i], pairs[i + 1]);
+        }
+        vm->stackTop = pairs;
+        NEXT;
+      }
+      CASE(OP_MAP_TEMPLATE) {
+        ObjMap* template = AS_MAP(READ_CONSTANT());
+        ObjMap* map = newMap(&vm->gc);
+        push(vm, OBJ_VAL(map));
+        dictAddAll(&vm->gc, &template->dict, &map->dict);
+        NEXT;
+      }
+      CASE(OP_ITER_INIT) {
+        Value iterable = peek(vm, 0);
+        if (!IS_LIST(iterable) && !IS_MAP(iterable) &&
+            !IS_STRING(iterable) && !IS_RANGE(iterable)) {
+          runtimeError(vm,
+              "Can only iterate over lists, maps, strings and ranges.");
           return INTERPRET_RUNTIME_ERROR;
         }
-        ObjMap* map = AS_MAP(peek(vm, 2));
-        ObjString* key = AS_STRING(peek(vm, 1));
-        tableSet(&vm->gc, &map->table, key, peek(vm, 0));
-        pop(vm); // Value.
-        pop(vm); // Key.
+        push(vm, NUMBER_VAL(0)); // Cursor.
+        NEXT;
+      }
+      CASE(OP_ITER_NEXT) {
+        Value* vars = &frame->slots[READ_BYTE()];
+        bool both = READ_BYTE() == 2;
+        uint16_t offset = READ_SHORT();
+        // The iterable and cursor are just below the loop variables.
+        if (!iterNext(vars[-2], &vars[-1], vars, both)) {
+          frame->ip += offset;
+        }
         NEXT;
       }
       CASE(OP_RETURN) {
@@ -1425,6 +2693,9 @@ static InterpretResult run(VM* vm) {
 
         vm->stackTop = frame->slots;
         push(vm, result);
+        if (vm->frameCount == baseFrame) {
+          return INTERPRET_OK;
+        }
         frame = &vm->frames[vm->frameCount - 1];
         NEXT;
       }
@@ -1467,16 +2738,36 @@ static InterpretResult run(VM* vm) {
 #undef READ_SHORT
 #undef READ_STRING
 #undef BINARY_OP
+#undef BINARY_OP_C
+#undef BINARY_OP_NN
+#undef BINARY_OP_C_NN
+#undef COMPARE_JUMP
+#undef EQUAL_JUMP
+#undef NOT_BOOL_VAL
+}
+
+// Call callee with the arguments above it on the stack from inside a
+// native, leaving the result in their place.
+static bool callFromNative(VM* vm, Value callee, int argCount) {
+  int baseFrame = vm->frameCount;
+  if (!callValue(vm, callee, argCount)) {
+    return false;
+  }
+  if (vm->frameCount == baseFrame) {
+    return true; // A native or a class without an initializer.
+  }
+  return run(vm, baseFrame) == INTERPRET_OK;
 }
 
 InterpretResult interpretCall(VM* vm, Obj* callable, int argCount) {
   call(vm, callable, argCount);
-  return run(vm);
+  return run(vm, 0);
 }
 
 InterpretResult interpret(VM* vm, const char* source) {
   ObjFunction* function =
-      compile(vm->fout, vm->ferr, source, &vm->gc, &vm->strings);
+      compile(vm->fout, vm->ferr, source, &vm->gc, &vm->strings,
+          &vm->globals, &vm->globalSlots, &vm->reboundNatives);
   if (function == NULL) {
     return INTERPRET_COMPILE_ERROR;
   }
@@ -1484,5 +2775,5 @@ InterpretResult interpret(VM* vm, const char* source) {
   push(vm, OBJ_VAL(function));
   call(vm, (Obj*)function, 0);
 
-  return run(vm);
+  return run(vm, 0);
 }
@@ -34,10 +34,13 @@ typedef struct {
   Table strings;
   ObjString* initString;
   ObjUpvalue* openUpvalues;
+  int reboundNatives; // See compile().
 
+  ObjClass* float64ArrayClass;
   ObjClass* listClass;
   ObjClass* mapClass;
   ObjClass* stringClass;
+  ObjClass* stringBuilderClass;
 
   GC gc;
 } VM;
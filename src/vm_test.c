@@ -1,6 +1,7 @@
 #include "vm.h"
 
 #include <assert.h>
+#include <math.h>
 #include <string.h>
 
 #include "utest.h"
@@ -342,6 +343,15 @@ VMCase opPop[] = {
 
 VM_TEST(OpPop, opPop, 1);
 
+VMCase opDup[] = {
+  { INTERPRET_OK, "1\n1\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_DUP, OP_PRINT, OP_PRINT,
+          OP_NIL, OP_RETURN),
+      LIST(Lit, N(1.0)) },
+};
+
+VM_TEST(OpDup, opDup, 1);
+
 VMCase opLocals[] = {
   { INTERPRET_OK, "false\ntrue\nfalse\ntrue\n", LIST(LitFun),
       LIST(uint8_t, OP_TRUE, OP_FALSE, OP_GET_LOCAL, 1, OP_GET_LOCAL, 2,
@@ -355,6 +365,15 @@ VMCase opLocals[] = {
 
 VM_TEST(OpLocals, opLocals, 2);
 
+VMCase opSetLocalPop[] = {
+  { INTERPRET_OK, "true\n", LIST(LitFun),
+      LIST(uint8_t, OP_FALSE, OP_TRUE, OP_SET_LOCAL_POP, 1, OP_PRINT,
+          OP_NIL, OP_RETURN),
+      LIST(Lit) },
+};
+
+VM_TEST(OpSetLocalPop, opSetLocalPop, 1);
+
 VMCase opGlobals[] = {
   { INTERPRET_RUNTIME_ERROR, "Undefined variable 'foo'.", LIST(LitFun),
       LIST(uint8_t, OP_GET_GLOBAL, 0, 0, OP_NIL, OP_RETURN),
@@ -510,6 +529,48 @@ VMCase opLessC[] = {
 
 VM_TEST(OpLessC, opLessC, 6);
 
+VMCase opNotCompare[] = {
+  { INTERPRET_OK, "true\n", LIST(LitFun),
+      LIST(uint8_t, OP_NIL, OP_FALSE, OP_NOT_EQUAL, OP_PRINT, OP_NIL,
+          OP_RETURN),
+      LIST(Lit) },
+  { INTERPRET_OK, "false\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1, OP_NOT_EQUAL,
+          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(1.0), N(1.0)) },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.", LIST(LitFun),
+      LIST(uint8_t, OP_NIL, OP_NIL, OP_NOT_GREATER, OP_PRINT, OP_NIL,
+          OP_RETURN),
+      LIST(Lit) },
+  { INTERPRET_OK, "true\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
+          OP_NOT_GREATER, OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(2.0), N(2.0)) },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.", LIST(LitFun),
+      LIST(uint8_t, OP_NIL, OP_NIL, OP_NOT_LESS, OP_PRINT, OP_NIL,
+          OP_RETURN),
+      LIST(Lit) },
+  { INTERPRET_OK, "false\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1, OP_NOT_LESS,
+          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(1.0), N(2.0)) },
+  { INTERPRET_RUNTIME_ERROR, "Operands must be numbers.", LIST(LitFun),
+      LIST(uint8_t, OP_NIL, OP_NOT_LESS_C, 0, 0, OP_PRINT, OP_NIL,
+          OP_RETURN),
+      LIST(Lit, N(0.0)) },
+  { INTERPRET_OK, "true\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_NOT_LESS_C, 0, 1, OP_PRINT,
+          OP_NIL, OP_RETURN),
+      LIST(Lit, N(3.0), N(2.0)) },
+  // Like the comparison then OP_NOT, so NaN makes them all true.
+  { INTERPRET_OK, "true\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 0, OP_NOT_LESS,
+          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(NAN)) },
+};
+
+VM_TEST(OpNotCompare, opNotCompare, 9);
+
 VMCase opAdd[] = {
   { INTERPRET_RUNTIME_ERROR,
       "Operands must be two numbers or two strings.", LIST(LitFun),
@@ -729,6 +790,48 @@ VMCase opModulo[] = {
 
 VM_TEST(OpModulo, opModulo, 4);
 
+// The compiler only emits these for numbers, so they don't check.
+VMCase opNumbersNN[] = {
+  { INTERPRET_OK, "true\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1, OP_GREATER_NN,
+          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(3.0), N(2.0)) },
+  { INTERPRET_OK, "false\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1, OP_LESS_NN,
+          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(3.0), N(2.0)) },
+  { INTERPRET_OK, "false\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_LESS_C_NN, 0, 1, OP_PRINT,
+          OP_NIL, OP_RETURN),
+      LIST(Lit, N(3.0), N(2.0)) },
+  { INTERPRET_OK, "5\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1, OP_ADD_NN,
+          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(3.0), N(2.0)) },
+  { INTERPRET_OK, "5\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_ADD_C_NN, 0, 1, OP_PRINT,
+          OP_NIL, OP_RETURN),
+      LIST(Lit, N(3.0), N(2.0)) },
+  { INTERPRET_OK, "1\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
+          OP_SUBTRACT_NN, OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(3.0), N(2.0)) },
+  { INTERPRET_OK, "1\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_SUBTRACT_C_NN, 0, 1, OP_PRINT,
+          OP_NIL, OP_RETURN),
+      LIST(Lit, N(3.0), N(2.0)) },
+  { INTERPRET_OK, "6\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
+          OP_MULTIPLY_NN, OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(3.0), N(2.0)) },
+  { INTERPRET_OK, "1.5\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1, OP_DIVIDE_NN,
+          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(3.0), N(2.0)) },
+};
+
+VM_TEST(OpNumbersNN, opNumbersNN, 9);
+
 VMCase opNot[] = {
   { INTERPRET_OK, "true\n", LIST(LitFun),
       LIST(uint8_t, OP_NIL, OP_NOT, OP_PRINT, OP_NIL, OP_RETURN),
@@ -1243,6 +1346,46 @@ VMCase classes[] = {
 
 VM_TEST(Classes, classes, 6);
 
+// Hoisted reads cache fields, but not methods, until the cache is
+// dropped with the loop.
+VMCase opHoisted[] = {
+  { INTERPRET_OK, "1\n1\n2\n", LIST(LitFun),
+      // class F{} var f = F(); f.x = 1; with a cache in slot 1, print
+      // f.x; f.x = 2; print f.x; then print f.x without the cache.
+      LIST(uint8_t, OP_CLASS, 0, 0, OP_DEFINE_GLOBAL, 0, 0,
+          OP_GET_GLOBAL, 0, 1, OP_CALL, 0, OP_DEFINE_GLOBAL, 0, 2,
+          OP_GET_GLOBAL, 0, 2, OP_CONSTANT, 0, 3, OP_SET_PROPERTY, 0, 4,
+          OP_POP, OP_NIL, OP_GET_HOISTED, 1, 0, 7, OP_GET_GLOBAL, 0, 2,
+          OP_HOIST_PROPERTY, 0, 4, 1, OP_PRINT, OP_GET_GLOBAL, 0, 2,
+          OP_CONSTANT, 0, 5, OP_SET_PROPERTY, 0, 4, OP_POP,
+          OP_GET_HOISTED, 1, 0, 7, OP_GET_GLOBAL, 0, 2,
+          OP_HOIST_PROPERTY, 0, 4, 1, OP_PRINT, OP_GET_GLOBAL, 0, 2,
+          OP_GET_PROPERTY, 0, 4, OP_PRINT, OP_POP, OP_NIL, OP_RETURN),
+      LIST(Lit, S("F"), S("F"), S("f"), N(1.0), S("x"), N(2.0)) },
+  { INTERPRET_OK, "nil\n", LIST(LitFun),
+      LIST(uint8_t, OP_NIL, OP_LIST_BUILD, 0, OP_HOIST_PROPERTY, 0, 0,
+          1, OP_POP, OP_GET_LOCAL, 1, OP_PRINT, OP_POP, OP_NIL,
+          OP_RETURN),
+      LIST(Lit, S("size")) },
+  { INTERPRET_RUNTIME_ERROR,
+      "Only lists and instances have properties.", LIST(LitFun),
+      LIST(uint8_t, OP_NIL, OP_CONSTANT, 0, 0, OP_HOIST_PROPERTY, 0, 1,
+          1, OP_POP, OP_POP, OP_NIL, OP_RETURN),
+      LIST(Lit, N(0.0), S("x")) },
+};
+
+VM_TEST(OpHoisted, opHoisted, 3);
+
+VMCase opIncLocal[] = {
+  { INTERPRET_OK, "3\n0.5\n", LIST(LitFun),
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_INC_LOCAL, 1, 0, 1,
+          OP_GET_LOCAL, 1, OP_PRINT, OP_INC_LOCAL, 1, 0, 2,
+          OP_GET_LOCAL, 1, OP_PRINT, OP_POP, OP_NIL, OP_RETURN),
+      LIST(Lit, N(1.0), N(2.0), N(-2.5)) },
+};
+
+VM_TEST(OpIncLocal, opIncLocal, 1);
+
 VMCase classesMethods[] = {
   // ClassesMethods
   // class F {
@@ -1747,8 +1890,8 @@ VMCase nativeType[] = {
   { INTERPRET_OK, "string\nlist\nmap\n", LIST(LitFun),
       // print type(""); print type([]); print type({});
       LIST(uint8_t, OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0, 1, OP_CALL, 1,
-          OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_LIST_INIT, OP_CALL, 1,
-          OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_MAP_INIT, OP_CALL, 1,
+          OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_LIST_BUILD, 0, OP_CALL, 1,
+          OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_MAP_BUILD, 0, OP_CALL, 1,
           OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("type"), S("")) },
   // NativeTypeFunctionClosure
@@ -1835,31 +1978,42 @@ UTEST(VM, NativeTypeUpvalue) {
 }
 
 VMCase lists[] = {
+  // ListsBuildMany
+  { INTERPRET_OK, "[nil, true, false]\n", LIST(LitFun),
+      // print [nil, true, false];
+      LIST(uint8_t, OP_NIL, OP_TRUE, OP_FALSE, OP_LIST_BUILD, 3,
+          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit) },
+  // ListsDataMany
+  { INTERPRET_OK, "[nil, true, false]\n", LIST(LitFun),
+      LIST(uint8_t, OP_NIL, OP_LIST_BUILD, 1, OP_TRUE, OP_FALSE,
+          OP_LIST_DATA, 2, OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit) },
   // ListsDataNonList1
   { INTERPRET_RUNTIME_ERROR, "List data can only be added to a list.",
       LIST(LitFun),
-      LIST(uint8_t, OP_NIL, OP_NIL, OP_LIST_DATA, OP_POP, OP_NIL,
+      LIST(uint8_t, OP_NIL, OP_NIL, OP_LIST_DATA, 1, OP_POP, OP_NIL,
           OP_RETURN),
       LIST(Lit) },
   // ListsDataNonList2
   { INTERPRET_RUNTIME_ERROR, "List data can only be added to a list.",
       LIST(LitFun),
-      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_NIL, OP_LIST_DATA, OP_POP,
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_NIL, OP_LIST_DATA, 1, OP_POP,
           OP_NIL, OP_RETURN),
       LIST(Lit, S("foo")) },
   // ListsGetIndexSimple
   { INTERPRET_OK, "nil\n", LIST(LitFun),
       // print [nil][0];
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_CONSTANT, 0,
-          0, OP_GET_INDEX, OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1,
+          OP_CONSTANT, 0, 0, OP_GET_INDEX, OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, N(0.0)) },
   // ListsSetIndexSimple
   { INTERPRET_OK, "0\n1\n1\n", LIST(LitFun),
       // var l=0;print l[0];print l[0]=1;print l[0];
-      LIST(uint8_t, OP_LIST_INIT, OP_CONSTANT, 0, 1, OP_LIST_DATA,
-          OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0,
-          1, OP_GET_INDEX, OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_CONSTANT,
-          0, 1, OP_CONSTANT, 0, 2, OP_SET_INDEX, OP_PRINT,
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_CONSTANT, 0, 1, OP_LIST_DATA,
+          1, OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL, 0, 0, OP_CONSTANT,
+          0, 1, OP_GET_INDEX, OP_PRINT, OP_GET_GLOBAL, 0, 0,
+          OP_CONSTANT, 0, 1, OP_CONSTANT, 0, 2, OP_SET_INDEX, OP_PRINT,
           OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0, 1, OP_GET_INDEX,
           OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("l"), N(0.0), N(1.0)) },
@@ -1867,85 +2021,88 @@ VMCase lists[] = {
   { INTERPRET_RUNTIME_ERROR, "List index must be a number.",
       LIST(LitFun),
       // [nil][nil];
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_NIL,
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1, OP_NIL,
           OP_GET_INDEX, OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit) },
   // ListsSetIndexNonNumber
   { INTERPRET_RUNTIME_ERROR, "List index must be a number.",
       LIST(LitFun),
       // [nil][nil]=nil;
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_NIL, OP_NIL,
-          OP_SET_INDEX, OP_POP, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1, OP_NIL,
+          OP_NIL, OP_SET_INDEX, OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit) },
   // ListsGetIndexGetOutOfBounds1
   { INTERPRET_RUNTIME_ERROR, "List index (-1) out of bounds (1).",
       LIST(LitFun),
       // [nil][-1];
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_CONSTANT, 0,
-          0, OP_GET_INDEX, OP_POP, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1,
+          OP_CONSTANT, 0, 0, OP_GET_INDEX, OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit, N(-1.0)) },
   // ListsSetIndexGetOutOfBounds1
   { INTERPRET_RUNTIME_ERROR, "List index (-1) out of bounds (1).",
       LIST(LitFun),
       // [nil][-1]=nil;
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_CONSTANT, 0,
-          0, OP_NIL, OP_SET_INDEX, OP_POP, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1,
+          OP_CONSTANT, 0, 0, OP_NIL, OP_SET_INDEX, OP_POP, OP_NIL,
+          OP_RETURN),
       LIST(Lit, N(-1.0)) },
   // ListsGetIndexGetOutOfBounds2
   { INTERPRET_RUNTIME_ERROR, "List index (1) out of bounds (1).",
       LIST(LitFun),
       // [nil][1];
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_CONSTANT, 0,
-          0, OP_GET_INDEX, OP_POP, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1,
+          OP_CONSTANT, 0, 0, OP_GET_INDEX, OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit, N(1.0)) },
   // ListsSetIndexGetOutOfBounds2
   { INTERPRET_RUNTIME_ERROR, "List index (1) out of bounds (1).",
       LIST(LitFun),
       // [nil][1]=nil;
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_CONSTANT, 0,
-          0, OP_NIL, OP_SET_INDEX, OP_POP, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1,
+          OP_CONSTANT, 0, 0, OP_NIL, OP_SET_INDEX, OP_POP, OP_NIL,
+          OP_RETURN),
       LIST(Lit, N(1.0)) },
   // ListsGetIndexGetBadNumber
   { INTERPRET_RUNTIME_ERROR, "List index (0.5) must be a whole number.",
       LIST(LitFun),
       // [nil][0.5];
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_CONSTANT, 0,
-          0, OP_GET_INDEX, OP_POP, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1,
+          OP_CONSTANT, 0, 0, OP_GET_INDEX, OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit, N(0.5)) },
   // ListsSetIndexGetBadNumber
   { INTERPRET_RUNTIME_ERROR, "List index (0.5) must be a whole number.",
       LIST(LitFun),
       // [nil][0.5]=nil;
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_CONSTANT, 0,
-          0, OP_NIL, OP_SET_INDEX, OP_POP, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1,
+          OP_CONSTANT, 0, 0, OP_NIL, OP_SET_INDEX, OP_POP, OP_NIL,
+          OP_RETURN),
       LIST(Lit, N(0.5)) },
   // ListsInsertSimple
   { INTERPRET_OK, "[123, 456]\n", LIST(LitFun),
       // var l=[123];l.insert(0,456);print l;
-      LIST(uint8_t, OP_LIST_INIT, OP_CONSTANT, 0, 1, OP_LIST_DATA,
-          OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0,
-          3, OP_CONSTANT, 0, 4, OP_INVOKE, 0, 2, 2, OP_POP,
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_CONSTANT, 0, 1, OP_LIST_DATA,
+          1, OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL, 0, 0, OP_CONSTANT,
+          0, 3, OP_CONSTANT, 0, 4, OP_INVOKE, 0, 2, 2, OP_POP,
           OP_GET_GLOBAL, 0, 0, OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("l"), N(456.0), S("insert"), N(0.0), N(123.0)) },
   // ListsInsertBadArity
   { INTERPRET_RUNTIME_ERROR, "Expected 2 arguments but got 0.",
       LIST(LitFun),
       // [].insert();
-      LIST(uint8_t, OP_LIST_INIT, OP_INVOKE, 0, 0, 0, OP_POP, OP_NIL,
-          OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_INVOKE, 0, 0, 0, OP_POP,
+          OP_NIL, OP_RETURN),
       LIST(Lit, S("insert")) },
   // ListsInsertBadIndex
   { INTERPRET_RUNTIME_ERROR, "List index must be a number.",
       LIST(LitFun),
       // [].insert(nil,nil);
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_NIL, OP_INVOKE, 0, 0, 2,
-          OP_POP, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_NIL, OP_INVOKE, 0, 0,
+          2, OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit, S("insert")) },
   // ListsPopSimple
   { INTERPRET_OK, "[123, 456]\n456\n[123]\n", LIST(LitFun),
       // var l=[123,456];print l;print l.pop();print l;
-      LIST(uint8_t, OP_LIST_INIT, OP_CONSTANT, 0, 1, OP_LIST_DATA,
-          OP_CONSTANT, 0, 2, OP_LIST_DATA, OP_DEFINE_GLOBAL, 0, 0,
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_CONSTANT, 0, 1, OP_LIST_DATA,
+          1, OP_CONSTANT, 0, 2, OP_LIST_DATA, 1, OP_DEFINE_GLOBAL, 0, 0,
           OP_GET_GLOBAL, 0, 0, OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_INVOKE,
           0, 3, 0, OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_PRINT, OP_NIL,
           OP_RETURN),
@@ -1954,38 +2111,39 @@ VMCase lists[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
       LIST(LitFun),
       // [].pop(nil);
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_INVOKE, 0, 0, 1, OP_POP,
-          OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_INVOKE, 0, 0, 1,
+          OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit, S("pop")) },
   // ListsPopEmpty
   { INTERPRET_RUNTIME_ERROR, "Can't pop from an empty list.",
       LIST(LitFun),
       // [].pop();
-      LIST(uint8_t, OP_LIST_INIT, OP_INVOKE, 0, 0, 0, OP_POP, OP_NIL,
-          OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_INVOKE, 0, 0, 0, OP_POP,
+          OP_NIL, OP_RETURN),
       LIST(Lit, S("pop")) },
   // ListsPushSimple
   { INTERPRET_OK, "[]\n[123]\n[123, 456]\n", LIST(LitFun),
       // var l=[];print l;l.push(123);print l;l.push(456);print l;
-      LIST(uint8_t, OP_LIST_INIT, OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL,
-          0, 0, OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0, 2,
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_DEFINE_GLOBAL, 0, 0,
+          OP_GET_GLOBAL, 0, 0, OP_PRINT, OP_GET_GLOBAL, 0, 0,
+          OP_CONSTANT, 0, 2, OP_INVOKE, 0, 1, 1, OP_POP, OP_GET_GLOBAL,
+          0, 0, OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0, 3,
           OP_INVOKE, 0, 1, 1, OP_POP, OP_GET_GLOBAL, 0, 0, OP_PRINT,
-          OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0, 3, OP_INVOKE, 0, 1, 1,
-          OP_POP, OP_GET_GLOBAL, 0, 0, OP_PRINT, OP_NIL, OP_RETURN),
+          OP_NIL, OP_RETURN),
       LIST(Lit, S("l"), S("push"), N(123.0), N(456.0)) },
   // ListsPushBadArity
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       LIST(LitFun),
       // [].push();
-      LIST(uint8_t, OP_LIST_INIT, OP_INVOKE, 0, 0, 0, OP_POP, OP_NIL,
-          OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_INVOKE, 0, 0, 0, OP_POP,
+          OP_NIL, OP_RETURN),
       LIST(Lit, S("push")) },
   // ListsRemoveSimple
   { INTERPRET_OK, "[123, 456, 789]\n456\n[123, 789]\n", LIST(LitFun),
       // var l=[123,456,789];print l;print l.remove(1);print l;
-      LIST(uint8_t, OP_LIST_INIT, OP_CONSTANT, 0, 1, OP_LIST_DATA,
-          OP_CONSTANT, 0, 2, OP_LIST_DATA, OP_CONSTANT, 0, 3,
-          OP_LIST_DATA, OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL, 0, 0,
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_CONSTANT, 0, 1, OP_LIST_DATA,
+          1, OP_CONSTANT, 0, 2, OP_LIST_DATA, 1, OP_CONSTANT, 0, 3,
+          OP_LIST_DATA, 1, OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL, 0, 0,
           OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0, 5, OP_INVOKE,
           0, 4, 1, OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_PRINT, OP_NIL,
           OP_RETURN),
@@ -1995,203 +2153,215 @@ VMCase lists[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       LIST(LitFun),
       // [].remove();
-      LIST(uint8_t, OP_LIST_INIT, OP_INVOKE, 0, 0, 0, OP_POP, OP_NIL,
-          OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_INVOKE, 0, 0, 0, OP_POP,
+          OP_NIL, OP_RETURN),
       LIST(Lit, S("remove")) },
   // ListsRemoveBadIndex
   { INTERPRET_RUNTIME_ERROR, "List index (1) out of bounds (0).",
       LIST(LitFun),
       // [].remove(1);
-      LIST(uint8_t, OP_LIST_INIT, OP_CONSTANT, 0, 1, OP_INVOKE, 0, 0, 1,
-          OP_POP, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_CONSTANT, 0, 1, OP_INVOKE, 0,
+          0, 1, OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit, S("remove"), N(1.0)) },
   // ListsSizeSimple1
   { INTERPRET_OK, "3\n", LIST(LitFun),
       // print [nil,nil,nil].size();
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_NIL,
-          OP_LIST_DATA, OP_NIL, OP_LIST_DATA, OP_INVOKE, 0, 0, 0,
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1, OP_NIL,
+          OP_LIST_DATA, 1, OP_NIL, OP_LIST_DATA, 1, OP_INVOKE, 0, 0, 0,
           OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("size")) },
   // ListsSizeSimple2
   { INTERPRET_OK, "3\n", LIST(LitFun),
       // var s=[nil,nil,nil].size;print s();
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_LIST_DATA, OP_NIL,
-          OP_LIST_DATA, OP_NIL, OP_LIST_DATA, OP_GET_PROPERTY, 0, 1,
-          OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL, 0, 0, OP_CALL, 0,
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_LIST_DATA, 1, OP_NIL,
+          OP_LIST_DATA, 1, OP_NIL, OP_LIST_DATA, 1, OP_GET_PROPERTY, 0,
+          1, OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL, 0, 0, OP_CALL, 0,
           OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("s"), S("size")) },
   // ListsSizeBadArity
   { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
       LIST(LitFun),
       // [].size(nil);
-      LIST(uint8_t, OP_LIST_INIT, OP_NIL, OP_INVOKE, 0, 0, 1, OP_POP,
-          OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_LIST_BUILD, 0, OP_NIL, OP_INVOKE, 0, 0, 1,
+          OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit, S("size")) },
 };
 
-VM_TEST(Lists, lists, 26);
+VM_TEST(Lists, lists, 28);
 
 VMCase maps[] = {
+  // MapsBuildMany
+  { INTERPRET_OK, "{nil: true, false: nil}\n", LIST(LitFun),
+      // print {[nil]: true, [false]: nil};
+      LIST(uint8_t, OP_NIL, OP_TRUE, OP_FALSE, OP_NIL, OP_MAP_BUILD, 2,
+          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit) },
+  // MapsBuildDuplicateKey
+  { INTERPRET_OK, "{nil: false}\n", LIST(LitFun),
+      // print {[nil]: true, [nil]: false};
+      LIST(uint8_t, OP_NIL, OP_TRUE, OP_NIL, OP_FALSE, OP_MAP_BUILD, 2,
+          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit) },
+  // MapsDataMany
+  { INTERPRET_OK, "{nil: true, false: nil}\n", LIST(LitFun),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_NIL, OP_TRUE, OP_FALSE, OP_NIL,
+          OP_MAP_DATA, 2, OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit) },
   // MapsDataNonMap1
   { INTERPRET_RUNTIME_ERROR, "Map data can only be added to a map.",
       LIST(LitFun),
-      LIST(uint8_t, OP_NIL, OP_NIL, OP_NIL, OP_MAP_DATA, OP_POP, OP_NIL,
-          OP_RETURN),
+      LIST(uint8_t, OP_NIL, OP_NIL, OP_NIL, OP_MAP_DATA, 1, OP_POP,
+          OP_NIL, OP_RETURN),
       LIST(Lit) },
   // MapsDataNonMap2
   { INTERPRET_RUNTIME_ERROR, "Map data can only be added to a map.",
       LIST(LitFun),
-      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_NIL, OP_NIL, OP_MAP_DATA,
+      LIST(uint8_t, OP_CONSTANT, 0, 0, OP_NIL, OP_NIL, OP_MAP_DATA, 1,
           OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit, S("foo")) },
   // MapsDataNonStringKey1
-  { INTERPRET_RUNTIME_ERROR, "Map key must be a string.", LIST(LitFun),
-      // ({[nil]:nil});
-      LIST(uint8_t, OP_MAP_INIT, OP_NIL, OP_NIL, OP_MAP_DATA, OP_POP,
-          OP_NIL, OP_RETURN),
+  { INTERPRET_OK, "{nil: nil}\n", LIST(LitFun),
+      // print{[nil]:nil};
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_NIL, OP_NIL, OP_MAP_DATA, 1,
+          OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit) },
   // MapsDataNonStringKey2
-  { INTERPRET_RUNTIME_ERROR, "Map key must be a string.", LIST(LitFun),
-      // ({[{}]:nil});
-      LIST(uint8_t, OP_MAP_INIT, OP_MAP_INIT, OP_NIL, OP_MAP_DATA,
-          OP_POP, OP_NIL, OP_RETURN),
+  { INTERPRET_OK, "{<map>: nil}\n", LIST(LitFun),
+      // print{[{}]:nil};
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_MAP_BUILD, 0, OP_NIL,
+          OP_MAP_DATA, 1, OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit) },
   // MapsGetIndexSimple
   { INTERPRET_OK, "1\n", LIST(LitFun),
       // print{a:1}["a"];
-      LIST(uint8_t, OP_MAP_INIT, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
-          OP_MAP_DATA, OP_CONSTANT, 0, 0, OP_GET_INDEX, OP_PRINT,
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_CONSTANT, 0, 0, OP_CONSTANT, 0,
+          1, OP_MAP_DATA, 1, OP_CONSTANT, 0, 0, OP_GET_INDEX, OP_PRINT,
           OP_NIL, OP_RETURN),
       LIST(Lit, S("a"), N(1.0)) },
   // MapsSetIndexSimple
   { INTERPRET_OK, "{}\n1\n{a: 1}\n", LIST(LitFun),
       // var m={};print m;print m["a"]=1;print m;
-      LIST(uint8_t, OP_MAP_INIT, OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL,
-          0, 0, OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0, 1,
-          OP_CONSTANT, 0, 2, OP_SET_INDEX, OP_PRINT, OP_GET_GLOBAL, 0,
-          0, OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_DEFINE_GLOBAL, 0, 0,
+          OP_GET_GLOBAL, 0, 0, OP_PRINT, OP_GET_GLOBAL, 0, 0,
+          OP_CONSTANT, 0, 1, OP_CONSTANT, 0, 2, OP_SET_INDEX, OP_PRINT,
+          OP_GET_GLOBAL, 0, 0, OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("m"), S("a"), N(1.0)) },
   // MapsGetIndexNonString1
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      LIST(LitFun),
+  { INTERPRET_RUNTIME_ERROR, "Undefined key 'nil'.", LIST(LitFun),
       // ({}[nil]);
-      LIST(uint8_t, OP_MAP_INIT, OP_NIL, OP_GET_INDEX, OP_POP, OP_NIL,
-          OP_RETURN),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_NIL, OP_GET_INDEX, OP_POP,
+          OP_NIL, OP_RETURN),
       LIST(Lit) },
   // MapsGetIndexNonString2
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      LIST(LitFun),
+  { INTERPRET_RUNTIME_ERROR, "Undefined key '<map>'.", LIST(LitFun),
       // ({}[{}]);
-      LIST(uint8_t, OP_MAP_INIT, OP_MAP_INIT, OP_GET_INDEX, OP_POP,
-          OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_MAP_BUILD, 0, OP_GET_INDEX,
+          OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit) },
   // MapsSetIndexNonString1
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      LIST(LitFun),
-      // ({}[nil]=nil);
-      LIST(uint8_t, OP_MAP_INIT, OP_NIL, OP_NIL, OP_SET_INDEX, OP_POP,
-          OP_NIL, OP_RETURN),
-      LIST(Lit) },
+  { INTERPRET_OK, "1\n", LIST(LitFun),
+      // print{}[nil]=1;
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_NIL, OP_CONSTANT, 0, 0,
+          OP_SET_INDEX, OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(Lit, N(1.0)) },
   // MapsSetIndexNonString2
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      LIST(LitFun),
+  { INTERPRET_OK, "", LIST(LitFun),
       // ({}[{}]=nil);
-      LIST(uint8_t, OP_MAP_INIT, OP_MAP_INIT, OP_NIL, OP_SET_INDEX,
-          OP_POP, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_MAP_BUILD, 0, OP_NIL,
+          OP_SET_INDEX, OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit) },
   // MapsGetIndexMissing
   { INTERPRET_RUNTIME_ERROR, "Undefined key 'a'.", LIST(LitFun),
       // ({}["a"]);
-      LIST(uint8_t, OP_MAP_INIT, OP_CONSTANT, 0, 0, OP_GET_INDEX,
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_CONSTANT, 0, 0, OP_GET_INDEX,
           OP_POP, OP_NIL, OP_RETURN),
       LIST(Lit, S("a")) },
   // MapsCountSimple
   { INTERPRET_OK, "3\n", LIST(LitFun),
       // print{a:4,b:5,c:6}.count();
-      LIST(uint8_t, OP_MAP_INIT, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
-          OP_MAP_DATA, OP_CONSTANT, 0, 2, OP_CONSTANT, 0, 3,
-          OP_MAP_DATA, OP_CONSTANT, 0, 4, OP_CONSTANT, 0, 5,
-          OP_MAP_DATA, OP_INVOKE, 0, 6, 0, OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_CONSTANT, 0, 0, OP_CONSTANT, 0,
+          1, OP_MAP_DATA, 1, OP_CONSTANT, 0, 2, OP_CONSTANT, 0, 3,
+          OP_MAP_DATA, 1, OP_CONSTANT, 0, 4, OP_CONSTANT, 0, 5,
+          OP_MAP_DATA, 1, OP_INVOKE, 0, 6, 0, OP_PRINT, OP_NIL,
+          OP_RETURN),
       LIST(Lit, S("a"), N(4.0), S("b"), N(5.0), S("c"), N(6.0),
           S("count")) },
   // MapsCountBadArity
   { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
       LIST(LitFun),
       // ({}).count(nil);
-      LIST(uint8_t, OP_MAP_INIT, OP_NIL, OP_INVOKE, 0, 0, 1, OP_POP,
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_NIL, OP_INVOKE, 0, 0, 1, OP_POP,
           OP_NIL, OP_RETURN),
       LIST(Lit, S("count")) },
   // MapsHasSimple1
   { INTERPRET_OK, "true\n", LIST(LitFun),
       // print{a:1}.has("a");
-      LIST(uint8_t, OP_MAP_INIT, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
-          OP_MAP_DATA, OP_CONSTANT, 0, 0, OP_INVOKE, 0, 2, 1, OP_PRINT,
-          OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_CONSTANT, 0, 0, OP_CONSTANT, 0,
+          1, OP_MAP_DATA, 1, OP_CONSTANT, 0, 0, OP_INVOKE, 0, 2, 1,
+          OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("a"), N(1.0), S("has")) },
   // MapsHasSimple2
   { INTERPRET_OK, "false\n", LIST(LitFun),
       // print{a:1}.has("b");
-      LIST(uint8_t, OP_MAP_INIT, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
-          OP_MAP_DATA, OP_CONSTANT, 0, 3, OP_INVOKE, 0, 2, 1, OP_PRINT,
-          OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_CONSTANT, 0, 0, OP_CONSTANT, 0,
+          1, OP_MAP_DATA, 1, OP_CONSTANT, 0, 3, OP_INVOKE, 0, 2, 1,
+          OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("a"), N(1.0), S("has"), S("b")) },
   // MapsHasSimple3
   { INTERPRET_OK, "true\n", LIST(LitFun),
       // var mh={a:1}.has;print mh("a");
-      LIST(uint8_t, OP_MAP_INIT, OP_CONSTANT, 0, 1, OP_CONSTANT, 0, 2,
-          OP_MAP_DATA, OP_GET_PROPERTY, 0, 3, OP_DEFINE_GLOBAL, 0, 0,
-          OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0, 1, OP_CALL, 1, OP_PRINT,
-          OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_CONSTANT, 0, 1, OP_CONSTANT, 0,
+          2, OP_MAP_DATA, 1, OP_GET_PROPERTY, 0, 3, OP_DEFINE_GLOBAL, 0,
+          0, OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0, 1, OP_CALL, 1,
+          OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("mh"), S("a"), N(1.0), S("has")) },
   // MapsHasBadArity
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       LIST(LitFun),
       // ({}).has();
-      LIST(uint8_t, OP_MAP_INIT, OP_INVOKE, 0, 0, 0, OP_POP, OP_NIL,
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_INVOKE, 0, 0, 0, OP_POP, OP_NIL,
           OP_RETURN),
       LIST(Lit, S("has")) },
   // MapsHasNonStringKey1
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      LIST(LitFun),
-      // ({}).has(nil);
-      LIST(uint8_t, OP_MAP_INIT, OP_NIL, OP_INVOKE, 0, 0, 1, OP_POP,
-          OP_NIL, OP_RETURN),
+  { INTERPRET_OK, "false\n", LIST(LitFun),
+      // print{}.has(nil);
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_NIL, OP_INVOKE, 0, 0, 1,
+          OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("has")) },
   // MapsHasNonStringKey2
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      LIST(LitFun),
-      // ({}).has({});
-      LIST(uint8_t, OP_MAP_INIT, OP_MAP_INIT, OP_INVOKE, 0, 0, 1,
-          OP_POP, OP_NIL, OP_RETURN),
+  { INTERPRET_OK, "false\n", LIST(LitFun),
+      // print{}.has({});
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_MAP_BUILD, 0, OP_INVOKE, 0, 0,
+          1, OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("has")) },
   // MapsKeysSimple
   { INTERPRET_OK, "3\n", LIST(LitFun),
       // print{a:4,b:5,c:6}.keys().size();
-      LIST(uint8_t, OP_MAP_INIT, OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
-          OP_MAP_DATA, OP_CONSTANT, 0, 2, OP_CONSTANT, 0, 3,
-          OP_MAP_DATA, OP_CONSTANT, 0, 4, OP_CONSTANT, 0, 5,
-          OP_MAP_DATA, OP_INVOKE, 0, 6, 0, OP_INVOKE, 0, 7, 0, OP_PRINT,
-          OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_CONSTANT, 0, 0, OP_CONSTANT, 0,
+          1, OP_MAP_DATA, 1, OP_CONSTANT, 0, 2, OP_CONSTANT, 0, 3,
+          OP_MAP_DATA, 1, OP_CONSTANT, 0, 4, OP_CONSTANT, 0, 5,
+          OP_MAP_DATA, 1, OP_INVOKE, 0, 6, 0, OP_INVOKE, 0, 7, 0,
+          OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("a"), N(4.0), S("b"), N(5.0), S("c"), N(6.0),
           S("keys"), S("size")) },
   // MapsKeysBadArity
   { INTERPRET_RUNTIME_ERROR, "Expected 0 arguments but got 1.",
       LIST(LitFun),
       // ({}).keys(nil);
-      LIST(uint8_t, OP_MAP_INIT, OP_NIL, OP_INVOKE, 0, 0, 1, OP_POP,
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_NIL, OP_INVOKE, 0, 0, 1, OP_POP,
           OP_NIL, OP_RETURN),
       LIST(Lit, S("keys")) },
   // MapsRemoveSimple1
   { INTERPRET_OK, "false\n", LIST(LitFun),
       // print{}.remove("");
-      LIST(uint8_t, OP_MAP_INIT, OP_CONSTANT, 0, 1, OP_INVOKE, 0, 0, 1,
-          OP_PRINT, OP_NIL, OP_RETURN),
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_CONSTANT, 0, 1, OP_INVOKE, 0, 0,
+          1, OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("remove"), S("")) },
   // MapsRemoveSimple2
   { INTERPRET_OK, "{a: 1, b: 2}\ntrue\n{b: 2}\n", LIST(LitFun),
-      LIST(uint8_t, OP_MAP_INIT, OP_CONSTANT, 0, 1, OP_CONSTANT, 0, 2,
-          OP_MAP_DATA, OP_CONSTANT, 0, 3, OP_CONSTANT, 0, 4,
-          OP_MAP_DATA, OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL, 0, 0,
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_CONSTANT, 0, 1, OP_CONSTANT, 0,
+          2, OP_MAP_DATA, 1, OP_CONSTANT, 0, 3, OP_CONSTANT, 0, 4,
+          OP_MAP_DATA, 1, OP_DEFINE_GLOBAL, 0, 0, OP_GET_GLOBAL, 0, 0,
           OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_CONSTANT, 0, 1, OP_INVOKE,
           0, 5, 1, OP_PRINT, OP_GET_GLOBAL, 0, 0, OP_PRINT, OP_NIL,
           OP_RETURN),
@@ -2200,26 +2370,24 @@ VMCase maps[] = {
   { INTERPRET_RUNTIME_ERROR, "Expected 1 arguments but got 0.",
       LIST(LitFun),
       // ({}).remove();
-      LIST(uint8_t, OP_MAP_INIT, OP_INVOKE, 0, 0, 0, OP_POP, OP_NIL,
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_INVOKE, 0, 0, 0, OP_POP, OP_NIL,
           OP_RETURN),
       LIST(Lit, S("remove")) },
   // MapsRemoveNonStringKey1
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      LIST(LitFun),
-      // ({}).remove(nil);
-      LIST(uint8_t, OP_MAP_INIT, OP_NIL, OP_INVOKE, 0, 0, 1, OP_POP,
-          OP_NIL, OP_RETURN),
+  { INTERPRET_OK, "false\n", LIST(LitFun),
+      // print{}.remove(nil);
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_NIL, OP_INVOKE, 0, 0, 1,
+          OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("remove")) },
   // MapsRemoveNonStringKey2
-  { INTERPRET_RUNTIME_ERROR, "Maps can only be indexed by string.",
-      LIST(LitFun),
-      // ({}).remove({});
-      LIST(uint8_t, OP_MAP_INIT, OP_MAP_INIT, OP_INVOKE, 0, 0, 1,
-          OP_POP, OP_NIL, OP_RETURN),
+  { INTERPRET_OK, "false\n", LIST(LitFun),
+      // print{}.remove({});
+      LIST(uint8_t, OP_MAP_BUILD, 0, OP_MAP_BUILD, 0, OP_INVOKE, 0, 0,
+          1, OP_PRINT, OP_NIL, OP_RETURN),
       LIST(Lit, S("remove")) },
 };
 
-VM_TEST(Maps, maps, 26);
+VM_TEST(Maps, maps, 29);
 
 UTEST_STATE();
 
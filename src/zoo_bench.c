@@ -45,4 +45,38 @@ UBENCH_EX(Bench, Zoo) {
   freeVM(&vm);
 }
 
+UBENCH_EX(Bench, ZooFields) {
+  VM vm;
+  InterpretResult ires;
+  const char src[] =
+      "class Zoo { \n"
+      "  init() { \n"
+      "    this.aardvark = 1; \n"
+      "    this.baboon = 1; \n"
+      "    this.cat = 1; \n"
+      "    this.donkey = 1; \n"
+      "    this.elephant = 1; \n"
+      "    this.fox = 1; \n"
+      "  } \n"
+      "} \n"
+      "var zoo = Zoo(); \n"
+      "var sum = 0; \n"
+      "while (sum < 6000000) { \n"
+      "  sum = sum + \n"
+      "      zoo.aardvark + \n"
+      "      zoo.baboon + \n"
+      "      zoo.cat + \n"
+      "      zoo.donkey + \n"
+      "      zoo.elephant + \n"
+      "      zoo.fox; \n"
+      "} \n";
+
+  initVM(&vm, stdout, stderr);
+  UBENCH_DO_BENCHMARK() {
+    ires = interpret(&vm, src);
+  }
+  assert(ires == INTERPRET_OK);
+  freeVM(&vm);
+}
+
 UBENCH_MAIN();